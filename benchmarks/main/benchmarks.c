@@ -0,0 +1,269 @@
+/*
+
+  ESP-IDF DMX and RDM Benchmarks
+
+  Measures the hot paths of the DMX driver on the target so that the results
+  of each release can be compared. Two DMX ports are wired back to back: the
+  TX pin of the controller port is wired to the RX pin of the responder port
+  and the TX pin of the responder port is wired to the RX pin of the
+  controller port. The sniffer pin must also be wired to the RX pin of the
+  responder port. No RS-485 transceivers are needed. A chip with at least
+  three UARTs is required.
+
+  Results are printed as JSON Lines, one JSON object per measurement. Every
+  other line of the output is an ordinary log line, so the results can be
+  collected by keeping each line which begins with '{'. Each object contains
+  the library version, the target, the CPU frequency, the measurement name,
+  its unit, the number of samples, and the minimum, average, and maximum.
+
+  Note: this example is for use with the ESP-IDF. It will not work on Arduino!
+
+  https://github.com/someweisguy/esp_dmx
+
+*/
+#include <inttypes.h>
+#include <stdio.h>
+
+#include "dmx/sniffer.h"
+#include "driver/gpio.h"
+#include "esp_dmx.h"
+#include "esp_log.h"
+#include "esp_rom_sys.h"
+#include "esp_timer.h"
+#include "freertos/task.h"
+#include "rdm/controller.h"
+#include "rdm/controller/include/utils.h"
+#include "rdm/responder.h"
+
+#define CONTROLLER_TX_PIN 17  // Wired to RESPONDER_RX_PIN.
+#define CONTROLLER_RX_PIN 16  // Wired to RESPONDER_TX_PIN.
+#define RESPONDER_TX_PIN 4    // Wired to CONTROLLER_RX_PIN.
+#define RESPONDER_RX_PIN 5    // Wired to CONTROLLER_TX_PIN.
+#define SNIFFER_PIN 18        // Wired to RESPONDER_RX_PIN.
+
+#define WARMUP_COUNT 4        // The number of samples discarded before each run.
+#define DMX_SAMPLE_COUNT 500  // The number of DMX packets sent in each run.
+#define RDM_SAMPLE_COUNT 200  // The number of RDM transactions which are sent.
+#define DISCOVERY_COUNT 10    // The number of times full discovery is run.
+
+static const char *TAG = "benchmarks";
+
+static const dmx_port_t controller_num = DMX_NUM_1;
+static const dmx_port_t responder_num = DMX_NUM_2;
+
+typedef struct sample_t {
+  uint32_t count;
+  int64_t min;
+  int64_t max;
+  int64_t total;
+} sample_t;
+
+static void sample_add(sample_t *sample, int64_t value) {
+  if (sample->count == 0 || value < sample->min) {
+    sample->min = value;
+  }
+  if (sample->count == 0 || value > sample->max) {
+    sample->max = value;
+  }
+  sample->total += value;
+  ++sample->count;
+}
+
+static void report(const char *name, const char *unit, const sample_t *sample) {
+  const int64_t avg = sample->count > 0 ? sample->total / sample->count : 0;
+  printf("{\"version\":\"%i.%i.%i\",\"target\":\"%s\",\"cpu_mhz\":%" PRIu32
+         ",\"name\":\"%s\",\"unit\":\"%s\",\"count\":%" PRIu32
+         ",\"min\":%" PRIi64 ",\"avg\":%" PRIi64 ",\"max\":%" PRIi64 "}\n",
+         ESP_DMX_VERSION_MAJOR, ESP_DMX_VERSION_MINOR, ESP_DMX_VERSION_PATCH,
+         CONFIG_IDF_TARGET, esp_rom_get_cpu_ticks_per_us(), name, unit,
+         sample->count, sample->min, avg, sample->max);
+}
+
+static void report_value(const char *name, const char *unit, int64_t value) {
+  const sample_t sample = {.count = 1, .min = value, .max = value,
+                           .total = value};
+  report(name, unit, &sample);
+}
+
+// The time at which the DMX interrupt finished receiving the last packet
+static volatile int64_t rx_done_ts;
+
+static bool IRAM_ATTR on_packet_received(dmx_port_t dmx_num,
+                                         const dmx_packet_t *packet,
+                                         void *context) {
+  rx_done_ts = esp_timer_get_time();
+  return false;
+}
+
+static int64_t get_frame_duration(dmx_port_t dmx_num, size_t size) {
+  // Each slot is 11 bits long at 250 kbaud
+  return dmx_get_break_len(dmx_num) + dmx_get_mab_len(dmx_num) + size * 44;
+}
+
+static void benchmark_send(void) {
+  sample_t latency = {0};
+  sample_t overhead = {0};
+  const int64_t frame_duration =
+      get_frame_duration(controller_num, DMX_PACKET_SIZE);
+
+  for (int i = 0; i < WARMUP_COUNT + DMX_SAMPLE_COUNT; ++i) {
+    const int64_t start = esp_timer_get_time();
+    dmx_send_num(controller_num, DMX_PACKET_SIZE);
+    dmx_wait_sent(controller_num, DMX_TIMEOUT_TICK);
+    const int64_t elapsed = esp_timer_get_time() - start;
+    if (i >= WARMUP_COUNT) {
+      sample_add(&latency, elapsed);
+      sample_add(&overhead, elapsed - frame_duration);
+    }
+  }
+
+  report("send_to_tx_done", "us", &latency);
+  report("send_to_tx_done_overhead", "us", &overhead);
+}
+
+static void benchmark_receive(void) {
+  sample_t wakeup = {0};
+
+  dmx_reset_stats(controller_num);
+  dmx_reset_stats(responder_num);
+  dmx_subscribe(responder_num, on_packet_received, NULL);
+  dmx_receive(responder_num, NULL, 0);  // Put the responder port in receive mode
+
+  for (int i = 0; i < WARMUP_COUNT + DMX_SAMPLE_COUNT; ++i) {
+    dmx_packet_t packet;
+    dmx_send_num(controller_num, DMX_PACKET_SIZE);
+    const size_t size = dmx_receive(responder_num, &packet, DMX_TIMEOUT_TICK);
+    const int64_t now = esp_timer_get_time();
+    if (i >= WARMUP_COUNT && size > 0 && packet.err == DMX_OK) {
+      sample_add(&wakeup, now - rx_done_ts);
+    }
+    dmx_wait_sent(controller_num, DMX_TIMEOUT_TICK);
+  }
+  dmx_unsubscribe(responder_num, on_packet_received, NULL);
+
+  report("receive_wakeup", "us", &wakeup);
+
+  // Convert the total time spent in the DMX interrupts to CPU cycles per frame
+  const uint32_t cpu_mhz = esp_rom_get_cpu_ticks_per_us();
+  dmx_stats_t stats;
+  dmx_get_stats(controller_num, &stats);
+  if (stats.packets_sent > 0) {
+    report_value("tx_isr_per_frame", "cycles",
+                 stats.isr_total_us * cpu_mhz / stats.packets_sent);
+  }
+  dmx_get_stats(responder_num, &stats);
+  if (stats.packets_received > 0) {
+    report_value("rx_isr_per_frame", "cycles",
+                 stats.isr_total_us * cpu_mhz / stats.packets_received);
+  }
+}
+
+static void benchmark_timing(void) {
+  sample_t break_error = {0};
+  sample_t mab_error = {0};
+  const int64_t break_len = dmx_get_break_len(controller_num);
+  const int64_t mab_len = dmx_get_mab_len(controller_num);
+
+  gpio_install_isr_service(DMX_SNIFFER_INTR_FLAGS_DEFAULT);
+  if (!dmx_sniffer_enable(responder_num, SNIFFER_PIN)) {
+    ESP_LOGE(TAG, "Unable to enable the DMX sniffer.");
+    return;
+  }
+
+  for (int i = 0; i < WARMUP_COUNT + DMX_SAMPLE_COUNT; ++i) {
+    dmx_packet_t packet;
+    dmx_metadata_t metadata;
+    dmx_send_num(controller_num, DMX_PACKET_SIZE);
+    const size_t size = dmx_receive(responder_num, &packet, DMX_TIMEOUT_TICK);
+    if (i >= WARMUP_COUNT && size > 0 &&
+        dmx_sniffer_get_data(responder_num, &metadata)) {
+      sample_add(&break_error, (int64_t)metadata.break_len - break_len);
+      sample_add(&mab_error, (int64_t)metadata.mab_len - mab_len);
+    }
+    dmx_wait_sent(controller_num, DMX_TIMEOUT_TICK);
+  }
+  dmx_sniffer_disable(responder_num);
+
+  report("break_error", "us", &break_error);
+  report("mab_error", "us", &mab_error);
+}
+
+static void responder_task(void *arg) {
+  dmx_packet_t packet;
+  while (true) {
+    if (dmx_receive(responder_num, &packet, DMX_TIMEOUT_TICK) &&
+        packet.is_rdm) {
+      rdm_send_response(responder_num);
+    }
+  }
+}
+
+static void benchmark_rdm(void) {
+  sample_t discovery = {0};
+  rdm_uid_t uid;
+  int found = 0;
+
+  xTaskCreate(responder_task, "responder", 4096, NULL,
+              uxTaskPriorityGet(NULL) + 1, NULL);
+
+  for (int i = 0; i < DISCOVERY_COUNT; ++i) {
+    const int64_t start = esp_timer_get_time();
+    found = rdm_discover_devices_simple(controller_num, &uid, 1);
+    const int64_t elapsed = esp_timer_get_time() - start;
+    if (found == 1) {
+      sample_add(&discovery, elapsed);
+    }
+  }
+  report("full_discovery", "us", &discovery);
+  if (found != 1) {
+    ESP_LOGE(TAG, "The responder port was not discovered.");
+    return;
+  }
+
+  sample_t transaction = {0};
+  const rdm_request_t request = {.dest_uid = &uid,
+                                 .sub_device = RDM_SUB_DEVICE_ROOT,
+                                 .cc = RDM_CC_GET_COMMAND,
+                                 .pid = RDM_PID_IDENTIFY_DEVICE};
+  uint32_t acks = 0;
+  const int64_t start = esp_timer_get_time();
+  for (int i = 0; i < RDM_SAMPLE_COUNT; ++i) {
+    bool identify;
+    rdm_ack_t ack;
+    const int64_t request_start = esp_timer_get_time();
+    if (rdm_send_request(controller_num, &request, "b$", &identify,
+                         sizeof(identify), &ack)) {
+      sample_add(&transaction, esp_timer_get_time() - request_start);
+      ++acks;
+    }
+  }
+  const int64_t elapsed = esp_timer_get_time() - start;
+
+  report("rdm_transaction", "us", &transaction);
+  report_value("rdm_transactions_per_second", "hz",
+               elapsed > 0 ? acks * 1000000LL / elapsed : 0);
+}
+
+void app_main() {
+  dmx_config_t config = DMX_CONFIG_DEFAULT;
+  dmx_personality_t personalities[] = {{1, "Benchmark"}};
+  dmx_driver_install(controller_num, &config, NULL, 0);
+  dmx_set_pin(controller_num, CONTROLLER_TX_PIN, CONTROLLER_RX_PIN,
+              DMX_PIN_NO_CHANGE);
+  dmx_driver_install(responder_num, &config, personalities, 1);
+  dmx_set_pin(responder_num, RESPONDER_TX_PIN, RESPONDER_RX_PIN,
+              DMX_PIN_NO_CHANGE);
+
+  uint8_t data[DMX_PACKET_SIZE] = {DMX_SC};
+  for (int i = 1; i < DMX_PACKET_SIZE; ++i) {
+    data[i] = i;
+  }
+  dmx_write(controller_num, data, DMX_PACKET_SIZE);
+
+  ESP_LOGI(TAG, "Running benchmarks for esp_dmx " ESP_DMX_VERSION_LABEL);
+  benchmark_send();
+  benchmark_receive();
+  benchmark_timing();
+  benchmark_rdm();
+  ESP_LOGI(TAG, "Benchmarks are done.");
+}
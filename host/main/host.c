@@ -0,0 +1,197 @@
+/*
+
+  ESP-IDF DMX and RDM on the Host
+
+  Runs the DMX driver on the linux target of the ESP-IDF against the simulated
+  DMX bus of the host HAL. Two DMX ports are connected on the simulated bus. The
+  controller port sends DMX packets to the responder port and then discovers
+  the responder port with RDM. The number of packets per second is reported in
+  simulated time and in real time, so the program may be used to profile the
+  DMX driver with tools such as perf and valgrind.
+
+  Then a growing number of virtual RDM responders are connected to a separate
+  simulated DMX bus, each with its own DMX driver and responder task, and the
+  number of requests and the simulated bus time of RDM discovery are reported
+  for each number of responders. Discovery is run once with adjacent UIDs and
+  once with scattered UIDs and response latencies. The number of responders is
+  limited by CONFIG_DMX_HOST_PORT_NUM.
+
+  Build it with 'idf.py --preview set-target linux build' and run the built
+  program found in 'build/esp_dmx_host.elf'.
+
+  Note: this example is for use with the ESP-IDF. It will not work on Arduino!
+
+  https://github.com/someweisguy/esp_dmx
+
+*/
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "dmx/host.h"
+#include "esp_dmx.h"
+#include "esp_log.h"
+#include "freertos/task.h"
+#include "rdm/controller.h"
+#include "rdm/responder.h"
+
+#define PACKET_COUNT 10000    // The number of DMX packets which are sent.
+#define DISCOVERY_COUNT 100   // The number of times full discovery is run.
+#define SCALING_FIRST_PORT 3  // The first DMX port used as a virtual responder.
+
+static const char *TAG = "host";
+
+static const dmx_port_t controller_num = DMX_NUM_1;
+static const dmx_port_t responder_num = DMX_NUM_2;
+static const dmx_port_t scaling_num = DMX_NUM_0;
+
+static dmx_personality_t personalities[] = {{1, "Host"}};
+
+static int64_t get_real_time(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000000LL + ts.tv_nsec / 1000;
+}
+
+static void report(const char *name, uint32_t count, int64_t sim_us,
+                   int64_t real_us) {
+  ESP_LOGI(TAG,
+           "%s: %" PRIu32 " in %" PRIi64 " us simulated (%" PRIi64
+           "/s), %" PRIi64 " us real (%" PRIi64 "/s)",
+           name, count, sim_us, sim_us > 0 ? count * 1000000LL / sim_us : 0,
+           real_us, real_us > 0 ? count * 1000000LL / real_us : 0);
+}
+
+static void run_dmx(void) {
+  uint8_t data[DMX_PACKET_SIZE] = {DMX_SC};
+  uint32_t received = 0;
+
+  dmx_receive(responder_num, NULL, 0);  // Put the responder port in receive mode
+
+  const int64_t sim_start = dmx_host_get_time();
+  const int64_t real_start = get_real_time();
+  for (int i = 0; i < PACKET_COUNT; ++i) {
+    for (int j = 1; j < DMX_PACKET_SIZE; ++j) {
+      data[j] = i + j;
+    }
+    dmx_write(controller_num, data, DMX_PACKET_SIZE);
+    dmx_send(controller_num);
+
+    dmx_packet_t packet;
+    if (dmx_receive(responder_num, &packet, DMX_TIMEOUT_TICK) &&
+        packet.err == DMX_OK) {
+      ++received;
+    }
+    dmx_wait_sent(controller_num, DMX_TIMEOUT_TICK);
+  }
+  report("DMX packets", received, dmx_host_get_time() - sim_start,
+         get_real_time() - real_start);
+}
+
+static void responder_task(void *arg) {
+  const dmx_port_t dmx_num = (uintptr_t)arg;
+  dmx_packet_t packet;
+  while (true) {
+    if (dmx_receive(dmx_num, &packet, DMX_TIMEOUT_TICK) && packet.is_rdm) {
+      rdm_send_response(dmx_num);
+    }
+  }
+}
+
+static void run_rdm(void) {
+  uint32_t found = 0;
+
+  xTaskCreate(responder_task, "responder", 4096, (void *)(uintptr_t)responder_num,
+              uxTaskPriorityGet(NULL) + 1, NULL);
+
+  const int64_t sim_start = dmx_host_get_time();
+  const int64_t real_start = get_real_time();
+  for (int i = 0; i < DISCOVERY_COUNT; ++i) {
+    rdm_uid_t uid;
+    found += rdm_discover_devices_simple(controller_num, &uid, 1);
+  }
+  report("RDM discoveries", found, dmx_host_get_time() - sim_start,
+         get_real_time() - real_start);
+}
+
+// Counts the RDM requests sent by the controller, which each begin with a break
+static void on_slot_sent(dmx_port_t dmx_num, int64_t timestamp, int slot,
+                         void *context) {
+  if (slot == DMX_HOST_BREAK) {
+    ++*(uint32_t *)context;
+  }
+}
+
+static void on_device_found(dmx_port_t dmx_num, rdm_uid_t uid, int num_found,
+                            const rdm_disc_mute_t *mute, void *context) {}
+
+static void run_discovery(int num_responders, const char *uids) {
+  uint32_t requests = 0;
+  dmx_host_set_tap(scaling_num, on_slot_sent, &requests);
+  const int64_t sim_start = dmx_host_get_time();
+  const int64_t real_start = get_real_time();
+  const int found =
+      rdm_discover_with_callback(scaling_num, on_device_found, NULL);
+  const int64_t sim_us = dmx_host_get_time() - sim_start;
+  const int64_t real_us = get_real_time() - real_start;
+  dmx_host_set_tap(scaling_num, NULL, NULL);
+
+  ESP_LOGI(TAG,
+           "%s UIDs: %i of %i responders found with %" PRIu32
+           " requests in %" PRIi64 " us simulated, %" PRIi64 " us real",
+           uids, found, num_responders, requests, sim_us, real_us);
+}
+
+static void run_discovery_scaling(void) {
+  int num_responders = 0;
+
+  dmx_config_t config = DMX_CONFIG_DEFAULT;
+  dmx_driver_install(scaling_num, &config, NULL, 0);
+
+  for (int n = 1; SCALING_FIRST_PORT + n <= DMX_NUM_MAX; n *= 2) {
+    // Install the virtual responders which are not yet installed
+    for (; num_responders < n; ++num_responders) {
+      const dmx_port_t dmx_num = SCALING_FIRST_PORT + num_responders;
+      dmx_driver_install(dmx_num, &config, personalities, 1);
+      dmx_host_connect(scaling_num, dmx_num);
+      xTaskCreate(responder_task, "responder", 4096, (void *)(uintptr_t)dmx_num,
+                  uxTaskPriorityGet(NULL) + 1, NULL);
+    }
+
+    // Each responder has a UID one greater than the responder before it
+    for (int i = 0; i < num_responders; ++i) {
+      const dmx_port_t dmx_num = SCALING_FIRST_PORT + i;
+      const rdm_uid_t uid = {.man_id = 0x05e0, .dev_id = 0x1000 + i};
+      dmx_host_set_uid(dmx_num, &uid);
+      dmx_host_set_latency(dmx_num, 0);
+    }
+    run_discovery(num_responders, "Adjacent");
+
+    // Scatter the UIDs and response latencies of the responders
+    uint32_t seed = 1;
+    for (int i = 0; i < num_responders; ++i) {
+      const dmx_port_t dmx_num = SCALING_FIRST_PORT + i;
+      seed = seed * 1664525 + 1013904223;
+      const rdm_uid_t uid = {.man_id = 0x05e0 + (seed >> 28),
+                             .dev_id = seed ^ (uint32_t)i};
+      dmx_host_set_uid(dmx_num, &uid);
+      dmx_host_set_latency(dmx_num, (seed >> 8) % 8);
+    }
+    run_discovery(num_responders, "Scattered");
+  }
+}
+
+void app_main() {
+  dmx_config_t config = DMX_CONFIG_DEFAULT;
+  dmx_driver_install(controller_num, &config, NULL, 0);
+  dmx_driver_install(responder_num, &config, personalities, 1);
+  dmx_host_connect(controller_num, responder_num);
+
+  ESP_LOGI(TAG, "Running esp_dmx " ESP_DMX_VERSION_LABEL " on the host");
+  run_dmx();
+  run_rdm();
+  run_discovery_scaling();
+  ESP_LOGI(TAG, "Done.");
+  exit(0);
+}
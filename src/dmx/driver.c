@@ -2,17 +2,24 @@
 
 #include <string.h>
 
+#include "./hal/include/dma.h"
 #include "./hal/include/gpio.h"
 #include "./hal/include/nvs.h"
 #include "./hal/include/timer.h"
 #include "./hal/include/uart.h"
 #include "./include/service.h"
+#include "./failover.h"
+#include "./fade.h"
+#include "./merge.h"
+#include "./recorder.h"
+#include "./repeater.h"
 #include "./sniffer.h"
 #include "endian.h"
+#include "../rdm/controller.h"
 #include "../rdm/include/types.h"
 #include "../rdm/responder/include/utils.h"
 
-#if ESP_IDF_VERSION_MAJOR >= 5
+#if ESP_IDF_VERSION_MAJOR >= 5 && !defined(CONFIG_IDF_TARGET_LINUX)
 #include "esp_mac.h"  // TODO: Make this hardware agnostic
 #endif
 
@@ -53,6 +60,21 @@ const char *TAG = "dmx";  // The log tagline for the library.
 
 dmx_driver_t *dmx_driver[DMX_NUM_MAX] = {};  // The DMX drivers for each port.
 
+#ifdef CONFIG_DMX_DRIVER_STATIC
+// The size of the storage of each DMX driver, rounded up so that each DMX driver is aligned
+#define DMX_DRIVER_STATIC_SIZE                                                                        \
+    ((sizeof(dmx_driver_t) + sizeof(dmx_parameter_t) * DMX_DRIVER_STATIC_PARAMETER_COUNT +             \
+      __alignof__(dmx_driver_t) - 1) &                                                                \
+     ~(__alignof__(dmx_driver_t) - 1))
+
+// The DMX drivers and their root device parameters
+static uint8_t dmx_driver_storage[DMX_NUM_MAX][DMX_DRIVER_STATIC_SIZE] __attribute__((aligned(__alignof__(dmx_driver_t))));
+
+// The DMX packet buffers and RDM buffer of each DMX driver, which are in internal RAM so that they are DMA-capable
+static uint8_t dmx_buffer_storage[DMX_NUM_MAX][DMX_BUFFER_COUNT + 1][DMX_PACKET_SIZE_MAX] __attribute__((aligned(4)));
+#endif
+
+#ifndef CONFIG_RDM_RESPONDER_DISABLE
 static void rdm_default_identify_cb(dmx_port_t dmx_num, rdm_header_t *request, rdm_header_t *response, void *context) {
     if (request->cc == RDM_CC_SET_COMMAND && request->sub_device == RDM_SUB_DEVICE_ROOT) {
         const uint8_t *identify = dmx_parameter_get_data(dmx_num, request->sub_device, RDM_PID_IDENTIFY_DEVICE);
@@ -63,6 +85,23 @@ static void rdm_default_identify_cb(dmx_port_t dmx_num, rdm_header_t *request, r
 #endif
     }
 }
+#endif
+
+static bool dmx_driver_init_isr(void *arg) {
+    dmx_driver_t *const driver = (dmx_driver_t *)arg;
+
+    if (!dmx_uart_init(driver->dmx_num, driver, driver->isr_flags)) {
+        DMX_ERR("UART init error");
+        return false;
+    }
+
+    if (!dmx_timer_init(driver->dmx_num, driver, driver->isr_flags)) {
+        DMX_ERR("timer init error");
+        return false;
+    }
+
+    return true;
+}
 
 bool dmx_driver_install(dmx_port_t dmx_num, const dmx_config_t *config, const dmx_personality_t *personalities,
                         int personality_count) {
@@ -79,7 +118,15 @@ bool dmx_driver_install(dmx_port_t dmx_num, const dmx_config_t *config, const dm
         }
     }
 
+    DMX_CHECK(config->interrupt_core >= DMX_INTR_CORE_DEFAULT && config->interrupt_core <= portNUM_PROCESSORS,
+              false, "interrupt_core error");
+    DMX_CHECK(config->interrupt_level >= 0 && config->interrupt_level <= 3, false, "interrupt_level error");
+
     int interrupt_flags = config->interrupt_flags;
+    if (config->interrupt_level > 0) {
+        interrupt_flags &= ~ESP_INTR_FLAG_LEVELMASK;
+        interrupt_flags |= ESP_INTR_FLAG_LEVEL1 << (config->interrupt_level - 1);
+    }
 #ifdef DMX_ISR_IN_IRAM
     // Driver ISR is in IRAM so interrupt flags must include IRAM flag
     if (!(interrupt_flags & ESP_INTR_FLAG_IRAM)) {
@@ -89,7 +136,11 @@ bool dmx_driver_install(dmx_port_t dmx_num, const dmx_config_t *config, const dm
 #endif
 
     // Ensure the parameter count is valid
+#ifdef CONFIG_RDM_RESPONDER_DISABLE
+    const int required_parameter_count = uses_dmx ? 3 : 0;  // Only the DMX parameters are registered
+#else
     const int required_parameter_count = uses_dmx ? 7 : 6;
+#endif
     int root_param_count               = config->root_device_parameter_count;
     if (root_param_count > 0 && root_param_count < required_parameter_count) {
         DMX_WARN(
@@ -99,15 +150,39 @@ bool dmx_driver_install(dmx_port_t dmx_num, const dmx_config_t *config, const dm
         root_param_count = required_parameter_count;
     }
 
-    // Initialize NVS
-    dmx_nvs_init(dmx_num);
+    // Drivers without root device parameters are controller-only and never answer RDM requests
+    const bool is_responder = (root_param_count > 0);
+
+    // Initialize NVS, which is only needed to store RDM parameters
+    if (is_responder || config->sub_device_parameter_count > 0) {
+        dmx_nvs_init(dmx_num);
+    }
 
-    // Allocate the DMX driver
+    // Allocate the DMX driver and its DMX packet buffers. Only the buffers are read by DMA.
+#ifdef CONFIG_DMX_DRIVER_STATIC
+    DMX_CHECK(root_param_count <= DMX_DRIVER_STATIC_PARAMETER_COUNT, false, "root_device_parameter_count error");
+    dmx_driver_t *driver = (dmx_driver_t *)dmx_driver_storage[dmx_num];
+    driver->dmx.buffer   = dmx_buffer_storage[dmx_num];
+#else
     const size_t driver_size = sizeof(dmx_driver_t) + (sizeof(dmx_parameter_t) * root_param_count);
     dmx_driver_t *driver     = heap_caps_malloc(driver_size, MALLOC_CAP_8BIT);
     DMX_CHECK(driver != NULL, false, "DMX driver malloc error");
-    dmx_driver[dmx_num] = driver;
-    driver->mux         = NULL;
+#ifdef CONFIG_DMX_UART_DMA
+    const uint32_t buffer_caps = MALLOC_CAP_8BIT | MALLOC_CAP_DMA;
+#else
+    const uint32_t buffer_caps = MALLOC_CAP_8BIT;
+#endif
+    driver->dmx.buffer = heap_caps_malloc((DMX_BUFFER_COUNT + 1) * DMX_PACKET_SIZE_MAX, buffer_caps);
+    if (driver->dmx.buffer == NULL) {
+        heap_caps_free(driver);
+        DMX_ERR("DMX buffer malloc error");
+        return false;
+    }
+#endif
+    dmx_driver[dmx_num]    = driver;
+    driver->mux            = NULL;
+    driver->dmx.rdm_buffer = driver->dmx.buffer[DMX_BUFFER_COUNT];
+    memset(&driver->device, 0, sizeof(driver->device));
 #ifdef DMX_USE_SPINLOCK
     driver->spinlock = (dmx_spinlock_t)DMX_SPINLOCK_INIT;
 #endif
@@ -124,56 +199,172 @@ bool dmx_driver_install(dmx_port_t dmx_num, const dmx_config_t *config, const dm
     driver->uid.man_id = RDM_UID_MANUFACTURER_ID;
 #if RDM_UID_DEVICE_ID == 0xffffffff
     // Set the device ID based on the device's MAC address
+#ifdef CONFIG_IDF_TARGET_LINUX
+    const uint8_t mac[8] = {0x02, 0x00, 0x00, 0x00, 0x00, 0x01};  // A locally administered address
+#else
     uint8_t mac[8];
     esp_efuse_mac_get_default(mac);
+#endif
     driver->uid.dev_id = bswap32(*(uint32_t *)(mac + 2));
 #else
     // Set the device ID based on what the user set in the kconfig
     driver->uid.dev_id = RDM_UID_DEVICE_UID;
 #endif
+#ifdef CONFIG_IDF_TARGET_LINUX
+    driver->uid.dev_id += dmx_num;  // The host may have more DMX ports than fit in the last octet
+#else
     *(uint8_t *)(&driver->uid.dev_id) += dmx_num;  // Increment last octect
+#endif
     driver->break_len = RDM_BREAK_LEN_US;
     driver->mab_len   = RDM_MAB_LEN_US;
 
     // Set the default values for the root device
-    driver->device.root.num  = RDM_SUB_DEVICE_ROOT;
-    driver->device.root.next = NULL;
-    for (int i = 0; i < config->root_device_parameter_count; ++i) {
+    driver->device.root.num = RDM_SUB_DEVICE_ROOT;
+    for (int i = 0; i < root_param_count; ++i) {
         driver->device.root.parameters[i].pid = 0;
     }
 
+    // Allocate the parameter table which is shared by every sub-device
+    if (config->sub_device_parameter_count > 0) {
+        const size_t table_size =
+            sizeof(dmx_device_t) + (sizeof(dmx_parameter_t) * config->sub_device_parameter_count);
+        driver->device.sub_devices.table = malloc(table_size);
+        if (driver->device.sub_devices.table == NULL) {
+            dmx_driver_delete(dmx_num);
+            DMX_CHECK(false, false, "DMX sub-device malloc error");
+        }
+        driver->device.sub_devices.table->num = RDM_SUB_DEVICE_ROOT + 1;
+        for (int i = 0; i < config->sub_device_parameter_count; ++i) {
+            driver->device.sub_devices.table->parameters[i].pid = 0;
+        }
+    }
+
     // Set the default values for the DMX device
-    driver->device.parameter_count.root        = config->root_device_parameter_count;
+    driver->device.parameter_count.root        = root_param_count;
     driver->device.parameter_count.sub_devices = config->sub_device_parameter_count;
     driver->device.parameter_count.staged      = 0;
+    driver->device.generation                  = 0;
+    driver->device.commit.task                 = NULL;
+    driver->device.commit.is_running           = false;
+    driver->device.commit.debounce             = 0;
+    driver->device.footprint.version           = 1;  // The footprint is looked up when it is first received
+    driver->device.footprint.cached_version    = 0;
+    driver->device.footprint.received_version  = 0;
+    driver->device.footprint.start_address     = 0;
+    driver->device.footprint.size              = 0;
     driver->is_controller                      = false;  // Assume false until dmx_send_num()
     driver->is_enabled                         = true;
 
     // Synchronization state
-    driver->task_waiting = NULL;
+    driver->task_waiting     = NULL;
+    driver->task_waiting_any = NULL;
+    for (int i = 0; i < DMX_SUBSCRIBER_MAX; ++i) {
+        driver->subscribers[i].cb      = NULL;
+        driver->subscribers[i].context = NULL;
+    }
+    memset(driver->filter.start_codes, 0xff, sizeof(driver->filter.start_codes));  // Accept every start code
+    driver->filter.is_rdm_filtered = false;
 
     // Data buffer
-    driver->dmx.head = DMX_HEAD_WAITING_FOR_BREAK;
-    driver->dmx.size = DMX_PACKET_SIZE_MAX;
-    memset(driver->dmx.data, 0, sizeof(driver->dmx.data));
-    driver->dmx.status                   = DMX_STATUS_IDLE;
-    driver->dmx.progress                 = DMX_PROGRESS_STALE;
-    driver->dmx.last_controller_pid      = 0;
-    driver->dmx.controller_eop_timestamp = 0;
-    driver->dmx.last_responder_pid       = 0;
-    driver->dmx.responder_sent_last      = false;
-    driver->dmx.last_request_pid         = 0;
-    driver->dmx.last_request_pid_repeats = 0;
+    driver->dmx.state      = DMX_STATE(DMX_STATUS_IDLE, DMX_PROGRESS_STALE, DMX_HEAD_WAITING_FOR_BREAK);
+    driver->dmx.size       = DMX_PACKET_SIZE_MAX;
+    driver->dmx.auto_size  = 0;
+    driver->dmx.high_water = 0;
+    driver->dmx.checksum   = 0;
+    memset(driver->dmx.buffer, 0, (DMX_BUFFER_COUNT + 1) * DMX_PACKET_SIZE_MAX);
+    driver->dmx.data   = driver->dmx.buffer[0];
+    driver->dmx.front  = driver->dmx.buffer[0];
+    driver->dmx.leased = NULL;
+    driver->dmx.staged = driver->dmx.buffer[DMX_BUFFER_COUNT - 1];
+    driver->dmx.is_staged       = false;
+    driver->dmx.staged_is_stale = false;
+    driver->dmx.staged_writers  = 0;
+    driver->dmx.rdm_saved       = NULL;
+#ifdef CONFIG_DMX_CHANGED_SLOTS
+    memset(driver->dmx.changed, 0, sizeof(driver->dmx.changed));
+    memset(driver->dmx.changed_pending, 0, sizeof(driver->dmx.changed_pending));
+    memset(driver->dmx.changed_last, 0, sizeof(driver->dmx.changed_last));
+#endif
+    driver->dmx.last_controller_pid       = 0;
+    driver->dmx.controller_eop_timestamp  = 0;
+    driver->dmx.responder_eop_timestamp   = 0;
+    driver->dmx.rx_sequence               = 0;
+    driver->dmx.rx_break_timestamp        = -1;
+    driver->dmx.rx_packet_break_timestamp = -1;
+    driver->dmx.rx_packet_timestamp       = -1;
+    driver->dmx.rx_packet_data            = NULL;
+    driver->dmx.response_timeout          = 0;
+    driver->dmx.last_responder_pid        = 0;
+    driver->dmx.responder_sent_last       = false;
+    driver->dmx.last_request_pid          = 0;
+    driver->dmx.last_request_pid_repeats  = 0;
+
+    // Runtime statistics
+    memset(&driver->stats, 0, sizeof(driver->stats));
+
+    // Continuous transmit configuration
+    driver->flags                      = 0;
+    driver->continuous.period          = 0;
+    driver->continuous.size            = DMX_PACKET_SIZE_MAX;
+    driver->continuous.is_paused       = false;
+    driver->continuous.break_timestamp = 0;
+
+    // Scheduled transmit
+    driver->send_at    = -1;
+    driver->send_group = 0;
 
     // RDM responder configuration
-    driver->rdm.tn = 0;
+    driver->rdm.tn           = 0;
+    driver->rdm.decoded.data = NULL;
+    memset(driver->rdm.deferred, 0, sizeof(driver->rdm.deferred));
+    driver->rdm.deferred_task = NULL;
+#ifndef CONFIG_RDM_RESPONDER_DISABLE
+    memset(&driver->rdm.fast_discovery, 0, sizeof(driver->rdm.fast_discovery));
+    memset(&driver->rdm.responder, 0, sizeof(driver->rdm.responder));
+    driver->rdm.virtuals = NULL;
+#endif
 
+    // RDM controller configuration
+#ifndef CONFIG_RDM_CONTROLLER_DISABLE
+    memset(driver->rdm.latency, 0, sizeof(driver->rdm.latency));
+    memset(&driver->rdm.controller, 0, sizeof(driver->rdm.controller));
+#endif
+
+#ifndef CONFIG_DMX_SNIFFER_DISABLE
     // DMX sniffer configuration
     driver->sniffer.is_enabled   = false;
     driver->sniffer.buffer_index = 0;
     // The driver->metadata field is left uninitialized
     driver->sniffer.last_pos_edge_ts = -1;
     driver->sniffer.last_neg_edge_ts = -1;
+    driver->sniffer.history          = NULL;
+    driver->sniffer.history_head     = 0;
+    driver->sniffer.history_tail     = 0;
+    driver->sniffer.history_overrun  = false;
+    driver->sniffer.last_break_ts    = -1;
+    driver->sniffer.flags            = 0;
+#endif
+
+    // DMX merge and fade configuration
+    driver->merge = NULL;
+    driver->fade  = NULL;
+
+    // DMX recorder and player configuration
+    driver->recorder          = NULL;
+    driver->player.task       = NULL;
+    driver->player.is_running = false;
+
+    // DMX repeater configuration
+    driver->repeater.outputs       = 0;
+    driver->repeater.input         = -1;
+    driver->repeater.forward_rdm   = false;
+    driver->repeater.is_skipping   = false;
+    driver->repeater.is_drained    = false;
+    driver->repeater.break_pending = false;
+    driver->repeater.size          = 0;
+
+    // DMX redundant input configuration
+    driver->failover = NULL;
 
     // Add the personality numbers to the DMX personalities
     rdm_dmx_personality_description_t *personality_description = (void *)personalities;
@@ -182,45 +373,58 @@ bool dmx_driver_install(dmx_port_t dmx_num, const dmx_config_t *config, const dm
         personality_description[i].personality_num = i + 1;
     }
 
-    // Register the default RDM parameters
-    rdm_register_disc_unique_branch(dmx_num, NULL, NULL);
-    rdm_register_disc_mute(dmx_num, NULL, NULL);
-    rdm_register_disc_un_mute(dmx_num, NULL, NULL);
-    rdm_register_device_info(dmx_num, config->model_id, config->product_category, config->software_version_id, NULL,
-                             NULL);
-    rdm_register_software_version_label(dmx_num, config->software_version_label, NULL, NULL);
-    rdm_register_identify_device(dmx_num, rdm_default_identify_cb, NULL);
+    if (is_responder) {
+#ifdef CONFIG_RDM_RESPONDER_DISABLE
+        // Only the DMX parameters are registered because the RDM responder is compiled out
+        if (uses_dmx > 0) {
+            rdm_register_dmx_start_address(dmx_num, NULL, NULL);
+            rdm_register_dmx_personality(dmx_num, personality_count, NULL, NULL);
+            rdm_register_dmx_personality_description(dmx_num, personality_description, personality_count, NULL, NULL);
+        }
+#else
+        // Register the default RDM parameters
+        rdm_register_disc_unique_branch(dmx_num, NULL, NULL);
+        rdm_register_disc_mute(dmx_num, NULL, NULL);
+        rdm_register_disc_un_mute(dmx_num, NULL, NULL);
+        rdm_register_device_info(dmx_num, config->model_id, config->product_category, config->software_version_id, NULL,
+                                 NULL);
+        rdm_register_software_version_label(dmx_num, config->software_version_label, NULL, NULL);
+        rdm_register_identify_device(dmx_num, rdm_default_identify_cb, NULL);
+
+        // The registration of DMX parameters is optional
+        if (uses_dmx > 0) {
+            rdm_register_dmx_start_address(dmx_num, NULL, NULL);
+        }
 
-    // The registration of DMX parameters is optional
-    if (uses_dmx > 0) {
-        rdm_register_dmx_start_address(dmx_num, NULL, NULL);
-    }
+        // Register additional RDM parameters
+        if (config->queue_size_max > 0) {
+            rdm_register_queued_message(dmx_num, config->queue_size_max, NULL, NULL);
+        }
+        rdm_register_manufacturer_label(dmx_num, RDM_MANUFACTURER_LABEL, NULL, NULL);
+        if (uses_dmx > 0) {
+            rdm_register_dmx_personality(dmx_num, personality_count, NULL, NULL);
+            rdm_register_dmx_personality_description(dmx_num, personality_description, personality_count, NULL, NULL);
+        }
+        const char *default_device_label = "";
+        rdm_register_device_label(dmx_num, default_device_label, NULL, NULL);
+        rdm_register_supported_parameters(dmx_num, NULL, NULL);
+        rdm_register_parameter_description(dmx_num, NULL, NULL);
+#endif
 
-    // Register additional RDM parameters
-    if (config->queue_size_max > 0) {
-        rdm_register_queued_message(dmx_num, config->queue_size_max, NULL, NULL);
+        // Persist any parameters which were not yet stored in the parameter image
+        dmx_nvs_sync(dmx_num);
     }
-    rdm_register_manufacturer_label(dmx_num, RDM_MANUFACTURER_LABEL, NULL, NULL);
-    if (uses_dmx > 0) {
-        rdm_register_dmx_personality(dmx_num, personality_count, NULL, NULL);
-        rdm_register_dmx_personality_description(dmx_num, personality_description, personality_count, NULL, NULL);
-    }
-    const char *default_device_label = "";
-    rdm_register_device_label(dmx_num, default_device_label, NULL, NULL);
-    rdm_register_supported_parameters(dmx_num, NULL, NULL);
-    rdm_register_parameter_description(dmx_num, NULL, NULL);
 
-    // Initialize the UART peripheral
-    if (!dmx_uart_init(dmx_num, driver, interrupt_flags)) {
+    // Initialize the UART and timer peripherals on the DMX interrupt core
+    driver->isr_core  = config->interrupt_core - DMX_INTR_CORE_0;  // -1 if DMX_INTR_CORE_DEFAULT
+    driver->isr_flags = interrupt_flags;
+    if (!dmx_call_on_core(driver->isr_core, dmx_driver_init_isr, driver)) {
         dmx_driver_delete(dmx_num);
-        DMX_CHECK(false, false, "UART init error");
+        return false;
     }
 
-    // Initialize the timer peripheral
-    if (!dmx_timer_init(dmx_num, driver, interrupt_flags)) {
-        dmx_driver_delete(dmx_num);
-        DMX_CHECK(false, false, "timer init error");
-    }
+    // Attempt to transmit using DMA - falls back to the UART FIFO on failure
+    dmx_dma_init(dmx_num);
 
     // Enable reading on the DMX port
     taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
@@ -240,6 +444,51 @@ bool dmx_driver_delete(dmx_port_t dmx_num) {
 
     dmx_driver_t *const driver = dmx_driver[dmx_num];
 
+#ifndef CONFIG_RDM_RESPONDER_DISABLE
+    // Stop the RDM responder service task, which holds the mutex while it waits
+    if (!rdm_responder_stop(dmx_num)) {
+        return false;
+    }
+#endif
+
+#ifndef CONFIG_RDM_CONTROLLER_DISABLE
+    // Stop the RDM bus scheduler task, which takes the mutex for each packet
+    if (!rdm_controller_stop(dmx_num)) {
+        return false;
+    }
+    rdm_controller_cache_enable(dmx_num, 0);  // Free the cached RDM responses
+#endif
+
+    // Stop the deferred RDM work task, which may call back into the driver
+    if (!rdm_deferred_stop(dmx_num)) {
+        return false;
+    }
+
+    // Stop the parameter commit task, which commits any staged parameters before it exits
+    if (!dmx_parameter_commit_stop(dmx_num)) {
+        return false;
+    }
+
+    // Stop repeating packets out of this port and stop the ports which repeat it
+    if (dmx_repeater_is_running(dmx_num)) {
+        dmx_repeater_stop(dmx_num);
+    }
+    for (int i = 0; i < DMX_NUM_MAX; ++i) {
+        if (driver->repeater.outputs & (1u << i)) {
+            dmx_repeater_stop(i);
+        }
+    }
+
+    // Stop the redundant input which this port is a part of
+    if (driver->failover != NULL) {
+        dmx_failover_stop(dmx_num);
+    }
+
+    // Stop the player task, which takes the mutex for each packet
+    if (!dmx_player_stop(dmx_num)) {
+        return false;
+    }
+
     // Take the mutex
     if (!xSemaphoreTakeRecursive(driver->mux, 0)) {
         return false;
@@ -251,38 +500,77 @@ bool dmx_driver_delete(dmx_port_t dmx_num) {
         dmx_sniffer_disable(dmx_num);
     }
 
+    // Free the merge stage and its sources
+    if (dmx_merge_is_enabled(dmx_num)) {
+        dmx_merge_disable(dmx_num);
+    }
+
+    // Free the fade engine
+    if (dmx_fade_is_enabled(dmx_num)) {
+        dmx_fade_disable(dmx_num);
+    }
+
+    // Stop recording and free the recorder
+    if (dmx_recorder_is_running(dmx_num)) {
+        dmx_recorder_stop(dmx_num);
+    }
+
     // Free hardware timer ISR
     dmx_timer_deinit(dmx_num);
 
+    // Release DMA peripherals
+    dmx_dma_deinit(dmx_num);
+
     // Disable UART module
     dmx_uart_deinit(dmx_num);
 
-    // Free parameters
-    dmx_device_t *device = &driver->device.root;
-    do {
-        int param_count = device->num == RDM_SUB_DEVICE_ROOT ? driver->device.parameter_count.root
-                                                             : driver->device.parameter_count.sub_devices;
-        for (int i = 0; i < param_count; ++i) {
-            if (device->parameters[i].pid == 0) {
-                break;  // No more parameters remaining
-            } else if (device->parameters[i].type != DMX_PARAMETER_TYPE_DYNAMIC) {
-                continue;  // Nothing to free
-            }
-            free(device->parameters[i].data);
+#ifndef CONFIG_RDM_RESPONDER_DISABLE
+    // Free the RDM responder queue
+    if (driver->rdm.responder.frames != NULL) {
+        vQueueDelete(driver->rdm.responder.frames);
+    }
+
+    // Free the virtual RDM responders
+    if (driver->rdm.virtuals != NULL) {
+        for (int i = 0; i < driver->rdm.virtuals->count; ++i) {
+            free(driver->rdm.virtuals->responders[i].root);
         }
-        device = device->next;
-    } while (device != NULL);
+        free(driver->rdm.virtuals);
+    }
+#endif
 
-    // Free devices
-    device = driver->device.root.next;  // Can't free root device
-    while (device != NULL) {
-        dmx_device_t *next_device = device->next;
-        free(device);
-        device = next_device;
+#ifndef CONFIG_RDM_CONTROLLER_DISABLE
+    // Free the RDM bus scheduler queue and asynchronous requests
+    if (driver->rdm.controller.jobs != NULL) {
+        vQueueDelete(driver->rdm.controller.jobs);
+    }
+    free(driver->rdm.controller.async_jobs);
+#endif
+
+    // Free the parameter arena
+    while (driver->device.arena != NULL) {
+        dmx_parameter_chunk_t *const chunk = driver->device.arena;
+        driver->device.arena               = chunk->next;
+        free(chunk);
     }
 
+    // Free sub-devices
+    for (int i = 0; i < DMX_SUB_DEVICE_PAGE_COUNT; ++i) {
+        if (driver->device.sub_devices.pages[i] == NULL) {
+            continue;
+        }
+        for (int j = 0; j < DMX_SUB_DEVICE_PAGE_SIZE; ++j) {
+            free(driver->device.sub_devices.pages[i][j]);
+        }
+        free(driver->device.sub_devices.pages[i]);
+    }
+    free(driver->device.sub_devices.table);
+
     // Free driver
+#ifndef CONFIG_DMX_DRIVER_STATIC
+    heap_caps_free(driver->dmx.buffer);
     heap_caps_free(driver);
+#endif
     dmx_driver[dmx_num] = NULL;
 
     // Free driver mutex
@@ -302,7 +590,8 @@ bool dmx_driver_disable(dmx_port_t dmx_num) {
     // Disable receive interrupts
     bool ret = false;
     taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
-    if (driver->dmx.status != DMX_STATUS_SENDING) {
+    const int dmx_status = DMX_STATE_STATUS(DMX_STATE_LOAD(driver));
+    if (dmx_status != DMX_STATUS_SENDING && dmx_status != DMX_STATUS_ARMED) {
         dmx_uart_disable_interrupt(dmx_num, DMX_INTR_RX_ALL);
         dmx_uart_clear_interrupt(dmx_num, DMX_INTR_RX_ALL);
         driver->is_enabled = false;
@@ -322,7 +611,7 @@ bool dmx_driver_enable(dmx_port_t dmx_num) {
 
     // Initialize driver flags and reenable interrupts
     taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
-    driver->dmx.head   = -1;  // Wait for DMX break before reading data
+    dmx_state_set_head(dmx_num, DMX_HEAD_WAITING_FOR_BREAK);  // Wait for DMX break before reading data
     driver->is_enabled = true;
     dmx_uart_rxfifo_reset(dmx_num);
     dmx_uart_txfifo_reset(dmx_num);
@@ -448,6 +737,92 @@ uint32_t dmx_set_mab_len(dmx_port_t dmx_num, uint32_t mab_len) {
     return mab_len;
 }
 
+size_t dmx_get_auto_size(dmx_port_t dmx_num) {
+    DMX_CHECK(dmx_num < DMX_NUM_MAX, 0, "dmx_num error");
+    DMX_CHECK(dmx_driver_is_installed(dmx_num), 0, "driver is not installed");
+
+    size_t auto_size;
+    taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+    auto_size = dmx_driver[dmx_num]->dmx.auto_size;
+    taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+
+    return auto_size;
+}
+
+size_t dmx_set_auto_size(dmx_port_t dmx_num, size_t min_size) {
+    DMX_CHECK(dmx_num < DMX_NUM_MAX, 0, "dmx_num error");
+    DMX_CHECK(dmx_driver_is_installed(dmx_num), 0, "driver is not installed");
+
+    // Clamp the minimum size to the maximum DMX packet size
+    if (min_size > DMX_PACKET_SIZE_MAX) {
+        min_size = DMX_PACKET_SIZE_MAX;
+    }
+
+    // The highest written slot is tracked from now on
+    taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+    dmx_driver[dmx_num]->dmx.auto_size  = min_size;
+    dmx_driver[dmx_num]->dmx.high_water = 0;
+    taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+
+    return min_size;
+}
+
+bool dmx_get_stats(dmx_port_t dmx_num, dmx_stats_t *stats) {
+    DMX_CHECK(dmx_num < DMX_NUM_MAX, false, "dmx_num error");
+    DMX_CHECK(stats != NULL, false, "stats is null");
+    DMX_CHECK(dmx_driver_is_installed(dmx_num), false, "driver is not installed");
+
+    dmx_driver_t *const driver = dmx_driver[dmx_num];
+
+    struct dmx_driver_stats_t snapshot;
+    taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+    snapshot = driver->stats;
+    taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+
+    // ISR execution times are measured in CPU cycles and are converted to microseconds when they are read
+    const uint64_t isr_avg     = snapshot.isr_count > 0 ? snapshot.isr_total / snapshot.isr_count : 0;
+    stats->packets_received    = snapshot.packets_received;
+    stats->packets_sent        = snapshot.packets_sent;
+    stats->uart_overflows      = snapshot.uart_overflows;
+    stats->improper_slots      = snapshot.improper_slots;
+    stats->not_enough_slots    = snapshot.not_enough_slots;
+    stats->rdm_checksum_errors = snapshot.rdm_checksum_errors;
+    stats->packets_filtered    = snapshot.packets_filtered;
+    stats->refresh_hz          = snapshot.packet_period > 0 ? 1000000 / snapshot.packet_period : 0;
+    stats->isr_min_us          = dmx_timer_cycles_to_micros(snapshot.isr_min);
+    stats->isr_avg_us          = dmx_timer_cycles_to_micros(isr_avg);
+    stats->isr_max_us          = dmx_timer_cycles_to_micros(snapshot.isr_max);
+    stats->isr_count           = snapshot.isr_count;
+    stats->isr_total_us        = dmx_timer_cycles_to_micros(snapshot.isr_total);
+
+    return true;
+}
+
+bool dmx_reset_stats(dmx_port_t dmx_num) {
+    DMX_CHECK(dmx_num < DMX_NUM_MAX, false, "dmx_num error");
+    DMX_CHECK(dmx_driver_is_installed(dmx_num), false, "driver is not installed");
+
+    dmx_driver_t *const driver = dmx_driver[dmx_num];
+
+    taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+    memset(&driver->stats, 0, sizeof(driver->stats));
+    taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+
+    return true;
+}
+
 const rdm_uid_t *rdm_uid_get(dmx_port_t dmx_num) {
-    return dmx_driver_is_installed(dmx_num) ? &dmx_driver[dmx_num]->uid : NULL;
+    if (!dmx_driver_is_installed(dmx_num)) {
+        return NULL;
+    }
+
+#ifndef CONFIG_RDM_RESPONDER_DISABLE
+    // Responses are sent from the UID of the virtual responder which is handling the request
+    const struct dmx_driver_virtual_responder_t *const responder = rdm_virtual_get_active(dmx_num);
+    if (responder != NULL) {
+        return &responder->uid;
+    }
+#endif
+
+    return &dmx_driver[dmx_num]->uid;
 }
@@ -0,0 +1,244 @@
+#include "fade.h"
+
+#include <string.h>
+
+#include "./hal/include/timer.h"
+#include "./include/driver.h"
+#include "./include/service.h"
+#include "esp_heap_caps.h"
+
+#define DMX_FADE_DURATION_MAX (UINT32_MAX)  // The longest fade in microseconds.
+
+typedef struct dmx_fade_t {
+    struct dmx_fade_range_t {
+        int64_t start;       // The timestamp in microseconds at which the fade started.
+        uint32_t duration;   // The duration of the fade in microseconds.
+        uint32_t rate;       // The 16.16 fixed-point progress of the fade per microsecond, scaled by 65536.
+        uint16_t first;      // The first slot of the fade.
+        uint16_t last;       // The last slot of the fade.
+        uint16_t slot_count;  // The number of slots which have not been taken over by a newer fade.
+    } ranges[DMX_FADE_MAX];
+    int active_count;                    // The number of fades which are running.
+    uint32_t users;                      // The number of callers which are using the fade engine.
+    uint8_t index[DMX_PACKET_SIZE_MAX];  // The fade of each slot, plus one, or 0 if the slot is not fading.
+    uint8_t from[DMX_PACKET_SIZE_MAX];   // The value of each slot when its fade started.
+    uint8_t to[DMX_PACKET_SIZE_MAX];     // The target value of each slot.
+} dmx_fade_t;
+
+static void DMX_ISR_ATTR dmx_fade_release_slot(dmx_fade_t *fade, int slot) {
+    const int i = fade->index[slot] - 1;
+    assert(i >= 0);
+    fade->index[slot] = 0;
+    if (--fade->ranges[i].slot_count == 0) {
+        --fade->active_count;
+    }
+}
+
+void DMX_ISR_ATTR dmx_fade_apply(dmx_port_t dmx_num, int64_t now) {
+    dmx_driver_t *const driver = dmx_driver[dmx_num];
+    dmx_fade_t *const fade     = driver->fade;
+    if (fade == NULL || fade->active_count == 0 || dmx_start_code_is_rdm(driver->dmx.data[0])) {
+        return;
+    }
+
+    uint8_t *const data   = driver->dmx.data;
+    uint8_t *const staged = driver->dmx.staged;
+    for (int i = 0; i < DMX_FADE_MAX; ++i) {
+        struct dmx_fade_range_t *const range = &fade->ranges[i];
+        if (range->slot_count == 0) {
+            continue;
+        }
+
+        // Slots which were taken over by a newer fade are skipped
+        const int64_t elapsed = now - range->start;
+        if (elapsed >= range->duration) {
+            for (int slot = range->first; slot <= range->last; ++slot) {
+                if (fade->index[slot] == i + 1) {
+                    // The final value is staged too so that it is kept when the next packet is committed
+                    data[slot]   = fade->to[slot];
+                    staged[slot] = fade->to[slot];
+                    dmx_fade_release_slot(fade, slot);
+                }
+            }
+        } else {
+            const uint32_t progress = ((uint64_t)(elapsed > 0 ? elapsed : 0) * range->rate) >> 16;  // 0.16 fixed-point
+            for (int slot = range->first; slot <= range->last; ++slot) {
+                if (fade->index[slot] == i + 1) {
+                    const int32_t difference = fade->to[slot] - fade->from[slot];
+                    data[slot]               = fade->from[slot] + ((difference * (int32_t)progress) >> 16);
+                }
+            }
+        }
+    }
+}
+
+static dmx_fade_t *dmx_fade_get(dmx_port_t dmx_num) {
+    dmx_driver_t *const driver = dmx_driver[dmx_num];
+
+    // The fade engine is held by its users so that it is not freed by dmx_fade_disable() while it is used
+    dmx_fade_t *fade;
+    taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+    fade = driver->fade;
+    if (fade != NULL) {
+        __atomic_fetch_add(&fade->users, 1, __ATOMIC_ACQUIRE);
+    }
+    taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+
+    return fade;
+}
+
+static void dmx_fade_put(dmx_fade_t *fade) { __atomic_fetch_sub(&fade->users, 1, __ATOMIC_RELEASE); }
+
+bool dmx_fade_enable(dmx_port_t dmx_num) {
+    DMX_CHECK(dmx_num < DMX_NUM_MAX, false, "dmx_num error");
+    DMX_CHECK(dmx_driver_is_installed(dmx_num), false, "driver is not installed");
+    DMX_CHECK(!dmx_fade_is_enabled(dmx_num), false, "fade is already enabled");
+
+    dmx_driver_t *const driver = dmx_driver[dmx_num];
+
+    // The fade engine is used by the DMX ISR so it must not be placed in external RAM
+    dmx_fade_t *const fade = heap_caps_calloc(1, sizeof(dmx_fade_t), MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    DMX_CHECK(fade != NULL, false, "fade malloc error");
+
+    taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+    driver->fade = fade;
+    taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+
+    return true;
+}
+
+bool dmx_fade_disable(dmx_port_t dmx_num) {
+    DMX_CHECK(dmx_num < DMX_NUM_MAX, false, "dmx_num error");
+    DMX_CHECK(dmx_driver_is_installed(dmx_num), false, "driver is not installed");
+
+    dmx_driver_t *const driver = dmx_driver[dmx_num];
+
+    dmx_fade_t *fade;
+    taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+    fade         = driver->fade;
+    driver->fade = NULL;
+    taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+    if (fade == NULL) {
+        return false;
+    }
+
+    // Wait for every user to leave the fade engine before freeing it
+    while (__atomic_load_n(&fade->users, __ATOMIC_ACQUIRE) > 0) {
+        vTaskDelay(1);
+    }
+    heap_caps_free(fade);
+
+    return true;
+}
+
+bool dmx_fade_is_enabled(dmx_port_t dmx_num) {
+    DMX_CHECK(dmx_num < DMX_NUM_MAX, false, "dmx_num error");
+    DMX_CHECK(dmx_driver_is_installed(dmx_num), false, "driver is not installed");
+
+    return dmx_driver[dmx_num]->fade != NULL;
+}
+
+size_t dmx_fade_to(dmx_port_t dmx_num, size_t offset, const uint8_t *targets, size_t size, uint32_t fade_ms) {
+    DMX_CHECK(dmx_num < DMX_NUM_MAX, 0, "dmx_num error");
+    DMX_CHECK(offset > 0 && offset < DMX_PACKET_SIZE_MAX, 0, "offset error");
+    DMX_CHECK(targets != NULL, 0, "targets is null");
+    DMX_CHECK(dmx_driver_is_installed(dmx_num), 0, "driver is not installed");
+
+    // Clamp size to the maximum DMX packet size
+    if (size + offset > DMX_PACKET_SIZE_MAX) {
+        size = DMX_PACKET_SIZE_MAX - offset;
+    } else if (size == 0) {
+        return 0;
+    }
+
+    dmx_driver_t *const driver = dmx_driver[dmx_num];
+    dmx_fade_t *const fade     = dmx_fade_get(dmx_num);
+    DMX_CHECK(fade != NULL, 0, "fade is not enabled");
+
+    // Compute the fixed-point rate of the fade outside of the critical section
+    uint64_t duration = (uint64_t)fade_ms * 1000;
+    if (duration == 0) {
+        duration = 1;  // The fade finishes in the next packet
+    } else if (duration > DMX_FADE_DURATION_MAX) {
+        duration = DMX_FADE_DURATION_MAX;
+    }
+    const uint32_t rate = duration > 1 ? (1ull << 32) / duration : UINT32_MAX;
+
+    taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+    int i;
+    for (i = 0; i < DMX_FADE_MAX; ++i) {
+        if (fade->ranges[i].slot_count == 0) {
+            break;
+        }
+    }
+    if (i < DMX_FADE_MAX) {
+        struct dmx_fade_range_t *const range = &fade->ranges[i];
+        const uint8_t *const sent = driver->dmx.rdm_saved != NULL ? driver->dmx.rdm_saved : driver->dmx.data;
+        for (size_t slot = offset; slot < offset + size; ++slot) {
+            if (fade->index[slot] != 0) {
+                dmx_fade_release_slot(fade, slot);  // The newer fade takes over the slot
+            }
+            fade->index[slot] = i + 1;
+            fade->from[slot]  = sent[slot];
+            fade->to[slot]    = targets[slot - offset];
+        }
+        range->start      = dmx_timer_get_micros_since_boot();
+        range->duration   = duration;
+        range->rate       = rate;
+        range->first      = offset;
+        range->last       = offset + size - 1;
+        range->slot_count = size;
+        ++fade->active_count;
+        if (offset + size > driver->dmx.high_water) {
+            driver->dmx.high_water = offset + size;
+        }
+    }
+    taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+    dmx_fade_put(fade);
+    DMX_CHECK(i < DMX_FADE_MAX, 0, "no more fades");
+
+    return size;
+}
+
+bool dmx_fade_stop(dmx_port_t dmx_num, size_t offset, size_t size) {
+    DMX_CHECK(dmx_num < DMX_NUM_MAX, false, "dmx_num error");
+    DMX_CHECK(offset < DMX_PACKET_SIZE_MAX, false, "offset error");
+    DMX_CHECK(dmx_driver_is_installed(dmx_num), false, "driver is not installed");
+
+    dmx_driver_t *const driver = dmx_driver[dmx_num];
+    dmx_fade_t *const fade     = dmx_fade_get(dmx_num);
+    DMX_CHECK(fade != NULL, false, "fade is not enabled");
+
+    // Clamp size to the maximum DMX packet size
+    if (size + offset > DMX_PACKET_SIZE_MAX) {
+        size = DMX_PACKET_SIZE_MAX - offset;
+    }
+
+    // Stopped slots are staged with the value they were last sent with so that it is kept
+    taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+    const uint8_t *const sent = driver->dmx.rdm_saved != NULL ? driver->dmx.rdm_saved : driver->dmx.data;
+    for (size_t slot = offset; slot < offset + size; ++slot) {
+        if (fade->index[slot] != 0) {
+            dmx_fade_release_slot(fade, slot);
+            driver->dmx.staged[slot] = sent[slot];
+        }
+    }
+    taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+    dmx_fade_put(fade);
+
+    return true;
+}
+
+bool dmx_fade_is_fading(dmx_port_t dmx_num) {
+    DMX_CHECK(dmx_num < DMX_NUM_MAX, false, "dmx_num error");
+    DMX_CHECK(dmx_driver_is_installed(dmx_num), false, "driver is not installed");
+
+    dmx_driver_t *const driver = dmx_driver[dmx_num];
+
+    bool is_fading;
+    taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+    is_fading = driver->fade != NULL && driver->fade->active_count > 0;
+    taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+
+    return is_fading;
+}
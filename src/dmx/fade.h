@@ -0,0 +1,91 @@
+/**
+ * @file dmx/fade.h
+ * @author Mitch Weisbrod (mitch@theweisbrods.com)
+ * @brief This file contains functions which allow DMX slots to be faded to new
+ * values by the DMX driver as DMX packets are sent.
+ */
+#pragma once
+
+#include "./include/types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @brief The maximum number of fades which may be running at once on a DMX
+ * port. Each call to dmx_fade_to() starts a fade.*/
+#define DMX_FADE_MAX (16)
+
+/**
+ * @brief Enables the fade engine of a DMX port. Once enabled, fades which are
+ * started with dmx_fade_to() are interpolated by the DMX driver just before
+ * the DMX break of each packet which is sent. Only the slots which are fading
+ * are computed.
+ *
+ * @param dmx_num The DMX port number.
+ * @return true if the fade engine was enabled.
+ * @return false on failure.
+ */
+bool dmx_fade_enable(dmx_port_t dmx_num);
+
+/**
+ * @brief Disables the fade engine of a DMX port. Slots which are fading keep
+ * the value which was last sent.
+ *
+ * @param dmx_num The DMX port number.
+ * @return true if the fade engine was disabled.
+ * @return false if it was not enabled.
+ */
+bool dmx_fade_disable(dmx_port_t dmx_num);
+
+/**
+ * @brief Checks if the fade engine of a DMX port is enabled.
+ *
+ * @param dmx_num The DMX port number.
+ * @return true if the fade engine is enabled.
+ * @return false if it is not.
+ */
+bool dmx_fade_is_enabled(dmx_port_t dmx_num);
+
+/**
+ * @brief Fades a range of DMX slots from their current values to target
+ * values. A slot which is already fading starts the new fade from the value
+ * it was last sent with. Slots which are written with dmx_write() while they
+ * are fading are overwritten by the fade.
+ *
+ * @param dmx_num The DMX port number.
+ * @param offset The first slot to fade. Slot 0 is the start code, which cannot
+ * be faded.
+ * @param[in] targets The target value of each slot.
+ * @param size The number of slots to fade.
+ * @param fade_ms The duration of the fade in milliseconds. If 0, the slots are
+ * set to their target values in the next packet.
+ * @return The number of slots which are fading.
+ */
+size_t dmx_fade_to(dmx_port_t dmx_num, size_t offset, const uint8_t *targets,
+                   size_t size, uint32_t fade_ms);
+
+/**
+ * @brief Stops fading a range of DMX slots. The slots keep the value which
+ * they were last sent with.
+ *
+ * @param dmx_num The DMX port number.
+ * @param offset The first slot to stop fading.
+ * @param size The number of slots to stop fading.
+ * @return true if the fades were stopped.
+ * @return false on failure.
+ */
+bool dmx_fade_stop(dmx_port_t dmx_num, size_t offset, size_t size);
+
+/**
+ * @brief Checks if any slots are fading on a DMX port.
+ *
+ * @param dmx_num The DMX port number.
+ * @return true if a fade is running.
+ * @return false if no fade is running.
+ */
+bool dmx_fade_is_fading(dmx_port_t dmx_num);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,345 @@
+#include "failover.h"
+
+#include <string.h>
+
+#include "./hal/include/timer.h"
+#include "./hal/include/uart.h"
+#include "./include/driver.h"
+#include "./include/service.h"
+
+// The packet period which is assumed before the period of a DMX port has been measured
+#define DMX_FAILOVER_PERIOD_DEFAULT_US (23000)
+// Gaps longer than the DMX loss-of-data time are never part of a packet stream
+#define DMX_FAILOVER_PERIOD_MAX_US (1000000)
+
+struct dmx_failover_t {
+    portMUX_TYPE spinlock;       // The spinlock which guards the redundant input.
+    uint32_t users;              // The number of callers and interrupts which are using the redundant input.
+    bool is_stopped;             // True once the redundant input has been detached from its DMX ports.
+    dmx_port_t ports[2];         // The primary and backup DMX ports.
+    dmx_failover_config_t config;  // The configuration of the redundant input.
+    struct dmx_failover_source_t {
+        int64_t last_ts;  // The timestamp of the last packet received on the DMX port, or 0.
+        int32_t period;   // The measured period of the packets received on the DMX port, or 0.
+        int streak;       // The number of consecutive packets received without the DMX port being lost.
+    } sources[2];
+    int active;                // The index of the active source, or -1 before any packet is received.
+    uint32_t switch_count;     // The number of times the active source has changed.
+    TaskHandle_t task_waiting;  // The task waiting in dmx_failover_receive(), or NULL.
+    bool is_new;               // True if the input holds a packet which has not been received.
+    bool is_holding;           // True if the last packet which was received was a held packet.
+    uint32_t sequence;         // The number of packets which have been copied into the input.
+    int64_t look_break_ts;     // The timestamp of the DMX break of the last packet which was copied into the input.
+    int64_t look_ts;           // The timestamp of the last packet which was copied into the input.
+    int32_t look_period;       // The period of the source of the last packet which was copied into the input.
+    int64_t output_ts;         // The timestamp at which a packet was last returned by dmx_failover_receive().
+    size_t size;               // The size of the last packet which was copied into the input.
+    uint8_t data[DMX_PACKET_SIZE_MAX];  // The last packet which was copied into the input.
+};
+
+static int32_t DMX_ISR_ATTR dmx_failover_get_loss_timeout(const struct dmx_failover_t *failover, int i) {
+    if (failover->config.loss_timeout > 0) {
+        return failover->config.loss_timeout;
+    }
+    const int32_t period = failover->sources[i].period > 0 ? failover->sources[i].period : DMX_FAILOVER_PERIOD_DEFAULT_US;
+    return period + period / 2;
+}
+
+static bool DMX_ISR_ATTR dmx_failover_is_lost(const struct dmx_failover_t *failover, int i, int64_t now) {
+    const int64_t last_ts = failover->sources[i].last_ts;
+    return last_ts == 0 || now - last_ts > dmx_failover_get_loss_timeout(failover, i);
+}
+
+DMX_ISR_ATTR struct dmx_failover_t *dmx_failover_get_isr(dmx_port_t dmx_num) {
+    struct dmx_failover_t *const failover = dmx_driver[dmx_num]->failover;
+    if (failover != NULL) {
+        __atomic_fetch_add(&failover->users, 1, __ATOMIC_ACQUIRE);
+    }
+    return failover;
+}
+
+bool DMX_ISR_ATTR dmx_failover_receive_isr(struct dmx_failover_t *failover, dmx_port_t dmx_num, int64_t now,
+                                           int64_t break_timestamp, const uint8_t *data, size_t size) {
+    const int i                                = (dmx_num == failover->ports[0]) ? 0 : 1;
+    struct dmx_failover_source_t *const source = &failover->sources[i];
+    BaseType_t task_awoken                     = pdFALSE;
+
+    taskENTER_CRITICAL_ISR(&failover->spinlock);
+
+    // Measure the packet period of the DMX port before deciding if it was lost
+    if (dmx_failover_is_lost(failover, i, now)) {
+        source->streak = 1;
+    } else {
+        ++source->streak;
+    }
+    if (source->last_ts > 0 && now - source->last_ts < DMX_FAILOVER_PERIOD_MAX_US) {
+        source->period = now - source->last_ts;
+    }
+    source->last_ts = now;
+
+    // Fail over to this port if the active source was lost, and return to the primary port once it is stable
+    const int active = failover->active;
+    if (active != i) {
+        if (active < 0 || dmx_failover_is_lost(failover, active, now) ||
+            (i == 0 && source->streak >= DMX_FAILOVER_RESTORE_COUNT)) {
+            failover->active = i;
+            if (active >= 0) {
+                ++failover->switch_count;
+            }
+        }
+    }
+
+    // Copy the packet into the redundant input
+    if (failover->active == i) {
+        memcpy(failover->data, data, size);
+        failover->size          = size;
+        ++failover->sequence;
+        failover->look_break_ts = break_timestamp;
+        failover->look_ts       = now;
+        failover->look_period   = source->period > 0 ? source->period : DMX_FAILOVER_PERIOD_DEFAULT_US;
+        failover->is_new        = true;
+        if (failover->task_waiting) {
+            xTaskNotifyFromISR(failover->task_waiting, DMX_OK, eNoAction, &task_awoken);
+        }
+    }
+
+    taskEXIT_CRITICAL_ISR(&failover->spinlock);
+
+    // The redundant input may be freed as soon as it is released
+    __atomic_fetch_sub(&failover->users, 1, __ATOMIC_RELEASE);
+
+    return task_awoken;
+}
+
+static struct dmx_failover_t *dmx_failover_get(dmx_port_t dmx_num) {
+    struct dmx_failover_t *failover;
+    taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+    failover = dmx_failover_get_isr(dmx_num);
+    taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+    return failover;
+}
+
+static void dmx_failover_put(struct dmx_failover_t *failover) {
+    __atomic_fetch_sub(&failover->users, 1, __ATOMIC_RELEASE);
+}
+
+static bool dmx_failover_listen(dmx_port_t dmx_num) {
+    dmx_driver_t *const driver = dmx_driver[dmx_num];
+
+    // Block until the mutex can be taken and the driver is done sending
+    xSemaphoreTakeRecursive(driver->mux, portMAX_DELAY);
+    if (!dmx_wait_sent(dmx_num, dmx_ms_to_ticks(23)) ||
+        DMX_STATE_STATUS(DMX_STATE_LOAD(driver)) == DMX_STATUS_ARMED) {
+        xSemaphoreGiveRecursive(driver->mux);
+        return false;
+    }
+
+    // Set the RTS pin to enable reading from the DMX bus
+    taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+    if (dmx_uart_get_rts(dmx_num) == 0) {
+        dmx_state_update(dmx_num, DMX_STATE_PROGRESS_MASK | DMX_STATE_HEAD_MASK,
+                         DMX_STATE(0, DMX_PROGRESS_STALE, DMX_HEAD_WAITING_FOR_BREAK));
+        dmx_uart_set_rts(dmx_num, 1);
+    }
+    driver->is_controller = false;
+    taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+
+    xSemaphoreGiveRecursive(driver->mux);
+    return true;
+}
+
+bool dmx_failover_start(dmx_port_t primary_num, dmx_port_t backup_num, const dmx_failover_config_t *config) {
+    DMX_CHECK(primary_num < DMX_NUM_MAX, false, "primary_num error");
+    DMX_CHECK(backup_num < DMX_NUM_MAX && backup_num != primary_num, false, "backup_num error");
+    DMX_CHECK(config != NULL, false, "config is null");
+    DMX_CHECK(dmx_driver_is_installed(primary_num), false, "primary driver is not installed");
+    DMX_CHECK(dmx_driver_is_installed(backup_num), false, "backup driver is not installed");
+    DMX_CHECK(dmx_driver_is_enabled(primary_num), false, "primary driver is not enabled");
+    DMX_CHECK(dmx_driver_is_enabled(backup_num), false, "backup driver is not enabled");
+
+    dmx_driver_t *const primary = dmx_driver[primary_num];
+    dmx_driver_t *const backup  = dmx_driver[backup_num];
+
+    DMX_CHECK(primary->failover == NULL && backup->failover == NULL, false, "port is already a redundant input");
+    DMX_CHECK(primary->repeater.input < 0 && backup->repeater.input < 0, false, "port is repeating");
+    DMX_CHECK(primary->continuous.period == 0 && backup->continuous.period == 0, false,
+              "port is sending continuously");
+
+    struct dmx_failover_t *failover = heap_caps_calloc(1, sizeof(*failover), MALLOC_CAP_8BIT);
+    DMX_CHECK(failover != NULL, false, "failover malloc error");
+    const portMUX_TYPE spinlock = DMX_SPINLOCK_INIT;
+    failover->spinlock          = spinlock;
+    failover->ports[0]          = primary_num;
+    failover->ports[1]          = backup_num;
+    failover->config            = *config;
+    failover->active            = -1;
+
+    if (!dmx_failover_listen(primary_num) || !dmx_failover_listen(backup_num)) {
+        heap_caps_free(failover);
+        DMX_CHECK(false, false, "driver is sending");
+    }
+
+    // The DMX interrupt begins copying packets as soon as the redundant input is assigned
+    taskENTER_CRITICAL(DMX_SPINLOCK(primary_num));
+    primary->failover = failover;
+    taskEXIT_CRITICAL(DMX_SPINLOCK(primary_num));
+    taskENTER_CRITICAL(DMX_SPINLOCK(backup_num));
+    backup->failover = failover;
+    taskEXIT_CRITICAL(DMX_SPINLOCK(backup_num));
+
+    return true;
+}
+
+bool dmx_failover_stop(dmx_port_t dmx_num) {
+    DMX_CHECK(dmx_num < DMX_NUM_MAX, false, "dmx_num error");
+    DMX_CHECK(dmx_driver_is_installed(dmx_num), false, "driver is not installed");
+
+    struct dmx_failover_t *const failover = dmx_driver[dmx_num]->failover;
+    if (failover == NULL) {
+        return false;
+    }
+
+    // Detach the redundant input from the DMX interrupt of each port before it is freed
+    for (int i = 0; i < 2; ++i) {
+        const dmx_port_t port_num = failover->ports[i];
+        taskENTER_CRITICAL(DMX_SPINLOCK(port_num));
+        dmx_driver[port_num]->failover = NULL;
+        taskEXIT_CRITICAL(DMX_SPINLOCK(port_num));
+    }
+
+    // Wake a task which is waiting for a packet and wait for every user to leave the redundant input
+    taskENTER_CRITICAL(&failover->spinlock);
+    failover->is_stopped = true;
+    taskEXIT_CRITICAL(&failover->spinlock);
+    while (__atomic_load_n(&failover->users, __ATOMIC_ACQUIRE) > 0) {
+        taskENTER_CRITICAL(&failover->spinlock);
+        const TaskHandle_t task_waiting = failover->task_waiting;
+        if (task_waiting != NULL) {
+            xTaskNotify(task_waiting, DMX_ERR_TIMEOUT, eNoAction);
+        }
+        taskEXIT_CRITICAL(&failover->spinlock);
+        vTaskDelay(1);
+    }
+    heap_caps_free(failover);
+
+    return true;
+}
+
+size_t dmx_failover_receive(dmx_port_t primary_num, void *destination, size_t size, dmx_packet_t *packet,
+                            TickType_t wait_ticks) {
+    DMX_CHECK(primary_num < DMX_NUM_MAX, 0, "primary_num error");
+    DMX_CHECK(destination != NULL, 0, "destination is null");
+    DMX_CHECK(dmx_driver_is_installed(primary_num), 0, "driver is not installed");
+
+    // The redundant input is held until this function returns so that it cannot be freed while it is used
+    struct dmx_failover_t *const failover = dmx_failover_get(primary_num);
+    DMX_CHECK(failover != NULL, 0, "port is not a redundant input");
+    if (failover->ports[0] != primary_num) {
+        dmx_failover_put(failover);
+        DMX_CHECK(false, 0, "port is not a redundant input");
+    }
+
+    size_t packet_size = 0;
+    const TaskHandle_t current_task_handle = xTaskGetCurrentTaskHandle();
+    TimeOut_t timeout;
+    vTaskSetTimeOutState(&timeout);
+    while (true) {
+        const int64_t now = dmx_timer_get_micros_since_boot();
+        TickType_t block_ticks = wait_ticks;
+
+        // Return a new packet, or the last packet again if both sources were lost and it is being held
+        bool is_ready;
+        taskENTER_CRITICAL(&failover->spinlock);
+        if (failover->is_stopped) {
+            taskEXIT_CRITICAL(&failover->spinlock);
+            break;
+        }
+        is_ready             = failover->is_new;
+        failover->is_holding = false;
+        if (!is_ready && failover->config.hold_time > 0 && failover->size > 0 &&
+            (failover->active < 0 || dmx_failover_is_lost(failover, failover->active, now)) &&
+            now - failover->look_ts < failover->config.hold_time) {
+            const int64_t next_ts = failover->output_ts + failover->look_period;
+            if (now >= next_ts) {
+                is_ready             = true;
+                failover->is_holding = true;
+            } else {
+                const TickType_t hold_ticks = dmx_ms_to_ticks((next_ts - now + 999) / 1000);
+                if (hold_ticks < block_ticks) {
+                    block_ticks = hold_ticks;
+                }
+            }
+        }
+        if (is_ready) {
+            packet_size = failover->size;
+            memcpy(destination, failover->data, packet_size < size ? packet_size : size);
+            failover->is_new    = false;
+            failover->output_ts = now;
+            if (packet != NULL) {
+                packet->err             = DMX_OK;
+                packet->sc              = failover->data[0];
+                packet->size            = packet_size;
+                packet->is_rdm          = false;
+                packet->sequence        = failover->sequence;  // A held packet repeats the sequence number
+                packet->break_timestamp = failover->look_break_ts;
+                packet->timestamp       = failover->look_ts;
+            }
+            taskEXIT_CRITICAL(&failover->spinlock);
+            break;
+        }
+        if (wait_ticks > 0) {
+            failover->task_waiting = current_task_handle;
+        }
+        taskEXIT_CRITICAL(&failover->spinlock);
+
+        if (wait_ticks == 0) {
+            break;
+        }
+
+        // Wait for the DMX interrupt to notify this task that a packet was copied into the input
+        xTaskNotifyWait(0, ULONG_MAX, NULL, block_ticks);
+        taskENTER_CRITICAL(&failover->spinlock);
+        failover->task_waiting = NULL;
+        taskEXIT_CRITICAL(&failover->spinlock);
+        if (xTaskCheckForTimeOut(&timeout, &wait_ticks)) {
+            wait_ticks = 0;  // Check for a packet one more time
+        }
+    }
+
+    dmx_failover_put(failover);  // The redundant input must not be accessed after it is released
+    if (packet_size > 0) {
+        return packet_size;
+    }
+
+    dmx_packet_set_timeout(packet);
+    return 0;
+}
+
+bool dmx_failover_get_status(dmx_port_t primary_num, dmx_failover_status_t *status) {
+    DMX_CHECK(primary_num < DMX_NUM_MAX, false, "primary_num error");
+    DMX_CHECK(status != NULL, false, "status is null");
+    DMX_CHECK(dmx_driver_is_installed(primary_num), false, "driver is not installed");
+
+    struct dmx_failover_t *const failover = dmx_failover_get(primary_num);
+    if (failover == NULL) {
+        return false;
+    } else if (failover->ports[0] != primary_num) {
+        dmx_failover_put(failover);
+        return false;
+    }
+
+    const int64_t now = dmx_timer_get_micros_since_boot();
+    taskENTER_CRITICAL(&failover->spinlock);
+    const int active = failover->active;
+    if (active >= 0 && !dmx_failover_is_lost(failover, active, now)) {
+        status->active = failover->ports[active];
+    } else {
+        status->active = DMX_NUM_MAX;
+    }
+    status->is_holding   = failover->is_holding;
+    status->switch_count = failover->switch_count;
+    taskEXIT_CRITICAL(&failover->spinlock);
+    dmx_failover_put(failover);
+
+    return true;
+}
@@ -0,0 +1,116 @@
+/**
+ * @file dmx/failover.h
+ * @author Mitch Weisbrod (mitch@theweisbrods.com)
+ * @brief This file contains functions which allow two DMX ports which receive
+ * the same universe from independent sources to be read as a single redundant
+ * input. The DMX interrupt of each port tracks the arrival of packets and the
+ * input fails over to the backup port as soon as the primary port stops
+ * receiving packets.
+ */
+#pragma once
+
+#include "./include/types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @brief The number of consecutive packets which must be received on the
+ * primary DMX port before the redundant input returns to it.*/
+#define DMX_FAILOVER_RESTORE_COUNT (8)
+
+/** @brief The configuration of a redundant input.*/
+typedef struct dmx_failover_config_t {
+  /** @brief The number of microseconds without a packet after which a DMX
+     port is considered lost. If 0, a DMX port is lost once no packet is
+     received for one and a half of its measured packet periods, so that the
+     input fails over within about one packet period.*/
+  uint32_t loss_timeout;
+  /** @brief The number of microseconds to keep repeating the last packet which
+     was received once both DMX ports have been lost. If 0, the last packet is
+     not repeated and dmx_failover_receive() times out instead.*/
+  uint32_t hold_time;
+} dmx_failover_config_t;
+
+/** @brief The status of a redundant input.*/
+typedef struct dmx_failover_status_t {
+  /** @brief The DMX port which is the active source of the input, or
+     DMX_NUM_MAX if both DMX ports have been lost.*/
+  dmx_port_t active;
+  /** @brief True if the last packet is being repeated because both DMX ports
+     have been lost.*/
+  bool is_holding;
+  /** @brief The number of times the active source has changed.*/
+  uint32_t switch_count;
+} dmx_failover_status_t;
+
+/**
+ * @brief Starts a redundant input on two DMX ports. Both DMX ports are put
+ * into receive mode. Each DMX packet which is received on the active source
+ * is copied by the DMX interrupt into the redundant input, so the switch from
+ * the primary port to the backup port happens on the first packet received by
+ * the backup port after the primary port is lost. The input returns to the
+ * primary port once DMX_FAILOVER_RESTORE_COUNT consecutive packets have been
+ * received on it. RDM packets are not part of the redundant input.
+ *
+ * @note dmx_receive() should not be called on either DMX port while the
+ * redundant input is running.
+ *
+ * @param primary_num The DMX port number of the preferred source. The
+ * redundant input is referred to by this port number.
+ * @param backup_num The DMX port number of the backup source.
+ * @param[in] config A pointer to the configuration of the redundant input.
+ * @return true if the redundant input was started.
+ * @return false on failure.
+ */
+bool dmx_failover_start(dmx_port_t primary_num, dmx_port_t backup_num,
+                        const dmx_failover_config_t *config);
+
+/**
+ * @brief Stops a redundant input. Either DMX port number of the redundant input
+ * may be used.
+ *
+ * @param dmx_num The DMX port number of either DMX port of the redundant input.
+ * @return true if the redundant input was stopped.
+ * @return false if the DMX port is not part of a redundant input.
+ */
+bool dmx_failover_stop(dmx_port_t dmx_num);
+
+/**
+ * @brief Receives a DMX packet from the active source of a redundant input and
+ * copies it into a buffer. If both DMX ports have been lost and a hold time is
+ * configured, the last packet is returned again once per packet period until
+ * the hold time expires.
+ *
+ * @note This function uses FreeRTOS direct-to-task notifications to block and
+ * unblock. Using task notifications on the same task that calls this function
+ * can lead to undesired behavior and program instability.
+ *
+ * @param primary_num The DMX port number of the primary DMX port.
+ * @param[out] destination A buffer into which the packet is copied, including
+ * its start code.
+ * @param size The size of the destination buffer.
+ * @param[out] packet An optional pointer to a dmx_packet_t which contains
+ * information about the received DMX packet.
+ * @param wait_ticks The number of ticks to wait before this function times out.
+ * @return The size of the received DMX packet or 0 if no packet was received.
+ */
+size_t dmx_failover_receive(dmx_port_t primary_num, void *destination,
+                            size_t size, dmx_packet_t *packet,
+                            TickType_t wait_ticks);
+
+/**
+ * @brief Gets the status of a redundant input.
+ *
+ * @param primary_num The DMX port number of the primary DMX port.
+ * @param[out] status A pointer into which to copy the status.
+ * @return true if the status was copied.
+ * @return false if the DMX port is not the primary DMX port of a redundant
+ * input.
+ */
+bool dmx_failover_get_status(dmx_port_t primary_num,
+                             dmx_failover_status_t *status);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,368 @@
+#include "gateway.h"
+
+#include <string.h>
+
+#include "./include/driver.h"
+#include "./include/service.h"
+
+#ifdef CONFIG_DMX_GATEWAY
+
+#include "lwip/igmp.h"
+#include "lwip/priv/tcpip_priv.h"
+#include "lwip/udp.h"
+
+#define DMX_GATEWAY_ARTNET_HEADER_SIZE (18)
+#define DMX_GATEWAY_ARTNET_OP_DMX      (0x5000)
+#define DMX_GATEWAY_SACN_HEADER_SIZE   (126)
+#define DMX_GATEWAY_SACN_UNIVERSE_MAX  (63999)
+#define DMX_GATEWAY_SACN_OPT_PREVIEW   (0x80)
+#define DMX_GATEWAY_SACN_OPT_TERMINATE (0x40)
+
+static struct dmx_gateway_t {
+    struct udp_pcb *pcb;              // The UDP control block which receives network packets.
+    dmx_gateway_protocol_t protocol;  // The network protocol which is received.
+    uint32_t refresh_hz;              // The refresh rate of the mapped DMX ports.
+    struct dmx_gateway_port_t {
+        bool is_mapped;      // True if a universe is mapped to the DMX port.
+        uint16_t universe;   // The universe which is mapped to the DMX port.
+        bool has_sequence;   // True once a sequence number was received on the universe.
+        uint8_t sequence;    // The last sequence number received on the universe.
+        uint32_t received;   // The number of packets written to the DMX port.
+        uint32_t discarded;  // The number of packets discarded because they were out of sequence.
+    } ports[DMX_NUM_MAX];
+} dmx_gateway = {};
+
+struct dmx_gateway_call_t {
+    struct tcpip_api_call_data call;  // Must be the first member so the call can be cast to this type.
+    dmx_port_t dmx_num;               // The DMX port number.
+    uint16_t universe;                // The universe to map.
+    bool success;                     // True if the call succeeded.
+};
+
+static uint16_t dmx_gateway_read_be16(const uint8_t *data) { return (data[0] << 8) | data[1]; }
+
+static bool dmx_gateway_is_in_sequence(struct dmx_gateway_port_t *port, uint8_t sequence) {
+    // Packets which are up to 20 sequence numbers older than the last packet are discarded as in E1.31
+    const int8_t difference = (int8_t)(sequence - port->sequence);
+    if (port->has_sequence && difference <= 0 && difference > -20) {
+        return false;
+    }
+    port->sequence     = sequence;
+    port->has_sequence = true;
+    return true;
+}
+
+static void dmx_gateway_write(dmx_port_t dmx_num, struct pbuf *p, size_t offset, size_t slot, size_t size) {
+    dmx_driver_t *const driver = dmx_driver[dmx_num];
+
+    // The staged buffer is not swapped until every writer has finished writing it
+    taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+    ++driver->dmx.staged_writers;
+    uint8_t *const staged = driver->dmx.staged;
+    if (driver->dmx.staged_is_stale) {
+        // Only the slots which are not in the network packet need to be synced with the last sent packet
+        const uint8_t *const sent = driver->dmx.rdm_saved != NULL ? driver->dmx.rdm_saved : driver->dmx.data;
+        const size_t end          = slot + size;
+        if (end < DMX_PACKET_SIZE_MAX) {
+            memcpy(staged + end, sent + end, DMX_PACKET_SIZE_MAX - end);
+        }
+        driver->dmx.staged_is_stale = false;
+    }
+    taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+
+    // Copy the network packet straight from the lwIP buffer into the staged buffer
+    if (slot > 0) {
+        staged[0] = DMX_SC;  // The network packet does not contain the start code
+    }
+    pbuf_copy_partial(p, staged + slot, size, offset);
+
+    taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+    --driver->dmx.staged_writers;
+    taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+
+    dmx_write_commit(dmx_num);
+}
+
+static void dmx_gateway_recv_artnet(struct pbuf *p) {
+    uint8_t header[DMX_GATEWAY_ARTNET_HEADER_SIZE];
+    if (pbuf_copy_partial(p, header, sizeof(header), 0) != sizeof(header) || memcmp(header, "Art-Net", 8) != 0 ||
+        (header[8] | (header[9] << 8)) != DMX_GATEWAY_ARTNET_OP_DMX) {
+        return;
+    }
+    const uint8_t sequence   = header[12];
+    const uint16_t universe  = ((header[15] & 0x7f) << 8) | header[14];
+    size_t size              = dmx_gateway_read_be16(&header[16]);
+    if (size > p->tot_len - sizeof(header)) {
+        size = p->tot_len - sizeof(header);
+    }
+    if (size > DMX_PACKET_SIZE_MAX - 1) {
+        size = DMX_PACKET_SIZE_MAX - 1;
+    }
+
+    for (int i = 0; i < DMX_NUM_MAX; ++i) {
+        struct dmx_gateway_port_t *const port = &dmx_gateway.ports[i];
+        if (!port->is_mapped || port->universe != universe) {
+            continue;
+        }
+
+        // A sequence number of 0 means that sequencing is disabled
+        if (sequence != 0 && !dmx_gateway_is_in_sequence(port, sequence)) {
+            ++port->discarded;
+            continue;
+        }
+
+        // ArtDmx packets contain only the DMX data slots without a start code
+        dmx_gateway_write(i, p, sizeof(header), 1, size);
+        ++port->received;
+    }
+}
+
+static void dmx_gateway_recv_sacn(struct pbuf *p) {
+    uint8_t header[DMX_GATEWAY_SACN_HEADER_SIZE];
+    if (pbuf_copy_partial(p, header, sizeof(header), 0) != sizeof(header) ||
+        memcmp(&header[4], "ASC-E1.17\0\0\0", 12) != 0 || header[21] != 0x04 || header[43] != 0x02 ||
+        header[117] != 0x02 || header[118] != 0xa1 || header[125] != DMX_SC) {
+        return;
+    }
+    const uint8_t options   = header[112];
+    const uint8_t sequence  = header[111];
+    const uint16_t universe = dmx_gateway_read_be16(&header[113]);
+    size_t size             = dmx_gateway_read_be16(&header[123]);  // Includes the start code
+    if (size > p->tot_len - (sizeof(header) - 1)) {
+        size = p->tot_len - (sizeof(header) - 1);
+    }
+    if (size > DMX_PACKET_SIZE_MAX) {
+        size = DMX_PACKET_SIZE_MAX;
+    }
+    if (size == 0 || (options & (DMX_GATEWAY_SACN_OPT_PREVIEW | DMX_GATEWAY_SACN_OPT_TERMINATE))) {
+        return;  // Preview data is not meant for live output and terminated streams hold their last look
+    }
+
+    for (int i = 0; i < DMX_NUM_MAX; ++i) {
+        struct dmx_gateway_port_t *const port = &dmx_gateway.ports[i];
+        if (!port->is_mapped || port->universe != universe) {
+            continue;
+        }
+
+        if (!dmx_gateway_is_in_sequence(port, sequence)) {
+            ++port->discarded;
+            continue;
+        }
+
+        dmx_gateway_write(i, p, sizeof(header) - 1, 0, size);
+        ++port->received;
+    }
+}
+
+static void dmx_gateway_recv(void *arg, struct udp_pcb *pcb, struct pbuf *p, const ip_addr_t *addr, u16_t port) {
+    if (dmx_gateway.protocol == DMX_GATEWAY_ARTNET) {
+        dmx_gateway_recv_artnet(p);
+    } else {
+        dmx_gateway_recv_sacn(p);
+    }
+    pbuf_free(p);
+}
+
+#if LWIP_IGMP
+static void dmx_gateway_set_multicast(uint16_t universe, bool join) {
+    // Each sACN universe is sent to its own multicast group
+    ip4_addr_t group;
+    IP4_ADDR(&group, 239, 255, universe >> 8, universe & 0xff);
+    if (join) {
+        igmp_joingroup(IP4_ADDR_ANY4, &group);
+    } else {
+        igmp_leavegroup(IP4_ADDR_ANY4, &group);
+    }
+}
+#endif
+
+static bool dmx_gateway_universe_is_mapped(uint16_t universe) {
+    for (int i = 0; i < DMX_NUM_MAX; ++i) {
+        if (dmx_gateway.ports[i].is_mapped && dmx_gateway.ports[i].universe == universe) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/* The gateway state is only modified in the lwIP TCP/IP task so that it never
+ changes while a network packet is being handled. */
+
+static err_t dmx_gateway_start_call(struct tcpip_api_call_data *arg) {
+    struct dmx_gateway_call_t *const call = (struct dmx_gateway_call_t *)arg;
+
+    struct udp_pcb *pcb = udp_new();
+    if (pcb == NULL) {
+        call->success = false;
+        return ERR_MEM;
+    }
+    const u16_t port = dmx_gateway.protocol == DMX_GATEWAY_ARTNET ? DMX_GATEWAY_ARTNET_PORT : DMX_GATEWAY_SACN_PORT;
+    if (udp_bind(pcb, IP_ANY_TYPE, port) != ERR_OK) {
+        udp_remove(pcb);
+        call->success = false;
+        return ERR_USE;
+    }
+    udp_recv(pcb, dmx_gateway_recv, NULL);
+    dmx_gateway.pcb = pcb;
+    call->success   = true;
+
+    return ERR_OK;
+}
+
+static err_t dmx_gateway_stop_call(struct tcpip_api_call_data *arg) {
+    struct dmx_gateway_call_t *const call = (struct dmx_gateway_call_t *)arg;
+
+    udp_remove(dmx_gateway.pcb);
+    dmx_gateway.pcb = NULL;
+    call->success   = true;
+
+    return ERR_OK;
+}
+
+static err_t dmx_gateway_map_call(struct tcpip_api_call_data *arg) {
+    struct dmx_gateway_call_t *const call = (struct dmx_gateway_call_t *)arg;
+    struct dmx_gateway_port_t *const port = &dmx_gateway.ports[call->dmx_num];
+
+    if (dmx_gateway.pcb == NULL) {
+        call->success = false;
+        return ERR_CONN;
+    }
+
+    const bool was_mapped           = port->is_mapped;
+    const uint16_t current_universe = port->universe;
+    port->is_mapped                 = false;
+#if LWIP_IGMP
+    if (dmx_gateway.protocol == DMX_GATEWAY_SACN) {
+        if (!dmx_gateway_universe_is_mapped(call->universe)) {
+            dmx_gateway_set_multicast(call->universe, true);
+        }
+        if (was_mapped && current_universe != call->universe && !dmx_gateway_universe_is_mapped(current_universe)) {
+            dmx_gateway_set_multicast(current_universe, false);
+        }
+    }
+#endif
+    port->universe     = call->universe;
+    port->has_sequence = false;
+    port->received     = 0;
+    port->discarded    = 0;
+    port->is_mapped    = true;
+    call->success      = true;
+
+    return ERR_OK;
+}
+
+static err_t dmx_gateway_unmap_call(struct tcpip_api_call_data *arg) {
+    struct dmx_gateway_call_t *const call = (struct dmx_gateway_call_t *)arg;
+    struct dmx_gateway_port_t *const port = &dmx_gateway.ports[call->dmx_num];
+
+    call->success = port->is_mapped;
+    if (port->is_mapped) {
+        port->is_mapped = false;
+#if LWIP_IGMP
+        if (dmx_gateway.protocol == DMX_GATEWAY_SACN && !dmx_gateway_universe_is_mapped(port->universe)) {
+            dmx_gateway_set_multicast(port->universe, false);
+        }
+#endif
+    }
+
+    return ERR_OK;
+}
+
+bool dmx_gateway_start(dmx_gateway_protocol_t protocol, uint32_t refresh_hz) {
+    DMX_CHECK(protocol == DMX_GATEWAY_ARTNET || protocol == DMX_GATEWAY_SACN, false, "protocol error");
+    DMX_CHECK(refresh_hz > 0 && refresh_hz <= DMX_REFRESH_HZ_MAX, false, "refresh_hz error");
+    DMX_CHECK(!dmx_gateway_is_running(), false, "gateway is already running");
+
+    dmx_gateway.protocol   = protocol;
+    dmx_gateway.refresh_hz = refresh_hz;
+
+    struct dmx_gateway_call_t call = {};
+    tcpip_api_call(dmx_gateway_start_call, &call.call);
+    DMX_CHECK(call.success, false, "gateway socket error");
+
+    return true;
+}
+
+bool dmx_gateway_stop() {
+    if (!dmx_gateway_is_running()) {
+        return false;
+    }
+
+    for (int i = 0; i < DMX_NUM_MAX; ++i) {
+        if (dmx_gateway.ports[i].is_mapped) {
+            dmx_gateway_unmap(i);
+        }
+    }
+
+    struct dmx_gateway_call_t call = {};
+    tcpip_api_call(dmx_gateway_stop_call, &call.call);
+
+    return call.success;
+}
+
+bool dmx_gateway_is_running() { return dmx_gateway.pcb != NULL; }
+
+bool dmx_gateway_map(dmx_port_t dmx_num, uint16_t universe) {
+    DMX_CHECK(dmx_num < DMX_NUM_MAX, false, "dmx_num error");
+    DMX_CHECK(dmx_driver_is_installed(dmx_num), false, "driver is not installed");
+    DMX_CHECK(dmx_gateway_is_running(), false, "gateway is not running");
+    DMX_CHECK(dmx_gateway.protocol != DMX_GATEWAY_SACN || (universe > 0 && universe <= DMX_GATEWAY_SACN_UNIVERSE_MAX),
+              false, "universe error");
+    DMX_CHECK(dmx_gateway.protocol != DMX_GATEWAY_ARTNET || universe <= 0x7fff, false, "universe error");
+
+    // Mapped DMX ports are refreshed by the DMX timer rather than by calls to dmx_send()
+    if (dmx_driver[dmx_num]->continuous.period == 0 && !dmx_start_continuous(dmx_num, dmx_gateway.refresh_hz, 0)) {
+        return false;
+    }
+
+    struct dmx_gateway_call_t call = {.dmx_num = dmx_num, .universe = universe};
+    tcpip_api_call(dmx_gateway_map_call, &call.call);
+
+    return call.success;
+}
+
+bool dmx_gateway_unmap(dmx_port_t dmx_num) {
+    DMX_CHECK(dmx_num < DMX_NUM_MAX, false, "dmx_num error");
+
+    struct dmx_gateway_call_t call = {.dmx_num = dmx_num};
+    tcpip_api_call(dmx_gateway_unmap_call, &call.call);
+    if (call.success && dmx_driver_is_installed(dmx_num)) {
+        dmx_stop_continuous(dmx_num);
+    }
+
+    return call.success;
+}
+
+bool dmx_gateway_get_stats(dmx_port_t dmx_num, uint32_t *received, uint32_t *discarded) {
+    DMX_CHECK(dmx_num < DMX_NUM_MAX, false, "dmx_num error");
+
+    const struct dmx_gateway_port_t *const port = &dmx_gateway.ports[dmx_num];
+    if (received != NULL) {
+        *received = port->received;
+    }
+    if (discarded != NULL) {
+        *discarded = port->discarded;
+    }
+
+    return port->is_mapped;
+}
+
+#else
+
+bool dmx_gateway_start(dmx_gateway_protocol_t protocol, uint32_t refresh_hz) {
+    DMX_CHECK(false, false, "CONFIG_DMX_GATEWAY is not enabled");
+}
+
+bool dmx_gateway_stop() { return false; }
+
+bool dmx_gateway_is_running() { return false; }
+
+bool dmx_gateway_map(dmx_port_t dmx_num, uint16_t universe) {
+    DMX_CHECK(false, false, "CONFIG_DMX_GATEWAY is not enabled");
+}
+
+bool dmx_gateway_unmap(dmx_port_t dmx_num) { return false; }
+
+bool dmx_gateway_get_stats(dmx_port_t dmx_num, uint32_t *received, uint32_t *discarded) { return false; }
+
+#endif
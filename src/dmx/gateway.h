@@ -0,0 +1,109 @@
+/**
+ * @file dmx/gateway.h
+ * @author Mitch Weisbrod (mitch@theweisbrods.com)
+ * @brief This file contains functions which allow DMX ports to be driven by
+ * Art-Net or sACN (E1.31) universes received over the network. The gateway is
+ * only available when CONFIG_DMX_GATEWAY is enabled.
+ */
+#pragma once
+
+#include "./include/types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @brief The UDP port on which Art-Net packets are received.*/
+#define DMX_GATEWAY_ARTNET_PORT (6454)
+
+/** @brief The UDP port on which sACN (E1.31) packets are received.*/
+#define DMX_GATEWAY_SACN_PORT (5568)
+
+/** @brief The default refresh rate at which mapped DMX ports are sent.*/
+#define DMX_GATEWAY_REFRESH_HZ_DEFAULT (40)
+
+/** @brief The network protocols which may be received by the DMX gateway.*/
+typedef enum dmx_gateway_protocol_t {
+  /** @brief Receive ArtDmx packets. Universes are 15-bit Art-Net port
+   * addresses.*/
+  DMX_GATEWAY_ARTNET,
+  /** @brief Receive sACN (E1.31) data packets. Universes are numbered from 1
+   * to 63999.*/
+  DMX_GATEWAY_SACN,
+} dmx_gateway_protocol_t;
+
+/**
+ * @brief Starts the DMX gateway. The gateway receives network packets of the
+ * chosen protocol and writes each packet whose universe is mapped to a DMX
+ * port directly into the staged buffer of that port. Mapped ports are sent
+ * continuously, so dmx_send() should not be called on them.
+ *
+ * @note Network packets are handled in the lwIP TCP/IP task. The network
+ * interface must be initialized before the gateway is started.
+ *
+ * @param protocol The network protocol to receive.
+ * @param refresh_hz The number of DMX packets to send per second on each mapped
+ * DMX port.
+ * @return true if the gateway was started.
+ * @return false on failure.
+ */
+bool dmx_gateway_start(dmx_gateway_protocol_t protocol, uint32_t refresh_hz);
+
+/**
+ * @brief Stops the DMX gateway. Every mapped DMX port is unmapped and stops
+ * sending continuously.
+ *
+ * @return true if the gateway was stopped.
+ * @return false if the gateway was not running.
+ */
+bool dmx_gateway_stop();
+
+/**
+ * @brief Checks if the DMX gateway is running.
+ *
+ * @return true if the gateway is running.
+ * @return false if it is not.
+ */
+bool dmx_gateway_is_running();
+
+/**
+ * @brief Maps a network universe onto a DMX port and starts sending the DMX
+ * port continuously. A DMX port may be mapped to a single universe at a time,
+ * but a universe may be mapped to several DMX ports. The DMX port keeps
+ * sending the last received data if the universe stops being received.
+ *
+ * @param dmx_num The DMX port number.
+ * @param universe The universe to send on the DMX port.
+ * @return true if the universe was mapped.
+ * @return false on failure.
+ */
+bool dmx_gateway_map(dmx_port_t dmx_num, uint16_t universe);
+
+/**
+ * @brief Unmaps the network universe of a DMX port. The DMX port stops sending
+ * continuously.
+ *
+ * @param dmx_num The DMX port number.
+ * @return true if the DMX port was unmapped.
+ * @return false if the DMX port was not mapped.
+ */
+bool dmx_gateway_unmap(dmx_port_t dmx_num);
+
+/**
+ * @brief Gets the number of network packets which were written to a DMX port
+ * and the number which were discarded because they arrived out of sequence.
+ *
+ * @param dmx_num The DMX port number.
+ * @param[out] received The number of packets written to the DMX port. May be
+ * NULL.
+ * @param[out] discarded The number of packets discarded because they were out
+ * of sequence. May be NULL.
+ * @return true if the DMX port is mapped.
+ * @return false if it is not.
+ */
+bool dmx_gateway_get_stats(dmx_port_t dmx_num, uint32_t *received,
+                           uint32_t *discarded);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,87 @@
+#include "include/dma.h"
+
+#include "../include/service.h"
+
+#if defined(CONFIG_DMX_UART_DMA) && ESP_IDF_VERSION_MAJOR >= 5
+#include "esp_private/gdma.h"
+#include "esp_private/periph_ctrl.h"
+#include "hal/dma_types.h"
+#include "hal/uhci_ll.h"
+
+static struct dmx_dma_t {
+    int owner;                      // The DMX port which has claimed the UHCI, or -1 if unclaimed.
+    gdma_channel_handle_t tx_chan;  // The GDMA TX channel connected to the UHCI.
+    dma_descriptor_t tx_desc;       // The descriptor used to transmit a DMX packet.
+} dmx_dma_context = {.owner = -1};
+
+bool dmx_dma_init(dmx_port_t dmx_num) {
+    struct dmx_dma_t *dma = &dmx_dma_context;
+    if (dma->owner != -1) {
+        return false;  // The UHCI is already attached to another UART
+    }
+
+    // Allocate a GDMA channel and connect it to the UHCI
+    const gdma_channel_alloc_config_t chan_config = {.direction = GDMA_CHANNEL_DIRECTION_TX};
+    if (gdma_new_channel(&chan_config, &dma->tx_chan) != ESP_OK) {
+        return false;
+    }
+    if (gdma_connect(dma->tx_chan, GDMA_MAKE_TRIGGER(GDMA_TRIG_PERIPH_UHCI, 0)) != ESP_OK) {
+        gdma_del_channel(dma->tx_chan);
+        return false;
+    }
+
+    // Attach the UHCI to the UART and disable SLIP framing and escapes
+    periph_module_enable(PERIPH_UHCI0_MODULE);
+    periph_module_reset(PERIPH_UHCI0_MODULE);
+    uhci_ll_init(&UHCI0);
+    UHCI0.escape_conf.val = 0;  // DMX slots must not be escaped
+    uhci_ll_attach_uart_port(&UHCI0, dmx_num);
+
+    dma->owner = dmx_num;
+
+    return true;
+}
+
+void dmx_dma_deinit(dmx_port_t dmx_num) {
+    struct dmx_dma_t *dma = &dmx_dma_context;
+    if (dma->owner != dmx_num) {
+        return;
+    }
+
+    gdma_stop(dma->tx_chan);
+    gdma_disconnect(dma->tx_chan);
+    gdma_del_channel(dma->tx_chan);
+    periph_module_disable(PERIPH_UHCI0_MODULE);
+
+    dma->owner = -1;
+}
+
+bool DMX_ISR_ATTR dmx_dma_write(dmx_port_t dmx_num, const void *buf, size_t size) {
+    struct dmx_dma_t *dma = &dmx_dma_context;
+    if (dma->owner != dmx_num) {
+        return false;
+    }
+
+    // A DMX packet always fits within a single descriptor
+    dma->tx_desc.dw0.size    = size;
+    dma->tx_desc.dw0.length  = size;
+    dma->tx_desc.dw0.suc_eof = 1;
+    dma->tx_desc.dw0.owner   = DMA_DESCRIPTOR_BUFFER_OWNER_DMA;
+    dma->tx_desc.buffer      = (void *)buf;
+    dma->tx_desc.next        = NULL;
+
+    gdma_reset(dma->tx_chan);
+    gdma_start(dma->tx_chan, (intptr_t)&dma->tx_desc);
+
+    return true;
+}
+
+#else
+
+bool dmx_dma_init(dmx_port_t dmx_num) { return false; }
+
+void dmx_dma_deinit(dmx_port_t dmx_num) {}
+
+bool DMX_ISR_ATTR dmx_dma_write(dmx_port_t dmx_num, const void *buf, size_t size) { return false; }
+
+#endif
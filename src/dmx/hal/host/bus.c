@@ -0,0 +1,512 @@
+#include "sdkconfig.h"
+
+#ifdef CONFIG_IDF_TARGET_LINUX
+#include "include/bus.h"
+
+#include <string.h>
+
+#include "../include/isr.h"
+#include "../include/uart.h"
+#include "../../include/driver.h"
+#include "../../include/service.h"
+#include "../../../rdm/include/uid.h"
+#include "../../../rdm/responder/include/discovery.h"
+#include "freertos/task.h"
+
+#define DMX_HOST_TASK_STACK_SIZE (8192)
+#define DMX_HOST_BUS_PRIORITY    (configMAX_PRIORITIES - 1)  // The bus task acts as the interrupt of every DMX port
+#define DMX_HOST_CLOCK_PRIORITY  (tskIDLE_PRIORITY)         // Simulated time only advances while every task is blocked
+#define DMX_HOST_RX_TOUT_BITS    (22)                        // The RX FIFO timeout, in bit times
+
+enum dmx_host_event_type_t {
+    DMX_HOST_EVENT_NONE = 0,  // There is no scheduled event.
+    DMX_HOST_EVENT_TX,        // The next slot in the TX FIFO is shifted out.
+    DMX_HOST_EVENT_TX_DONE,   // The last slot in the TX FIFO has been shifted out.
+    DMX_HOST_EVENT_RX_TOUT,   // The RX FIFO has timed out.
+    DMX_HOST_EVENT_TIMER,     // The timer alarm is triggered.
+    DMX_HOST_EVENT_LINE,      // An event on the RX line is received.
+};
+
+dmx_host_port_t dmx_host_port[DMX_NUM_MAX];
+portMUX_TYPE dmx_host_spinlock = portMUX_INITIALIZER_UNLOCKED;
+
+static struct dmx_host_bus_t {
+    TaskHandle_t bus_task;    // The task which dispatches the simulated interrupts.
+    TaskHandle_t clock_task;  // The task which advances the simulated time.
+    int64_t now;              // The simulated time in microseconds.
+    int64_t target;           // The simulated time up to which events are handled.
+} dmx_host_bus = {};
+
+int64_t dmx_host_now() { return dmx_host_bus.now; }
+
+uint32_t dmx_host_bit_us(const dmx_host_port_t *port) {
+    const uint32_t baud_rate = port->uart.baud_rate > 0 ? port->uart.baud_rate : DMX_BAUD_RATE;
+    return (1000000 + baud_rate / 2) / baud_rate;
+}
+
+int64_t dmx_host_queue_event(dmx_port_t dmx_num, int64_t ts, int value) {
+    dmx_host_port_t *const port = &dmx_host_port[dmx_num];
+    if (port->events_head - port->events_tail >= DMX_HOST_EVENT_QUEUE_SIZE) {
+        return -1;
+    }
+    if (port->events_head != port->events_tail) {
+        const int64_t last_ts = port->events[(port->events_head - 1) % DMX_HOST_EVENT_QUEUE_SIZE].ts;
+        if (ts < last_ts) {
+            ts = last_ts;  // Events on the same line are serialized
+        }
+    }
+    dmx_host_event_t *const event = &port->events[port->events_head % DMX_HOST_EVENT_QUEUE_SIZE];
+    event->ts                     = ts;
+    event->value                  = value;
+    ++port->events_head;
+    return ts;
+}
+
+static int64_t dmx_host_queue_slot(dmx_port_t dmx_num, int64_t start, uint8_t value, uint32_t bit_us) {
+    // The start bit is seen by the sniffer, but the data bits are not
+    start = dmx_host_queue_event(dmx_num, start, DMX_HOST_LINE_LOW);
+    dmx_host_queue_event(dmx_num, start + bit_us, DMX_HOST_LINE_HIGH);
+    return dmx_host_queue_event(dmx_num, start + bit_us * 11, value);
+}
+
+static void dmx_host_send_slot(dmx_port_t dmx_num, int64_t ts, uint8_t value, uint32_t bit_us) {
+    const dmx_host_port_t *const sender = &dmx_host_port[dmx_num];
+    if (sender->bus < 0) {
+        return;
+    }
+
+    const int64_t start = ts + sender->latency;
+    for (int i = 0; i < DMX_NUM_MAX; ++i) {
+        dmx_host_port_t *const port = &dmx_host_port[i];
+        if (i == dmx_num || port->bus != sender->bus) {
+            continue;
+        }
+
+        // Check if the slot collides with a slot which is still being received
+        if (port->events_head != port->events_tail) {
+            dmx_host_event_t *const last = &port->events[(port->events_head - 1) % DMX_HOST_EVENT_QUEUE_SIZE];
+            const int64_t last_start     = last->ts - bit_us * 11;
+            if (last->value >= 0 && start < last->ts && start + bit_us * 11 > last_start) {
+                const int64_t skew = start > last_start ? start - last_start : last_start - start;
+                if (skew * 2 < bit_us) {
+                    last->value &= (value | DMX_HOST_FRAME_ERR);  // Any transceiver which sends a 0 bit wins
+                } else {
+                    last->value |= DMX_HOST_FRAME_ERR;  // The slots are not aligned
+                }
+                continue;
+            }
+        }
+
+        dmx_host_queue_slot(i, start, value, bit_us);
+    }
+}
+
+void dmx_host_send_line(dmx_port_t dmx_num, int64_t ts, int value) {
+    const dmx_host_port_t *const sender = &dmx_host_port[dmx_num];
+    if (sender->bus < 0) {
+        return;
+    }
+    for (int i = 0; i < DMX_NUM_MAX; ++i) {
+        if (i != dmx_num && dmx_host_port[i].bus == sender->bus) {
+            dmx_host_queue_event(i, ts + sender->latency, value);
+        }
+    }
+}
+
+void dmx_host_uart_update(dmx_host_port_t *port) {
+    if (port->uart.rx_len >= port->uart.rxfifo_full) {
+        port->uart.intr_raw |= UART_INTR_RXFIFO_FULL;
+    }
+    if (port->uart.tx_len <= SOC_UART_FIFO_LEN / 16) {
+        port->uart.intr_raw |= UART_INTR_TXFIFO_EMPTY;
+    }
+}
+
+static int dmx_host_get_next_event(const dmx_host_port_t *port, int64_t *ts) {
+    int type = DMX_HOST_EVENT_NONE;
+    *ts      = INT64_MAX;
+
+    if (port->uart.isr_context != NULL) {
+        if (port->uart.tx_len > 0 && port->uart.tx_next_ts < *ts) {
+            type = DMX_HOST_EVENT_TX;
+            *ts  = port->uart.tx_next_ts;
+        }
+        if (port->uart.tx_done_ts >= 0 && port->uart.tx_done_ts < *ts) {
+            type = DMX_HOST_EVENT_TX_DONE;
+            *ts  = port->uart.tx_done_ts;
+        }
+        if (port->uart.rx_tout_ts >= 0 && port->uart.rx_tout_ts < *ts) {
+            type = DMX_HOST_EVENT_RX_TOUT;
+            *ts  = port->uart.rx_tout_ts;
+        }
+    }
+    if (port->timer.isr_context != NULL && port->timer.is_running && port->timer.is_armed) {
+        const int64_t alarm_ts = port->timer.alarm > port->timer.counter
+                                     ? port->timer.counter_ts + (int64_t)(port->timer.alarm - port->timer.counter)
+                                     : port->timer.counter_ts;
+        if (alarm_ts < *ts) {
+            type = DMX_HOST_EVENT_TIMER;
+            *ts  = alarm_ts;
+        }
+    }
+    if (port->events_head != port->events_tail) {
+        const dmx_host_event_t *const event = &port->events[port->events_tail % DMX_HOST_EVENT_QUEUE_SIZE];
+        if (event->ts < *ts) {
+            type = DMX_HOST_EVENT_LINE;
+            *ts  = event->ts;
+        }
+    }
+
+    return type;
+}
+
+static void dmx_host_receive(dmx_host_port_t *port, int64_t ts, int value) {
+    const uint32_t bit_us = dmx_host_bit_us(port);
+
+    if (value == DMX_HOST_LINE_LOW || value == DMX_HOST_LINE_HIGH) {
+        port->gpio.level      = (value == DMX_HOST_LINE_HIGH);
+        port->gpio.is_pending = (port->gpio.isr_context != NULL);
+    }
+
+    // The UART only receives while the RTS pin is set to receive
+    if (port->uart.isr_context == NULL || port->uart.rts == 0) {
+        port->uart.break_ts = -1;
+        return;
+    }
+
+    if (value == DMX_HOST_LINE_LOW) {
+        port->uart.break_ts = ts;
+    } else if (value == DMX_HOST_LINE_HIGH) {
+        if (port->uart.break_ts >= 0 && ts - port->uart.break_ts >= bit_us * 11) {
+            // The DMX break is received as a null slot
+            if (port->uart.rx_len < SOC_UART_FIFO_LEN) {
+                port->uart.rxfifo[port->uart.rx_len++] = 0;
+            }
+            port->uart.intr_raw |= UART_INTR_BRK_DET;
+        }
+        port->uart.break_ts = -1;
+    } else {
+        if (port->uart.rx_len < SOC_UART_FIFO_LEN) {
+            port->uart.rxfifo[port->uart.rx_len++] = value;
+        } else {
+            port->uart.intr_raw |= UART_INTR_RXFIFO_OVF;
+        }
+        if (value & DMX_HOST_FRAME_ERR) {
+            port->uart.intr_raw |= UART_INTR_FRAM_ERR;
+        }
+        port->uart.rx_tout_ts = ts + bit_us * DMX_HOST_RX_TOUT_BITS;
+        dmx_host_uart_update(port);
+    }
+}
+
+static void dmx_host_run() {
+    while (true) {
+        // Dispatch the simulated interrupts until none are pending
+        bool is_dispatched;
+        do {
+            is_dispatched = false;
+            for (int i = 0; i < DMX_NUM_MAX; ++i) {
+                dmx_host_port_t *const port = &dmx_host_port[i];
+                if (port->uart.tap_break_ts < 0 && !port->gpio.is_pending &&
+                    !(port->uart.intr_raw & port->uart.intr_ena)) {
+                    continue;  // Skip the critical section since no other task runs while the bus task does
+                }
+
+                taskENTER_CRITICAL(&dmx_host_spinlock);
+                const dmx_host_tap_cb_t tap = port->tap;
+                void *const tap_context     = port->tap_context;
+                const int64_t tap_break_ts  = port->uart.tap_break_ts;
+                port->uart.tap_break_ts     = -1;
+#ifndef CONFIG_DMX_SNIFFER_DISABLE
+                void *const gpio_context = port->gpio.is_pending ? port->gpio.isr_context : NULL;
+                port->gpio.is_pending    = false;
+#endif
+                void *const uart_context =
+                    (port->uart.intr_raw & port->uart.intr_ena) ? port->uart.isr_context : NULL;
+                taskEXIT_CRITICAL(&dmx_host_spinlock);
+
+                if (tap != NULL && tap_break_ts >= 0) {
+                    tap(i, tap_break_ts, DMX_HOST_BREAK, tap_context);
+                }
+#ifndef CONFIG_DMX_SNIFFER_DISABLE
+                if (gpio_context != NULL) {
+                    dmx_gpio_isr(gpio_context);
+                    is_dispatched = true;
+                }
+#endif
+                if (uart_context != NULL) {
+                    dmx_uart_isr(uart_context);
+                    is_dispatched = true;
+                }
+            }
+        } while (is_dispatched);
+
+        // Handle the earliest event which is due
+        taskENTER_CRITICAL(&dmx_host_spinlock);
+        int dmx_num = -1;
+        int type    = DMX_HOST_EVENT_NONE;
+        int64_t ts  = INT64_MAX;
+        for (int i = 0; i < DMX_NUM_MAX; ++i) {
+            int64_t event_ts;
+            const int event_type = dmx_host_get_next_event(&dmx_host_port[i], &event_ts);
+            if (event_type != DMX_HOST_EVENT_NONE && event_ts < ts) {
+                dmx_num = i;
+                type    = event_type;
+                ts      = event_ts;
+            }
+        }
+        if (dmx_num < 0 || ts > dmx_host_bus.target) {
+            taskEXIT_CRITICAL(&dmx_host_spinlock);
+            break;  // Wait for the clock task to advance the simulated time
+        }
+        if (ts > dmx_host_bus.now) {
+            dmx_host_bus.now = ts;
+        }
+
+        dmx_host_port_t *const port = &dmx_host_port[dmx_num];
+        const uint32_t bit_us       = dmx_host_bit_us(port);
+        void *alarm_context         = NULL;
+        int tap_slot                = -1;
+        switch (type) {
+            case DMX_HOST_EVENT_TX: {
+                // Shift the next slot out onto the bus
+                const uint8_t slot = port->uart.txfifo[0];
+                --port->uart.tx_len;
+                memmove(port->uart.txfifo, &port->uart.txfifo[1], port->uart.tx_len);
+                dmx_host_send_slot(dmx_num, ts, slot, bit_us);
+                port->uart.tx_next_ts = ts + bit_us * 11;
+                if (port->uart.tx_len == 0) {
+                    port->uart.tx_done_ts = port->uart.tx_next_ts;
+                }
+                dmx_host_uart_update(port);
+                tap_slot = slot;
+                break;
+            }
+            case DMX_HOST_EVENT_TX_DONE:
+                port->uart.tx_done_ts = -1;
+                port->uart.intr_raw |= UART_INTR_TX_DONE;
+                break;
+            case DMX_HOST_EVENT_RX_TOUT:
+                port->uart.rx_tout_ts = -1;
+                if (port->uart.rx_len > 0) {
+                    port->uart.intr_raw |= UART_INTR_RXFIFO_TOUT;
+                }
+                break;
+            case DMX_HOST_EVENT_TIMER:
+                port->timer.counter += ts - port->timer.counter_ts;
+                port->timer.counter_ts = ts;
+                if (port->timer.auto_reload) {
+                    port->timer.counter = 0;
+                } else {
+                    port->timer.is_armed = false;
+                }
+                alarm_context = port->timer.isr_context;
+                break;
+            case DMX_HOST_EVENT_LINE: {
+                const dmx_host_event_t event = port->events[port->events_tail % DMX_HOST_EVENT_QUEUE_SIZE];
+                ++port->events_tail;
+                dmx_host_receive(port, event.ts, event.value);
+                break;
+            }
+        }
+        const dmx_host_tap_cb_t tap = port->tap;
+        void *const tap_context     = port->tap_context;
+        taskEXIT_CRITICAL(&dmx_host_spinlock);
+
+        if (tap != NULL && tap_slot >= 0) {
+            tap(dmx_num, ts + bit_us * 11, tap_slot, tap_context);
+        }
+        if (alarm_context != NULL) {
+            dmx_timer_handle_alarm(alarm_context);
+        }
+    }
+}
+
+static void dmx_host_bus_task(void *arg) {
+    while (true) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        dmx_host_run();
+    }
+}
+
+static void dmx_host_clock_task(void *arg) {
+    while (true) {
+        // Find the next event on any DMX port
+        int64_t next_ts = INT64_MAX;
+        taskENTER_CRITICAL(&dmx_host_spinlock);
+        for (int i = 0; i < DMX_NUM_MAX; ++i) {
+            int64_t ts;
+            if (dmx_host_get_next_event(&dmx_host_port[i], &ts) != DMX_HOST_EVENT_NONE && ts < next_ts) {
+                next_ts = ts;
+            }
+        }
+        if (next_ts != INT64_MAX && next_ts > dmx_host_bus.target) {
+            dmx_host_bus.target = next_ts;
+        }
+        taskEXIT_CRITICAL(&dmx_host_spinlock);
+
+        if (next_ts == INT64_MAX) {
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);  // Nothing is scheduled
+        } else {
+            xTaskNotifyGive(dmx_host_bus.bus_task);  // Preempts this task
+        }
+    }
+}
+
+bool dmx_host_start() {
+    if (dmx_host_bus.bus_task != NULL) {
+        return true;
+    }
+
+    for (int i = 0; i < DMX_NUM_MAX; ++i) {
+        dmx_host_port_t *const port = &dmx_host_port[i];
+        memset(port, 0, sizeof(*port));
+        port->uart.baud_rate    = DMX_BAUD_RATE;
+        port->uart.rts          = 1;
+        port->uart.rxfifo_full  = DMX_UART_FULL_DEFAULT;
+        port->uart.rx_tout_ts   = -1;
+        port->uart.break_ts     = -1;
+        port->uart.tx_done_ts   = -1;
+        port->uart.tap_break_ts = -1;
+        port->gpio.level        = 1;
+        port->bus               = -1;
+    }
+
+    if (xTaskCreate(dmx_host_bus_task, "dmx_host_bus", DMX_HOST_TASK_STACK_SIZE, NULL, DMX_HOST_BUS_PRIORITY,
+                    &dmx_host_bus.bus_task) != pdPASS) {
+        dmx_host_bus.bus_task = NULL;
+        return false;
+    }
+    if (xTaskCreate(dmx_host_clock_task, "dmx_host_clock", DMX_HOST_TASK_STACK_SIZE, NULL, DMX_HOST_CLOCK_PRIORITY,
+                    &dmx_host_bus.clock_task) != pdPASS) {
+        vTaskDelete(dmx_host_bus.bus_task);
+        dmx_host_bus.bus_task = NULL;
+        return false;
+    }
+
+    return true;
+}
+
+void dmx_host_kick() {
+    if (dmx_host_bus.bus_task != NULL) {
+        xTaskNotifyGive(dmx_host_bus.bus_task);
+        xTaskNotifyGive(dmx_host_bus.clock_task);
+    }
+}
+
+bool dmx_host_connect(dmx_port_t a, dmx_port_t b) {
+    DMX_CHECK(a < DMX_NUM_MAX, false, "a error");
+    DMX_CHECK(b < DMX_NUM_MAX && b != a, false, "b error");
+    DMX_CHECK(dmx_host_start(), false, "host bus error");
+
+    taskENTER_CRITICAL(&dmx_host_spinlock);
+    if (dmx_host_port[a].bus < 0) {
+        dmx_host_port[a].bus = a;
+    }
+    if (dmx_host_port[b].bus < 0) {
+        dmx_host_port[b].bus = b;
+    }
+    const int bus = dmx_host_port[b].bus;
+    if (bus != dmx_host_port[a].bus) {
+        // Join the bus of DMX port b to the bus of DMX port a
+        for (int i = 0; i < DMX_NUM_MAX; ++i) {
+            if (dmx_host_port[i].bus == bus) {
+                dmx_host_port[i].bus = dmx_host_port[a].bus;
+            }
+        }
+    }
+    taskEXIT_CRITICAL(&dmx_host_spinlock);
+
+    return true;
+}
+
+bool dmx_host_disconnect(dmx_port_t dmx_num) {
+    DMX_CHECK(dmx_num < DMX_NUM_MAX, false, "dmx_num error");
+
+    taskENTER_CRITICAL(&dmx_host_spinlock);
+    const bool is_connected    = (dmx_host_port[dmx_num].bus >= 0);
+    dmx_host_port[dmx_num].bus = -1;
+    taskEXIT_CRITICAL(&dmx_host_spinlock);
+
+    return is_connected;
+}
+
+bool dmx_host_set_latency(dmx_port_t dmx_num, uint32_t latency) {
+    DMX_CHECK(dmx_num < DMX_NUM_MAX, false, "dmx_num error");
+    DMX_CHECK(dmx_host_start(), false, "host bus error");
+
+    taskENTER_CRITICAL(&dmx_host_spinlock);
+    dmx_host_port[dmx_num].latency = latency;
+    taskEXIT_CRITICAL(&dmx_host_spinlock);
+
+    return true;
+}
+
+bool dmx_host_set_uid(dmx_port_t dmx_num, const rdm_uid_t *uid) {
+    DMX_CHECK(dmx_num < DMX_NUM_MAX, false, "dmx_num error");
+    DMX_CHECK(uid != NULL, false, "uid is null");
+    DMX_CHECK(!rdm_uid_is_broadcast(uid) && !rdm_uid_is_null(uid), false, "uid error");
+    DMX_CHECK(dmx_driver_is_installed(dmx_num), false, "driver is not installed");
+
+    dmx_driver_t *const driver = dmx_driver[dmx_num];
+    xSemaphoreTakeRecursive(driver->mux, portMAX_DELAY);
+    taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+    driver->uid = *uid;
+#ifndef CONFIG_RDM_RESPONDER_DISABLE
+    const bool is_fast_disc = driver->rdm.fast_discovery.is_enabled;
+#endif
+    taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+#ifndef CONFIG_RDM_RESPONDER_DISABLE
+    if (is_fast_disc) {
+        rdm_set_fast_discovery(dmx_num, true);  // Encode the discovery responses with the new UID
+    }
+#endif
+    xSemaphoreGiveRecursive(driver->mux);
+
+    return true;
+}
+
+bool dmx_host_inject(dmx_port_t dmx_num, const void *data, size_t size, uint32_t break_len, uint32_t mab_len) {
+    DMX_CHECK(dmx_num < DMX_NUM_MAX, false, "dmx_num error");
+    DMX_CHECK(data != NULL || size == 0, false, "data is null");
+    DMX_CHECK(size <= DMX_PACKET_SIZE_MAX, false, "size error");
+    DMX_CHECK(dmx_host_start(), false, "host bus error");
+
+    dmx_host_port_t *const port = &dmx_host_port[dmx_num];
+    const uint8_t *slots        = data;
+    const uint32_t bit_us       = dmx_host_bit_us(port);
+
+    taskENTER_CRITICAL(&dmx_host_spinlock);
+    const uint32_t required = (break_len > 0 ? 2 : 0) + size * 3;
+    if (port->events_head - port->events_tail + required > DMX_HOST_EVENT_QUEUE_SIZE) {
+        taskEXIT_CRITICAL(&dmx_host_spinlock);
+        return false;
+    }
+    int64_t ts = dmx_host_bus.now;
+    if (break_len > 0) {
+        ts = dmx_host_queue_event(dmx_num, ts, DMX_HOST_LINE_LOW);
+        ts = dmx_host_queue_event(dmx_num, ts + break_len, DMX_HOST_LINE_HIGH) + mab_len;
+    }
+    for (size_t i = 0; i < size; ++i) {
+        ts = dmx_host_queue_slot(dmx_num, ts, slots[i], bit_us);
+    }
+    dmx_host_kick();
+    taskEXIT_CRITICAL(&dmx_host_spinlock);
+
+    return true;
+}
+
+bool dmx_host_set_tap(dmx_port_t dmx_num, dmx_host_tap_cb_t cb, void *context) {
+    DMX_CHECK(dmx_num < DMX_NUM_MAX, false, "dmx_num error");
+    DMX_CHECK(dmx_host_start(), false, "host bus error");
+
+    taskENTER_CRITICAL(&dmx_host_spinlock);
+    dmx_host_port[dmx_num].tap         = cb;
+    dmx_host_port[dmx_num].tap_context = context;
+    taskEXIT_CRITICAL(&dmx_host_spinlock);
+
+    return true;
+}
+
+int64_t dmx_host_get_time() { return dmx_host_bus.now; }
+#endif
@@ -0,0 +1,28 @@
+#include "../include/gpio.h"
+
+#ifdef CONFIG_IDF_TARGET_LINUX
+#include "include/bus.h"
+
+bool dmx_gpio_init(dmx_port_t dmx_num, void *isr_context, int sniffer_pin) {
+    if (!dmx_host_start()) {
+        return false;
+    }
+
+    // The sniffer pin of a simulated DMX port always reads the RX line of the port
+    taskENTER_CRITICAL(&dmx_host_spinlock);
+    dmx_host_port[dmx_num].gpio.is_pending  = false;
+    dmx_host_port[dmx_num].gpio.isr_context = isr_context;
+    taskEXIT_CRITICAL(&dmx_host_spinlock);
+
+    return true;
+}
+
+void dmx_gpio_deinit(dmx_port_t dmx_num) {
+    taskENTER_CRITICAL(&dmx_host_spinlock);
+    dmx_host_port[dmx_num].gpio.isr_context = NULL;
+    dmx_host_port[dmx_num].gpio.is_pending  = false;
+    taskEXIT_CRITICAL(&dmx_host_spinlock);
+}
+
+int dmx_gpio_read(dmx_port_t dmx_num) { return dmx_host_port[dmx_num].gpio.level; }
+#endif
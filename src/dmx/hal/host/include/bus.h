@@ -0,0 +1,164 @@
+/**
+ * @file dmx/hal/host/include/bus.h
+ * @author Mitch Weisbrod (mitch@theweisbrods.com)
+ * @brief This file contains the simulated bus which is shared by the UART,
+ * timer, and GPIO of the host HAL. Every change to the simulated peripherals is
+ * made with the host spinlock held. The simulated interrupts are dispatched by
+ * the host bus task, which has the highest priority so that no task runs while
+ * an interrupt is being handled. This file is not considered part of the API
+ * and should not be included by the user.
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "../../../host.h"
+#include "../../../include/types.h"
+#include "port.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @brief The number of line events which may be queued on each DMX port.*/
+#define DMX_HOST_EVENT_QUEUE_SIZE (4096)
+
+/** @brief The value of a line event which pulls the line low.*/
+#define DMX_HOST_LINE_LOW (-1)
+/** @brief The value of a line event which releases the line high.*/
+#define DMX_HOST_LINE_HIGH (-2)
+/** @brief The flag which is set in the value of a received slot which has a
+ * framing error.*/
+#define DMX_HOST_FRAME_ERR (0x100)
+
+/** @brief An event on the RX line of a simulated UART.*/
+typedef struct dmx_host_event_t {
+    int64_t ts;     // The simulated time of the event.
+    int16_t value;  // The received slot and DMX_HOST_FRAME_ERR, DMX_HOST_LINE_LOW, or DMX_HOST_LINE_HIGH.
+} dmx_host_event_t;
+
+/** @brief The simulated peripherals of a DMX port.*/
+typedef struct dmx_host_port_t {
+    // The simulated UART
+    struct dmx_host_uart_t {
+        void *isr_context;                   // The context of the UART ISR, or NULL if the UART is not initialized.
+        uint32_t baud_rate;                  // The baud rate of the UART.
+        int rts;                             // The level of the RTS pin. The UART only receives while it is 1.
+        int invert_tx;                       // True if the TX line is held low.
+        uint32_t intr_raw;                   // The raw interrupt status.
+        uint32_t intr_ena;                   // The enabled interrupts.
+        int rxfifo_full;                     // The RX FIFO full threshold.
+        uint32_t tx_idle;                    // The number of idle bits sent before the first slot of a packet.
+        uint8_t rxfifo[SOC_UART_FIFO_LEN];  // The RX FIFO.
+        int rx_len;                          // The number of slots in the RX FIFO.
+        int64_t rx_tout_ts;                  // The time of the RX FIFO timeout, or -1.
+        int64_t break_ts;                    // The time at which the RX line was pulled low, or -1.
+        uint8_t txfifo[SOC_UART_FIFO_LEN];  // The TX FIFO.
+        int tx_len;                          // The number of slots in the TX FIFO.
+        int64_t tx_next_ts;                  // The time at which the next slot may be shifted out.
+        int64_t tx_done_ts;                  // The time at which the last slot is done being shifted out, or -1.
+        int64_t tap_break_ts;                // The time of a DMX break which has not been tapped, or -1.
+    } uart;
+
+    // The simulated timer
+    struct dmx_host_timer_t {
+        void *isr_context;  // The context of the timer ISR, or NULL if the timer is not initialized.
+        bool is_running;    // True if the timer is counting.
+        bool is_armed;      // True if the alarm has not been triggered since it was set.
+        bool auto_reload;   // True if the counter is reset to 0 when the alarm is triggered.
+        uint64_t counter;   // The counter value at counter_ts.
+        int64_t counter_ts; // The time at which the counter was last set or started.
+        uint64_t alarm;     // The alarm value.
+    } timer;
+
+    // The simulated sniffer pin
+    struct dmx_host_gpio_t {
+        void *isr_context;  // The context of the GPIO ISR, or NULL if the sniffer pin is not initialized.
+        int level;          // The level of the RX line.
+        bool is_pending;    // True if an edge has not been dispatched to the GPIO ISR.
+    } gpio;
+
+    // The simulated bus
+    int bus;                                             // The simulated bus to which the port is connected, or -1.
+    uint32_t latency;                                    // The delay of the slots sent by this port, in microseconds.
+    dmx_host_tap_cb_t tap;                               // The callback which observes the slots of this port, or NULL.
+    void *tap_context;                                   // The context of the tap callback.
+    dmx_host_event_t events[DMX_HOST_EVENT_QUEUE_SIZE];  // The queue of events on the RX line.
+    uint32_t events_head;                                // The index at which the next event is queued.
+    uint32_t events_tail;                                // The index of the next event on the RX line.
+} dmx_host_port_t;
+
+/** @brief The simulated peripherals of every DMX port.*/
+extern dmx_host_port_t dmx_host_port[DMX_NUM_MAX];
+
+/** @brief The spinlock which guards the simulated peripherals.*/
+extern portMUX_TYPE dmx_host_spinlock;
+
+/**
+ * @brief Starts the host bus and clock tasks if they are not already running.
+ *
+ * @return true if the host bus is running.
+ * @return false on failure.
+ */
+bool dmx_host_start();
+
+/**
+ * @brief Wakes the host bus task so that pending interrupts are dispatched,
+ * and wakes the host clock task so that it sees changes to the schedule of the
+ * simulated peripherals. It acts like an interrupt request line, so it may be
+ * called with the host spinlock held.
+ */
+void dmx_host_kick();
+
+/**
+ * @brief Gets the simulated time without taking the host spinlock.
+ *
+ * @return The simulated time in microseconds.
+ */
+int64_t dmx_host_now();
+
+/**
+ * @brief Gets the number of microseconds taken to send one bit by a simulated
+ * UART.
+ *
+ * @param port A pointer to the simulated DMX port.
+ * @return The bit time in microseconds.
+ */
+uint32_t dmx_host_bit_us(const dmx_host_port_t *port);
+
+/**
+ * @brief Queues an event on the RX line of a DMX port. Events are serialized,
+ * so an event which is queued before the last queued event is delayed. It must
+ * be called with the host spinlock held.
+ *
+ * @param dmx_num The DMX port number.
+ * @param ts The simulated time of the event.
+ * @param value The received slot, DMX_HOST_LINE_LOW, or DMX_HOST_LINE_HIGH.
+ * @return The simulated time of the queued event, or -1 if the queue is full.
+ */
+int64_t dmx_host_queue_event(dmx_port_t dmx_num, int64_t ts, int value);
+
+/**
+ * @brief Drives the line of the simulated bus to which a DMX port is connected.
+ * The line event is received by every other DMX port on the bus after the
+ * latency of the sending DMX port. It must be called with the host spinlock
+ * held.
+ *
+ * @param dmx_num The DMX port number which drives the line.
+ * @param ts The simulated time at which the line is driven.
+ * @param value DMX_HOST_LINE_LOW or DMX_HOST_LINE_HIGH.
+ */
+void dmx_host_send_line(dmx_port_t dmx_num, int64_t ts, int value);
+
+/**
+ * @brief Updates the level-triggered interrupts of a simulated UART. It must
+ * be called with the host spinlock held.
+ *
+ * @param port A pointer to the simulated DMX port.
+ */
+void dmx_host_uart_update(dmx_host_port_t *port);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,76 @@
+/**
+ * @file dmx/hal/host/include/port.h
+ * @author Mitch Weisbrod (mitch@theweisbrods.com)
+ * @brief This file contains the definitions which the ESP32 peripheral headers
+ * provide to esp_dmx but which do not exist on the linux target of the ESP-IDF.
+ * The host HAL uses the interrupt bits and FIFO sizes of the ESP32 UART so that
+ * the DMX driver behaves the same on the host as it does on the target. This
+ * file is not considered part of the API and should not be included by the
+ * user.
+ */
+#pragma once
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @brief The number of simulated UARTs.*/
+#ifndef SOC_UART_NUM
+#ifdef CONFIG_DMX_HOST_PORT_NUM
+#define SOC_UART_NUM (CONFIG_DMX_HOST_PORT_NUM)
+#else
+#define SOC_UART_NUM (3)
+#endif
+#endif
+
+/** @brief The size of the FIFOs of each simulated UART.*/
+#ifndef SOC_UART_FIFO_LEN
+#define SOC_UART_FIFO_LEN (128)
+#endif
+
+/** @brief The interrupt bits of the simulated UARTs.*/
+#define UART_INTR_RXFIFO_FULL  (1 << 0)
+#define UART_INTR_TXFIFO_EMPTY (1 << 1)
+#define UART_INTR_PARITY_ERR   (1 << 2)
+#define UART_INTR_FRAM_ERR     (1 << 3)
+#define UART_INTR_RXFIFO_OVF   (1 << 4)
+#define UART_INTR_BRK_DET      (1 << 7)
+#define UART_INTR_RXFIFO_TOUT  (1 << 8)
+#define UART_INTR_TX_DONE      (1 << 14)
+
+/** @brief The interrupt allocation flags, which are accepted but ignored.*/
+#ifndef ESP_INTR_FLAG_LEVEL1
+#define ESP_INTR_FLAG_LEVEL1    (1 << 1)
+#define ESP_INTR_FLAG_LEVEL2    (1 << 2)
+#define ESP_INTR_FLAG_LEVEL3    (1 << 3)
+#define ESP_INTR_FLAG_LEVEL4    (1 << 4)
+#define ESP_INTR_FLAG_LEVEL5    (1 << 5)
+#define ESP_INTR_FLAG_LEVEL6    (1 << 6)
+#define ESP_INTR_FLAG_NMI       (1 << 7)
+#define ESP_INTR_FLAG_SHARED    (1 << 8)
+#define ESP_INTR_FLAG_EDGE      (1 << 9)
+#define ESP_INTR_FLAG_IRAM      (1 << 10)
+#define ESP_INTR_FLAG_LEVELMASK (0x7e)
+#endif
+
+/** @brief The number of simulated GPIOs. Any of them may be used as a TX, RX,
+ * RTS, or sniffer pin.*/
+#define DMX_HOST_GPIO_NUM (64)
+
+#define GPIO_IS_VALID_GPIO(gpio_num)        ((gpio_num) >= 0 && (gpio_num) < DMX_HOST_GPIO_NUM)
+#define GPIO_IS_VALID_OUTPUT_GPIO(gpio_num) GPIO_IS_VALID_GPIO(gpio_num)
+
+/**
+ * @brief The host HAL dispatches the edges of each sniffer pin itself, so the
+ * GPIO ISR service does not need to be installed.
+ *
+ * @param flags The interrupt allocation flags, which are ignored.
+ * @return 0 always.
+ */
+static inline int gpio_install_isr_service(int flags) { return 0; }
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,120 @@
+#include "../include/nvs.h"
+
+#ifdef CONFIG_IDF_TARGET_LINUX
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../../include/service.h"
+
+/** @brief A parameter which is stored in the simulated non-volatile storage.
+ * Parameters are kept in memory, so they are lost when the host program
+ * exits.*/
+typedef struct dmx_nvs_record_t {
+    struct dmx_nvs_record_t *next;  // The next record, or NULL.
+    dmx_port_t dmx_num;             // The DMX port which owns the parameter.
+    rdm_sub_device_t sub_device;    // The sub-device which owns the parameter.
+    rdm_pid_t pid;                  // The parameter ID.
+    size_t size;                    // The size in bytes of the parameter data.
+    uint8_t data[];                 // The parameter data.
+} dmx_nvs_record_t;
+
+static struct dmx_nvs_host_t {
+    SemaphoreHandle_t mux;      // The recursive mutex which guards the records and is held for the duration of a batch.
+    int depth;                  // The number of nested calls to dmx_nvs_begin().
+    dmx_nvs_record_t *records;  // The stored parameters.
+} dmx_nvs_host = {};
+
+static dmx_nvs_record_t **dmx_nvs_find(dmx_port_t dmx_num, rdm_sub_device_t sub_device, rdm_pid_t pid) {
+    dmx_nvs_record_t **record = &dmx_nvs_host.records;
+    while (*record != NULL && !((*record)->dmx_num == dmx_num && (*record)->sub_device == sub_device &&
+                                (*record)->pid == pid)) {
+        record = &(*record)->next;
+    }
+    return record;
+}
+
+void dmx_nvs_init(dmx_port_t dmx_num) {
+    if (dmx_nvs_host.mux == NULL) {
+        dmx_nvs_host.mux = xSemaphoreCreateRecursiveMutex();
+    }
+}
+
+bool dmx_nvs_sync(dmx_port_t dmx_num) { return true; }
+
+bool dmx_nvs_begin() {
+    assert(dmx_nvs_host.mux != NULL);
+    xSemaphoreTakeRecursive(dmx_nvs_host.mux, portMAX_DELAY);
+    ++dmx_nvs_host.depth;
+    return true;
+}
+
+bool dmx_nvs_end() {
+    assert(dmx_nvs_host.depth > 0);
+    --dmx_nvs_host.depth;
+    xSemaphoreGiveRecursive(dmx_nvs_host.mux);
+    return true;
+}
+
+size_t dmx_nvs_get(dmx_port_t dmx_num, rdm_sub_device_t sub_device, rdm_pid_t pid, void *param, size_t size) {
+    assert(dmx_num < DMX_NUM_MAX);
+    assert(pid > 0);
+    assert(sub_device < RDM_SUB_DEVICE_MAX);
+    assert(param != NULL);
+
+    if (dmx_nvs_host.mux == NULL) {
+        return 0;
+    }
+
+    xSemaphoreTakeRecursive(dmx_nvs_host.mux, portMAX_DELAY);
+    const dmx_nvs_record_t *const record = *dmx_nvs_find(dmx_num, sub_device, pid);
+    if (record != NULL && record->size <= size) {
+        memcpy(param, record->data, record->size);
+        size = record->size;
+    } else {
+        size = 0;
+    }
+    xSemaphoreGiveRecursive(dmx_nvs_host.mux);
+
+    return size;
+}
+
+bool dmx_nvs_set(dmx_port_t dmx_num, rdm_sub_device_t sub_device, rdm_pid_t pid, const void *param, size_t size) {
+    assert(dmx_num < DMX_NUM_MAX);
+    assert(pid > 0);
+    assert(sub_device < 513);
+    assert(param != NULL);
+
+    if (size == 0) {
+        return true;
+    }
+
+    dmx_nvs_begin();
+    dmx_nvs_record_t **const record = dmx_nvs_find(dmx_num, sub_device, pid);
+    if (*record != NULL && (*record)->size == size) {
+        memcpy((*record)->data, param, size);  // Overwrite the record in place
+        return dmx_nvs_end();
+    } else if (*record != NULL) {
+        // The size of the parameter changed so remove the old record
+        dmx_nvs_record_t *const old_record = *record;
+        *record                            = old_record->next;
+        free(old_record);
+    }
+
+    // Add a new record to the front of the list
+    dmx_nvs_record_t *const new_record = malloc(sizeof(*new_record) + size);
+    if (new_record == NULL) {
+        dmx_nvs_end();
+        return false;
+    }
+    new_record->next       = dmx_nvs_host.records;
+    new_record->dmx_num    = dmx_num;
+    new_record->sub_device = sub_device;
+    new_record->pid        = pid;
+    new_record->size       = size;
+    memcpy(new_record->data, param, size);
+    dmx_nvs_host.records = new_record;
+
+    return dmx_nvs_end();
+}
+#endif
@@ -0,0 +1,80 @@
+#include "../include/timer.h"
+
+#ifdef CONFIG_IDF_TARGET_LINUX
+#include "include/bus.h"
+
+bool dmx_timer_init(dmx_port_t dmx_num, void *isr_context, int isr_flags) {
+    if (!dmx_host_start()) {
+        return false;
+    }
+
+    dmx_host_port_t *const port = &dmx_host_port[dmx_num];
+    taskENTER_CRITICAL(&dmx_host_spinlock);
+    port->timer.is_running  = false;
+    port->timer.is_armed    = false;
+    port->timer.auto_reload = false;
+    port->timer.counter     = 0;
+    port->timer.counter_ts  = dmx_host_now();
+    port->timer.alarm       = 0;
+    port->timer.isr_context = isr_context;
+    taskEXIT_CRITICAL(&dmx_host_spinlock);
+
+    return true;
+}
+
+void dmx_timer_deinit(dmx_port_t dmx_num) {
+    dmx_host_port_t *const port = &dmx_host_port[dmx_num];
+    taskENTER_CRITICAL(&dmx_host_spinlock);
+    port->timer.is_running  = false;
+    port->timer.isr_context = NULL;
+    taskEXIT_CRITICAL(&dmx_host_spinlock);
+}
+
+void dmx_timer_stop(dmx_port_t dmx_num) {
+    dmx_host_port_t *const port = &dmx_host_port[dmx_num];
+    taskENTER_CRITICAL(&dmx_host_spinlock);
+    port->timer.is_running = false;
+    port->timer.counter    = 0;
+    taskEXIT_CRITICAL(&dmx_host_spinlock);
+}
+
+void dmx_timer_set_counter(dmx_port_t dmx_num, uint64_t counter) {
+    dmx_host_port_t *const port = &dmx_host_port[dmx_num];
+    taskENTER_CRITICAL(&dmx_host_spinlock);
+    port->timer.counter    = counter;
+    port->timer.counter_ts = dmx_host_now();
+    dmx_host_kick();
+    taskEXIT_CRITICAL(&dmx_host_spinlock);
+}
+
+void dmx_timer_set_alarm(dmx_port_t dmx_num, uint64_t alarm, bool auto_reload) {
+    dmx_host_port_t *const port = &dmx_host_port[dmx_num];
+    taskENTER_CRITICAL(&dmx_host_spinlock);
+    port->timer.alarm       = alarm;
+    port->timer.auto_reload = auto_reload;
+    port->timer.is_armed    = true;
+    dmx_host_kick();
+    taskEXIT_CRITICAL(&dmx_host_spinlock);
+}
+
+void dmx_timer_start(dmx_port_t dmx_num) {
+    dmx_host_port_t *const port = &dmx_host_port[dmx_num];
+    taskENTER_CRITICAL(&dmx_host_spinlock);
+    if (!port->timer.is_running) {
+        port->timer.counter_ts = dmx_host_now();
+        port->timer.is_running = true;
+        dmx_host_kick();
+    }
+    taskEXIT_CRITICAL(&dmx_host_spinlock);
+}
+
+int64_t dmx_timer_get_micros_since_boot() { return dmx_host_now(); }
+
+uint32_t dmx_timer_get_cycle_count() { return dmx_host_now(); }
+
+uint64_t dmx_timer_cycles_to_micros(uint64_t cycles) { return cycles; }
+
+uint32_t dmx_timer_get_timestamp() { return dmx_host_now(); }
+
+uint32_t dmx_timer_timestamp_to_micros(uint32_t elapsed) { return elapsed; }
+#endif
@@ -0,0 +1,188 @@
+#include "../include/uart.h"
+
+#ifdef CONFIG_IDF_TARGET_LINUX
+#include <string.h>
+
+#include "include/bus.h"
+
+#define DMX_UART_IDLE_MAX 1023  // The maximum UART TX idle time, in bit times
+
+bool dmx_uart_init(dmx_port_t dmx_num, void *isr_context, int isr_flags) {
+    if (!dmx_host_start()) {
+        return false;
+    }
+
+    dmx_host_port_t *const port = &dmx_host_port[dmx_num];
+    taskENTER_CRITICAL(&dmx_host_spinlock);
+    port->uart.baud_rate    = DMX_BAUD_RATE;
+    port->uart.rts          = 1;
+    port->uart.invert_tx    = 0;
+    port->uart.intr_raw     = 0;
+    port->uart.intr_ena     = 0;
+    port->uart.rxfifo_full  = DMX_UART_FULL_DEFAULT;
+    port->uart.tx_idle      = 0;
+    port->uart.rx_len       = 0;
+    port->uart.rx_tout_ts   = -1;
+    port->uart.break_ts     = -1;
+    port->uart.tx_len       = 0;
+    port->uart.tx_done_ts   = -1;
+    port->uart.tap_break_ts = -1;
+    port->uart.isr_context  = isr_context;
+    dmx_host_uart_update(port);
+    taskEXIT_CRITICAL(&dmx_host_spinlock);
+
+    return true;
+}
+
+void dmx_uart_deinit(dmx_port_t dmx_num) {
+    dmx_host_port_t *const port = &dmx_host_port[dmx_num];
+    taskENTER_CRITICAL(&dmx_host_spinlock);
+    port->uart.isr_context = NULL;
+    port->uart.intr_ena    = 0;
+    taskEXIT_CRITICAL(&dmx_host_spinlock);
+}
+
+bool dmx_uart_set_pin(dmx_port_t dmx_num, int tx, int rx, int rts) {
+    return true;  // The simulated UARTs are always connected to the simulated bus
+}
+
+uint32_t dmx_uart_get_baud_rate(dmx_port_t dmx_num) { return dmx_host_port[dmx_num].uart.baud_rate; }
+
+void dmx_uart_set_baud_rate(dmx_port_t dmx_num, uint32_t baud_rate) {
+    taskENTER_CRITICAL(&dmx_host_spinlock);
+    dmx_host_port[dmx_num].uart.baud_rate = baud_rate;
+    taskEXIT_CRITICAL(&dmx_host_spinlock);
+}
+
+void dmx_uart_invert_tx(dmx_port_t dmx_num, int invert) {
+    dmx_host_port_t *const port = &dmx_host_port[dmx_num];
+    taskENTER_CRITICAL(&dmx_host_spinlock);
+    if (port->uart.invert_tx != invert) {
+        port->uart.invert_tx = invert;
+        const int64_t now    = dmx_host_now();
+        dmx_host_send_line(dmx_num, now, invert ? DMX_HOST_LINE_LOW : DMX_HOST_LINE_HIGH);
+        if (invert) {
+            port->uart.tap_break_ts = now;
+        }
+        dmx_host_kick();
+    }
+    taskEXIT_CRITICAL(&dmx_host_spinlock);
+}
+
+int dmx_uart_get_rts(dmx_port_t dmx_num) { return dmx_host_port[dmx_num].uart.rts; }
+
+int dmx_uart_get_interrupt_status(dmx_port_t dmx_num) {
+    dmx_host_port_t *const port = &dmx_host_port[dmx_num];
+    taskENTER_CRITICAL(&dmx_host_spinlock);
+    const int status = port->uart.intr_raw & port->uart.intr_ena;
+    taskEXIT_CRITICAL(&dmx_host_spinlock);
+    return status;
+}
+
+void dmx_uart_enable_interrupt(dmx_port_t dmx_num, int mask) {
+    dmx_host_port_t *const port = &dmx_host_port[dmx_num];
+    taskENTER_CRITICAL(&dmx_host_spinlock);
+    port->uart.intr_ena |= mask;
+    if (port->uart.intr_raw & port->uart.intr_ena) {
+        dmx_host_kick();  // Raise the simulated interrupt
+    }
+    taskEXIT_CRITICAL(&dmx_host_spinlock);
+}
+
+void dmx_uart_disable_interrupt(dmx_port_t dmx_num, int mask) {
+    taskENTER_CRITICAL(&dmx_host_spinlock);
+    dmx_host_port[dmx_num].uart.intr_ena &= ~mask;
+    taskEXIT_CRITICAL(&dmx_host_spinlock);
+}
+
+void dmx_uart_clear_interrupt(dmx_port_t dmx_num, int mask) {
+    dmx_host_port_t *const port = &dmx_host_port[dmx_num];
+    taskENTER_CRITICAL(&dmx_host_spinlock);
+    port->uart.intr_raw &= ~mask;
+    dmx_host_uart_update(port);  // Level-triggered interrupts are raised again
+    taskEXIT_CRITICAL(&dmx_host_spinlock);
+}
+
+uint32_t dmx_uart_get_rxfifo_len(dmx_port_t dmx_num) { return dmx_host_port[dmx_num].uart.rx_len; }
+
+bool dmx_uart_set_tx_idle(dmx_port_t dmx_num, uint32_t idle_len) {
+    const uint32_t bits = (idle_len * (DMX_BAUD_RATE / 1000) + 999) / 1000;  // Round up to the next bit
+    if (bits > DMX_UART_IDLE_MAX) {
+        return false;
+    }
+    taskENTER_CRITICAL(&dmx_host_spinlock);
+    dmx_host_port[dmx_num].uart.tx_idle = bits;
+    taskEXIT_CRITICAL(&dmx_host_spinlock);
+    return true;
+}
+
+void dmx_uart_set_rxfifo_full(dmx_port_t dmx_num, int threshold) {
+    dmx_host_port_t *const port = &dmx_host_port[dmx_num];
+    taskENTER_CRITICAL(&dmx_host_spinlock);
+    port->uart.rxfifo_full = threshold;
+    dmx_host_uart_update(port);
+    taskEXIT_CRITICAL(&dmx_host_spinlock);
+}
+
+void dmx_uart_read_rxfifo(dmx_port_t dmx_num, uint8_t *buf, int *size) {
+    dmx_host_port_t *const port = &dmx_host_port[dmx_num];
+    taskENTER_CRITICAL(&dmx_host_spinlock);
+    if (*size > port->uart.rx_len) {
+        *size = port->uart.rx_len;
+    }
+    memcpy(buf, port->uart.rxfifo, *size);
+    port->uart.rx_len -= *size;
+    memmove(port->uart.rxfifo, &port->uart.rxfifo[*size], port->uart.rx_len);
+    taskEXIT_CRITICAL(&dmx_host_spinlock);
+}
+
+void dmx_uart_set_rts(dmx_port_t dmx_num, int set) {
+    dmx_host_port_t *const port = &dmx_host_port[dmx_num];
+    taskENTER_CRITICAL(&dmx_host_spinlock);
+    port->uart.rts = set;
+    if (!set) {
+        port->uart.break_ts = -1;  // The transceiver stops receiving the RX line
+    }
+    taskEXIT_CRITICAL(&dmx_host_spinlock);
+}
+
+void dmx_uart_rxfifo_reset(dmx_port_t dmx_num) {
+    dmx_host_port_t *const port = &dmx_host_port[dmx_num];
+    taskENTER_CRITICAL(&dmx_host_spinlock);
+    port->uart.rx_len     = 0;
+    port->uart.rx_tout_ts = -1;
+    taskEXIT_CRITICAL(&dmx_host_spinlock);
+}
+
+uint32_t dmx_uart_get_txfifo_len(dmx_port_t dmx_num) {
+    return SOC_UART_FIFO_LEN - dmx_host_port[dmx_num].uart.tx_len;
+}
+
+void dmx_uart_write_txfifo(dmx_port_t dmx_num, const void *buf, int *size) {
+    dmx_host_port_t *const port = &dmx_host_port[dmx_num];
+    taskENTER_CRITICAL(&dmx_host_spinlock);
+    const int txfifo_len = SOC_UART_FIFO_LEN - port->uart.tx_len;
+    if (*size > txfifo_len) *size = txfifo_len;
+    if (*size > 0) {
+        const int64_t now = dmx_host_now();
+        if (port->uart.tx_len == 0 && port->uart.tx_done_ts < 0 && port->uart.tx_next_ts <= now) {
+            // The UART is idle so the packet starts after the TX idle time
+            port->uart.tx_next_ts = now + (int64_t)port->uart.tx_idle * dmx_host_bit_us(port);
+        }
+        port->uart.tx_done_ts = -1;  // The UART is not done until the new slots are shifted out
+        memcpy(&port->uart.txfifo[port->uart.tx_len], buf, *size);
+        port->uart.tx_len += *size;
+        port->uart.intr_raw &= ~UART_INTR_TX_DONE;
+        dmx_host_kick();
+    }
+    taskEXIT_CRITICAL(&dmx_host_spinlock);
+}
+
+void dmx_uart_txfifo_reset(dmx_port_t dmx_num) {
+    dmx_host_port_t *const port = &dmx_host_port[dmx_num];
+    taskENTER_CRITICAL(&dmx_host_spinlock);
+    port->uart.tx_len = 0;
+    dmx_host_uart_update(port);
+    taskEXIT_CRITICAL(&dmx_host_spinlock);
+}
+#endif
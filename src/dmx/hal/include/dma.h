@@ -0,0 +1,59 @@
+/**
+ * @file dmx/hal/include/dma.h
+ * @author Mitch Weisbrod (mitch@theweisbrods.com)
+ * @brief This file is the DMA Hardware Abstraction Layer (HAL) of esp_dmx. It
+ * contains low-level functions to transmit DMX and RDM packets using the UHCI
+ * and GDMA peripherals. When DMA is used, an entire DMX packet is moved into
+ * the UART using a single DMA descriptor instead of refilling the UART FIFO on
+ * every FIFO-empty interrupt. The UHCI peripheral can only be attached to one
+ * UART at a time, so only the first DMX port to claim it uses DMA. All other
+ * ports fall back to writing the UART FIFO. This file is not considered part of
+ * the API and should not be included by the user.
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "../../include/types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Attempts to claim the DMA peripherals for DMX transmission on the
+ * specified port.
+ *
+ * @param dmx_num The DMX port number.
+ * @return true if the port transmits using DMA.
+ * @return false if DMA is not supported, not enabled, or already in use by
+ * another port.
+ */
+bool dmx_dma_init(dmx_port_t dmx_num);
+
+/**
+ * @brief Releases the DMA peripherals if they are claimed by the specified
+ * port.
+ *
+ * @param dmx_num The DMX port number.
+ */
+void dmx_dma_deinit(dmx_port_t dmx_num);
+
+/**
+ * @brief Starts a DMA transfer of a buffer to the UART transmit FIFO. This
+ * function returns immediately and the UART TX done interrupt is triggered
+ * when the transfer has been sent on the DMX bus.
+ *
+ * @param dmx_num The DMX port number.
+ * @param[in] buf The buffer to transmit. It must be in DMA-capable memory.
+ * @param size The number of bytes to transmit.
+ * @return true if the transfer was started.
+ * @return false if the port does not use DMA. The caller should write the UART
+ * FIFO instead.
+ */
+bool dmx_dma_write(dmx_port_t dmx_num, const void *buf, size_t size);
+
+#ifdef __cplusplus
+}
+#endif
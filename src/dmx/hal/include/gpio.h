@@ -9,7 +9,11 @@
 #pragma once
 
 #include "../../include/types.h"
+#ifdef CONFIG_IDF_TARGET_LINUX
+#include "../host/include/port.h"
+#else
 #include "driver/gpio.h"
+#endif
 
 #ifdef __cplusplus
 extern "C" {
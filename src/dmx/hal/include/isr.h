@@ -0,0 +1,49 @@
+/**
+ * @file dmx/hal/include/isr.h
+ * @author Mitch Weisbrod (mitch@theweisbrods.com)
+ * @brief This file contains the interrupt handlers of esp_dmx. The handlers
+ * only use the functions of the UART, timer, and GPIO Hardware Abstraction
+ * Layers, so they are shared by the ESP32 HAL and the host HAL. Each HAL
+ * registers these handlers with its own interrupt source. This file is not
+ * considered part of the API and should not be included by the user.
+ */
+#pragma once
+
+#include <stdbool.h>
+
+#include "../../include/types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Handles the UART interrupts of a DMX port. It reads and writes the
+ * UART FIFOs and runs the state machine which receives DMX and RDM packets.
+ *
+ * @param[inout] arg The DMX driver of the DMX port.
+ */
+void dmx_uart_isr(void *arg);
+
+/**
+ * @brief Handles the alarm of the DMX timer of a DMX port. It times the DMX
+ * break and mark-after-break of sent packets, the RDM turnaround times, and
+ * continuously sent packets.
+ *
+ * @param[inout] arg The DMX driver of the DMX port.
+ * @return true if a higher priority task was woken.
+ */
+bool dmx_timer_handle_alarm(void *arg);
+
+/**
+ * @brief Handles the edges on the sniffer pin of a DMX port. It measures the
+ * DMX break and mark-after-break of received packets. It is not compiled when
+ * CONFIG_DMX_SNIFFER_DISABLE is enabled.
+ *
+ * @param[inout] arg The DMX driver of the DMX port.
+ */
+void dmx_gpio_isr(void *arg);
+
+#ifdef __cplusplus
+}
+#endif
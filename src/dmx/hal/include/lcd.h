@@ -0,0 +1,70 @@
+/**
+ * @file dmx/hal/include/lcd.h
+ * @author Mitch Weisbrod (mitch@theweisbrods.com)
+ * @brief This file is the LCD Hardware Abstraction Layer (HAL) of esp_dmx. It
+ * contains low-level functions to clock samples out of a parallel Intel 8080
+ * LCD bus using DMA. On the ESP32 the bus is driven by the I2S peripheral in
+ * LCD mode and on other chips by the LCD peripheral. Each data pin of the bus
+ * carries one parallel DMX port. This file is not considered part of the API
+ * and should not be included by the user.
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "../../include/types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief The type of function which is called in an interrupt when a buffer
+ * has finished being clocked out of the LCD bus.
+ *
+ * @param[in] context The context which was passed to dmx_lcd_init().
+ * @return true if a higher priority task was woken.
+ */
+typedef bool (*dmx_lcd_done_cb_t)(void *context);
+
+/**
+ * @brief Initializes the LCD bus. One sample is clocked out of the bus on
+ * every cycle of the pixel clock.
+ *
+ * @param[in] data_pins The GPIO numbers of the data pins of the bus.
+ * @param pin_count The number of data pins. Must be 8 or 16.
+ * @param clock_pin The GPIO number of the pixel clock pin of the bus.
+ * @param dc_pin The GPIO number of the data/command pin of the bus.
+ * @param clock_hz The frequency of the pixel clock.
+ * @param max_transfer_size The size in bytes of the largest buffer which is
+ * written.
+ * @param cb The function to call when a buffer has been written.
+ * @param[in] context The context of the callback.
+ * @return true if the LCD bus was initialized.
+ * @return false if the LCD bus is not supported or could not be allocated.
+ */
+bool dmx_lcd_init(const int *data_pins, int pin_count, int clock_pin, int dc_pin, uint32_t clock_hz,
+                  size_t max_transfer_size, dmx_lcd_done_cb_t cb, void *context);
+
+/**
+ * @brief De-initializes the LCD bus.
+ */
+void dmx_lcd_deinit();
+
+/**
+ * @brief Queues a buffer to be clocked out of the LCD bus. This function
+ * returns immediately unless two buffers are already queued. The callback
+ * which was passed to dmx_lcd_init() is called once per buffer in the order
+ * in which the buffers were queued.
+ *
+ * @param[in] buf The buffer to write. It must be in DMA-capable memory.
+ * @param size The size of the buffer in bytes.
+ * @return true if the buffer was queued.
+ * @return false on failure.
+ */
+bool dmx_lcd_write(const void *buf, size_t size);
+
+#ifdef __cplusplus
+}
+#endif
@@ -48,6 +48,42 @@ size_t dmx_nvs_get(dmx_port_t dmx_num, rdm_sub_device_t sub_device, rdm_pid_t pi
  */
 bool dmx_nvs_set(dmx_port_t dmx_num, rdm_sub_device_t sub_device, rdm_pid_t pid, const void *param, size_t size);
 
+/**
+ * @brief Begins a batch of writes to non-volatile storage. Calls to
+ * dmx_nvs_set() which are made before the matching call to dmx_nvs_end() are
+ * written using a single NVS handle and are committed together. Batches may be
+ * nested, in which case they are committed when the outermost batch ends. Other
+ * tasks which write to non-volatile storage are blocked until the batch ends.
+ * If the DMX driver ISRs are not in IRAM, every enabled DMX driver is disabled
+ * once it has finished sending its current packet and stays disabled until the
+ * batch ends.
+ *
+ * @return true if non-volatile storage was opened.
+ * @return false on failure.
+ */
+bool dmx_nvs_begin();
+
+/**
+ * @brief Ends a batch of writes which was begun with dmx_nvs_begin(). When the
+ * outermost batch ends, the writes are committed to non-volatile storage and
+ * the DMX drivers which were disabled are re-enabled.
+ *
+ * @return true if the writes were committed.
+ * @return false on failure.
+ */
+bool dmx_nvs_end();
+
+/**
+ * @brief Writes the parameter image of a DMX port to non-volatile storage if it
+ * has changed since it was last written. Parameter images are only used when
+ * CONFIG_DMX_NVS_BLOB is enabled. Otherwise this function does nothing.
+ *
+ * @param dmx_num The DMX port number.
+ * @return true if the parameter image is up to date in non-volatile storage.
+ * @return false on failure.
+ */
+bool dmx_nvs_sync(dmx_port_t dmx_num);
+
 #ifdef __cplusplus
 }
 #endif
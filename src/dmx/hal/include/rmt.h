@@ -0,0 +1,45 @@
+/**
+ * @file dmx/hal/include/rmt.h
+ * @author Mitch Weisbrod (mitch@theweisbrods.com)
+ * @brief This file is the RMT Hardware Abstraction Layer (HAL) of esp_dmx. It
+ * contains low-level functions to run the DMX sniffer on the RMT peripheral.
+ * The RMT receiver timestamps every edge on the sniffer pin in hardware and
+ * interrupts the CPU only once its memory block is half full, so the sniffer
+ * does not need an interrupt on every edge of the DMX signal. This file is not
+ * considered part of the API and should not be included by the user.
+ */
+#pragma once
+
+#include <stdbool.h>
+
+#include "../../include/types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Initializes an RMT receive channel for the DMX sniffer. Break and
+ * mark-after-break lengths are written to the DMX driver sniffer metadata in
+ * microseconds.
+ *
+ * @param dmx_num The DMX port number.
+ * @param[in] isr_context Context to be used in the DMX RMT callback.
+ * @param sniffer_pin The sniffer pin GPIO number.
+ * @param isr_flags The interrupt allocation flags to use.
+ * @return true if the RMT channel was initialized.
+ * @return false if the RMT sniffer is not enabled or if there is no free RMT
+ * receive channel.
+ */
+bool dmx_rmt_init(dmx_port_t dmx_num, void *isr_context, int sniffer_pin, int isr_flags);
+
+/**
+ * @brief De-initializes the RMT receive channel of the DMX sniffer.
+ *
+ * @param dmx_num The DMX port number.
+ */
+void dmx_rmt_deinit(dmx_port_t dmx_num);
+
+#ifdef __cplusplus
+}
+#endif
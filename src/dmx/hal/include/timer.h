@@ -12,7 +12,9 @@
 
 #include "../../include/types.h"
 
-#if ESP_IDF_VERSION_MAJOR >= 5
+#if defined(CONFIG_IDF_TARGET_LINUX)
+#include "../host/include/port.h"
+#elif ESP_IDF_VERSION_MAJOR >= 5
 #include "driver/gptimer.h"
 #include "esp_timer.h"
 #else
@@ -96,6 +98,45 @@ void dmx_timer_set_alarm(dmx_port_t dmx_num, uint64_t alarm, bool auto_reload);
  */
 void dmx_timer_start(dmx_port_t dmx_num);
 
+/**
+ * @brief Gets the CPU cycle counter of the current core. It is a single
+ * register read, so it may be used to measure short intervals in an interrupt.
+ * The counter wraps around, so only the difference between two counts which
+ * were read on the same core is meaningful.
+ *
+ * @return The current CPU cycle count.
+ */
+uint32_t dmx_timer_get_cycle_count();
+
+/**
+ * @brief Converts a number of CPU cycles to microseconds at the current CPU
+ * frequency.
+ *
+ * @param cycles The number of CPU cycles.
+ * @return The number of microseconds, rounded to the nearest microsecond.
+ */
+uint64_t dmx_timer_cycles_to_micros(uint64_t cycles);
+
+/**
+ * @brief Gets a timestamp which is cheap to read from an interrupt. If
+ * CONFIG_DMX_ISR_CYCLE_TIMESTAMPS is enabled, this is the CPU cycle counter of
+ * the current core. Otherwise, it is the number of microseconds since boot.
+ * Timestamps wrap around, so only the difference between two timestamps which
+ * were read on the same core is meaningful.
+ *
+ * @return The current timestamp.
+ */
+uint32_t dmx_timer_get_timestamp();
+
+/**
+ * @brief Converts the difference between two values returned from
+ * dmx_timer_get_timestamp() to microseconds.
+ *
+ * @param elapsed The difference between two timestamps.
+ * @return The difference in microseconds, rounded to the nearest microsecond.
+ */
+uint32_t dmx_timer_timestamp_to_micros(uint32_t elapsed);
+
 /**
  * @brief Gets the number of microseconds that have elapsed since boot.
  *
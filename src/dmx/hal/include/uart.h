@@ -11,19 +11,31 @@
 #pragma once
 
 #include "../../include/types.h"
+#ifdef CONFIG_IDF_TARGET_LINUX
+#include "../host/include/port.h"
+#else
 #include "hal/uart_hal.h"
+#endif
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+#ifdef CONFIG_DMX_UART_RX_FULL_THRESHOLD
+#define DMX_UART_FULL_DMX CONFIG_DMX_UART_RX_FULL_THRESHOLD
+#else
+#define DMX_UART_FULL_DMX 1
+#endif
+
+#define DMX_UART_FULL_DEFAULT 1
+
 enum dmx_interrupt_mask_t {
     DMX_INTR_RX_FIFO_OVERFLOW = UART_INTR_RXFIFO_OVF,
     DMX_INTR_RX_FRAMING_ERR   = UART_INTR_PARITY_ERR | UART_INTR_FRAM_ERR,
     DMX_INTR_RX_ERR           = DMX_INTR_RX_FIFO_OVERFLOW | DMX_INTR_RX_FRAMING_ERR,
 
     DMX_INTR_RX_BREAK = UART_INTR_BRK_DET,
-    DMX_INTR_RX_DATA  = UART_INTR_RXFIFO_FULL,
+    DMX_INTR_RX_DATA  = UART_INTR_RXFIFO_FULL | UART_INTR_RXFIFO_TOUT,
     DMX_INTR_RX_ALL   = DMX_INTR_RX_DATA | DMX_INTR_RX_BREAK | DMX_INTR_RX_ERR,
 
     DMX_INTR_TX_DATA = UART_INTR_TXFIFO_EMPTY,
@@ -131,6 +143,28 @@ void dmx_uart_clear_interrupt(dmx_port_t dmx_num, int mask);
  */
 uint32_t dmx_uart_get_rxfifo_len(dmx_port_t dmx_num);
 
+/**
+ * @brief Sets the time that the UART idles before it sends the data which is
+ * written to the UART TX FIFO. This may be used to generate the DMX
+ * mark-after-break.
+ *
+ * @param dmx_num The DMX port number.
+ * @param idle_len The idle time in microseconds.
+ * @return true if the UART is able to idle for the requested time.
+ * @return false if the idle time is too long.
+ */
+bool dmx_uart_set_tx_idle(dmx_port_t dmx_num, uint32_t idle_len);
+
+/**
+ * @brief Sets the number of bytes in the UART RX FIFO at which the UART RX
+ * interrupt fires. Bytes which do not reach the threshold are read when the
+ * UART RX timeout interrupt fires.
+ *
+ * @param dmx_num The DMX port number.
+ * @param threshold The number of bytes at which the UART RX interrupt fires.
+ */
+void dmx_uart_set_rxfifo_full(dmx_port_t dmx_num, int threshold);
+
 /**
  * @brief Reads from the UART RX FIFO.
  *
@@ -0,0 +1,685 @@
+#include "include/isr.h"
+
+#include <string.h>
+
+#include "./include/dma.h"
+#include "./include/gpio.h"
+#include "./include/timer.h"
+#include "./include/uart.h"
+#include "./../include/service.h"
+#include "endian.h"
+#include "./../../rdm/include/driver.h"
+#include "./../../rdm/include/uid.h"
+
+enum {
+    RDM_TYPE_IS_NOT_RDM = 0,  // The packet is not RDM.
+    RDM_TYPE_IS_DISCOVERY,    // The packet is an RDM discovery request.
+    RDM_TYPE_IS_RESPONSE,     // The packet is an RDM response.
+    RDM_TYPE_IS_BROADCAST,    // The packet is a non-discovery RDM broadcast.
+    RDM_TYPE_IS_REQUEST,      // The packet is a standard RDM request.
+    RDM_TYPE_IS_UNKNOWN,      // The packet is RDM, but it is unclear what type it is.
+};
+
+#ifdef CONFIG_DMX_CHANGED_SLOTS
+static void DMX_ISR_ATTR dmx_uart_mark_changed(dmx_driver_t *driver, const uint8_t *slots, int offset, int size) {
+    const uint8_t *const last = &driver->dmx.changed_last[offset];
+    for (int i = 0; i < size; ++i) {
+        if (last[i] != slots[i]) {
+            const int slot = offset + i;
+            driver->dmx.changed_pending[slot / 32] |= 1u << (slot % 32);
+        }
+    }
+}
+#endif
+
+#ifndef CONFIG_DMX_SNIFFER_DISABLE
+static void DMX_ISR_ATTR dmx_uart_sniffer_commit(dmx_driver_t *driver, int64_t now, int dmx_head) {
+    struct dmx_driver_sniffer_t *const sniffer = &driver->sniffer;
+
+    /* The UART ISR is the only writer of the sniffer history. The reader only
+    writes the tail, so the history is shared without a lock. The spinlock is
+    taken to read the break and mark-after-break of the sniffer backend and so
+    that the history is not freed while it is written. */
+    taskENTER_CRITICAL_ISR(DMX_SPINLOCK(driver->dmx_num));
+    if (sniffer->history != NULL && sniffer->last_break_ts > -1 && dmx_head > 0) {
+        const uint32_t head = sniffer->history_head;
+        const uint32_t tail = __atomic_load_n(&sniffer->history_tail, __ATOMIC_ACQUIRE);
+        if (head - tail < DMX_SNIFFER_HISTORY_SIZE) {
+            dmx_metadata_t *const entry = &sniffer->history[head % DMX_SNIFFER_HISTORY_SIZE];
+            entry->break_len            = sniffer->metadata[sniffer->buffer_index].break_len;
+            entry->mab_len              = sniffer->metadata[sniffer->buffer_index].mab_len;
+            entry->timestamp            = sniffer->last_break_ts;
+            entry->period               = now - sniffer->last_break_ts;
+            entry->size                 = dmx_head - 1;  // The DMX break is received as a null slot
+            entry->sc                   = driver->dmx.data[0];
+            entry->flags                = sniffer->flags;
+            if (sniffer->history_overrun) {
+                entry->flags |= DMX_SNIFFER_FLAG_HISTORY_OVERRUN;
+                sniffer->history_overrun = false;
+            }
+            __atomic_store_n(&sniffer->history_head, head + 1, __ATOMIC_RELEASE);
+        } else {
+            sniffer->history_overrun = true;
+        }
+    }
+    sniffer->last_break_ts = now;
+    sniffer->flags         = 0;
+    taskEXIT_CRITICAL_ISR(DMX_SPINLOCK(driver->dmx_num));
+}
+#endif
+
+void DMX_ISR_ATTR dmx_uart_isr(void *arg) {
+    const uint32_t isr_start   = dmx_timer_get_cycle_count();
+    const int64_t now          = dmx_timer_get_micros_since_boot();
+    dmx_driver_t *const driver = arg;
+    const dmx_port_t dmx_num   = driver->dmx_num;
+    int task_awoken            = false;
+    DMX_TRACE(dmx_num, DMX_TRACE_UART_ISR_ENTER, DMX_OK, 0);
+
+    while (true) {
+        const uint32_t intr_flags = dmx_uart_get_interrupt_status(dmx_num);
+        if (intr_flags == 0) break;
+        DMX_TRACE(dmx_num, DMX_TRACE_UART_INTR, DMX_OK, intr_flags);
+
+        // DMX Receive ####################################################
+        if (intr_flags & DMX_INTR_RX_ALL) {
+            // Read data into the DMX buffer if there is enough space
+            int dmx_head = DMX_STATE_HEAD(DMX_STATE_LOAD(driver));
+            if (dmx_head >= 0 && dmx_head < DMX_PACKET_SIZE_MAX) {
+                int read_len         = DMX_PACKET_SIZE_MAX - dmx_head;
+                uint8_t *const slots = &driver->dmx.data[dmx_head];
+                dmx_uart_read_rxfifo(dmx_num, slots, &read_len);
+#ifdef CONFIG_DMX_CHANGED_SLOTS
+                if (driver->dmx.data[0] == DMX_SC) {
+                    // Compare the received slots to the last published DMX packet with a null start code
+                    dmx_uart_mark_changed(driver, slots, dmx_head, read_len);
+                }
+#endif
+                if (driver->dmx.data[0] == RDM_SC) {
+                    // Sum the RDM packet as it is received so its checksum need not be calculated when it is complete
+                    uint16_t checksum = driver->dmx.checksum;
+                    for (int i = dmx_head; i < dmx_head + read_len && (i < 3 || i < driver->dmx.data[2]); ++i) {
+                        checksum += driver->dmx.data[i];
+                    }
+                    driver->dmx.checksum = checksum;
+                }
+                if (driver->repeater.outputs != 0) {
+                    // The DMX break is received as a null slot which is not repeated
+                    const int forward_len = intr_flags & DMX_INTR_RX_BREAK ? read_len - 1 : read_len;
+                    dmx_repeater_forward(dmx_num, dmx_head, slots, forward_len);
+                }
+                dmx_head += read_len;
+                dmx_state_set_head(dmx_num, dmx_head);
+            } else {
+                if (dmx_head > 0) {
+                    // Record the number of slots received for error reporting
+                    dmx_head += dmx_uart_get_rxfifo_len(dmx_num);
+                    dmx_state_set_head(dmx_num, dmx_head);
+                }
+                dmx_uart_rxfifo_reset(dmx_num);
+            }
+            dmx_uart_clear_interrupt(dmx_num, DMX_INTR_RX_ALL);
+
+            // Handle DMX break condition
+            if (intr_flags & DMX_INTR_RX_BREAK) {
+                DMX_TRACE(dmx_num, DMX_TRACE_RX_BREAK, DMX_OK, dmx_head);
+
+                // Handle possible condition where expected packet size is too large
+                if (DMX_STATE_PROGRESS(DMX_STATE_LOAD(driver)) == DMX_PROGRESS_IN_DATA && dmx_head > 0) {
+                    taskENTER_CRITICAL_ISR(DMX_SPINLOCK(dmx_num));
+                    driver->dmx.size = dmx_head - 1;  // Attempt to fix packet size
+                    ++driver->stats.not_enough_slots;
+                    ++driver->dmx.rx_sequence;
+                    driver->dmx.rx_packet_break_timestamp = driver->dmx.rx_break_timestamp;
+                    driver->dmx.rx_packet_timestamp       = now;
+                    driver->dmx.rx_packet_data            = driver->dmx.data;
+                    if (driver->task_waiting) {
+                        xTaskNotifyFromISR(driver->task_waiting, DMX_ERR_NOT_ENOUGH_SLOTS, eSetValueWithOverwrite,
+                                           &task_awoken);
+                    }
+                    taskEXIT_CRITICAL_ISR(DMX_SPINLOCK(dmx_num));
+                }
+
+#ifndef CONFIG_DMX_SNIFFER_DISABLE
+                // Record the packet which was just finished in the sniffer history
+                if (driver->sniffer.is_enabled) {
+                    dmx_uart_sniffer_commit(driver, now, dmx_head);
+                }
+#endif
+
+                // Reset the DMX buffer for the next packet
+                taskENTER_CRITICAL_ISR(DMX_SPINLOCK(dmx_num));
+                dmx_state_update(dmx_num, DMX_STATE_MASK, DMX_STATE(DMX_STATUS_RECEIVING, DMX_PROGRESS_IN_BREAK, 0));
+                driver->dmx.checksum           = 0;
+                driver->dmx.rx_break_timestamp = now;
+#ifndef CONFIG_RDM_RESPONDER_DISABLE
+                driver->rdm.fast_discovery.responded = false;
+#endif
+                dmx_buffer_rotate(dmx_num);  // Don't overwrite the last complete packet
+                dmx_buffer_invalidate_rdm(dmx_num);
+#ifdef CONFIG_DMX_CHANGED_SLOTS
+                for (int i = 0; i < DMX_SLOT_BITMAP_WORDS; ++i) {
+                    driver->dmx.changed_pending[i] = 0;
+                }
+#endif
+                taskEXIT_CRITICAL_ISR(DMX_SPINLOCK(dmx_num));
+                dmx_uart_set_rxfifo_full(dmx_num, DMX_UART_FULL_DEFAULT);  // Read the start code immediately
+                continue;  // Nothing else to do on DMX break
+            }
+            int progress = DMX_STATE_PROGRESS(DMX_STATE_LOAD(driver));
+            if (progress == DMX_PROGRESS_IN_BREAK || progress == DMX_PROGRESS_IN_MAB) {
+                // UART ISR cannot detect MAB so we go straight to DMX_PROGRESS_IN_DATA
+                progress = DMX_PROGRESS_IN_DATA;
+                dmx_state_set_progress(dmx_num, progress);
+            }
+
+            // Guard against notifying multiple times for the same packet
+            if (progress != DMX_PROGRESS_IN_DATA) {
+                continue;
+            }
+
+            // Process the data depending on the type of packet that was received
+            dmx_err_t err;
+            int rdm_type;
+            bool packet_is_complete;
+            if (intr_flags & DMX_INTR_RX_ERR) {
+                rdm_type           = RDM_TYPE_IS_NOT_RDM;
+                packet_is_complete = true;
+                err                = intr_flags & DMX_INTR_RX_FIFO_OVERFLOW ? DMX_ERR_UART_OVERFLOW  // UART overflow
+                                                                            : DMX_ERR_IMPROPER_SLOT;  // Missing stop bits
+                if (err == DMX_ERR_UART_OVERFLOW) {
+                    ++driver->stats.uart_overflows;
+                } else {
+                    ++driver->stats.improper_slots;
+                }
+#ifndef CONFIG_DMX_SNIFFER_DISABLE
+                driver->sniffer.flags |= err == DMX_ERR_UART_OVERFLOW ? DMX_SNIFFER_FLAG_UART_OVERFLOW
+                                                                      : DMX_SNIFFER_FLAG_IMPROPER_SLOT;
+#endif
+            } else {
+                // Determine the type of the packet that was received
+                const uint8_t sc = driver->dmx.data[0];  // DMX start-code.
+                if (sc == RDM_SC) {
+                    rdm_type = RDM_TYPE_IS_UNKNOWN;  // Determine actual type later
+                } else if (sc == RDM_PREAMBLE || sc == RDM_DELIMITER) {
+                    rdm_type = RDM_TYPE_IS_DISCOVERY;
+                } else {
+                    rdm_type = RDM_TYPE_IS_NOT_RDM;
+                    taskENTER_CRITICAL_ISR(DMX_SPINLOCK(dmx_num));
+                    // Get the best resolution on the controller EOP timestamp
+                    driver->dmx.controller_eop_timestamp = now;
+                    taskEXIT_CRITICAL_ISR(DMX_SPINLOCK(dmx_num));
+
+                    // The rest of a DMX packet is read in batches. RDM packets are read slot by slot.
+                    dmx_uart_set_rxfifo_full(dmx_num, DMX_UART_FULL_DMX);
+                }
+
+                // Set inter-slot timer for RDM response packets
+                if (driver->is_controller && rdm_type != RDM_TYPE_IS_NOT_RDM) {
+                    dmx_timer_set_counter(dmx_num, 0);
+                    dmx_timer_set_alarm(dmx_num, RDM_TIMING_RESPONDER_INTER_SLOT_MAX, false);
+                }
+
+                err = DMX_OK;
+            }
+            bool is_addressed = true;  // True if an RDM packet is addressed to this device
+            while (err == DMX_OK) {
+                if (rdm_type == RDM_TYPE_IS_DISCOVERY) {
+                    // Parse an RDM discovery response packet
+                    if (dmx_head < 17) {
+                        packet_is_complete = false;
+                        break;  // Haven't received the minimum packet size
+                    }
+
+                    // Get the delimiter index
+                    int delimiter_idx = 0;
+                    for (; delimiter_idx <= 7; ++delimiter_idx) {
+                        const uint8_t slot_value = driver->dmx.data[delimiter_idx];
+                        if (slot_value != RDM_PREAMBLE) {
+                            if (slot_value != RDM_DELIMITER) {
+                                delimiter_idx = 9;  // Force invalid packet type
+                            }
+                            break;
+                        }
+                    }
+                    if (delimiter_idx > 8) {
+                        rdm_type = RDM_TYPE_IS_NOT_RDM;
+                        continue;  // Packet is malformed - treat it as DMX
+                    }
+
+                    // Process RDM discovery response packet
+                    if (dmx_head < delimiter_idx + 17) {
+                        packet_is_complete = false;
+                        break;  // Haven't received full RDM_PID_DISC_UNIQUE_BRANCH response
+                    } else if (!rdm_read_header_isr(dmx_num, -1)) {
+                        ++driver->stats.rdm_checksum_errors;
+                        rdm_type = RDM_TYPE_IS_NOT_RDM;
+                        continue;  // Packet is malformed - treat it as DMX
+                    } else {
+                        driver->dmx.last_responder_pid      = RDM_PID_DISC_UNIQUE_BRANCH;
+                        driver->dmx.responder_sent_last     = true;
+                        driver->dmx.responder_eop_timestamp = now;
+                        packet_is_complete              = true;
+                        is_addressed                    = driver->is_controller;
+                        break;
+                    }
+                } else if (rdm_type != RDM_TYPE_IS_NOT_RDM) {
+                    // Parse a standard RDM packet
+                    uint8_t msg_len;
+                    if (dmx_head < sizeof(rdm_header_t) + 2) {
+                        packet_is_complete = false;
+                        break;  // Haven't received full RDM header and checksum yet
+                    } else if (driver->dmx.data[1] != RDM_SUB_SC || !rdm_cc_is_valid(driver->dmx.data[20]) ||
+                               (msg_len = driver->dmx.data[2]) < sizeof(rdm_header_t)) {
+                        rdm_type = RDM_TYPE_IS_NOT_RDM;
+                        continue;  // Packet is malformed - treat it as DMX
+                    } else if (dmx_head < msg_len + 2) {
+                        packet_is_complete = false;
+                        break;  // Haven't received full RDM packet and checksum yet
+                    } else if (!rdm_read_header_isr(dmx_num, driver->dmx.checksum)) {
+                        ++driver->stats.rdm_checksum_errors;
+                        rdm_type = RDM_TYPE_IS_NOT_RDM;
+                        continue;  // Packet is malformed - treat it as DMX
+                    } else {
+                        bool responder_sent_last;
+                        const rdm_cc_t cc        = driver->dmx.data[20];
+                        const rdm_pid_t *pid     = (rdm_pid_t *)&driver->dmx.data[21];
+                        const rdm_uid_t *uid_ptr = (rdm_uid_t *)&driver->dmx.data[3];
+                        const rdm_uid_t dest_uid = {.man_id = bswap16(uid_ptr->man_id),
+                                                    .dev_id = bswap32(uid_ptr->dev_id)};
+                        if (!rdm_cc_is_request(cc)) {
+                            rdm_type            = RDM_TYPE_IS_RESPONSE;
+                            responder_sent_last = true;
+                        } else if (rdm_uid_is_broadcast(&dest_uid)) {
+                            rdm_type            = RDM_TYPE_IS_BROADCAST;
+                            responder_sent_last = false;
+                        } else {
+                            rdm_type            = RDM_TYPE_IS_REQUEST;
+                            responder_sent_last = false;
+                        }
+                        if (!responder_sent_last) {
+                            taskENTER_CRITICAL_ISR(DMX_SPINLOCK(dmx_num));
+                            driver->dmx.controller_eop_timestamp = now;
+                            driver->dmx.last_controller_pid      = bswap16(*pid);
+                            taskEXIT_CRITICAL_ISR(DMX_SPINLOCK(dmx_num));
+                        } else {
+                            taskENTER_CRITICAL_ISR(DMX_SPINLOCK(dmx_num));
+                            driver->dmx.last_responder_pid      = bswap16(*pid);
+                            driver->dmx.responder_eop_timestamp = now;
+                            taskEXIT_CRITICAL_ISR(DMX_SPINLOCK(dmx_num));
+                        }
+                        taskENTER_CRITICAL_ISR(DMX_SPINLOCK(dmx_num));
+                        driver->dmx.responder_sent_last = responder_sent_last;
+                        taskEXIT_CRITICAL_ISR(DMX_SPINLOCK(dmx_num));
+                        packet_is_complete = true;
+                        taskENTER_CRITICAL_ISR(DMX_SPINLOCK(dmx_num));
+                        is_addressed = rdm_port_is_target(dmx_num, &dest_uid);
+                        taskEXIT_CRITICAL_ISR(DMX_SPINLOCK(dmx_num));
+                        break;
+                    }
+                } else {
+                    // Parse a standard DMX packet
+                    // TODO: verify that a data collision hasn't happened
+                    taskENTER_CRITICAL_ISR(DMX_SPINLOCK(dmx_num));
+                    driver->dmx.last_controller_pid = 0;
+                    driver->dmx.responder_sent_last = false;
+                    taskEXIT_CRITICAL_ISR(DMX_SPINLOCK(dmx_num));
+                    packet_is_complete = (dmx_head >= driver->dmx.size);
+                    break;
+                }
+            }
+            if (!packet_is_complete) {
+                continue;
+            }
+            dmx_timer_stop(dmx_num);
+
+            // Answer discovery requests without waiting for the RDM responder task
+            bool is_responding = false;
+#ifndef CONFIG_RDM_RESPONDER_DISABLE
+            if (err == DMX_OK && (rdm_type == RDM_TYPE_IS_REQUEST || rdm_type == RDM_TYPE_IS_BROADCAST)) {
+                is_responding = rdm_fast_discovery_isr(dmx_num);
+            }
+#ifdef CONFIG_RDM_RESPONDER_IRAM_SAFE
+            if (!is_responding && err == DMX_OK && rdm_type == RDM_TYPE_IS_REQUEST) {
+                is_responding = rdm_response_cache_isr(dmx_num);
+            }
+#endif
+#endif
+
+            // Filter packets which the waiting task should not be woken for. Packets with errors are never filtered.
+            const uint8_t filter_sc = rdm_type == RDM_TYPE_IS_NOT_RDM ? driver->dmx.data[0] : RDM_SC;
+            const bool is_accepted =
+                err != DMX_OK || ((driver->filter.start_codes[filter_sc / 32] & (1u << (filter_sc % 32))) &&
+                                  (is_addressed || !driver->filter.is_rdm_filtered));
+
+            // Set driver flags and notify task
+            DMX_TRACE(dmx_num, DMX_TRACE_RX_PACKET, err, dmx_head);
+            ++driver->stats.packets_received;
+            if (err == DMX_OK && rdm_type == RDM_TYPE_IS_NOT_RDM) {
+                dmx_stats_record_packet(dmx_num, now);
+            }
+            taskENTER_CRITICAL_ISR(DMX_SPINLOCK(dmx_num));
+            dmx_state_update(dmx_num, DMX_STATE_STATUS_MASK | DMX_STATE_PROGRESS_MASK,
+                             DMX_STATE(is_responding ? DMX_STATUS_SENDING : DMX_STATUS_IDLE,  // Could still be receiving
+                                       is_accepted ? DMX_PROGRESS_COMPLETE : DMX_PROGRESS_STALE, 0));
+            const uint32_t sequence               = ++driver->dmx.rx_sequence;
+            const int64_t break_timestamp         = driver->dmx.rx_break_timestamp;
+            driver->dmx.rx_packet_break_timestamp = break_timestamp;
+            driver->dmx.rx_packet_timestamp       = now;
+            driver->dmx.rx_packet_data            = driver->dmx.data;
+            driver->dmx.rx_break_timestamp        = -1;  // The next packet may not start with a DMX break
+            struct dmx_failover_t *failover       = NULL;
+            const uint8_t *published              = NULL;
+            if (!is_accepted) {
+                ++driver->stats.packets_filtered;
+            } else {
+                if (err == DMX_OK && rdm_type == RDM_TYPE_IS_NOT_RDM) {
+                    dmx_buffer_publish(dmx_num);  // Publish the complete DMX packet
+                    if (driver->dmx.front == driver->dmx.data) {
+                        published = driver->dmx.front;
+                        failover  = dmx_failover_get_isr(dmx_num);
+                    }
+                }
+                if (driver->task_waiting) {
+                    xTaskNotifyFromISR(driver->task_waiting, err, eSetValueWithOverwrite, &task_awoken);
+                }
+                if (driver->task_waiting_any) {
+                    xTaskNotifyFromISR(driver->task_waiting_any, 1 << dmx_num, eSetBits, &task_awoken);
+                }
+            }
+            struct dmx_driver_subscriber_t subscribers[DMX_SUBSCRIBER_MAX];
+            memcpy(subscribers, driver->subscribers, sizeof(subscribers));
+            taskEXIT_CRITICAL_ISR(DMX_SPINLOCK(dmx_num));
+
+            // Copy the published packet into the redundant input outside of the DMX driver critical section
+            if (failover != NULL) {
+                task_awoken |= dmx_failover_receive_isr(failover, dmx_num, now, break_timestamp, published, dmx_head);
+            }
+
+            // Deliver the packet to each subscriber
+            const int packet_sc       = dmx_head > 0 ? driver->dmx.data[0] : -1;
+            const dmx_packet_t packet = {
+                .err             = err,
+                .sc              = packet_sc,
+                .size            = dmx_head,
+                .is_rdm          = dmx_start_code_is_rdm(packet_sc),
+                .sequence        = sequence,
+                .break_timestamp = break_timestamp,
+                .timestamp       = now,
+            };
+            for (int i = 0; i < DMX_SUBSCRIBER_MAX; ++i) {
+                if (subscribers[i].cb != NULL) {
+                    task_awoken |= subscribers[i].cb(dmx_num, &packet, subscribers[i].context);
+                }
+            }
+        }
+
+        // DMX Transmit #####################################################
+        else if (intr_flags & DMX_INTR_TX_DATA) {
+            // Write data to the UART and clear the interrupt
+            int dmx_head  = DMX_STATE_HEAD(DMX_STATE_LOAD(driver));
+            int write_len = driver->dmx.size - dmx_head;
+            dmx_uart_write_txfifo(dmx_num, &driver->dmx.data[dmx_head], &write_len);
+            dmx_head += write_len;
+            dmx_state_set_head(dmx_num, dmx_head);
+            dmx_uart_clear_interrupt(dmx_num, DMX_INTR_TX_DATA);
+
+            // Allow FIFO to empty when done writing data
+            if (dmx_head == driver->dmx.size) {
+                dmx_uart_disable_interrupt(dmx_num, DMX_INTR_TX_DATA);
+            }
+        } else if (intr_flags & DMX_INTR_TX_DONE) {
+            // Disable write interrupts and clear the interrupt
+            dmx_uart_disable_interrupt(dmx_num, DMX_INTR_TX_ALL);
+            dmx_uart_clear_interrupt(dmx_num, DMX_INTR_TX_DONE);
+            DMX_TRACE(dmx_num, DMX_TRACE_TX_DONE, DMX_OK, DMX_STATE_HEAD(DMX_STATE_LOAD(driver)));
+#ifdef CONFIG_DMX_UART_MAB
+            dmx_uart_set_tx_idle(dmx_num, 0);  // Packets without a DMX break are sent immediately
+#endif
+
+            // Repeated packets are finished when the start code of the next packet is received
+            if (driver->repeater.input >= 0) {
+                taskENTER_CRITICAL_ISR(DMX_SPINLOCK(dmx_num));
+                dmx_repeater_tx_done(dmx_num);
+                taskEXIT_CRITICAL_ISR(DMX_SPINLOCK(dmx_num));
+                continue;
+            }
+
+#ifndef CONFIG_RDM_RESPONDER_DISABLE
+            // Give the DMX bus back to the controller after sending a discovery response
+            if (driver->rdm.fast_discovery.is_sending) {
+                ++driver->stats.packets_sent;
+                taskENTER_CRITICAL_ISR(DMX_SPINLOCK(dmx_num));
+                driver->rdm.fast_discovery.is_sending = false;
+                dmx_state_set_status(dmx_num, DMX_STATUS_IDLE);
+                dmx_uart_rxfifo_reset(dmx_num);
+                dmx_uart_set_rts(dmx_num, 1);
+                if (driver->task_waiting) {
+                    xTaskNotifyFromISR(driver->task_waiting, DMX_OK, eNoAction, &task_awoken);
+                }
+                taskEXIT_CRITICAL_ISR(DMX_SPINLOCK(dmx_num));
+                continue;
+            }
+#endif
+
+            // Record the EOP timestamp if this device is the DMX controller
+            if (driver->is_controller) {
+                taskENTER_CRITICAL_ISR(DMX_SPINLOCK(dmx_num));
+                driver->dmx.controller_eop_timestamp = now;
+                taskEXIT_CRITICAL_ISR(DMX_SPINLOCK(dmx_num));
+            }
+
+            // Update the DMX status and notify task
+            ++driver->stats.packets_sent;
+            taskENTER_CRITICAL_ISR(DMX_SPINLOCK(dmx_num));
+            dmx_state_update(dmx_num, DMX_STATE_STATUS_MASK | DMX_STATE_PROGRESS_MASK,
+                             DMX_STATE(DMX_STATUS_IDLE, DMX_PROGRESS_COMPLETE, 0));
+            if (driver->task_waiting) {
+                xTaskNotifyFromISR(driver->task_waiting, DMX_OK, eNoAction, &task_awoken);
+            }
+            taskEXIT_CRITICAL_ISR(DMX_SPINLOCK(dmx_num));
+
+            // Schedule the next DMX break when sending continuously
+            if (driver->continuous.period > 0 && !driver->continuous.is_paused) {
+                int64_t next_break = driver->continuous.period - (now - driver->continuous.break_timestamp);
+                if (next_break < 1) {
+                    next_break = 1;  // The refresh rate is faster than the packet can be sent
+                }
+                dmx_timer_stop(dmx_num);
+                taskENTER_CRITICAL_ISR(DMX_SPINLOCK(dmx_num));
+                driver->flags |= DMX_FLAGS_TIMER_IS_CONTINUOUS;
+                taskEXIT_CRITICAL_ISR(DMX_SPINLOCK(dmx_num));
+                dmx_timer_set_counter(dmx_num, 0);
+                dmx_timer_set_alarm(dmx_num, next_break, false);
+                dmx_timer_start(dmx_num);
+                continue;
+            }
+
+            // Skip the rest of the ISR loop if an RDM response is not expected
+            if (!driver->is_controller || driver->dmx.last_controller_pid == 0 ||
+                (driver->dmx.last_request_was_broadcast &&
+                 driver->dmx.last_controller_pid != RDM_PID_DISC_UNIQUE_BRANCH)) {
+                continue;
+            }
+
+            // Determine if a DMX break is expected in the response packet
+            uint32_t state;
+            if (driver->dmx.last_controller_pid == RDM_PID_DISC_UNIQUE_BRANCH) {
+                state = DMX_STATE(0, DMX_PROGRESS_IN_DATA, 0);  // Not expecting a DMX break
+            } else {
+                state = DMX_STATE(0, DMX_PROGRESS_STALE, DMX_HEAD_WAITING_FOR_BREAK);
+            }
+
+            // Flip the DMX bus so the response may be read
+            taskENTER_CRITICAL_ISR(DMX_SPINLOCK(dmx_num));
+            dmx_uart_set_rxfifo_full(dmx_num, DMX_UART_FULL_DEFAULT);
+            dmx_uart_rxfifo_reset(dmx_num);
+            dmx_uart_set_rts(dmx_num, 1);
+            dmx_state_update(dmx_num, DMX_STATE_PROGRESS_MASK | DMX_STATE_HEAD_MASK, state);
+            taskEXIT_CRITICAL_ISR(DMX_SPINLOCK(dmx_num));
+        }
+    }
+
+    DMX_TRACE(dmx_num, DMX_TRACE_UART_ISR_EXIT, DMX_OK, 0);
+    dmx_stats_record_isr(dmx_num, isr_start);
+    if (task_awoken) portYIELD_FROM_ISR();
+}
+
+/**
+ * @brief Ends the DMX break. If the UART generates the mark-after-break, the
+ * packet may be written to the UART immediately.
+ *
+ * @return true if the UART generates the mark-after-break.
+ * @return false if the mark-after-break must be timed by the DMX timer.
+ */
+static bool DMX_ISR_ATTR dmx_timer_end_break(dmx_port_t dmx_num) {
+    bool uart_mab = false;
+#ifdef CONFIG_DMX_UART_MAB
+    uart_mab = dmx_uart_set_tx_idle(dmx_num, dmx_driver[dmx_num]->mab_len);
+#endif
+    dmx_uart_invert_tx(dmx_num, 0);
+    return uart_mab;
+}
+
+bool DMX_ISR_ATTR dmx_timer_handle_alarm(void *arg) {
+    const uint32_t isr_start   = dmx_timer_get_cycle_count();
+    dmx_driver_t *const driver = arg;
+    const int64_t now          = dmx_timer_get_micros_since_boot();
+    const dmx_port_t dmx_num   = driver->dmx_num;
+    int task_awoken            = false;
+    const uint32_t state       = DMX_STATE_LOAD(driver);
+    DMX_TRACE(dmx_num, DMX_TRACE_TIMER_ISR_ENTER, DMX_OK, DMX_STATE_PROGRESS(state));
+
+#ifndef CONFIG_RDM_RESPONDER_DISABLE
+    struct dmx_driver_fast_discovery_t *const fast = &driver->rdm.fast_discovery;
+    if (fast->size > 0) {
+        // Send the discovery response which was prepared by the DMX interrupt
+        if (fast->progress == DMX_PROGRESS_STALE) {
+            dmx_uart_set_rts(dmx_num, 0);  // The responder turnaround time has elapsed
+        }
+        if (fast->progress == DMX_PROGRESS_STALE && fast->has_break) {
+            fast->progress = DMX_PROGRESS_IN_BREAK;
+            dmx_timer_set_counter(dmx_num, 0);
+            dmx_timer_set_alarm(dmx_num, driver->break_len, true);
+            dmx_uart_invert_tx(dmx_num, 1);
+        } else if (fast->progress == DMX_PROGRESS_IN_BREAK && !dmx_timer_end_break(dmx_num)) {
+            fast->progress = DMX_PROGRESS_IN_MAB;
+
+            // Reset the alarm for the end of the DMX mark-after-break
+            dmx_timer_set_alarm(dmx_num, driver->mab_len, false);
+        } else {
+            dmx_timer_stop(dmx_num);
+
+            // Discovery responses always fit in the UART FIFO
+            int write_len = fast->size;
+            dmx_uart_write_txfifo(dmx_num, fast->response, &write_len);
+            fast->size       = 0;
+            fast->is_sending = true;
+            dmx_uart_clear_interrupt(dmx_num, DMX_INTR_TX_DONE);
+            dmx_uart_enable_interrupt(dmx_num, DMX_INTR_TX_DONE);
+        }
+    } else
+#endif
+    if (driver->send_at >= 0) {
+        // Start the DMX breaks of the packets which were scheduled by dmx_send_at() or dmx_send_group()
+        dmx_timer_stop(dmx_num);
+        uint32_t group;
+        taskENTER_CRITICAL_ISR(DMX_SPINLOCK(dmx_num));
+        group              = driver->send_group;
+        driver->send_at    = -1;
+        driver->send_group = 0;
+        taskEXIT_CRITICAL_ISR(DMX_SPINLOCK(dmx_num));
+        dmx_packet_start_group_isr(group);
+    } else if (DMX_STATE_STATUS(state) == DMX_STATUS_SENDING) {
+        if (DMX_STATE_PROGRESS(state) == DMX_PROGRESS_IN_BREAK && !dmx_timer_end_break(dmx_num)) {
+            dmx_state_set_progress(dmx_num, DMX_PROGRESS_IN_MAB);
+
+            // Reset the alarm for the end of the DMX mark-after-break
+            dmx_timer_set_alarm(dmx_num, driver->mab_len, false);
+        } else if (driver->repeater.input >= 0) {
+            dmx_timer_stop(dmx_num);
+
+            // Repeated packets are written as they are received
+            taskENTER_CRITICAL_ISR(DMX_SPINLOCK(dmx_num));
+            dmx_repeater_start_data(dmx_num);
+            taskEXIT_CRITICAL_ISR(DMX_SPINLOCK(dmx_num));
+        } else {
+            // Pause MAB timer alarm
+            dmx_timer_stop(dmx_num);  // TODO: is this needed?
+
+            // Write data to the UART using DMA if possible
+            if (dmx_dma_write(dmx_num, driver->dmx.data, driver->dmx.size)) {
+                dmx_state_set_head(dmx_num, driver->dmx.size);
+                dmx_uart_clear_interrupt(dmx_num, DMX_INTR_TX_DONE);
+                dmx_uart_enable_interrupt(dmx_num, DMX_INTR_TX_DONE);
+            } else {
+                int write_len = driver->dmx.size;
+                dmx_uart_write_txfifo(dmx_num, driver->dmx.data, &write_len);
+                dmx_state_set_head(dmx_num, write_len);
+
+                // Enable DMX write interrupts
+                dmx_uart_enable_interrupt(dmx_num, DMX_INTR_TX_ALL);
+            }
+        }
+    } else if (driver->flags & DMX_FLAGS_TIMER_IS_CONTINUOUS) {
+        // Start the next continuously sent packet
+        dmx_timer_stop(dmx_num);
+        taskENTER_CRITICAL_ISR(DMX_SPINLOCK(dmx_num));
+        driver->flags &= ~DMX_FLAGS_TIMER_IS_CONTINUOUS;
+        if (driver->continuous.period > 0 && !driver->continuous.is_paused) {
+            dmx_packet_start_break(dmx_num);
+        }
+        taskEXIT_CRITICAL_ISR(DMX_SPINLOCK(dmx_num));
+    } else {
+        taskENTER_CRITICAL_ISR(DMX_SPINLOCK(dmx_num));
+        if (driver->task_waiting) {
+            xTaskNotifyFromISR(driver->task_waiting, DMX_OK, eSetValueWithOverwrite, &task_awoken);
+        }
+        taskEXIT_CRITICAL_ISR(DMX_SPINLOCK(dmx_num));
+        dmx_timer_stop(dmx_num);  // TODO: is this needed?
+    }
+
+    DMX_TRACE(dmx_num, DMX_TRACE_TIMER_ISR_EXIT, DMX_OK, 0);
+    dmx_stats_record_isr(dmx_num, isr_start);
+    return task_awoken;
+}
+
+#ifndef CONFIG_DMX_SNIFFER_DISABLE
+void DMX_ISR_ATTR dmx_gpio_isr(void *arg) {
+    const uint32_t now         = dmx_timer_get_timestamp();
+    dmx_driver_t *const driver = (dmx_driver_t *)arg;
+    const dmx_port_t dmx_num   = driver->dmx_num;
+    const int level            = dmx_gpio_read(dmx_num);
+    DMX_TRACE(dmx_num, DMX_TRACE_GPIO_EDGE, DMX_OK, level);
+
+    if (level) {
+        /* If this ISR is called on a positive edge and the current DMX frame is in
+        a break and a negative edge timestamp has been recorded then a break has
+        just finished. Therefore the DMX break length is able to be recorded. It can
+        also be deduced that the driver is now in a DMX mark-after-break. */
+
+        if (DMX_STATE_PROGRESS(DMX_STATE_LOAD(driver)) == DMX_PROGRESS_IN_BREAK && driver->sniffer.last_neg_edge_ts > -1) {
+            taskENTER_CRITICAL_ISR(DMX_SPINLOCK(dmx_num));
+            driver->sniffer.buffer_index                                     = !driver->sniffer.buffer_index;
+            driver->sniffer.metadata[driver->sniffer.buffer_index].break_len =
+                now - (uint32_t)driver->sniffer.last_neg_edge_ts;
+            taskEXIT_CRITICAL_ISR(DMX_SPINLOCK(dmx_num));
+            dmx_state_set_progress(dmx_num, DMX_PROGRESS_IN_MAB);
+        }
+        driver->sniffer.last_pos_edge_ts = now;
+    } else {
+        /* If this ISR is called on a negative edge in a DMX mark-after-break then
+        the DMX mark-after-break has just finished. It can be recorded. Sniffer data
+        is now available to be read by the user. */
+
+        if (DMX_STATE_PROGRESS(DMX_STATE_LOAD(driver)) == DMX_PROGRESS_IN_MAB) {
+            taskENTER_CRITICAL_ISR(DMX_SPINLOCK(dmx_num));
+            driver->sniffer.metadata[driver->sniffer.buffer_index].mab_len =
+                now - (uint32_t)driver->sniffer.last_pos_edge_ts;
+            taskEXIT_CRITICAL_ISR(DMX_SPINLOCK(dmx_num));
+            dmx_state_set_progress(dmx_num, DMX_PROGRESS_IN_DATA);
+        }
+        driver->sniffer.last_neg_edge_ts = now;
+    }
+}
+#endif
@@ -0,0 +1,95 @@
+#include "include/lcd.h"
+
+#include "../include/service.h"
+
+#if defined(CONFIG_DMX_PARALLEL) && ESP_IDF_VERSION_MAJOR >= 5
+#include "esp_lcd_panel_io.h"
+
+// Two buffers may be queued so that the next frame is ready when the last one finishes
+#define DMX_LCD_QUEUE_DEPTH (2)
+
+static struct dmx_lcd_t {
+    esp_lcd_i80_bus_handle_t bus;  // The Intel 8080 bus, or NULL if it is not initialized.
+    esp_lcd_panel_io_handle_t io;  // The panel IO which writes buffers onto the bus.
+    dmx_lcd_done_cb_t cb;          // The function to call when a buffer has been written.
+    void *context;                 // The context of the callback.
+} dmx_lcd_context = {};
+
+static bool DMX_ISR_ATTR dmx_lcd_trans_done(esp_lcd_panel_io_handle_t io, esp_lcd_panel_io_event_data_t *edata,
+                                            void *arg) {
+    struct dmx_lcd_t *const lcd = (struct dmx_lcd_t *)arg;
+    return lcd->cb(lcd->context);
+}
+
+bool dmx_lcd_init(const int *data_pins, int pin_count, int clock_pin, int dc_pin, uint32_t clock_hz,
+                  size_t max_transfer_size, dmx_lcd_done_cb_t cb, void *context) {
+    struct dmx_lcd_t *lcd = &dmx_lcd_context;
+    if (lcd->bus != NULL) {
+        return false;
+    }
+
+    esp_lcd_i80_bus_config_t bus_config = {
+        .dc_gpio_num        = dc_pin,
+        .wr_gpio_num        = clock_pin,
+        .clk_src            = LCD_CLK_SRC_DEFAULT,
+        .bus_width          = pin_count,
+        .max_transfer_bytes = max_transfer_size,
+    };
+    for (int i = 0; i < pin_count; ++i) {
+        bus_config.data_gpio_nums[i] = data_pins[i];
+    }
+    if (esp_lcd_new_i80_bus(&bus_config, &lcd->bus) != ESP_OK) {
+        lcd->bus = NULL;
+        return false;
+    }
+
+    // The data/command pin is unused because DMX frames are written without an LCD command
+    const esp_lcd_panel_io_i80_config_t io_config = {
+        .cs_gpio_num         = -1,
+        .pclk_hz             = clock_hz,
+        .trans_queue_depth   = DMX_LCD_QUEUE_DEPTH,
+        .on_color_trans_done = dmx_lcd_trans_done,
+        .user_ctx            = lcd,
+        .lcd_cmd_bits        = 8,
+        .lcd_param_bits      = 8,
+        .dc_levels           = {.dc_data_level = 1},
+    };
+    lcd->cb      = cb;
+    lcd->context = context;
+    if (esp_lcd_new_panel_io_i80(lcd->bus, &io_config, &lcd->io) != ESP_OK) {
+        lcd->io = NULL;
+        dmx_lcd_deinit();
+        return false;
+    }
+
+    return true;
+}
+
+void dmx_lcd_deinit() {
+    struct dmx_lcd_t *lcd = &dmx_lcd_context;
+    if (lcd->io != NULL) {
+        esp_lcd_panel_io_del(lcd->io);  // Waits for queued buffers to be written
+        lcd->io = NULL;
+    }
+    if (lcd->bus != NULL) {
+        esp_lcd_del_i80_bus(lcd->bus);
+        lcd->bus = NULL;
+    }
+}
+
+bool dmx_lcd_write(const void *buf, size_t size) {
+    return esp_lcd_panel_io_tx_color(dmx_lcd_context.io, -1, buf, size) == ESP_OK;
+}
+
+#else
+
+bool dmx_lcd_init(const int *data_pins, int pin_count, int clock_pin, int dc_pin, uint32_t clock_hz,
+                  size_t max_transfer_size, dmx_lcd_done_cb_t cb, void *context) {
+    return false;
+}
+
+void dmx_lcd_deinit() {}
+
+bool dmx_lcd_write(const void *buf, size_t size) { return false; }
+
+#endif
@@ -4,6 +4,9 @@
 #include "../../esp_dmx.h"
 #include "nvs_flash.h"
 
+#include <stdlib.h>
+#include <string.h>
+
 #ifndef CONFIG_DMX_NVS_PARTITION_NAME
 #define DMX_NVS_PARTITION_NAME "nvs"
 #else
@@ -14,14 +17,279 @@
 
 static const char *dmx_nvs_namespace = "esp_dmx";
 
+static struct dmx_nvs_batch_t {
+    SemaphoreHandle_t mux;                // The recursive mutex which is held for the duration of a batch.
+    int depth;                            // The number of nested calls to dmx_nvs_begin().
+    bool is_open;                         // True if the NVS handle of the batch is open.
+    nvs_handle_t nvs;                     // The NVS handle of the batch.
+    esp_err_t err;                        // The first error which occurred in the batch.
+    bool driver_is_enabled[DMX_NUM_MAX];  // True for the DMX drivers which must be re-enabled after the batch.
+} dmx_nvs_batch = {};
+
+#ifdef CONFIG_DMX_NVS_BLOB
+#define DMX_NVS_IMAGE_MAGIC   (0x21584d44)  // "DMX!" in little-endian
+#define DMX_NVS_IMAGE_VERSION (1)
+
+typedef struct __attribute__((packed)) dmx_nvs_image_header_t {
+    uint32_t magic;     // Identifies the blob as a DMX parameter image.
+    uint16_t version;   // The version of the image format.
+    uint16_t count;     // The number of parameter records which follow the header.
+    uint32_t size;      // The size in bytes of the parameter records.
+    uint32_t checksum;  // The FNV-1a hash of the parameter records.
+} dmx_nvs_image_header_t;
+
+typedef struct __attribute__((packed)) dmx_nvs_record_t {
+    uint16_t sub_device;  // The sub-device which owns the parameter.
+    uint16_t pid;         // The parameter ID.
+    uint16_t size;        // The size of the parameter data in bytes.
+    uint8_t data[];       // The parameter data.
+} dmx_nvs_record_t;
+
+static struct dmx_nvs_image_t {
+    uint8_t *records;  // The parameter records of the port, or NULL if there are none.
+    size_t size;       // The size in bytes of the parameter records.
+    int count;         // The number of parameter records.
+    bool is_loaded;    // True once the image has been read, or found missing, when the driver was installed.
+    bool is_stored;    // True if a valid image exists in NVS. Parameters are read from individual keys until then.
+    bool is_dirty;     // True if the image has changed since it was last written to NVS.
+} dmx_nvs_image[DMX_NUM_MAX] = {};
+#endif
+
+static void dmx_nvs_disable_drivers(bool *driver_is_enabled) {
+#ifndef DMX_ISR_IN_IRAM
+    // Track which drivers are currently enabled and disable those which are
+    for (int i = 0; i < DMX_NUM_MAX; ++i) {
+        driver_is_enabled[i] = dmx_driver_is_enabled(i);
+        if (driver_is_enabled[i]) {
+            dmx_wait_sent(i, dmx_ms_to_ticks(23));  // Don't cut short the packet on the bus
+            dmx_driver_disable(i);
+        }
+    }
+#endif
+}
+
+static void dmx_nvs_enable_drivers(const bool *driver_is_enabled) {
+#ifndef DMX_ISR_IN_IRAM
+    for (int i = 0; i < DMX_NUM_MAX; ++i) {
+        if (driver_is_enabled[i]) {
+            dmx_driver_enable(i);
+        }
+    }
+#endif
+}
+
 static void dmx_nvs_get_key(char *key, dmx_port_t dmx_num, rdm_sub_device_t sub_device, rdm_pid_t pid) {
     const int w = snprintf(key, DMX_NVS_KEY_SIZE_MAX, "%x%x%x%x%x", ESP_DMX_VERSION_MAJOR, ESP_DMX_VERSION_MINOR,
                            dmx_num, sub_device, pid);
     assert(w < DMX_NVS_KEY_SIZE_MAX);
 }
 
+#ifdef CONFIG_DMX_NVS_BLOB
+static void dmx_nvs_get_image_key(char *key, dmx_port_t dmx_num) {
+    const int w = snprintf(key, DMX_NVS_KEY_SIZE_MAX, "%x%ximg%x", ESP_DMX_VERSION_MAJOR, ESP_DMX_VERSION_MINOR,
+                           dmx_num);
+    assert(w < DMX_NVS_KEY_SIZE_MAX);
+}
+
+static uint32_t dmx_nvs_image_checksum(const uint8_t *data, size_t size) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < size; ++i) {
+        hash = (hash ^ data[i]) * 16777619u;
+    }
+    return hash;
+}
+
+static dmx_nvs_record_t *dmx_nvs_image_find(struct dmx_nvs_image_t *image, rdm_sub_device_t sub_device,
+                                            rdm_pid_t pid) {
+    for (size_t offset = 0; offset < image->size;) {
+        dmx_nvs_record_t *const record = (dmx_nvs_record_t *)(image->records + offset);
+        if (record->sub_device == sub_device && record->pid == pid) {
+            return record;
+        }
+        offset += sizeof(*record) + record->size;
+    }
+    return NULL;
+}
+
+static bool dmx_nvs_image_put(struct dmx_nvs_image_t *image, rdm_sub_device_t sub_device, rdm_pid_t pid,
+                              const void *param, size_t size) {
+    dmx_nvs_record_t *record = dmx_nvs_image_find(image, sub_device, pid);
+    if (record != NULL && record->size == size) {
+        // Overwrite the record in place
+        if (memcmp(record->data, param, size) != 0) {
+            memcpy(record->data, param, size);
+            image->is_dirty = true;
+        }
+        return true;
+    } else if (record != NULL) {
+        // The size of the parameter changed so remove the old record
+        const size_t record_size = sizeof(*record) + record->size;
+        const size_t offset      = (uint8_t *)record - image->records;
+        memmove(image->records + offset, image->records + offset + record_size, image->size - offset - record_size);
+        image->size -= record_size;
+        --image->count;
+    }
+
+    // Append a new record to the end of the image
+    uint8_t *records = realloc(image->records, image->size + sizeof(*record) + size);
+    if (records == NULL) {
+        return false;
+    }
+    image->records     = records;
+    record             = (dmx_nvs_record_t *)(image->records + image->size);
+    record->sub_device = sub_device;
+    record->pid        = pid;
+    record->size       = size;
+    memcpy(record->data, param, size);
+    image->size += sizeof(*record) + size;
+    ++image->count;
+    image->is_dirty = true;
+
+    return true;
+}
+
+static void dmx_nvs_image_load(dmx_port_t dmx_num) {
+    struct dmx_nvs_image_t *const image = &dmx_nvs_image[dmx_num];
+
+    char key[DMX_NVS_KEY_SIZE_MAX];
+    dmx_nvs_get_image_key(key, dmx_num);
+
+    // Read the whole image with a single NVS read
+    uint8_t *blob = NULL;
+    size_t size   = 0;
+    nvs_handle_t nvs;
+    if (nvs_open(dmx_nvs_namespace, NVS_READONLY, &nvs) == ESP_OK) {
+        if (nvs_get_blob(nvs, key, NULL, &size) == ESP_OK && size >= sizeof(dmx_nvs_image_header_t) &&
+            (blob = malloc(size)) != NULL) {
+            bool driver_is_enabled[DMX_NUM_MAX];
+            dmx_nvs_disable_drivers(driver_is_enabled);
+            if (nvs_get_blob(nvs, key, blob, &size) != ESP_OK) {
+                size = 0;
+            }
+            dmx_nvs_enable_drivers(driver_is_enabled);
+        }
+        nvs_close(nvs);
+    }
+
+    // Discard images which are corrupt or which were written in another format
+    const dmx_nvs_image_header_t *header = (dmx_nvs_image_header_t *)blob;
+    const uint8_t *records               = blob + sizeof(*header);
+    image->is_stored = (blob != NULL && size >= sizeof(*header) && header->magic == DMX_NVS_IMAGE_MAGIC &&
+                        header->version == DMX_NVS_IMAGE_VERSION && header->size == size - sizeof(*header) &&
+                        header->checksum == dmx_nvs_image_checksum(records, header->size));
+    if (image->is_stored) {
+        uint8_t *const copy = malloc(header->size);
+        if (copy != NULL) {
+            memcpy(copy, records, header->size);
+            free(image->records);
+            image->records = copy;
+            image->size    = header->size;
+            image->count   = header->count;
+        } else {
+            image->is_stored = false;
+        }
+    }
+    image->is_loaded = true;
+    image->is_dirty  = !image->is_stored;
+    free(blob);
+}
+
+static esp_err_t dmx_nvs_image_write(nvs_handle_t nvs, dmx_port_t dmx_num) {
+    struct dmx_nvs_image_t *const image = &dmx_nvs_image[dmx_num];
+
+    char key[DMX_NVS_KEY_SIZE_MAX];
+    dmx_nvs_get_image_key(key, dmx_num);
+
+    const size_t size = sizeof(dmx_nvs_image_header_t) + image->size;
+    uint8_t *blob     = malloc(size);
+    if (blob == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    dmx_nvs_image_header_t *const header = (dmx_nvs_image_header_t *)blob;
+    header->magic                        = DMX_NVS_IMAGE_MAGIC;
+    header->version                      = DMX_NVS_IMAGE_VERSION;
+    header->count                        = image->count;
+    header->size                         = image->size;
+    header->checksum                     = dmx_nvs_image_checksum(image->records, image->size);
+    if (image->size > 0) {
+        memcpy(blob + sizeof(*header), image->records, image->size);
+    }
+    const esp_err_t err = nvs_set_blob(nvs, key, blob, size);
+    free(blob);
+
+    if (err == ESP_OK) {
+        image->is_stored = true;
+        image->is_dirty  = false;
+    }
+    return err;
+}
+#endif
+
 void dmx_nvs_init(dmx_port_t dmx_num) {
     nvs_flash_init_partition(DMX_NVS_PARTITION_NAME);
+    if (dmx_nvs_batch.mux == NULL) {
+        dmx_nvs_batch.mux = xSemaphoreCreateRecursiveMutex();
+    }
+
+#ifdef CONFIG_DMX_NVS_BLOB
+    // Read every parameter of the port at once so that they can be looked up without accessing NVS
+    if (!dmx_nvs_image[dmx_num].is_loaded && dmx_nvs_batch.mux != NULL) {
+        xSemaphoreTakeRecursive(dmx_nvs_batch.mux, portMAX_DELAY);
+        dmx_nvs_image_load(dmx_num);
+        xSemaphoreGiveRecursive(dmx_nvs_batch.mux);
+    }
+#endif
+}
+
+bool dmx_nvs_sync(dmx_port_t dmx_num) {
+#ifdef CONFIG_DMX_NVS_BLOB
+    if (dmx_nvs_image[dmx_num].is_dirty) {
+        dmx_nvs_begin();
+        return dmx_nvs_end();
+    }
+#endif
+    return true;
+}
+
+bool dmx_nvs_begin() {
+    struct dmx_nvs_batch_t *const batch = &dmx_nvs_batch;
+    assert(batch->mux != NULL);
+
+    xSemaphoreTakeRecursive(batch->mux, portMAX_DELAY);
+    if (batch->depth++ == 0) {
+        batch->err     = nvs_open(dmx_nvs_namespace, NVS_READWRITE, &batch->nvs);
+        batch->is_open = (batch->err == ESP_OK);
+        if (batch->is_open) {
+            dmx_nvs_disable_drivers(batch->driver_is_enabled);
+        }
+    }
+
+    return batch->is_open;
+}
+
+bool dmx_nvs_end() {
+    struct dmx_nvs_batch_t *const batch = &dmx_nvs_batch;
+    assert(batch->depth > 0);
+
+    if (--batch->depth == 0 && batch->is_open) {
+#ifdef CONFIG_DMX_NVS_BLOB
+        for (int i = 0; i < DMX_NUM_MAX && batch->err == ESP_OK; ++i) {
+            if (dmx_nvs_image[i].is_dirty) {
+                batch->err = dmx_nvs_image_write(batch->nvs, i);
+            }
+        }
+#endif
+        if (batch->err == ESP_OK) {
+            batch->err = nvs_commit(batch->nvs);
+        }
+        dmx_nvs_enable_drivers(batch->driver_is_enabled);
+        nvs_close(batch->nvs);
+        batch->is_open = false;
+    }
+    const bool success = (batch->err == ESP_OK);
+    xSemaphoreGiveRecursive(batch->mux);
+
+    return success;
 }
 
 size_t dmx_nvs_get(dmx_port_t dmx_num, rdm_sub_device_t sub_device, rdm_pid_t pid, void *param, size_t size) {
@@ -34,6 +302,23 @@ size_t dmx_nvs_get(dmx_port_t dmx_num, rdm_sub_device_t sub_device, rdm_pid_t pi
         return size;
     }
 
+#ifdef CONFIG_DMX_NVS_BLOB
+    // Parameters are read from the image which was loaded when the driver was installed
+    struct dmx_nvs_image_t *const image = &dmx_nvs_image[dmx_num];
+    if (image->is_stored) {
+        xSemaphoreTakeRecursive(dmx_nvs_batch.mux, portMAX_DELAY);
+        const dmx_nvs_record_t *record = dmx_nvs_image_find(image, sub_device, pid);
+        if (record != NULL && record->size <= size) {
+            size = record->size;
+            memcpy(param, record->data, size);
+        } else {
+            size = 0;
+        }
+        xSemaphoreGiveRecursive(dmx_nvs_batch.mux);
+        return size;
+    }
+#endif
+
     // Get the NVS key
     char key[DMX_NVS_KEY_SIZE_MAX];
     dmx_nvs_get_key(key, dmx_num, sub_device, pid);
@@ -41,16 +326,8 @@ size_t dmx_nvs_get(dmx_port_t dmx_num, rdm_sub_device_t sub_device, rdm_pid_t pi
     nvs_handle_t nvs;
     esp_err_t err = nvs_open(dmx_nvs_namespace, NVS_READONLY, &nvs);
     if (!err) {
-#ifndef DMX_ISR_IN_IRAM
-        // Track which drivers are currently enabled and disable those which are
         bool driver_is_enabled[DMX_NUM_MAX];
-        for (int i = 0; i < DMX_NUM_MAX; ++i) {
-            driver_is_enabled[i] = dmx_driver_is_enabled(i);
-            if (dmx_driver_is_installed(i)) {
-                dmx_driver_disable(i);
-            }
-        }
-#endif
+        dmx_nvs_disable_drivers(driver_is_enabled);
 
         // Read the parameter from NVS depending on its type
         switch (size) {
@@ -70,20 +347,21 @@ size_t dmx_nvs_get(dmx_port_t dmx_num, rdm_sub_device_t sub_device, rdm_pid_t pi
                 err = nvs_get_blob(nvs, key, param, &size);
         }
 
-#ifndef DMX_ISR_IN_IRAM
-        for (int i = 0; i < DMX_NUM_MAX; ++i) {
-            if (driver_is_enabled[i]) {
-                dmx_driver_enable(i);
-            }
-        }
-#endif
-
+        dmx_nvs_enable_drivers(driver_is_enabled);
         nvs_close(nvs);
     }
 
     if (err) {
         size = 0;
     }
+#ifdef CONFIG_DMX_NVS_BLOB
+    else if (image->is_loaded) {
+        // Migrate the parameter into the image so that it is read from the image next time
+        xSemaphoreTakeRecursive(dmx_nvs_batch.mux, portMAX_DELAY);
+        dmx_nvs_image_put(image, sub_device, pid, param, size);
+        xSemaphoreGiveRecursive(dmx_nvs_batch.mux);
+    }
+#endif
 
     return size;
 }
@@ -98,52 +376,40 @@ bool dmx_nvs_set(dmx_port_t dmx_num, rdm_sub_device_t sub_device, rdm_pid_t pid,
         return true;
     }
 
+    struct dmx_nvs_batch_t *const batch = &dmx_nvs_batch;
+
+#ifdef CONFIG_DMX_NVS_BLOB
+    // The parameter is written with the rest of the image when the batch ends
+    if (dmx_nvs_begin() && !dmx_nvs_image_put(&dmx_nvs_image[dmx_num], sub_device, pid, param, size) &&
+        batch->err == ESP_OK) {
+        batch->err = ESP_ERR_NO_MEM;
+    }
+#else
     // Get the NVS key
     char key[DMX_NVS_KEY_SIZE_MAX];
     dmx_nvs_get_key(key, dmx_num, sub_device, pid);
 
-    nvs_handle_t nvs;
-    esp_err_t err = nvs_open(dmx_nvs_namespace, NVS_READWRITE, &nvs);
-    if (!err) {
-#ifndef DMX_ISR_IN_IRAM
-        // Track which drivers are currently enabled and disable those which are
-        bool driver_is_enabled[DMX_NUM_MAX];
-        for (int i = 0; i < DMX_NUM_MAX; ++i) {
-            driver_is_enabled[i] = dmx_driver_is_enabled(i);
-            if (dmx_driver_is_installed(i)) {
-                dmx_driver_disable(i);
-            }
-        }
-#endif
-
-        // Write the parameter to NVS depending on its type
+    // Write the parameter to NVS depending on its type
+    if (dmx_nvs_begin()) {
+        esp_err_t err;
         switch (size) {
             case sizeof(uint8_t):
-                err = nvs_set_u8(nvs, key, *(uint8_t *)param);
+                err = nvs_set_u8(batch->nvs, key, *(uint8_t *)param);
                 break;
             case sizeof(uint16_t):
-                err = nvs_set_u16(nvs, key, *(uint16_t *)param);
+                err = nvs_set_u16(batch->nvs, key, *(uint16_t *)param);
                 break;
             case sizeof(uint32_t):
-                err = nvs_set_u32(nvs, key, *(uint32_t *)param);
+                err = nvs_set_u32(batch->nvs, key, *(uint32_t *)param);
                 break;
             default:
-                err = nvs_set_blob(nvs, key, param, size);
-        }
-        if (!err) {
-            err = nvs_commit(nvs);
+                err = nvs_set_blob(batch->nvs, key, param, size);
         }
-
-#ifndef DMX_ISR_IN_IRAM
-        for (int i = 0; i < DMX_NUM_MAX; ++i) {
-            if (driver_is_enabled[i]) {
-                dmx_driver_enable(i);
-            }
+        if (err && batch->err == ESP_OK) {
+            batch->err = err;  // The batch is not committed if any of its writes fail
         }
-#endif
-
-        nvs_close(nvs);
     }
+#endif
 
-    return (err == ESP_OK);
+    return dmx_nvs_end();
 }
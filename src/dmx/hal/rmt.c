@@ -0,0 +1,138 @@
+#include "include/rmt.h"
+
+#include "../include/service.h"
+
+#ifdef CONFIG_DMX_SNIFFER_RMT
+#include "driver/rmt_rx.h"
+#include "esp_heap_caps.h"
+
+#if ESP_IDF_VERSION < ESP_IDF_VERSION_VAL(5, 3, 0)
+#error "CONFIG_DMX_SNIFFER_RMT requires ESP-IDF v5.3 or newer"
+#endif
+
+// One RMT tick per microsecond so that symbol durations are DMX timings in microseconds
+#define DMX_RMT_RESOLUTION_HZ (1000000)
+// The RMT memory block is handed to the sniffer each time half of it is filled
+#define DMX_RMT_MEM_SYMBOLS (SOC_RMT_MEM_WORDS_PER_CHANNEL)
+// The size of the buffer into which the RMT driver copies received symbols
+#define DMX_RMT_BUFFER_SYMBOLS (DMX_RMT_MEM_SYMBOLS * 2)
+// Pulses shorter than this are glitches. A DMX bit is 4us long.
+#define DMX_RMT_FILTER_NS (1000)
+// The DMX line must be idle this long for the RMT reception to end. Must fit in the 15-bit RMT idle threshold.
+#define DMX_RMT_IDLE_NS (32000000)
+// The shortest DMX break which a receiver must accept. See ANSI-ESTA E1.11 Table 6.
+#define DMX_RMT_BREAK_LEN_MIN_US (88)
+
+static struct dmx_rmt_t {
+    rmt_channel_handle_t channel;  // The RMT receive channel, or NULL if the sniffer does not use the RMT.
+    dmx_driver_t *driver;          // The DMX driver which owns the sniffer.
+    rmt_symbol_word_t *buffer;     // The buffer into which the RMT driver copies received symbols.
+    uint32_t break_len;            // The length of the last DMX break, or 0 if not in a DMX mark-after-break.
+} dmx_rmt_context[DMX_NUM_MAX] = {};
+
+static DRAM_ATTR const rmt_receive_config_t dmx_rmt_receive_config = {
+    .signal_range_min_ns = DMX_RMT_FILTER_NS,
+    .signal_range_max_ns = DMX_RMT_IDLE_NS,
+    .flags.en_partial_rx = true,
+};
+
+static void DMX_ISR_ATTR dmx_rmt_handle_level(struct dmx_rmt_t *rmt, int level, uint32_t duration) {
+    if (duration == 0) {
+        return;  // The end marker of an RMT reception
+    }
+
+    if (level == 0) {
+        /* No DMX slot is low for long enough to be mistaken for a DMX break, so
+        any sufficiently long low level is a break. A mark-after-break must
+        follow before the timings are reported. */
+        rmt->break_len = duration >= DMX_RMT_BREAK_LEN_MIN_US ? duration : 0;
+    } else if (rmt->break_len > 0) {
+        // A high level after a DMX break is the mark-after-break
+        dmx_driver_t *const driver = rmt->driver;
+        taskENTER_CRITICAL_ISR(DMX_SPINLOCK(driver->dmx_num));
+        driver->sniffer.buffer_index                                     = !driver->sniffer.buffer_index;
+        driver->sniffer.metadata[driver->sniffer.buffer_index].break_len = rmt->break_len;
+        driver->sniffer.metadata[driver->sniffer.buffer_index].mab_len   = duration;
+        taskEXIT_CRITICAL_ISR(DMX_SPINLOCK(driver->dmx_num));
+        rmt->break_len = 0;
+    }
+}
+
+static bool DMX_ISR_ATTR dmx_rmt_rx_done(rmt_channel_handle_t channel, const rmt_rx_done_event_data_t *edata,
+                                         void *arg) {
+    struct dmx_rmt_t *const rmt = (struct dmx_rmt_t *)arg;
+
+    for (size_t i = 0; i < edata->num_symbols; ++i) {
+        const rmt_symbol_word_t *symbol = &edata->received_symbols[i];
+        dmx_rmt_handle_level(rmt, symbol->level0, symbol->duration0);
+        dmx_rmt_handle_level(rmt, symbol->level1, symbol->duration1);
+    }
+
+    if (edata->flags.is_last) {
+        /* The DMX line was idle for longer than the RMT can count. The length of
+        a DMX break which was this long is unknown, so it is discarded. The
+        reception is restarted so that the next packet is sniffed. */
+        rmt->break_len = 0;
+        rmt_receive(channel, rmt->buffer, DMX_RMT_BUFFER_SYMBOLS * sizeof(rmt_symbol_word_t),
+                    &dmx_rmt_receive_config);
+    }
+
+    return false;
+}
+
+bool dmx_rmt_init(dmx_port_t dmx_num, void *isr_context, int sniffer_pin, int isr_flags) {
+    struct dmx_rmt_t *rmt = &dmx_rmt_context[dmx_num];
+
+    rmt->buffer = heap_caps_malloc(DMX_RMT_BUFFER_SYMBOLS * sizeof(rmt_symbol_word_t),
+                                   MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    if (rmt->buffer == NULL) {
+        return false;
+    }
+
+    const rmt_rx_channel_config_t rx_config = {
+        .gpio_num          = sniffer_pin,
+        .clk_src           = RMT_CLK_SRC_DEFAULT,
+        .resolution_hz     = DMX_RMT_RESOLUTION_HZ,
+        .mem_block_symbols = DMX_RMT_MEM_SYMBOLS,
+        .intr_priority     = dmx_intr_flags_to_level(isr_flags),
+    };
+    if (rmt_new_rx_channel(&rx_config, &rmt->channel) != ESP_OK) {
+        heap_caps_free(rmt->buffer);
+        rmt->buffer = NULL;
+        return false;
+    }
+
+    const rmt_rx_event_callbacks_t callbacks = {.on_recv_done = dmx_rmt_rx_done};
+    rmt->driver                              = (dmx_driver_t *)isr_context;
+    rmt->break_len                           = 0;
+    if (rmt_rx_register_event_callbacks(rmt->channel, &callbacks, rmt) != ESP_OK ||
+        rmt_enable(rmt->channel) != ESP_OK ||
+        rmt_receive(rmt->channel, rmt->buffer, DMX_RMT_BUFFER_SYMBOLS * sizeof(rmt_symbol_word_t),
+                    &dmx_rmt_receive_config) != ESP_OK) {
+        dmx_rmt_deinit(dmx_num);
+        return false;
+    }
+
+    return true;
+}
+
+void dmx_rmt_deinit(dmx_port_t dmx_num) {
+    struct dmx_rmt_t *rmt = &dmx_rmt_context[dmx_num];
+    if (rmt->channel == NULL) {
+        return;
+    }
+
+    rmt_disable(rmt->channel);
+    rmt_del_channel(rmt->channel);
+    rmt->channel = NULL;
+    heap_caps_free(rmt->buffer);
+    rmt->buffer = NULL;
+}
+
+#else
+
+bool dmx_rmt_init(dmx_port_t dmx_num, void *isr_context, int sniffer_pin, int isr_flags) { return false; }
+
+void dmx_rmt_deinit(dmx_port_t dmx_num) {}
+
+#endif
@@ -2,10 +2,47 @@
 
 #include <stdbool.h>
 
+#include "./include/dma.h"
+#include "./include/isr.h"
 #include "./include/uart.h"
 #include "../include/service.h"
 #include "driver/gpio.h"
 
+#if ESP_IDF_VERSION_MAJOR >= 5
+#include "esp_cpu.h"
+#include "esp_private/esp_clk.h"
+#else
+#include "esp32/clk.h"
+#include "hal/cpu_hal.h"
+#endif
+
+#ifdef CONFIG_DMX_SHARED_TIMER
+/** @brief The DMX timer of each port. Each DMX timer is a virtual timer which
+ * counts against a single free-running hardware timer that is shared by every
+ * DMX port.*/
+static struct dmx_timer_t {
+    void *isr_context;  // The context of the DMX timer ISR of the port.
+    uint64_t base;      // The hardware count at which the counter of the DMX timer was 0.
+    uint64_t counter;   // The counter of the DMX timer while it is stopped.
+    uint64_t alarm;     // The alarm value of the DMX timer.
+    bool auto_reload;   // True if the counter is reset to 0 when the alarm is triggered.
+    bool is_armed;      // True if the alarm has not been triggered since it was set.
+    bool is_running;    // True if the DMX timer is counting.
+} dmx_timer_context[DMX_NUM_MAX] = {};
+
+/** @brief The hardware timer which is shared by every DMX port.*/
+static struct dmx_timer_shared_t {
+#if ESP_IDF_VERSION_MAJOR >= 5
+    gptimer_handle_t gptimer_handle;
+#else
+    timer_group_t group;  // The timer group to use for DMX functions.
+    timer_idx_t idx;      // The timer index to use for DMX functions.
+#endif
+    int num_ports;  // The number of DMX ports which use the hardware timer.
+} dmx_timer_shared = {};
+
+static portMUX_TYPE dmx_timer_spinlock = DMX_SPINLOCK_INIT;
+#else
 static struct dmx_timer_t {
 #if ESP_IDF_VERSION_MAJOR >= 5
     gptimer_handle_t gptimer_handle;
@@ -15,47 +52,205 @@ static struct dmx_timer_t {
 #endif
     bool is_running;
 } dmx_timer_context[DMX_NUM_MAX] = {};
+#endif
 
-static bool DMX_ISR_ATTR dmx_timer_isr(
+#ifdef CONFIG_DMX_SHARED_TIMER
+static uint64_t DMX_ISR_ATTR dmx_timer_shared_get_count() {
+#if ESP_IDF_VERSION_MAJOR >= 5
+    uint64_t count;
+    gptimer_get_raw_count(dmx_timer_shared.gptimer_handle, &count);
+    return count;
+#else
+    return timer_group_get_counter_value_in_isr(dmx_timer_shared.group, dmx_timer_shared.idx);
+#endif
+}
+
+// Sets the hardware alarm to the earliest deadline of the running DMX timers. Must be called in a critical section.
+static void DMX_ISR_ATTR dmx_timer_shared_schedule() {
+    bool is_armed     = false;
+    uint64_t deadline = UINT64_MAX;
+    for (int i = 0; i < DMX_NUM_MAX; ++i) {
+        const struct dmx_timer_t *const timer = &dmx_timer_context[i];
+        if (timer->is_running && timer->is_armed && timer->base + timer->alarm < deadline) {
+            deadline = timer->base + timer->alarm;
+            is_armed = true;
+        }
+    }
+
+#if ESP_IDF_VERSION_MAJOR >= 5
+    if (!is_armed) {
+        gptimer_set_alarm_action(dmx_timer_shared.gptimer_handle, NULL);
+        return;
+    }
+    const gptimer_alarm_config_t alarm_config = {
+        .alarm_count = deadline, .reload_count = 0, .flags.auto_reload_on_alarm = false};
+    gptimer_set_alarm_action(dmx_timer_shared.gptimer_handle, &alarm_config);
+#else
+    timer_group_set_alarm_value_in_isr(dmx_timer_shared.group, dmx_timer_shared.idx, deadline);
+    if (is_armed) {
+        timer_group_enable_alarm_in_isr(dmx_timer_shared.group, dmx_timer_shared.idx);
+    }
+#endif
+}
+
+static bool DMX_ISR_ATTR dmx_timer_shared_isr(
 #if ESP_IDF_VERSION_MAJOR >= 5
     gptimer_handle_t gptimer_handle, const gptimer_alarm_event_data_t *event_data,
 #endif
     void *arg) {
-    dmx_driver_t *const driver = (dmx_driver_t *)arg;
-    const dmx_port_t dmx_num   = driver->dmx_num;
-    int task_awoken            = false;
-
-    if (driver->dmx.status == DMX_STATUS_SENDING) {
-        if (driver->dmx.progress == DMX_PROGRESS_IN_BREAK) {
-            dmx_uart_invert_tx(dmx_num, 0);
-            driver->dmx.progress = DMX_PROGRESS_IN_MAB;
-
-            // Reset the alarm for the end of the DMX mark-after-break
-            dmx_timer_set_alarm(dmx_num, driver->mab_len, false);
-        } else {
-            // Write data to the UART
-            int write_len = driver->dmx.size;
-            dmx_uart_write_txfifo(dmx_num, driver->dmx.data, &write_len);
-            driver->dmx.head = write_len;
-
-            // Pause MAB timer alarm
-            dmx_timer_stop(dmx_num);  // TODO: is this needed?
-
-            // Enable DMX write interrupts
-            dmx_uart_enable_interrupt(dmx_num, DMX_INTR_TX_ALL);
+    int task_awoken = false;
+
+    // Trigger each DMX timer whose alarm is due. The handlers may set their timers again.
+    for (int i = 0; i < DMX_NUM_MAX; ++i) {
+        struct dmx_timer_t *const timer = &dmx_timer_context[i];
+        portENTER_CRITICAL_SAFE(&dmx_timer_spinlock);
+        const bool is_due = timer->is_running && timer->is_armed &&
+                            dmx_timer_shared_get_count() >= timer->base + timer->alarm;
+        if (is_due) {
+            if (timer->auto_reload) {
+                timer->base += timer->alarm;
+            } else {
+                timer->is_armed = false;
+            }
         }
-    } else {
-        taskENTER_CRITICAL_ISR(DMX_SPINLOCK(dmx_num));
-        if (driver->task_waiting) {
-            xTaskNotifyFromISR(driver->task_waiting, DMX_OK, eSetValueWithOverwrite, &task_awoken);
+        portEXIT_CRITICAL_SAFE(&dmx_timer_spinlock);
+        if (is_due) {
+            task_awoken |= dmx_timer_handle_alarm(timer->isr_context);
         }
-        taskEXIT_CRITICAL_ISR(DMX_SPINLOCK(dmx_num));
-        dmx_timer_stop(dmx_num);  // TODO: is this needed?
     }
 
+    portENTER_CRITICAL_SAFE(&dmx_timer_spinlock);
+    dmx_timer_shared_schedule();
+    portEXIT_CRITICAL_SAFE(&dmx_timer_spinlock);
+
     return task_awoken;
 }
 
+bool dmx_timer_init(dmx_port_t dmx_num, void *isr_context, int isr_flags) {
+    struct dmx_timer_t *timer = &dmx_timer_context[dmx_num];
+
+    // Initialize the hardware timer when the first DMX timer is initialized
+    if (dmx_timer_shared.num_ports == 0) {
+#if ESP_IDF_VERSION_MAJOR >= 5
+        const gptimer_config_t timer_config = {
+            .clk_src       = GPTIMER_CLK_SRC_DEFAULT,
+            .direction     = GPTIMER_COUNT_UP,
+            .resolution_hz = 1000000,  // 1MHz resolution timer
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 1, 0)
+            .intr_priority = dmx_intr_flags_to_level(isr_flags),
+#endif
+        };
+        esp_err_t err = gptimer_new_timer(&timer_config, &dmx_timer_shared.gptimer_handle);
+        if (err) {
+            return false;
+        }
+        const gptimer_event_callbacks_t gptimer_cb = {.on_alarm = dmx_timer_shared_isr};
+        gptimer_register_event_callbacks(dmx_timer_shared.gptimer_handle, &gptimer_cb, NULL);
+        gptimer_enable(dmx_timer_shared.gptimer_handle);
+        gptimer_start(dmx_timer_shared.gptimer_handle);
+#else
+        dmx_timer_shared.group = 0;
+        dmx_timer_shared.idx   = 0;
+        const timer_config_t timer_config = {
+            .divider     = 80,  // (80MHz / 80) == 1MHz resolution timer
+            .counter_dir = TIMER_COUNT_UP,
+            .counter_en  = false,
+            .alarm_en    = false,
+            .auto_reload = false,
+        };
+        esp_err_t err = timer_init(dmx_timer_shared.group, dmx_timer_shared.idx, &timer_config);
+        if (err) {
+            return false;
+        }
+        timer_isr_callback_add(dmx_timer_shared.group, dmx_timer_shared.idx, dmx_timer_shared_isr, NULL, isr_flags);
+        timer_start(dmx_timer_shared.group, dmx_timer_shared.idx);
+#endif
+    }
+    ++dmx_timer_shared.num_ports;
+
+    portENTER_CRITICAL_SAFE(&dmx_timer_spinlock);
+    timer->isr_context = isr_context;
+    timer->base        = 0;
+    timer->counter     = 0;
+    timer->alarm       = 0;
+    timer->auto_reload = false;
+    timer->is_armed    = false;
+    timer->is_running  = false;
+    portEXIT_CRITICAL_SAFE(&dmx_timer_spinlock);
+
+    return true;
+}
+
+void dmx_timer_deinit(dmx_port_t dmx_num) {
+    dmx_timer_stop(dmx_num);
+
+    // Free the hardware timer when the last DMX timer is de-initialized
+    if (--dmx_timer_shared.num_ports == 0) {
+#if ESP_IDF_VERSION_MAJOR >= 5
+        gptimer_stop(dmx_timer_shared.gptimer_handle);
+        gptimer_disable(dmx_timer_shared.gptimer_handle);
+        gptimer_del_timer(dmx_timer_shared.gptimer_handle);
+#else
+        timer_isr_callback_remove(dmx_timer_shared.group, dmx_timer_shared.idx);
+        timer_deinit(dmx_timer_shared.group, dmx_timer_shared.idx);
+#endif
+    }
+}
+
+void DMX_ISR_ATTR dmx_timer_stop(dmx_port_t dmx_num) {
+    struct dmx_timer_t *timer = &dmx_timer_context[dmx_num];
+    portENTER_CRITICAL_SAFE(&dmx_timer_spinlock);
+    if (timer->is_running) {
+        timer->is_running = false;
+        timer->counter    = 0;
+        dmx_timer_shared_schedule();
+    }
+    portEXIT_CRITICAL_SAFE(&dmx_timer_spinlock);
+}
+
+void DMX_ISR_ATTR dmx_timer_set_counter(dmx_port_t dmx_num, uint64_t counter) {
+    struct dmx_timer_t *timer = &dmx_timer_context[dmx_num];
+    portENTER_CRITICAL_SAFE(&dmx_timer_spinlock);
+    if (timer->is_running) {
+        timer->base = dmx_timer_shared_get_count() - counter;
+        dmx_timer_shared_schedule();
+    } else {
+        timer->counter = counter;
+    }
+    portEXIT_CRITICAL_SAFE(&dmx_timer_spinlock);
+}
+
+void DMX_ISR_ATTR dmx_timer_set_alarm(dmx_port_t dmx_num, uint64_t alarm, bool auto_reload) {
+    struct dmx_timer_t *timer = &dmx_timer_context[dmx_num];
+    portENTER_CRITICAL_SAFE(&dmx_timer_spinlock);
+    timer->alarm       = alarm;
+    timer->auto_reload = auto_reload;
+    timer->is_armed    = true;
+    if (timer->is_running) {
+        dmx_timer_shared_schedule();
+    }
+    portEXIT_CRITICAL_SAFE(&dmx_timer_spinlock);
+}
+
+void DMX_ISR_ATTR dmx_timer_start(dmx_port_t dmx_num) {
+    struct dmx_timer_t *timer = &dmx_timer_context[dmx_num];
+    portENTER_CRITICAL_SAFE(&dmx_timer_spinlock);
+    if (!timer->is_running) {
+        timer->base       = dmx_timer_shared_get_count() - timer->counter;
+        timer->is_running = true;
+        dmx_timer_shared_schedule();
+    }
+    portEXIT_CRITICAL_SAFE(&dmx_timer_spinlock);
+}
+#else
+static bool DMX_ISR_ATTR dmx_timer_isr(
+#if ESP_IDF_VERSION_MAJOR >= 5
+    gptimer_handle_t gptimer_handle, const gptimer_alarm_event_data_t *event_data,
+#endif
+    void *arg) {
+    return dmx_timer_handle_alarm(arg);
+}
+
 bool dmx_timer_init(dmx_port_t dmx_num, void *isr_context, int isr_flags) {
     struct dmx_timer_t *timer = &dmx_timer_context[dmx_num];
 
@@ -65,6 +260,9 @@ bool dmx_timer_init(dmx_port_t dmx_num, void *isr_context, int isr_flags) {
         .clk_src       = GPTIMER_CLK_SRC_DEFAULT,
         .direction     = GPTIMER_COUNT_UP,
         .resolution_hz = 1000000,  // 1MHz resolution timer
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 1, 0)
+        .intr_priority = dmx_intr_flags_to_level(isr_flags),
+#endif
     };
     esp_err_t err = gptimer_new_timer(&timer_config, &timer->gptimer_handle);
     if (err) {
@@ -154,7 +352,37 @@ void DMX_ISR_ATTR dmx_timer_start(dmx_port_t dmx_num) {
         timer->is_running = true;
     }
 }
+#endif
 
 int64_t DMX_ISR_ATTR dmx_timer_get_micros_since_boot() {
     return esp_timer_get_time();
-}
\ No newline at end of file
+}
+
+uint32_t DMX_ISR_ATTR dmx_timer_get_cycle_count() {
+#if ESP_IDF_VERSION_MAJOR >= 5
+    return esp_cpu_get_cycle_count();
+#else
+    return cpu_hal_get_cycle_count();
+#endif
+}
+
+uint64_t dmx_timer_cycles_to_micros(uint64_t cycles) {
+    const uint32_t cycles_per_us = esp_clk_cpu_freq() / 1000000;
+    return (cycles + cycles_per_us / 2) / cycles_per_us;
+}
+
+uint32_t DMX_ISR_ATTR dmx_timer_get_timestamp() {
+#ifdef CONFIG_DMX_ISR_CYCLE_TIMESTAMPS
+    return dmx_timer_get_cycle_count();
+#else
+    return esp_timer_get_time();
+#endif
+}
+
+uint32_t dmx_timer_timestamp_to_micros(uint32_t elapsed) {
+#ifdef CONFIG_DMX_ISR_CYCLE_TIMESTAMPS
+    return dmx_timer_cycles_to_micros(elapsed);
+#else
+    return elapsed;
+#endif
+}
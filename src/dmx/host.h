@@ -0,0 +1,138 @@
+/**
+ * @file dmx/host.h
+ * @author Mitch Weisbrod (mitch@theweisbrods.com)
+ * @brief This file contains functions to control the simulated DMX bus of the
+ * host HAL, which is used when esp_dmx is built for the linux target of the
+ * ESP-IDF. The simulated UARTs send and receive one slot every 44 microseconds
+ * of simulated time. Simulated time only advances while every other task is
+ * blocked, so the DMX driver runs as fast as the host allows while its timing
+ * is the same as it is on the target.
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "./include/types.h"
+#include "../rdm/include/types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @brief The slot value which is passed to a dmx_host_tap_cb_t when a DMX
+ * break is started.*/
+#define DMX_HOST_BREAK (-1)
+
+/**
+ * @brief A function type for callbacks which observe the slots sent by a DMX
+ * port on the simulated bus. Callbacks are called from the simulated DMX
+ * interrupt and must not block.
+ *
+ * @param dmx_num The DMX port number which sent the slot.
+ * @param timestamp The simulated time in microseconds at which the slot ended,
+ * or at which the DMX break started.
+ * @param slot The value of the slot, or DMX_HOST_BREAK.
+ * @param[inout] context The user context provided to dmx_host_set_tap().
+ */
+typedef void (*dmx_host_tap_cb_t)(dmx_port_t dmx_num, int64_t timestamp,
+                                  int slot, void *context);
+
+/**
+ * @brief Connects two DMX ports to the same simulated DMX bus, as if each DMX
+ * port had its own RS-485 transceiver on the same DMX cable. If either DMX port
+ * is already connected to a bus, the buses are joined, so any number of DMX
+ * ports may share a bus. The slots sent by each DMX port are received by every
+ * other DMX port on the bus. A DMX port only receives slots while its RTS pin
+ * is set to receive.
+ *
+ * Slots which are sent by more than one DMX port at the same time collide. If
+ * the colliding slots start within half of a bit time of each other, they are
+ * received as the bitwise AND of their values, as the line is pulled low by any
+ * transceiver which sends a 0 bit. Otherwise they are received with a framing
+ * error.
+ *
+ * @param a The DMX port number of the first DMX port.
+ * @param b The DMX port number of the second DMX port.
+ * @return true if the DMX ports were connected.
+ * @return false on failure.
+ */
+bool dmx_host_connect(dmx_port_t a, dmx_port_t b);
+
+/**
+ * @brief Disconnects a DMX port from the simulated DMX bus to which it is
+ * connected. The other DMX ports on the bus stay connected.
+ *
+ * @param dmx_num The DMX port number.
+ * @return true if the DMX port was disconnected.
+ * @return false if the DMX port was not connected.
+ */
+bool dmx_host_disconnect(dmx_port_t dmx_num);
+
+/**
+ * @brief Sets the delay between the time at which a DMX port sends each slot
+ * and the time at which the slot is received by the other DMX ports on its
+ * simulated bus. It models the response time of the transceiver and cable as
+ * well as the differences in the response times of RDM responders. Virtual
+ * responders with different latencies do not line up when they respond to the
+ * same RDM discovery request, so their responses collide with framing errors.
+ *
+ * @param dmx_num The DMX port number.
+ * @param latency The latency in microseconds.
+ * @return true on success.
+ * @return false on failure.
+ */
+bool dmx_host_set_latency(dmx_port_t dmx_num, uint32_t latency);
+
+/**
+ * @brief Sets the RDM UID of an installed DMX driver. By default, the DMX
+ * drivers on the host have adjacent UIDs which are incremented by DMX port
+ * number. Setting the UIDs of virtual responders allows RDM discovery to be
+ * tested with any distribution of UIDs.
+ *
+ * @param dmx_num The DMX port number.
+ * @param[in] uid A pointer to the RDM UID to set.
+ * @return true on success.
+ * @return false on failure.
+ */
+bool dmx_host_set_uid(dmx_port_t dmx_num, const rdm_uid_t *uid);
+
+/**
+ * @brief Queues a packet to be received by a DMX port as if it were sent by
+ * another device on the DMX bus. The packet starts as soon as the last packet
+ * which was queued on the DMX port has ended. Packets without a DMX break, such
+ * as RDM discovery responses, are queued with a break length of 0.
+ *
+ * @param dmx_num The DMX port number.
+ * @param[in] data The packet to receive, including its start code.
+ * @param size The size of the packet.
+ * @param break_len The length of the DMX break in microseconds, or 0.
+ * @param mab_len The length of the mark-after-break in microseconds.
+ * @return true if the packet was queued.
+ * @return false if the queue of the DMX port is full or on failure.
+ */
+bool dmx_host_inject(dmx_port_t dmx_num, const void *data, size_t size,
+                     uint32_t break_len, uint32_t mab_len);
+
+/**
+ * @brief Sets a callback which observes every slot sent by a DMX port.
+ *
+ * @param dmx_num The DMX port number.
+ * @param cb The callback, or NULL to remove the callback.
+ * @param[in] context An optional user context which is passed to the callback.
+ * @return true on success.
+ * @return false on failure.
+ */
+bool dmx_host_set_tap(dmx_port_t dmx_num, dmx_host_tap_cb_t cb, void *context);
+
+/**
+ * @brief Gets the simulated time.
+ *
+ * @return The simulated time in microseconds since the simulation started.
+ */
+int64_t dmx_host_get_time();
+
+#ifdef __cplusplus
+}
+#endif
@@ -193,6 +193,54 @@ uint32_t dmx_get_mab_len(dmx_port_t dmx_num);
  */
 uint32_t dmx_set_mab_len(dmx_port_t dmx_num, uint32_t mab_len);
 
+/**
+ * @brief Gets the minimum size of automatically sized DMX packets.
+ *
+ * @param dmx_num The DMX port number.
+ * @return The minimum size of automatically sized DMX packets, or 0 if DMX
+ * packets are not automatically sized.
+ */
+size_t dmx_get_auto_size(dmx_port_t dmx_num);
+
+/**
+ * @brief Sizes each DMX packet that is sent to include the highest slot which
+ * was written, instead of the size that was passed to dmx_send_num() or
+ * dmx_start_continuous(). The highest written slot is tracked from the time
+ * that this function is called, so packets never shrink while it is enabled.
+ * Shorter packets take less time to send, so a small rig which is sent
+ * continuously at DMX_REFRESH_HZ_MAX is refreshed much faster than a rig which
+ * uses every slot. RDM packets are not affected.
+ *
+ * @param dmx_num The DMX port number.
+ * @param min_size The minimum size of each DMX packet, including the start
+ * code. If 0, automatic sizing is disabled.
+ * @return The minimum size that was set, or 0 if automatic sizing is disabled
+ * or on error.
+ */
+size_t dmx_set_auto_size(dmx_port_t dmx_num, size_t min_size);
+
+/**
+ * @brief Gets the runtime statistics of the DMX port. The statistics include
+ * counts of packets and errors, the measured refresh rate of received DMX
+ * packets, and the execution time of the DMX interrupts.
+ *
+ * @param dmx_num The DMX port number.
+ * @param[out] stats A pointer to a dmx_stats_t into which the statistics are
+ * copied.
+ * @return true on success.
+ * @return false on failure.
+ */
+bool dmx_get_stats(dmx_port_t dmx_num, dmx_stats_t *stats);
+
+/**
+ * @brief Resets the runtime statistics of the DMX port to zero.
+ *
+ * @param dmx_num The DMX port number.
+ * @return true on success.
+ * @return false on failure.
+ */
+bool dmx_reset_stats(dmx_port_t dmx_num);
+
 /**
  * @brief Reads DMX data from the driver into a destination buffer with an
  * offset. This can be useful when a receiving DMX device only needs to process
@@ -228,11 +276,36 @@ size_t dmx_read(dmx_port_t dmx_num, void *destination, size_t size);
  */
 int dmx_read_slot(dmx_port_t dmx_num, size_t slot_num);
 
+/**
+ * @brief Gets a bitmap of the DMX slots which changed between the last complete
+ * DMX packet and the packet before it. Bit 0 of the first byte of the bitmap
+ * represents slot number first, bit 1 represents slot number first + 1, etc.
+ *
+ * @note Changed slots are only tracked when CONFIG_DMX_CHANGED_SLOTS is
+ * enabled, and only between DMX packets with a null start code. Otherwise,
+ * every slot is reported as changed.
+ *
+ * @param dmx_num The DMX port number.
+ * @param[out] bitmap The destination bitmap. It must be at least
+ * (count + 7) / 8 bytes long.
+ * @param first The first slot number of the bitmap.
+ * @param count The number of slots to include in the bitmap.
+ * @return The number of slots which changed within the requested range.
+ */
+size_t dmx_get_changed_slots(dmx_port_t dmx_num, uint8_t *bitmap, size_t first, size_t count);
+
 /**
  * @brief Writes DMX data from a source buffer into the DMX driver buffer with
  * an offset. Allows a source buffer to be written to a specific slot number in
  * the DMX driver buffer.
  *
+ * @note The data is copied into the staged buffer and swapped into the DMX
+ * driver buffer by pointer, as with dmx_write_staged() and dmx_write_commit(),
+ * so a packet which is being sent is never changed while it is on the DMX bus.
+ * If the DMX driver is sending or receiving, the data is swapped in at the
+ * next DMX break.
+ * Any data which was staged but not yet committed is committed with it.
+ *
  * @param dmx_num The DMX port number.
  * @param offset The number of slots with which to offset the write. If set to 0
  * this function is equivalent to dmx_write().
@@ -262,6 +335,31 @@ size_t dmx_write(dmx_port_t dmx_num, const void *source, size_t size);
  */
 int dmx_write_slot(dmx_port_t dmx_num, size_t slot_num, uint8_t value);
 
+/**
+ * @brief Writes DMX data into the staged buffer of the DMX driver. Staged data
+ * is not sent until dmx_write_commit() is called, so it does not affect the
+ * packet being sent. The staged buffer starts as a copy of the last sent
+ * packet.
+ *
+ * @param dmx_num The DMX port number.
+ * @param offset The number of slots with which to offset the write.
+ * @param[in] source The source buffer which is copied to the staged buffer.
+ * @param size The size of the source buffer.
+ * @return The number of bytes written into the staged buffer.
+ */
+size_t dmx_write_staged(dmx_port_t dmx_num, size_t offset, const void *source, size_t size);
+
+/**
+ * @brief Commits the staged buffer so that it is sent as the next DMX packet.
+ * The staged buffer is swapped in at the beginning of the next DMX break so
+ * that each packet which is sent is internally consistent.
+ *
+ * @param dmx_num The DMX port number.
+ * @retval true if the staged buffer was committed.
+ * @retval false on failure.
+ */
+bool dmx_write_commit(dmx_port_t dmx_num);
+
 /**
  * @brief Receives a DMX packet of a specified size from the DMX bus. This is a
  * blocking function. This function first blocks until the DMX driver is idle
@@ -303,6 +401,164 @@ size_t dmx_receive_num(dmx_port_t dmx_num, dmx_packet_t *packet, size_t size, Ti
  */
 size_t dmx_receive(dmx_port_t dmx_num, dmx_packet_t *packet, TickType_t wait_ticks);
 
+/**
+ * @brief Receives a DMX packet from whichever of a group of DMX ports receives
+ * a packet first. This allows a single task to service multiple DMX ports
+ * without polling. If more than one DMX port has a packet ready, the port which
+ * appears first in the array is received.
+ *
+ * @note This function uses FreeRTOS direct-to-task notifications to block and
+ * unblock. Using task notifications on the same task that calls this function
+ * can lead to undesired behavior and program instability.
+ *
+ * @param[in] ports An array of DMX port numbers.
+ * @param n The number of DMX ports in the array.
+ * @param[out] which A pointer into which the DMX port number which received the
+ * packet is stored.
+ * @param[out] packet An optional pointer to a dmx_packet_t which contains
+ * information about the received DMX packet.
+ * @param wait_ticks The number of ticks to wait before this function times out.
+ * @return The size of the received DMX packet or 0 if no packet was received.
+ */
+size_t dmx_receive_any(const dmx_port_t *ports, size_t n, dmx_port_t *which, dmx_packet_t *packet,
+                       TickType_t wait_ticks);
+
+/**
+ * @brief Subscribes a callback to the packets received by the DMX driver. The
+ * callback is called from the DMX interrupt each time a packet is received, so
+ * any number of tasks may be notified of each packet without calling
+ * dmx_receive(). Up to 4 callbacks may be subscribed per DMX port.
+ *
+ * @note Subscriber callbacks are called from an interrupt. They must not block
+ * and must be placed in IRAM if the DMX driver is placed in IRAM.
+ *
+ * @param dmx_num The DMX port number.
+ * @param cb The callback to call when a packet is received.
+ * @param[in] context An optional user context which is passed to the callback.
+ * @retval true if the callback was subscribed.
+ * @retval false if there are no subscriber slots available or on failure.
+ */
+bool dmx_subscribe(dmx_port_t dmx_num, dmx_subscriber_cb_t cb, void *context);
+
+/**
+ * @brief Unsubscribes a callback which was subscribed with dmx_subscribe().
+ *
+ * @param dmx_num The DMX port number.
+ * @param cb The callback which was subscribed.
+ * @param[in] context The user context with which the callback was subscribed.
+ * @retval true if the callback was unsubscribed.
+ * @retval false if the callback was not subscribed or on failure.
+ */
+bool dmx_unsubscribe(dmx_port_t dmx_num, dmx_subscriber_cb_t cb, void *context);
+
+/**
+ * @brief Sets the start codes of the packets which are received by
+ * dmx_receive(). Packets with any other start code are filtered by the DMX
+ * interrupt, so they do not wake the task which is waiting to receive a packet.
+ * Filtered packets are still delivered to subscriber callbacks. Packets with
+ * errors are never filtered. By default, every start code is accepted.
+ *
+ * @note RDM packets use the RDM_SC start code, including RDM discovery
+ * responses which do not begin with it. RDM_SC must be accepted on a DMX port
+ * which is used as an RDM controller or RDM responder.
+ *
+ * @param dmx_num The DMX port number.
+ * @param[in] start_codes An array of the start codes which are accepted, or
+ * NULL to accept every start code.
+ * @param count The number of start codes in the array.
+ * @return true on success.
+ * @return false on failure.
+ */
+bool dmx_set_start_code_filter(dmx_port_t dmx_num, const uint8_t *start_codes, size_t count);
+
+/**
+ * @brief Sets whether RDM packets which are not addressed to this device are
+ * filtered by the DMX interrupt. When enabled, RDM requests are only received
+ * by dmx_receive() if they are addressed to the UID of the DMX port or to a
+ * broadcast UID which includes it, RDM responses are only received if they are
+ * addressed to the UID of the DMX port, and RDM discovery responses are only
+ * received if the DMX port sent the last RDM request. Incoming RDM discovery
+ * requests are still answered because they are broadcast. By default, RDM
+ * packets are not filtered.
+ *
+ * @param dmx_num The DMX port number.
+ * @param enable True to filter RDM packets which are not addressed to this
+ * device.
+ * @return true on success.
+ * @return false on failure.
+ */
+bool dmx_set_rdm_filter(dmx_port_t dmx_num, bool enable);
+
+/**
+ * @brief Receives a DMX packet from the DMX bus and leases the driver buffer
+ * which holds it. This function behaves like dmx_receive() but instead of
+ * requiring the packet to be copied with dmx_read(), it provides a pointer to
+ * the packet data within the DMX driver. The DMX driver does not write to a
+ * leased buffer. The lease must be returned by calling dmx_release() as soon as
+ * the packet data is no longer needed. Only one lease may be held per DMX port.
+ * Calling this function while a lease is held releases the previous lease.
+ *
+ * @note With the default CONFIG_DMX_RX_BUFFER_COUNT of 1, the leased buffer is
+ * the only receive buffer, so every packet which arrives while the lease is
+ * held is dropped. It is recommended to set CONFIG_DMX_RX_BUFFER_COUNT to 3
+ * when using this function. If the packet is overwritten by the next packet
+ * before this function can lease it, no packet is returned.
+ *
+ * @note This function uses FreeRTOS direct-to-task notifications to block and
+ * unblock. Using task notifications on the same task that calls this function
+ * can lead to undesired behavior and program instability.
+ *
+ * @param dmx_num The DMX port number.
+ * @param[out] data A pointer to a pointer into which the address of the packet
+ * data is stored. It is set to NULL if no packet was received.
+ * @param[out] packet An optional pointer to a dmx_packet_t which contains
+ * information about the received DMX packet.
+ * @param wait_ticks The number of ticks to wait before this function times out.
+ * @return The size of the received DMX packet or 0 if no packet was received.
+ */
+size_t dmx_receive_lease(dmx_port_t dmx_num, const uint8_t **data, dmx_packet_t *packet, TickType_t wait_ticks);
+
+/**
+ * @brief Receives a DMX packet and leases only the slots of this device's
+ * footprint. This function behaves like dmx_receive_lease() but provides a
+ * pointer to the slot at the DMX start address, and returns the number of
+ * slots of the footprint of the current DMX personality which were received.
+ * The DMX start address and footprint are cached by the DMX driver and are
+ * only looked up again after the DMX start address or the DMX personality is
+ * changed, such as by an RDM controller. The lease must be returned by calling
+ * dmx_release().
+ *
+ * @note This function uses FreeRTOS direct-to-task notifications to block and
+ * unblock. Using task notifications on the same task that calls this function
+ * can lead to undesired behavior and program instability.
+ *
+ * @param dmx_num The DMX port number.
+ * @param[out] slots A pointer to a pointer into which the address of the first
+ * slot of the footprint is stored. It is set to NULL if no footprint was
+ * received.
+ * @param[out] packet An optional pointer to a dmx_packet_t which contains
+ * information about the received DMX packet.
+ * @param only_changed True to keep waiting until a packet is received in which
+ * a slot of the footprint changed, or in which the footprint moved. Every
+ * packet is treated as changed unless CONFIG_DMX_CHANGED_SLOTS is enabled.
+ * @param wait_ticks The number of ticks to wait before this function times out.
+ * @return The number of slots of the footprint which were received, or 0 if
+ * this device has no footprint, the packet was too short, or no packet was
+ * received.
+ */
+size_t dmx_receive_footprint(dmx_port_t dmx_num, const uint8_t **slots, dmx_packet_t *packet, bool only_changed,
+                             TickType_t wait_ticks);
+
+/**
+ * @brief Releases a buffer which was leased using dmx_receive_lease(). After
+ * this function is called, the DMX driver may overwrite the leased packet data.
+ *
+ * @param dmx_num The DMX port number.
+ * @retval true if a lease was released.
+ * @retval false if no lease was held.
+ */
+bool dmx_release(dmx_port_t dmx_num);
+
 /**
  * @brief Sends a DMX packet on the DMX bus. This function blocks until the DMX
  * driver is idle and then sends a packet.
@@ -332,10 +588,93 @@ size_t dmx_send_num(dmx_port_t dmx_num, size_t size);
  */
 size_t dmx_send(dmx_port_t dmx_num);
 
+/**
+ * @brief Sends a full DMX packet on each of a group of DMX ports so that the
+ * packets are frame-aligned. This function blocks until each DMX driver is
+ * idle and then arms a single DMX timer alarm on the first port in the group.
+ * The alarm starts the DMX break on every port while the spinlock of each port
+ * is held, so the breaks are skewed only by the few register writes needed to
+ * start each one. The packets are sent from the data most recently written to
+ * each port and are sized by dmx_set_auto_size() when it is enabled. Ports
+ * which are sending continuously cannot be sent as part of a group, and
+ * parallel ports cannot be grouped with UART ports.
+ *
+ * @note This function uses FreeRTOS direct-to-task notifications to block and
+ * unblock. Using task notifications on the same task that calls this function
+ * can lead to undesired behavior and program instability.
+ *
+ * @param[in] ports An array of DMX port numbers. Each port may only appear
+ * once.
+ * @param n The number of DMX ports in the array.
+ * @return The number of DMX ports on which a packet was sent. This is either n
+ * or 0 on failure.
+ */
+size_t dmx_send_group(const dmx_port_t *ports, size_t n);
+
+/**
+ * @brief Schedules a full DMX packet to be sent so that its DMX break starts at
+ * a timestamp. The DMX timer starts the DMX break, so the packet starts at the
+ * same time regardless of when the calling task runs. This allows the packets
+ * of several devices to be frame-aligned when their timestamps are derived
+ * from a shared time base, such as an SNTP-disciplined clock or a sync pulse
+ * which is timestamped in a GPIO interrupt. This function blocks until the DMX
+ * driver is idle and then returns without waiting for the timestamp. Until the
+ * DMX break starts the DMX port is armed rather than sending: dmx_write() may
+ * still update the scheduled packet, dmx_wait_sent() returns immediately, and
+ * dmx_send() and the other sending functions fail without blocking. Calling
+ * this function again reschedules the packet. If the timestamp has already
+ * passed, the packet is sent immediately. Ports which are sending continuously
+ * cannot schedule packets.
+ *
+ * @note This function uses FreeRTOS direct-to-task notifications to block and
+ * unblock. Using task notifications on the same task that calls this function
+ * can lead to undesired behavior and program instability.
+ *
+ * @param dmx_num The DMX port number.
+ * @param timestamp The time at which to start the DMX break, in microseconds
+ * since boot as returned by esp_timer_get_time(). It may not be more than
+ * DMX_SEND_AT_MAX_US in the future.
+ * @return The number of bytes which are scheduled to be sent on the DMX bus,
+ * or 0 on failure. If the packet is automatically sized, writes made while the
+ * DMX port is armed may lengthen it.
+ */
+size_t dmx_send_at(dmx_port_t dmx_num, int64_t timestamp);
+
+/**
+ * @brief Starts sending DMX packets continuously at a fixed refresh rate. The
+ * DMX timer starts each DMX break on its own so that DMX packets are sent
+ * without the need to call dmx_send(). Every packet sends the data most
+ * recently written with dmx_write(). Calls to dmx_send() while sending
+ * continuously return immediately. If an RDM request is sent, continuous
+ * sending is paused until the RDM transaction is complete and it is resumed
+ * by rdm_send_request() or by the next call to dmx_send() with DMX data.
+ *
+ * @note If the refresh rate is faster than the packet can be sent, packets are
+ * sent back-to-back.
+ *
+ * @param dmx_num The DMX port number.
+ * @param refresh_hz The number of packets to send per second.
+ * @param size The size of the packets to send. If 0, sends full DMX packets.
+ * @retval true if continuous sending was started.
+ * @retval false on failure.
+ */
+bool dmx_start_continuous(dmx_port_t dmx_num, uint32_t refresh_hz, size_t size);
+
+/**
+ * @brief Stops sending DMX packets continuously. The packet that is currently
+ * being sent, if any, is allowed to finish.
+ *
+ * @param dmx_num The DMX port number.
+ * @retval true if continuous sending was stopped.
+ * @retval false if the DMX driver was not sending continuously.
+ */
+bool dmx_stop_continuous(dmx_port_t dmx_num);
+
 /**
  * @brief Waits until the DMX packet is done being sent. This function can be
  * used to ensure that calls to dmx_write() happen synchronously with the
- * current DMX frame.
+ * current DMX frame. If the DMX driver is not sending, this function returns
+ * immediately without taking the DMX driver mutex.
  *
  * @note This function uses FreeRTOS direct-to-task notifications to block and
  * unblock. Using task notifications on the same task that calls this function
@@ -348,6 +687,24 @@ size_t dmx_send(dmx_port_t dmx_num);
  */
 bool dmx_wait_sent(dmx_port_t dmx_num, TickType_t wait_ticks);
 
+/**
+ * @brief Waits until each DMX port in a group is done sending its DMX packet.
+ * This function can be used after dmx_send_group() to ensure that calls to
+ * dmx_write() happen synchronously with the group's DMX frame.
+ *
+ * @note This function uses FreeRTOS direct-to-task notifications to block and
+ * unblock. Using task notifications on the same task that calls this function
+ * can lead to undesired behavior and program instability.
+ *
+ * @param[in] ports An array of DMX port numbers.
+ * @param n The number of DMX ports in the array.
+ * @param wait_ticks The number of ticks to wait before this function times out.
+ * The timeout is shared by every port in the group.
+ * @retval true if every DMX driver is done sending.
+ * @retval false if the function timed out.
+ */
+bool dmx_wait_sent_group(const dmx_port_t *ports, size_t n, TickType_t wait_ticks);
+
 #ifdef __cplusplus
 }
 #endif
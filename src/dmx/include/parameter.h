@@ -70,7 +70,9 @@ size_t dmx_parameter_size(dmx_port_t dmx_num, rdm_sub_device_t sub_device, rdm_p
 
 /**
  * @brief Get a pointer to the desired parameter. The returned pointer, if it
- * is valid, is not thread-safe.
+ * is valid, is not thread-safe. Pointers to the values of sub-devices are
+ * invalidated when a dynamic or non-volatile parameter is added to the
+ * sub-devices, because the value block of every sub-device is reallocated.
  *
  * @param dmx_num The DMX port number.
  * @param sub_device The sub-device number.
@@ -109,6 +111,20 @@ size_t dmx_parameter_copy(dmx_port_t dmx_num, rdm_sub_device_t sub_device, rdm_p
 size_t dmx_parameter_set(dmx_port_t dmx_num, rdm_sub_device_t sub_device, rdm_pid_t pid, const void *source,
                          size_t size);
 
+/**
+ * @brief Sets the value of a desired parameter on the root device and on every
+ * sub-device which has been added. Only sub-devices which exist are visited.
+ * Non-volatile sub-device parameters are staged as a single batch so they are
+ * committed to non-volatile storage by one call to dmx_parameter_commit().
+ *
+ * @param dmx_num The DMX port number.
+ * @param pid The parameter ID of the desired parameter.
+ * @param[in] source The value to which to set the parameter.
+ * @param size The size of the source buffer.
+ * @return The number of bytes written to the parameter.
+ */
+size_t dmx_parameter_set_all(dmx_port_t dmx_num, rdm_pid_t pid, const void *source, size_t size);
+
 /**
  * @brief Commits any updated non-volatile parameters to non-volatile storage.
  * Because committing non-volatile parameters can take some time, this function
@@ -121,6 +137,49 @@ size_t dmx_parameter_set(dmx_port_t dmx_num, rdm_sub_device_t sub_device, rdm_pi
  */
 rdm_pid_t dmx_parameter_commit(dmx_port_t dmx_num);
 
+/**
+ * @brief Starts a low-priority task which commits non-volatile parameters to
+ * non-volatile storage in the background. Parameters are committed once they
+ * have been unchanged for the debounce time, so a burst of RDM SET requests
+ * results in a single write. Every staged parameter is written using one NVS
+ * handle and a single commit. DMX drivers which must be disabled for the
+ * write are disabled after they finish sending their current packet. While
+ * this task is running, dmx_receive() no longer commits parameters when it
+ * times out and dmx_parameter_commit() should not be called by the user.
+ *
+ * @param dmx_num The DMX port number.
+ * @param debounce_ms The time in milliseconds for which parameters must be
+ * unchanged before they are committed.
+ * @param priority The priority of the commit task.
+ * @param core_id The core on which to run the task, or tskNO_AFFINITY.
+ * @return true if the task is running.
+ * @return false on failure.
+ */
+bool dmx_parameter_commit_start(dmx_port_t dmx_num, uint32_t debounce_ms, UBaseType_t priority,
+                                BaseType_t core_id);
+
+/**
+ * @brief Stops the task which was started with dmx_parameter_commit_start().
+ * Parameters which are staged when the task is stopped are committed before
+ * this function returns. This function is called automatically when the DMX
+ * driver is deleted.
+ *
+ * @param dmx_num The DMX port number.
+ * @return true if the task is not running.
+ * @return false on failure.
+ */
+bool dmx_parameter_commit_stop(dmx_port_t dmx_num);
+
+/**
+ * @brief Returns true if the task started with dmx_parameter_commit_start() is
+ * running.
+ *
+ * @param dmx_num The DMX port number.
+ * @return true if the commit task is running.
+ * @return false if it is not.
+ */
+bool dmx_parameter_commit_is_running(dmx_port_t dmx_num);
+
 #ifdef __cplusplus
 }
 #endif
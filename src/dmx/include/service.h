@@ -8,9 +8,14 @@
 
 #include <stdint.h>
 
+#include "../parallel.h"
+#include "../trace.h"
 #include "parameter.h"
 #include "types.h"
 #include "esp_check.h"
+#ifndef CONFIG_IDF_TARGET_LINUX
+#include "esp_intr_alloc.h"
+#endif
 #include "freertos/queue.h"
 #include "freertos/semphr.h"
 #include "./../../rdm/responder/include/utils.h"
@@ -53,9 +58,153 @@ extern "C" {
  * needed for devices which have multiple cores.*/
 #define DMX_USE_SPINLOCK
 #define DMX_SPINLOCK(n) (&dmx_driver[(n)]->spinlock)
-typedef spinlock_t dmx_spinlock_t;
+typedef portMUX_TYPE dmx_spinlock_t;
 #define DMX_SPINLOCK_INIT portMUX_INITIALIZER_UNLOCKED
 
+#ifdef CONFIG_DMX_RX_BUFFER_COUNT
+/** @brief The number of DMX packet buffers allocated per driver. When more
+ * than one buffer is used, the DMX driver receives into a back buffer and
+ * publishes each complete DMX packet by pointer so that readers never see a
+ * packet which is partially overwritten by the next packet.*/
+#define DMX_RX_BUFFER_COUNT (CONFIG_DMX_RX_BUFFER_COUNT)
+#else
+/** @brief The number of DMX packet buffers allocated per driver.*/
+#define DMX_RX_BUFFER_COUNT (1)
+#endif
+
+#ifdef CONFIG_DMX_SNIFFER_HISTORY_SIZE
+/** @brief The number of packets which are kept in the DMX sniffer history.
+ * Must be a power of two so that the history indices may wrap around.*/
+#define DMX_SNIFFER_HISTORY_SIZE (CONFIG_DMX_SNIFFER_HISTORY_SIZE)
+#else
+/** @brief The number of packets which are kept in the DMX sniffer history.*/
+#define DMX_SNIFFER_HISTORY_SIZE (32)
+#endif
+_Static_assert(DMX_SNIFFER_HISTORY_SIZE == 0 || (DMX_SNIFFER_HISTORY_SIZE & (DMX_SNIFFER_HISTORY_SIZE - 1)) == 0,
+               "DMX_SNIFFER_HISTORY_SIZE must be a power of two");
+
+/** @brief The number of DMX packet buffers allocated per driver, including the
+ * buffer used to stage DMX packets for dmx_write_commit().*/
+#define DMX_BUFFER_COUNT (DMX_RX_BUFFER_COUNT + 1)
+
+/** @brief The stack size of the task which is used to allocate DMX interrupts
+ * on another CPU core.*/
+#define DMX_CORE_CALL_STACK_SIZE (4096)
+
+/** @brief Evaluates to the interrupt priority level of a set of interrupt
+ * allocation flags, or 0 if the flags do not request a level.*/
+#define dmx_intr_flags_to_level(flags)       \
+    (((flags) & ESP_INTR_FLAG_LEVEL3)   ? 3  \
+     : ((flags) & ESP_INTR_FLAG_LEVEL2) ? 2  \
+     : ((flags) & ESP_INTR_FLAG_LEVEL1) ? 1  \
+                                        : 0)
+
+/** @brief The maximum number of subscriber callbacks per DMX driver.*/
+#define DMX_SUBSCRIBER_MAX (4)
+
+/** @brief The delay in microseconds between arming the DMX timer alarm which
+ * starts a group of DMX packets and the start of their DMX breaks.*/
+#define DMX_SEND_GROUP_LEAD_US (20)
+
+/** @brief The number of sub-devices in each page of the sub-device table.*/
+#define DMX_SUB_DEVICE_PAGE_SIZE (32)
+
+/** @brief The number of pages in the sub-device table. Sub-devices are numbered
+ * from 1 to RDM_SUB_DEVICE_MAX - 1.*/
+#define DMX_SUB_DEVICE_PAGE_COUNT ((RDM_SUB_DEVICE_MAX - 1 + DMX_SUB_DEVICE_PAGE_SIZE - 1) / DMX_SUB_DEVICE_PAGE_SIZE)
+
+/** @brief The size in bytes of an encoded RDM_PID_DISC_UNIQUE_BRANCH response.*/
+#define RDM_DISC_RESPONSE_SIZE (24)
+
+/** @brief The maximum size in bytes of an encoded RDM_PID_DISC_MUTE response,
+ * including the binding UID and the checksum.*/
+#define RDM_DISC_MUTE_RESPONSE_SIZE_MAX (24 + sizeof(uint16_t) + sizeof(rdm_uid_t) + sizeof(uint16_t))
+
+/** @brief The maximum depth of the RDM discovery binary tree. This is the size
+ * of the discovery branch stack of each DMX driver.*/
+#define RDM_DISCOVERY_STACK_SIZE (49)
+
+/** @brief The stack size in bytes of the tasks which discover devices on
+ * additional ports in rdm_discover_ports_with_callback().*/
+#define RDM_DISCOVERY_TASK_STACK_SIZE (4096)
+
+/** @brief The maximum number of RDM requests which may be deferred at once.*/
+#define RDM_DEFERRED_MAX (4)
+
+/** @brief The stack size in bytes of the task which runs the deferred work
+ * functions passed to rdm_write_deferred().*/
+#define RDM_DEFERRED_TASK_STACK_SIZE (4096)
+
+/** @brief The priority of the task which runs the deferred work functions
+ * passed to rdm_write_deferred().*/
+#define RDM_DEFERRED_TASK_PRIORITY (tskIDLE_PRIORITY + 1)
+
+/** @brief The maximum number of virtual RDM responders which may be added to
+ * each DMX driver with rdm_virtual_responder_add().*/
+#define RDM_VIRTUAL_RESPONDER_MAX (16)
+
+/** @brief The stack size in bytes of the task started with
+ * rdm_responder_start(). RDM response callbacks are called from this task.*/
+#define RDM_RESPONDER_TASK_STACK_SIZE (4096)
+
+/** @brief The stack size in bytes of the bus scheduler task started with
+ * rdm_controller_start().*/
+#define RDM_CONTROLLER_TASK_STACK_SIZE (4096)
+
+/** @brief The stack size in bytes of the task started with
+ * dmx_parameter_commit_start().*/
+#define DMX_PARAMETER_COMMIT_TASK_STACK_SIZE (4096)
+
+/** @brief The stack size in bytes of the task started with
+ * dmx_player_start().*/
+#define DMX_PLAYER_TASK_STACK_SIZE (4096)
+
+/** @brief The maximum number of RDM requests which may be waiting to be sent
+ * by the bus scheduler task at once.*/
+#define RDM_CONTROLLER_QUEUE_SIZE (8)
+
+/** @brief The maximum number of times that the bus scheduler task retrieves the
+ * response of an asynchronous RDM request which was answered with an
+ * RDM_RESPONSE_TYPE_ACK_TIMER.*/
+#define RDM_CONTROLLER_ACK_TIMER_RETRIES_MAX (8)
+
+/** @brief The number of RDM responders for which the response latency is
+ * tracked by each DMX driver.*/
+#define RDM_RESPONDER_LATENCY_MAX (16)
+
+/** @brief The number of consecutive RDM requests which a responder may leave
+ * unanswered before further requests to it fail without being sent.*/
+#define RDM_RESPONDER_MISSES_MAX (3)
+
+/** @brief The time in microseconds after which a request is sent again to an
+ * RDM responder which has repeatedly not responded.*/
+#define RDM_RESPONDER_MISSED_RETRY_PERIOD (1000000)
+
+/** @brief The maximum size in bytes of the request parameter data which may be
+ * used as the key of a cached RDM response.*/
+#define RDM_RESPONSE_CACHE_KEY_SIZE_MAX (4)
+
+/** @brief The minimum size in bytes of each chunk of the parameter arena.*/
+#define DMX_PARAMETER_ARENA_CHUNK_SIZE (512)
+
+/** @brief The number of 32-bit words needed to hold one bit per DMX slot.*/
+#define DMX_SLOT_BITMAP_WORDS ((DMX_PACKET_SIZE_MAX + 31) / 32)
+
+/** @brief The maximum size in bytes of an RDM packet, including its checksum.
+ * It is used to check that each DMX packet buffer can hold an RDM packet.*/
+#define RDM_PACKET_SIZE_MAX (257)
+
+#if !defined(CONFIG_RDM_RESPONDER_DISABLE) || !defined(CONFIG_RDM_CONTROLLER_DISABLE)
+_Static_assert(DMX_PACKET_SIZE_MAX >= RDM_PACKET_SIZE_MAX,
+               "CONFIG_DMX_PACKET_SIZE_MAX must be at least 257 unless RDM is disabled");
+#endif
+
+#ifdef CONFIG_DMX_DRIVER_STATIC
+/** @brief The number of root device parameters for which each statically
+ * allocated DMX driver has room.*/
+#define DMX_DRIVER_STATIC_PARAMETER_COUNT (CONFIG_DMX_DRIVER_STATIC_PARAMETER_COUNT)
+#endif
+
 extern const char *TAG;  // The log tagline for the library.
 
 enum dmx_parameter_type_t {
@@ -78,8 +227,67 @@ enum {
     DMX_STATUS_IDLE = 0,   // The DMX driver is idle.
     DMX_STATUS_RECEIVING,  // The DMX driver is receiving data.
     DMX_STATUS_SENDING,    // The DMX driver is sending data.
+    DMX_STATUS_ARMED,      // The DMX driver is waiting for the DMX timer to start a packet from dmx_send_at().
+};
+
+/** @brief Flags which select how the DMX driver behaves.*/
+enum dmx_driver_flags_t {
+    DMX_FLAGS_TIMER_IS_CONTINUOUS = (1 << 0),  // The DMX timer alarm starts the next continuously sent packet.
 };
 
+/* The status, progress, and head of a DMX driver are packed into a single
+state word so that they are always updated together and can be read by any
+task or interrupt without a lock. The head is stored in the low 16 bits as a
+signed value, the progress in the next 4 bits, and the status in the 4 bits
+above it. */
+
+/** @brief The mask of the head in the DMX driver state word.*/
+#define DMX_STATE_HEAD_MASK (0x0000ffffu)
+
+/** @brief The mask of the progress in the DMX driver state word.*/
+#define DMX_STATE_PROGRESS_MASK (0x000f0000u)
+
+/** @brief The mask of the status in the DMX driver state word.*/
+#define DMX_STATE_STATUS_MASK (0x00f00000u)
+
+/** @brief The mask of every field in the DMX driver state word.*/
+#define DMX_STATE_MASK (DMX_STATE_STATUS_MASK | DMX_STATE_PROGRESS_MASK | DMX_STATE_HEAD_MASK)
+
+/** @brief Packs a status, progress, and head into a DMX driver state word.*/
+#define DMX_STATE(status, progress, head)                                                                              \
+    ((((uint32_t)(status) << 20) & DMX_STATE_STATUS_MASK) | (((uint32_t)(progress) << 16) & DMX_STATE_PROGRESS_MASK) | \
+     ((uint32_t)(uint16_t)(head) & DMX_STATE_HEAD_MASK))
+
+/** @brief Gets the head of a DMX driver state word.*/
+#define DMX_STATE_HEAD(state) ((int)(int16_t)((state) & DMX_STATE_HEAD_MASK))
+
+/** @brief Gets the progress of a DMX driver state word.*/
+#define DMX_STATE_PROGRESS(state) ((int)(((state) & DMX_STATE_PROGRESS_MASK) >> 16))
+
+/** @brief Gets the status of a DMX driver state word.*/
+#define DMX_STATE_STATUS(state) ((int)(((state) & DMX_STATE_STATUS_MASK) >> 20))
+
+/** @brief Reads the state word of a DMX driver without a lock.*/
+#define DMX_STATE_LOAD(driver) (__atomic_load_n(&(driver)->dmx.state, __ATOMIC_ACQUIRE))
+
+/**
+ * @brief A pre-encoded RDM GET response. The response is only valid while the
+ * parameter generation of the DMX driver is unchanged and is only used to
+ * answer requests to the same sub-device with the same request parameter data.
+ * Only the destination UID, transaction number, message count, and checksum
+ * are patched when the response is sent.
+ */
+typedef struct dmx_parameter_cache_t {
+    uint32_t generation;                           // The parameter generation of the cached response.
+    rdm_sub_device_t sub_device;                   // The sub-device of the cached response.
+    uint8_t key_size;                              // The size of the request parameter data.
+    uint8_t key[RDM_RESPONSE_CACHE_KEY_SIZE_MAX];  // The request parameter data.
+    uint16_t sum;                                  // The sum of the bytes which are not patched.
+    uint8_t message_len;                           // The message length of the cached response.
+    uint8_t capacity;                              // The size of the cached response buffer.
+    uint8_t data[];                                // The encoded response, excluding the checksum.
+} dmx_parameter_cache_t;
+
 /**
  * @brief The DMX parameter type. Contains information necessary for maintaining
  * parameter information as well as RDM response information if necessary.
@@ -90,18 +298,32 @@ typedef struct dmx_parameter_t {
     void *data;     // A pointer to the data pertaining to the parameter.
     uint8_t type;   // The storage type of the parameter data. Determines if the parameter is non-volatile or not.
     const rdm_parameter_definition_t
-        *definition;          // The RDM definition of the parameter. Is only needed for RDM responders.
-    rdm_callback_t callback;  // A user callback for the parameter. Is only needed for RDM responders.
-    void *context;            // Context for the user callback.
+        *definition;               // The RDM definition of the parameter. Is only needed for RDM responders.
+    rdm_callback_t callback;       // A user callback for the parameter. Is only needed for RDM responders.
+    void *context;                 // Context for the user callback.
+    size_t offset;                 // The offset of the parameter value within each sub-device's value block.
+    dmx_parameter_cache_t *cache;  // The cached RDM GET response, or NULL if no response has been cached.
+    bool is_staged_all;            // True if the value of every sub-device is staged. Is only used by sub-devices.
 } dmx_parameter_t;
 
+/**
+ * @brief A chunk of the parameter arena. Parameter data is carved from chunks
+ * so that parameters don't need to be allocated individually.
+ */
+typedef struct dmx_parameter_chunk_t {
+    struct dmx_parameter_chunk_t *next;  // A pointer to the previously allocated chunk.
+    size_t size;                         // The size of the chunk data in bytes.
+    size_t used;                         // The number of bytes which have been carved from the chunk.
+    uint8_t data[];                      // The chunk data.
+} dmx_parameter_chunk_t;
+
 /**
  * @brief The DMX device type. Holds an array of parameters associated with the
- * device as well as a linked-list style pointer to the next DMX device.
+ * device. The root device owns its parameters. Sub-devices share a single
+ * parameter table and each sub-device only stores its parameter values.
  */
 typedef struct dmx_device_t {
     dmx_device_num_t num;          // The device number.
-    struct dmx_device_t *next;     // A pointer to the next device.
     dmx_parameter_t parameters[];  // An array of parameters associated with this device.
 } dmx_device_t;
 
@@ -115,26 +337,67 @@ typedef struct dmx_driver_t {
     uint32_t break_len;  // Length in microseconds of the transmitted break.
     uint32_t mab_len;    // Length in microseconds of the transmitted mark-after-break.
 
+    int isr_core;        // The CPU core on which DMX interrupts are allocated, or -1 for the installing core.
+    int isr_flags;       // The interrupt allocation flags of the DMX interrupts.
+
     bool is_enabled;     // True if the DMX driver is enabled.
     bool is_controller;  // True if the DMX driver is the controller on the DMX bus.
+    uint32_t flags;      // The enum dmx_driver_flags_t flags of the DMX driver.
 
     // Synchronization state
     SemaphoreHandle_t mux;      // The handle to the driver mutex which allows multi-threaded driver function calls.
     TaskHandle_t task_waiting;  // The handle to a task that is waiting for data to be sent or received.
+    TaskHandle_t task_waiting_any;  // The handle to a task that is waiting in dmx_receive_any().
+    struct dmx_driver_subscriber_t {
+        dmx_subscriber_cb_t cb;  // The subscriber callback, or NULL if the slot is unused.
+        void *context;           // The user context of the subscriber callback.
+    } subscribers[DMX_SUBSCRIBER_MAX];  // The callbacks which are called when a packet is received.
+    struct dmx_driver_filter_t {
+        uint32_t start_codes[8];  // A bitmap of the start codes of packets which notify the waiting task.
+        bool is_rdm_filtered;     // True if RDM packets which are not addressed to this device are filtered.
+    } filter;                     // The filter of the packets which notify the waiting task.
 #ifdef DMX_USE_SPINLOCK
     dmx_spinlock_t spinlock;  // The spinlock used for critical sections.
 #endif
 
     // Data buffer
     struct dmx_driver_dmx_t {
-        int head;                           // The index of the slot being transmitted or received.
-        uint8_t data[DMX_PACKET_SIZE_MAX];  // The buffer that stores the DMX packet.
+        uint32_t state;                     // The status, progress, and head of the DMX port. See DMX_STATE().
+        uint8_t *data;                      // The buffer which is being received into or sent from.
+        uint8_t *front;                     // The buffer which holds the last complete DMX packet.
+        uint8_t *leased;                    // The buffer which is leased by the user, or NULL if none.
+        uint8_t *staged;                    // The buffer into which the user stages the next DMX packet.
+        bool is_staged;                     // True if the staged buffer should be sent with the next DMX packet.
+        bool staged_is_stale;               // True if the staged buffer must be synced with the sent DMX packet.
+        uint8_t staged_writers;             // The number of tasks which are writing into the staged buffer.
+        uint8_t (*buffer)[DMX_PACKET_SIZE_MAX];  // The buffers that store DMX packets, followed by the RDM buffer.
+        uint8_t *rdm_saved;                 // The DMX buffer which is set aside during an RDM transaction, or NULL.
+        uint8_t *rdm_buffer;                // The buffer that RDM requests are sent from and received into.
+#ifdef CONFIG_DMX_CHANGED_SLOTS
+        uint32_t changed[DMX_SLOT_BITMAP_WORDS];  // Bitmap of slots which changed in the last complete DMX packet.
+        uint32_t changed_pending[DMX_SLOT_BITMAP_WORDS];  // Bitmap of slots which changed in the current packet.
+        uint8_t changed_last[DMX_PACKET_SIZE_MAX];  // The last published DMX packet with a null start code.
+#endif
+        uint16_t checksum;                  // The running sum of the received slots of an RDM packet.
         int size;                           // The expected size of the incoming/outgoing packet.
-        int status;                         // The status of the DMX port.
-        int progress;                       // The progress of the current packet.
+        int auto_size;                      // The minimum size of automatically sized packets, or 0 if disabled.
+        int high_water;                     // The size of a packet which includes the highest written slot.
         rdm_pid_t last_controller_pid;      // The PID of the last controller-generated packet.
         int64_t controller_eop_timestamp;   // The timestamp (in microseconds since boot) of the end-of-packet of the
                                             // last controller-generated packet.
+        int64_t responder_eop_timestamp;    // The timestamp (in microseconds since boot) of the end-of-packet of the
+                                            // last responder-generated packet.
+        uint32_t rx_sequence;               // The sequence number of the last packet which was received.
+        int64_t rx_break_timestamp;         // The timestamp (in microseconds since boot) of the DMX break of the
+                                            // packet which is being received, or -1 if it did not start with a break.
+        int64_t rx_packet_break_timestamp;  // The timestamp (in microseconds since boot) of the DMX break of the last
+                                            // packet which was received, or -1 if it did not start with a break.
+        int64_t rx_packet_timestamp;        // The timestamp (in microseconds since boot) at which the last packet
+                                            // which was received was complete, or -1 if none was received.
+        uint8_t *rx_packet_data;            // The buffer which holds the last packet which was received, or NULL if
+                                            // it is being overwritten by the next packet.
+        int32_t response_timeout;           // The time in microseconds to wait for the start of an RDM response, or
+                                            // 0 to wait for the maximum time allowed by the RDM standard.
         rdm_pid_t last_responder_pid;       // The PID of the last responder-generated packet.
         bool responder_sent_last;           // True if the last packet was a responder-generated packet.
         union {
@@ -150,6 +413,18 @@ typedef struct dmx_driver_t {
         };
     } dmx;
 
+    // Continuous transmit configuration
+    struct dmx_driver_continuous_t {
+        uint32_t period;          // The period in microseconds between continuously sent packets, or 0 if disabled.
+        int size;                 // The size of the continuously sent packets.
+        bool is_paused;           // True if continuous sending is paused so that an RDM transaction may use the bus.
+        int64_t break_timestamp;  // The timestamp (in microseconds since boot) of the start of the last DMX break.
+    } continuous;
+
+    // Scheduled transmit
+    int64_t send_at;      // The timestamp (in microseconds since boot) of the DMX break scheduled by dmx_send_at(), or -1.
+    uint32_t send_group;  // A bit for each DMX port whose DMX break is started by the scheduled alarm of this port.
+
     // RDM driver information
     struct dmx_driver_rdm_t {
         union {
@@ -157,16 +432,159 @@ typedef struct dmx_driver_t {
             bool boot_loader;  // The RDM responder boot-loader flag. True when when the device is incapable of normal
                                // operation until receiving a firmware upload.
         };
+
+        // The header of the RDM packet in the DMX buffer, which is decoded once when it is received or written
+        struct dmx_driver_rdm_decoded_t {
+            const uint8_t *data;  // The DMX buffer from which the header was decoded, or NULL if none is decoded.
+            rdm_header_t header;  // The decoded header of the RDM packet.
+        } decoded;
+
+#ifndef CONFIG_RDM_RESPONDER_DISABLE
+        // RDM discovery responses which are sent from the DMX interrupt
+        struct dmx_driver_fast_discovery_t {
+            bool is_enabled;               // True if discovery requests are answered from the DMX interrupt.
+            bool responded;                // True if the DMX interrupt handled the last received discovery request.
+            bool is_sending;               // True while a discovery response is being sent by the DMX interrupt.
+            bool has_break;                // True if the pending discovery response is sent with a DMX break.
+            int progress;                  // The progress of the pending discovery response.
+            int size;                      // The size of the pending discovery response, or 0 if none is pending.
+            const uint8_t *response;       // A pointer to the pending discovery response.
+            uint8_t *is_muted;             // A pointer to the value of the RDM_PID_DISC_MUTE parameter.
+            uint16_t queue_size;           // The size of the RDM queue, which is reported in mute responses.
+            rdm_uid_t binding_uid;         // The binding UID which is reported in mute responses.
+            rdm_header_t request;          // The header of the discovery request which was handled.
+            rdm_header_t response_header;  // The header of the discovery response which was sent, or zeroed.
+            uint8_t branch[RDM_DISC_RESPONSE_SIZE];  // The pre-encoded RDM_PID_DISC_UNIQUE_BRANCH response.
+            uint8_t mute[RDM_DISC_MUTE_RESPONSE_SIZE_MAX];  // The mute response or a virtual responder's branch response.
+#ifdef CONFIG_RDM_RESPONDER_IRAM_SAFE
+            uint8_t cached[RDM_PACKET_SIZE_MAX];  // A cached GET response which is sent while the cache is disabled.
+#endif
+        } fast_discovery;
+#endif
+
+#ifndef CONFIG_RDM_CONTROLLER_DISABLE
+        // The response latency of the RDM responders to which this RDM controller sent requests
+        struct dmx_driver_latency_t {
+            rdm_uid_t uid;          // The UID of the responder, or a null UID if the entry is unused.
+            uint32_t latency;       // The moving average time in microseconds until the start of a response, or 0.
+            uint8_t misses;         // The number of consecutive requests which the responder did not answer.
+            int64_t last_request;   // The timestamp (in microseconds since boot) of the last request that was sent.
+        } latency[RDM_RESPONDER_LATENCY_MAX];
+#endif
+
+        // RDM requests which were answered with RDM_RESPONSE_TYPE_ACK_TIMER
+        struct dmx_driver_deferred_t {
+            rdm_header_t header;   // The header of the deferred request.
+            rdm_deferred_cb_t cb;  // The function which performs the deferred work, or NULL if the slot is unused.
+            void *context;         // The user context of the deferred work function.
+            bool is_done;          // True if the deferred work is done and the response may be collected.
+        } deferred[RDM_DEFERRED_MAX];
+        TaskHandle_t deferred_task;  // The task which runs the deferred work, or NULL if it is not running.
+
+#if defined(CONFIG_RDM_STATIC_DISCOVERY_INSTRUCTIONS) && !defined(CONFIG_RDM_CONTROLLER_DISABLE)
+        // The branch stack of RDM discovery. Each port has its own stack so ports may discover concurrently.
+        rdm_disc_unique_branch_t discovery_stack[RDM_DISCOVERY_STACK_SIZE];
+#endif
+
+#ifndef CONFIG_RDM_RESPONDER_DISABLE
+        // The RDM responder service task started with rdm_responder_start()
+        struct dmx_driver_responder_t {
+            TaskHandle_t task;     // The handle of the service task, or NULL if it is not running.
+            QueueHandle_t frames;  // The queue which hands received DMX packets to the user.
+            bool is_running;       // True until the service task is asked to stop.
+        } responder;
+
+        // The virtual RDM responders which were added with rdm_virtual_responder_add()
+        struct dmx_driver_virtual_t {
+            int count;                                      // The number of virtual responders which were added.
+            struct dmx_driver_virtual_responder_t *active;  // The active virtual responder, or NULL if none is.
+            TaskHandle_t task;                              // The task for which the virtual responder is active.
+            struct dmx_driver_virtual_responder_t {
+                rdm_uid_t uid;         // The UID of the virtual responder.
+                dmx_device_t *root;    // The root device parameters of the virtual responder.
+                uint8_t *is_muted;     // A pointer to the value of its RDM_PID_DISC_MUTE parameter.
+                uint8_t branch[RDM_DISC_RESPONSE_SIZE];  // The pre-encoded RDM_PID_DISC_UNIQUE_BRANCH response.
+            } responders[RDM_VIRTUAL_RESPONDER_MAX];     // The virtual responders, sorted by UID.
+            uint8_t request[RDM_PACKET_SIZE_MAX];        // A copy of the request which is being handled.
+        } *virtuals;  // The virtual responders, or NULL if none have been added.
+#endif
+
+#ifndef CONFIG_RDM_CONTROLLER_DISABLE
+        // The bus scheduler task started with rdm_controller_start()
+        struct dmx_driver_controller_t {
+            TaskHandle_t task;   // The handle of the scheduler task, or NULL if it is not running.
+            QueueHandle_t jobs;  // The queue of RDM requests which are waiting to be sent.
+            void *async_jobs;    // The storage of the requests sent with rdm_send_request_async().
+            uint32_t period;     // The period in microseconds between the starts of DMX packets.
+            int size;            // The size of the DMX packets which are sent.
+            bool is_running;     // True until the scheduler task is asked to stop.
+
+            // The GET responses cached with rdm_controller_cache_enable()
+            void *cache;                  // The cached responses, or NULL if the cache is disabled.
+            int cache_size;               // The number of responses which may be cached.
+            uint32_t cache_clock;         // Incremented whenever a cached response is used. Used to evict responses.
+            SemaphoreHandle_t cache_mux;  // The mutex which guards the cached responses.
+        } controller;
+#endif
     } rdm;
 
+    // Runtime statistics
+    struct dmx_driver_stats_t {
+        uint32_t packets_received;       // The number of packets which were received.
+        uint32_t packets_sent;           // The number of packets which were sent.
+        uint32_t uart_overflows;         // The number of DMX_ERR_UART_OVERFLOW errors.
+        uint32_t improper_slots;         // The number of DMX_ERR_IMPROPER_SLOT errors.
+        uint32_t not_enough_slots;       // The number of DMX_ERR_NOT_ENOUGH_SLOTS errors.
+        uint32_t rdm_checksum_errors;    // The number of RDM packets which failed their checksum.
+        uint32_t packets_filtered;       // The number of packets which did not pass the packet filter.
+        int64_t last_packet_timestamp;   // The timestamp of the last received DMX packet.
+        uint32_t packet_period;          // The moving average of the period between DMX packets in microseconds.
+        uint32_t isr_min;                // The shortest ISR execution time in CPU cycles.
+        uint32_t isr_max;                // The longest ISR execution time in CPU cycles.
+        uint32_t isr_count;              // The number of ISR executions which were measured.
+        uint64_t isr_total;              // The total ISR execution time in CPU cycles.
+    } stats;
+
+#ifndef CONFIG_DMX_SNIFFER_DISABLE
     // DMX sniffer configuration
     struct dmx_driver_sniffer_t {
         bool is_enabled;
         int buffer_index;
-        dmx_metadata_t metadata[2];  // The metadata received by the DMX sniffer.
-        int64_t last_pos_edge_ts;    // Timestamp of the last positive edge on the sniffer pin.
-        int64_t last_neg_edge_ts;    // Timestamp of the last negative edge on the sniffer pin.
+        dmx_metadata_t metadata[2];  // The metadata received by the DMX sniffer, in dmx_timer_get_timestamp() units.
+        int64_t last_pos_edge_ts;    // Timestamp of the last positive edge on the sniffer pin, or -1.
+        int64_t last_neg_edge_ts;    // Timestamp of the last negative edge on the sniffer pin, or -1.
+        dmx_metadata_t *history;     // Ring buffer of recently sniffed packets, or NULL if it is not allocated.
+        uint32_t history_head;       // The number of packets written to the history. Only written by the DMX ISR.
+        uint32_t history_tail;       // The number of packets read from the history. Only written by the reader.
+        bool history_overrun;        // True if a packet was not recorded because the history was full.
+        int64_t last_break_ts;       // Timestamp of the DMX break of the packet being received, or -1.
+        uint32_t flags;              // The enum dmx_sniffer_flags_t errors of the packet being received.
     } sniffer;
+#endif
+
+    struct dmx_merge_t *merge;  // The merge stage in front of the transmit buffer, or NULL if it is not enabled.
+    struct dmx_fade_t *fade;    // The fades which are interpolated before each DMX break, or NULL if not enabled.
+
+    // DMX recorder and player configuration
+    struct dmx_recorder_t *recorder;  // The recorder of received packets, or NULL if it is not recording.
+    struct dmx_driver_player_t {
+        TaskHandle_t task;  // The handle of the player task, or NULL if it is not running.
+        bool is_running;    // True if the player task should keep running.
+    } player;
+
+    // DMX repeater configuration
+    struct dmx_driver_repeater_t {
+        uint32_t outputs;    // The DMX ports which repeat the packets received on this port, as a bitmask.
+        int input;           // The DMX port which is repeated by this port, or -1 if this port is not repeating.
+        bool forward_rdm;    // True if packets with an RDM start code are repeated.
+        bool is_skipping;    // True if the packet which is being received is not repeated.
+        bool is_drained;     // True if all of the slots which were received have been sent.
+        bool break_pending;  // True if the next packet was started while the last packet was still being sent.
+        int size;            // The number of slots of the next packet which were received while break_pending.
+    } repeater;
+
+    // DMX redundant input configuration
+    struct dmx_failover_t *failover;  // The redundant input of this DMX port, or NULL if it is not in one.
 
     // DMX device information
     struct dmx_driver_device_t {
@@ -176,17 +594,50 @@ typedef struct dmx_driver_t {
             unsigned int
                 staged;     // The number of non-volatile parameters waiting to be committed to non-volatile storage.
         } parameter_count;  // Parameter counts for various purposes.
-        dmx_device_t root;  // The root device of the RDM driver.
+        struct dmx_driver_sub_devices_t {
+            dmx_device_t *table;  // The parameter table which is shared by every sub-device.
+            uint8_t **pages[DMX_SUB_DEVICE_PAGE_COUNT];  // Pages of pointers to the value block of each sub-device.
+            size_t value_size;                           // The size of each sub-device's value block in bytes.
+            int count;                                   // The number of sub-devices which have been added.
+        } sub_devices;
+        struct dmx_driver_commit_t {
+            TaskHandle_t task;    // The handle of the commit task, or NULL if it is not running.
+            bool is_running;      // True until the commit task is asked to stop.
+            TickType_t debounce;  // The time for which parameters must be unchanged before they are committed.
+        } commit;                 // The commit task started with dmx_parameter_commit_start().
+        dmx_parameter_chunk_t *arena;  // The parameter arena from which root device parameter data is allocated.
+        uint32_t generation;           // Incremented when parameter data changes. Invalidates cached RDM responses.
+        struct dmx_driver_footprint_t {
+            uint32_t version;           // Incremented when the DMX start address or the DMX personality changes.
+            uint32_t cached_version;    // The version from which the start address and size were cached.
+            uint32_t received_version;  // The version of the last footprint returned by dmx_receive_footprint().
+            uint16_t start_address;     // The cached DMX start address, or 0 if the device has no footprint.
+            uint16_t size;              // The cached footprint of the current DMX personality.
+        } footprint;        // The footprint of the root device which is cached for dmx_receive_footprint().
+        dmx_device_t root;  // The root device of the RDM driver. Its parameters follow the driver so it must be last.
     } device;
 } dmx_driver_t;
 
 extern dmx_driver_t *dmx_driver[DMX_NUM_MAX];
 
-// TODO: implement dmx_device_add()
-// dmx_device_add(dmx_num, device_num);
+/**
+ * @brief Adds a sub-device to the DMX driver. Sub-devices share the parameter
+ * table of the DMX driver so that parameters which are added to one sub-device
+ * are supported by every sub-device. Each sub-device only stores the values of
+ * its parameters.
+ *
+ * @param dmx_num The DMX port number.
+ * @param device_num The sub-device number.
+ * @return true if the sub-device exists or was added.
+ * @return false on failure.
+ */
+bool dmx_device_add(dmx_port_t dmx_num, dmx_device_num_t device_num);
 
 /**
- * @brief Gets a pointer to the desired device, if it exists.
+ * @brief Gets a pointer to the desired device, if it exists. Sub-devices share
+ * a single parameter table so the parameter table is returned for every
+ * sub-device which exists. Use dmx_parameter_get_value() to get the value of a
+ * parameter on a specific device.
  *
  * @param dmx_num The DMX port number.
  * @param device_num The sub-device number.
@@ -194,6 +645,51 @@ extern dmx_driver_t *dmx_driver[DMX_NUM_MAX];
  */
 dmx_device_t *dmx_device_get(dmx_port_t dmx_num, dmx_device_num_t device_num);
 
+/**
+ * @brief Gets a pointer to the value block of a sub-device.
+ *
+ * @param dmx_num The DMX port number.
+ * @param device_num The sub-device number. Must not be the root device.
+ * @return A pointer to the value block, or NULL if the sub-device does not
+ * exist.
+ */
+uint8_t *dmx_sub_device_get_values(dmx_port_t dmx_num, dmx_device_num_t device_num);
+
+/**
+ * @brief Gets a pointer to the value of a parameter on a device.
+ *
+ * @param dmx_num The DMX port number.
+ * @param device_num The sub-device number.
+ * @param[in] entry A pointer to the parameter, as returned by
+ * dmx_parameter_get_entry() for the same device.
+ * @return A pointer to the parameter value, or NULL if it has no value.
+ */
+void *dmx_parameter_get_value(dmx_port_t dmx_num, dmx_device_num_t device_num, const dmx_parameter_t *entry);
+
+/**
+ * @brief Marks a non-volatile parameter as staged so that it is committed to
+ * non-volatile storage by dmx_parameter_commit(). It must be called within a
+ * critical section.
+ *
+ * @param dmx_num The DMX port number.
+ * @param device_num The sub-device number.
+ * @param[in] entry A pointer to the parameter, as returned by
+ * dmx_parameter_get_entry() for the same device.
+ */
+void dmx_parameter_stage(dmx_port_t dmx_num, dmx_device_num_t device_num, dmx_parameter_t *entry);
+
+/**
+ * @brief Allocates parameter data from the parameter arena of the DMX driver.
+ * The arena grows in chunks of at least DMX_PARAMETER_ARENA_CHUNK_SIZE bytes.
+ * Parameter data cannot be freed individually; the whole arena is freed when
+ * the DMX driver is deleted.
+ *
+ * @param dmx_num The DMX port number.
+ * @param size The size of the parameter data in bytes.
+ * @return A pointer to the parameter data, or NULL on failure.
+ */
+void *dmx_parameter_alloc(dmx_port_t dmx_num, size_t size);
+
 /**
  * @brief Adds a parameter to the DMX driver, if there is space available.
  *
@@ -220,6 +716,415 @@ bool dmx_parameter_add(dmx_port_t dmx_num, dmx_device_num_t device_num, rdm_pid_
  */
 dmx_parameter_t *dmx_parameter_get_entry(dmx_port_t dmx_num, dmx_device_num_t device_num, rdm_pid_t pid);
 
+/**
+ * @brief Gets a pointer to the desired parameter in the parameter table which
+ * is shared by every sub-device, if it exists. Every sub-device which has been
+ * added supports the parameters in this table.
+ *
+ * @param dmx_num The DMX port number.
+ * @param pid The parameter ID.
+ * @return A pointer to the parameter, or NULL on failure.
+ */
+dmx_parameter_t *dmx_parameter_get_shared_entry(dmx_port_t dmx_num, rdm_pid_t pid);
+
+/**
+ * @brief Moves the DMX driver receive buffer to a buffer which is neither
+ * holding the last complete DMX packet nor leased by the user. This function is
+ * called when a new packet begins. If the only available buffer is leased, the
+ * new packet is dropped. The RDM buffer is never rotated. It must be called
+ * within a critical section.
+ *
+ * @param dmx_num The DMX port number.
+ */
+void dmx_buffer_rotate(dmx_port_t dmx_num);
+
+/**
+ * @brief Publishes the DMX packet in the receive buffer as the last complete
+ * DMX packet. If CONFIG_DMX_CHANGED_SLOTS is enabled and the packet has a null
+ * start code, the bitmap of slots which changed while it was being received is
+ * published and the packet is kept to compare the next packet against. It must be called within a critical section.
+ *
+ * @param dmx_num The DMX port number.
+ */
+void dmx_buffer_publish(dmx_port_t dmx_num);
+
+/**
+ * @brief Points the DMX driver at its dedicated RDM buffer so that an RDM
+ * request can be written, sent, and its response received without touching
+ * the DMX packet. The DMX buffer is set aside until dmx_buffer_end_rdm() is
+ * called. It must be called within a critical section.
+ *
+ * @param dmx_num The DMX port number.
+ */
+void dmx_buffer_begin_rdm(dmx_port_t dmx_num);
+
+/**
+ * @brief Points the DMX driver back at the DMX buffer which was set aside by
+ * dmx_buffer_begin_rdm(). It must be called within a critical section.
+ *
+ * @param dmx_num The DMX port number.
+ */
+void dmx_buffer_end_rdm(dmx_port_t dmx_num);
+
+/**
+ * @brief Atomically updates the fields of the state word of a DMX driver which
+ * are selected by a mask, leaving the other fields unchanged. The state word
+ * may be updated from any task or interrupt without a lock.
+ *
+ * @param dmx_num The DMX port number.
+ * @param mask The mask of the fields which are updated.
+ * @param state A state word made with DMX_STATE() which holds the new values of
+ * the fields.
+ * @return The new state word.
+ */
+uint32_t dmx_state_update(dmx_port_t dmx_num, uint32_t mask, uint32_t state);
+
+/**
+ * @brief Atomically sets the head of a DMX driver. Heads greater than the
+ * largest value which fits in the state word are saturated.
+ *
+ * @param dmx_num The DMX port number.
+ * @param head The new head.
+ */
+void dmx_state_set_head(dmx_port_t dmx_num, int head);
+
+/**
+ * @brief Atomically sets the progress of a DMX driver.
+ *
+ * @param dmx_num The DMX port number.
+ * @param progress The new progress.
+ */
+void dmx_state_set_progress(dmx_port_t dmx_num, int progress);
+
+/**
+ * @brief Atomically sets the status of a DMX driver.
+ *
+ * @param dmx_num The DMX port number.
+ * @param status The new status.
+ */
+void dmx_state_set_status(dmx_port_t dmx_num, int status);
+
+/**
+ * @brief Sets every field of a packet to the value which is reported when no
+ * packet was received. Every receive path reports a timeout through this
+ * function so that new fields of dmx_packet_t are always initialized.
+ *
+ * @param[out] packet A pointer to the packet, or NULL.
+ */
+void dmx_packet_set_timeout(dmx_packet_t *packet);
+
+/**
+ * @brief Discards the RDM header which was decoded from the DMX driver buffer
+ * so that it is decoded again when it is next read. It must be called whenever
+ * the DMX driver buffer is written or moved. It must be called within a
+ * critical section.
+ *
+ * @param dmx_num The DMX port number.
+ */
+void dmx_buffer_invalidate_rdm(dmx_port_t dmx_num);
+
+/**
+ * @brief Verifies and decodes the header of the RDM packet which was received
+ * into the DMX driver buffer so that it may be read with rdm_read_header()
+ * without being decoded again. It is called from the DMX interrupt when an RDM
+ * packet is complete.
+ *
+ * @param dmx_num The DMX port number.
+ * @param checksum The sum of the slots of a standard RDM packet which was
+ * calculated while it was received, or -1 if it must be calculated.
+ * @return true if the packet is a valid RDM packet.
+ * @return false if the packet is not a valid RDM packet.
+ */
+bool rdm_read_header_isr(dmx_port_t dmx_num, int checksum);
+
+/**
+ * @brief Checks if an RDM destination UID targets the DMX port's own RDM
+ * responder or any of its virtual RDM responders. It may be called from the
+ * DMX interrupt. It must be called within a critical section or while the DMX
+ * driver mutex is held.
+ *
+ * @param dmx_num The DMX port number.
+ * @param[in] uid The destination UID of the RDM packet.
+ * @return true if the UID targets a responder of the DMX port.
+ * @return false if it does not.
+ */
+bool rdm_port_is_target(dmx_port_t dmx_num, const rdm_uid_t *uid);
+
+#ifndef CONFIG_RDM_RESPONDER_DISABLE
+/**
+ * @brief Gets the virtual RDM responder which is active for the calling task.
+ * While a virtual responder is active, the root device parameters and the UID
+ * of the DMX port are those of the virtual responder.
+ *
+ * @param dmx_num The DMX port number.
+ * @return A pointer to the active virtual responder, or NULL if the DMX port's
+ * own responder is active.
+ */
+struct dmx_driver_virtual_responder_t *rdm_virtual_get_active(dmx_port_t dmx_num);
+
+/**
+ * @brief Makes a virtual RDM responder active for the calling task. It must be
+ * called while the DMX driver mutex is held.
+ *
+ * @param dmx_num The DMX port number.
+ * @param[in] responder A pointer to the virtual responder, or NULL to make the
+ * DMX port's own responder active.
+ */
+void rdm_virtual_set_active(dmx_port_t dmx_num, struct dmx_driver_virtual_responder_t *responder);
+
+/**
+ * @brief Finds the next virtual RDM responder which is targeted by an RDM
+ * destination UID. Unicast UIDs are found with a binary search. It may be
+ * called from the DMX interrupt. Virtual responders are only added while both
+ * the DMX driver mutex and the DMX spinlock are held, so it must be called
+ * within a critical section or while the DMX driver mutex is held.
+ *
+ * @param dmx_num The DMX port number.
+ * @param[in] uid The destination UID of the RDM packet.
+ * @param start The index of the first virtual responder to check.
+ * @return The index of the virtual responder, or -1 if no more virtual
+ * responders are targeted.
+ */
+int rdm_virtual_find(dmx_port_t dmx_num, const rdm_uid_t *uid, int start);
+#endif
+
+/**
+ * @brief Swaps the staged buffer with the DMX driver buffer if the user has
+ * committed a staged DMX packet. The staged packet is not swapped while an RDM
+ * packet or a leased buffer is in the DMX driver buffer. It must be called
+ * within a critical section.
+ *
+ * @param dmx_num The DMX port number.
+ */
+void dmx_buffer_swap_staged(dmx_port_t dmx_num);
+
+/**
+ * @brief Interpolates the slots of the DMX driver buffer which are fading. It
+ * is called before the DMX break of each packet which is sent. It must be
+ * called within a critical section.
+ *
+ * @param dmx_num The DMX port number.
+ * @param now The timestamp in microseconds of the DMX break.
+ */
+void dmx_fade_apply(dmx_port_t dmx_num, int64_t now);
+
+/**
+ * @brief Records the DMX packet which was just received to the recorder of the
+ * DMX port. It is called by dmx_receive() while it holds the DMX driver mutex.
+ * The recording is stopped if the packet cannot be written.
+ *
+ * @param dmx_num The DMX port number.
+ * @param size The size of the received DMX packet.
+ */
+void dmx_recorder_record(dmx_port_t dmx_num, size_t size);
+
+/**
+ * @brief Forwards the slots which were just received on a DMX port to each DMX
+ * port which is repeating it. The DMX break of a repeated packet is started
+ * when its start code is forwarded. It is called by the DMX interrupt.
+ *
+ * @param dmx_num The DMX port number of the port which received the slots.
+ * @param offset The offset of the first received slot in the DMX packet.
+ * @param[in] slots The received slots.
+ * @param size The number of received slots.
+ */
+void dmx_repeater_forward(dmx_port_t dmx_num, int offset, const uint8_t *slots, int size);
+
+/**
+ * @brief Writes the slots of a repeated packet which were received during its
+ * DMX break and mark-after-break. It is called by the DMX timer at the end of
+ * the mark-after-break. It must be called within a critical section.
+ *
+ * @param dmx_num The DMX port number of the repeating port.
+ */
+void dmx_repeater_start_data(dmx_port_t dmx_num);
+
+/**
+ * @brief Handles the end of transmission of a repeating DMX port. The packet is
+ * not finished until the start code of the next packet is received. It must be
+ * called within a critical section.
+ *
+ * @param dmx_num The DMX port number of the repeating port.
+ */
+void dmx_repeater_tx_done(dmx_port_t dmx_num);
+
+/**
+ * @brief Gets the redundant input of the DMX port and marks it as in use so
+ * that it is not freed by dmx_failover_stop(). The redundant input must be
+ * released by dmx_failover_receive_isr(). It must be called within a critical
+ * section.
+ *
+ * @param dmx_num The DMX port number.
+ * @return A pointer to the redundant input, or NULL if the DMX port is not in
+ * one.
+ */
+struct dmx_failover_t *dmx_failover_get_isr(dmx_port_t dmx_num);
+
+/**
+ * @brief Copies the DMX packet which was just published into the redundant
+ * input and fails over to the DMX port if the active source of the redundant
+ * input was lost, then releases the redundant input. It is called by the DMX
+ * interrupt outside of the DMX driver critical section.
+ *
+ * @param failover The redundant input from dmx_failover_get_isr().
+ * @param dmx_num The DMX port number of the port which received the packet.
+ * @param now The timestamp of the end of the packet in microseconds.
+ * @param break_timestamp The timestamp of the DMX break of the packet in
+ * microseconds, or -1.
+ * @param[in] data The published packet, including its start code.
+ * @param size The size of the published packet.
+ * @return true if a higher priority task was woken.
+ */
+bool dmx_failover_receive_isr(struct dmx_failover_t *failover, dmx_port_t dmx_num, int64_t now,
+                              int64_t break_timestamp, const uint8_t *data, size_t size);
+
+/** @brief Evaluates to true if the DMX port number is that of a parallel DMX
+ * port.*/
+#define DMX_IS_PARALLEL_PORT(dmx_num) ((dmx_num) >= DMX_NUM_MAX && (dmx_num) < DMX_NUM_MAX + DMX_PARALLEL_NUM_MAX)
+
+/**
+ * @brief Copies slots into the buffer of a parallel DMX port. It is called by
+ * dmx_write() and the other functions which write DMX.
+ *
+ * @param dmx_num The DMX port number of the parallel DMX port.
+ * @param offset The number of slots with which to offset the write.
+ * @param[in] source The slots to copy.
+ * @param size The number of slots to copy.
+ * @return The number of slots which were copied.
+ */
+size_t dmx_parallel_write(dmx_port_t dmx_num, size_t offset, const void *source, size_t size);
+
+/**
+ * @brief Copies slots from the buffer of a parallel DMX port. It is called by
+ * dmx_read() and the other functions which read DMX.
+ *
+ * @param dmx_num The DMX port number of the parallel DMX port.
+ * @param offset The number of slots with which to offset the read.
+ * @param[out] destination The buffer into which to copy the slots.
+ * @param size The number of slots to copy.
+ * @return The number of slots which were copied.
+ */
+size_t dmx_parallel_read(dmx_port_t dmx_num, size_t offset, void *destination, size_t size);
+
+/**
+ * @brief Encodes the packets of several parallel DMX ports into one frame and
+ * queues it to be sent. It is called by dmx_send() and dmx_send_group().
+ *
+ * @param[in] ports The DMX port numbers of the parallel DMX ports to send.
+ * @param n The number of DMX ports to send.
+ * @param size The size of the packets to send.
+ * @return The size of the packets which were queued or 0 on failure.
+ */
+size_t dmx_parallel_send(const dmx_port_t *ports, size_t n, size_t size);
+
+/**
+ * @brief Waits until no frame which is sending a parallel DMX port is being
+ * sent. It is called by dmx_wait_sent().
+ *
+ * @param dmx_num The DMX port number of the parallel DMX port.
+ * @param wait_ticks The number of ticks to wait before this function times out.
+ * @return true if the parallel DMX port is done sending.
+ * @return false if the function timed out.
+ */
+bool dmx_parallel_wait_sent(dmx_port_t dmx_num, TickType_t wait_ticks);
+
+/**
+ * @brief Records the execution time of a DMX interrupt in the DMX driver
+ * statistics. It must be called at the end of the interrupt and must not be
+ * called within a critical section.
+ *
+ * @param dmx_num The DMX port number.
+ * @param start The CPU cycle count at which the interrupt began.
+ */
+void dmx_stats_record_isr(dmx_port_t dmx_num, uint32_t start);
+
+/**
+ * @brief Records an event in the trace of a DMX port. It is lock-free and may
+ * be called from the DMX interrupts and from tasks. It should be called with
+ * the DMX_TRACE() macro so that it is compiled out when CONFIG_DMX_TRACE is
+ * disabled.
+ *
+ * @param dmx_num The DMX port number.
+ * @param event The dmx_trace_event_t to record.
+ * @param err The error of the event, or DMX_OK.
+ * @param value The value of the event. It is saturated to the range of a
+ * uint16_t.
+ */
+void dmx_trace_record(dmx_port_t dmx_num, int event, int err, int32_t value);
+
+#ifdef CONFIG_DMX_TRACE
+/** @brief Records an event in the trace of a DMX port.*/
+#define DMX_TRACE(dmx_num, event, err, value) dmx_trace_record(dmx_num, event, err, value)
+#else
+/** @brief Records an event in the trace of a DMX port. The arguments are not
+ * evaluated because CONFIG_DMX_TRACE is disabled.*/
+#define DMX_TRACE(dmx_num, event, err, value) \
+    do {                                      \
+    } while (0)
+#endif
+
+/**
+ * @brief Records the arrival of a DMX packet so that the refresh rate may be
+ * measured.
+ *
+ * @param dmx_num The DMX port number.
+ * @param now The timestamp in microseconds at which the packet was received.
+ */
+void dmx_stats_record_packet(dmx_port_t dmx_num, int64_t now);
+
+/**
+ * @brief Gets the size of the next DMX packet which is sent, including the
+ * automatic size of the packet if automatic sizing is enabled. It must be
+ * called within a critical section.
+ *
+ * @param dmx_num The DMX port number.
+ * @return The size of the next DMX packet in bytes.
+ */
+int dmx_packet_get_size(dmx_port_t dmx_num);
+
+/**
+ * @brief Starts sending the packet in the DMX driver buffer by beginning the
+ * DMX break. The DMX timer generates the DMX break and mark-after-break before
+ * the packet data is written to the UART. It must be called within a critical
+ * section.
+ *
+ * @param dmx_num The DMX port number.
+ */
+void dmx_packet_start_break(dmx_port_t dmx_num);
+
+/**
+ * @brief Starts sending the packet in the DMX driver buffer of each DMX port in
+ * a group. Every packet is prepared before any DMX break is started, and the
+ * DMX breaks are then started together while the spinlock of every DMX port
+ * is held. It is called by the DMX timer alarm which was set by dmx_send_at()
+ * or dmx_send_group(). It must not be called within a critical section.
+ *
+ * @param group A bit for each DMX port number in the group.
+ */
+void dmx_packet_start_group_isr(uint32_t group);
+
+/**
+ * @brief Resumes sending continuously if it was paused for an RDM transaction.
+ * This function does nothing if continuous sending is not paused.
+ *
+ * @param dmx_num The DMX port number.
+ */
+void dmx_continuous_resume(dmx_port_t dmx_num);
+
+/**
+ * @brief Calls a function on the specified CPU core and waits for it to return.
+ * Interrupts which are allocated by the function are handled on that core. The
+ * function is called from a temporary task which is pinned to the core.
+ *
+ * @param core The CPU core on which to call the function, or -1 to call it
+ * from the calling task.
+ * @param func The function to call.
+ * @param[in] arg The argument of the function.
+ * @return The return value of the function, or false if the task could not be
+ * created.
+ */
+bool dmx_call_on_core(int core, bool (*func)(void *), void *arg);
+
 #ifdef __cplusplus
 }
 #endif
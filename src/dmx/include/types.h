@@ -7,6 +7,9 @@
 #pragma once
 
 #include "freertos/FreeRTOS.h"
+#ifdef CONFIG_IDF_TARGET_LINUX
+#include "../hal/host/include/port.h"
+#endif
 
 #ifdef __cplusplus
 extern "C" {
@@ -73,7 +76,13 @@ enum {
 #if SOC_UART_NUM > 2
   DMX_NUM_2, /** @brief DMX port 2.*/
 #endif
+#ifdef CONFIG_IDF_TARGET_LINUX
+  /** @brief DMX port max. Used for error checking. The host HAL may simulate
+     more DMX ports than are named.*/
+  DMX_NUM_MAX = SOC_UART_NUM
+#else
   DMX_NUM_MAX /** @brief DMX port max. Used for error checking.*/
+#endif
 };
 
 /** @brief DMX pin constants.*/
@@ -91,8 +100,15 @@ enum {
 enum {
   /** @brief The typical packet size of DMX.*/
   DMX_PACKET_SIZE = 513,
+#ifdef CONFIG_DMX_PACKET_SIZE_MAX
+  /** @brief The maximum packet size of DMX. It is set with
+     CONFIG_DMX_PACKET_SIZE_MAX so that the DMX packet buffers of each DMX
+     driver may be smaller than a full DMX packet.*/
+  DMX_PACKET_SIZE_MAX = CONFIG_DMX_PACKET_SIZE_MAX,
+#else
   /** @brief The maximum packet size of DMX.*/
   DMX_PACKET_SIZE_MAX = 513,
+#endif
 
   /** @brief The typical baud rate of DMX.*/
   DMX_BAUD_RATE = 250000,
@@ -115,6 +131,14 @@ enum {
   /** @brief The maximum DMX mark-after-break length in microseconds.*/
   DMX_MAB_LEN_MAX_US = 999999,
 
+  /** @brief The maximum refresh rate of DMX in packets per second. This is
+     the refresh rate of the shortest DMX packet allowed by the DMX standard.*/
+  DMX_REFRESH_HZ_MAX = 830,
+
+  /** @brief The maximum time in microseconds into the future at which a DMX
+     packet may be scheduled with dmx_send_at().*/
+  DMX_SEND_AT_MAX_US = 1000000,
+
   /** @brief The DMX receive timeout length in FreeRTOS ticks. If it takes
      longer than this amount of time to receive the next DMX packet the signal
      is considered lost.*/
@@ -263,11 +287,25 @@ typedef enum dmx_err_t {
   DMX_FAIL = -1
 } dmx_err_t;
 
+/** @brief The CPU cores on which the DMX interrupts may be handled.*/
+typedef enum dmx_intr_core_t {
+  /** @brief Handle the DMX interrupts on the core which installs the DMX
+   * driver.*/
+  DMX_INTR_CORE_DEFAULT = 0,
+  /** @brief Handle the DMX interrupts on core 0.*/
+  DMX_INTR_CORE_0,
+  /** @brief Handle the DMX interrupts on core 1. Only available on chips with
+   * two cores.*/
+  DMX_INTR_CORE_1,
+} dmx_intr_core_t;
+
 /** @brief Configuration settings for the DMX driver.*/
 typedef struct dmx_config_t {
   /** @brief The interrupt allocation flags to use.*/
   int interrupt_flags;
-  /** @brief The number of parameters that the root device supports.*/
+  /** @brief The number of parameters that the root device supports. Setting
+   * this value to 0 installs a controller-only driver which registers no RDM
+   * responder parameters and never responds to RDM requests.*/
   uint32_t root_device_parameter_count;
   /** @brief The number of parameters that the sub-devices support.*/
   uint32_t sub_device_parameter_count;
@@ -288,6 +326,13 @@ typedef struct dmx_config_t {
   /** @brief The maximum size of the RDM queue. Setting this value to 0 disables
    * the RDM queue.*/
   uint32_t queue_size_max;
+  /** @brief The CPU core on which to handle the DMX interrupts, including the
+   * DMX sniffer interrupt. Setting this value to DMX_INTR_CORE_DEFAULT handles
+   * the interrupts on the core which calls dmx_driver_install().*/
+  dmx_intr_core_t interrupt_core;
+  /** @brief The priority level of the DMX interrupts, from 1 to 3. Setting
+   * this value to 0 uses the level in interrupt_flags, if any.*/
+  int interrupt_level;
 } dmx_config_t;
 
 /** @brief A struct which defines DMX personalities. Used to declare the
@@ -311,16 +356,109 @@ typedef struct dmx_packet_t {
   size_t size;
   /** @brief True if the received packet is RDM.*/
   bool is_rdm;
+  /** @brief The sequence number of the packet. It is incremented for every
+   * packet which is received on the DMX port, including packets which were
+   * filtered or which had errors, so a gap in the sequence numbers of
+   * consecutive packets shows how many packets were missed. It is 0 if no
+   * packet was received.*/
+  uint32_t sequence;
+  /** @brief The time in microseconds since boot at which the DMX break that
+   * started the packet was received, or -1 if the packet did not start with a
+   * DMX break, such as an RDM discovery response, or if no packet was
+   * received.*/
+  int64_t break_timestamp;
+  /** @brief The time in microseconds since boot at which the packet was
+   * complete, or -1 if no packet was received.*/
+  int64_t timestamp;
 } dmx_packet_t;
 
+/** @brief Error flags of a packet which was recorded in the DMX sniffer
+ * history.*/
+enum dmx_sniffer_flags_t {
+  /** @brief A slot in the packet was missing its stop bits.*/
+  DMX_SNIFFER_FLAG_IMPROPER_SLOT = (1 << 0),
+  /** @brief The UART overflowed while the packet was received.*/
+  DMX_SNIFFER_FLAG_UART_OVERFLOW = (1 << 1),
+  /** @brief The sniffer history was full so one or more packets before this
+   * packet were not recorded.*/
+  DMX_SNIFFER_FLAG_HISTORY_OVERRUN = (1 << 2),
+};
+
 /** @brief Metadata for received DMX packets. For use in the DMX sniffer.*/
 typedef struct dmx_metadata_t {
   /** @brief Length in microseconds of the last received DMX break.*/
   uint32_t break_len;
   /** @brief Length in microseconds of the last received DMX mark-after-break.*/
   uint32_t mab_len;
+  /** @brief The time in microseconds since boot at which the DMX break of the
+   * packet was detected. Only set by dmx_sniffer_read_history().*/
+  int64_t timestamp;
+  /** @brief The time in microseconds from the DMX break of the packet to the
+   * DMX break of the following packet. Only set by
+   * dmx_sniffer_read_history().*/
+  uint32_t period;
+  /** @brief The number of slots in the packet, including the start code. Only
+   * set by dmx_sniffer_read_history().*/
+  int size;
+  /** @brief The start code of the packet. Only set by
+   * dmx_sniffer_read_history().*/
+  int sc;
+  /** @brief A bitmask of enum dmx_sniffer_flags_t errors which occurred while
+   * the packet was received. Only set by dmx_sniffer_read_history().*/
+  uint32_t flags;
 } dmx_metadata_t;
 
+/** @brief Runtime statistics of a DMX port. Counters accumulate from the time
+ * that the DMX driver is installed or from the last call to dmx_reset_stats().*/
+typedef struct dmx_stats_t {
+  /** @brief The number of packets which were received.*/
+  uint32_t packets_received;
+  /** @brief The number of packets which were sent.*/
+  uint32_t packets_sent;
+  /** @brief The number of DMX_ERR_UART_OVERFLOW errors.*/
+  uint32_t uart_overflows;
+  /** @brief The number of DMX_ERR_IMPROPER_SLOT errors.*/
+  uint32_t improper_slots;
+  /** @brief The number of DMX_ERR_NOT_ENOUGH_SLOTS errors.*/
+  uint32_t not_enough_slots;
+  /** @brief The number of RDM packets which failed their checksum.*/
+  uint32_t rdm_checksum_errors;
+  /** @brief The number of packets which were received but did not pass the
+     packet filter of the DMX port.*/
+  uint32_t packets_filtered;
+  /** @brief The measured refresh rate of received DMX packets in packets per
+     second, or 0 if no DMX packets have been received.*/
+  uint32_t refresh_hz;
+  /** @brief The shortest execution time of a DMX interrupt in microseconds.
+     Interrupts are timed with the CPU cycle counter, which is converted to
+     microseconds at the CPU frequency when the statistics are read.*/
+  uint32_t isr_min_us;
+  /** @brief The average execution time of a DMX interrupt in microseconds.*/
+  uint32_t isr_avg_us;
+  /** @brief The longest execution time of a DMX interrupt in microseconds.*/
+  uint32_t isr_max_us;
+  /** @brief The number of DMX interrupts which were measured.*/
+  uint32_t isr_count;
+  /** @brief The total execution time of the measured DMX interrupts in
+     microseconds.*/
+  uint64_t isr_total_us;
+} dmx_stats_t;
+
+/**
+ * @brief A function type for DMX subscriber callbacks. Subscriber callbacks are
+ * called from the DMX interrupt each time a packet is received. They must be
+ * short, must not block, and must be placed in IRAM if the DMX driver is placed
+ * in IRAM. FreeRTOS functions called from the callback must be those ending in
+ * FromISR().
+ *
+ * @param dmx_num The DMX port number which received the packet.
+ * @param[in] packet Information about the received packet.
+ * @param[inout] context The user context provided to dmx_subscribe().
+ * @return true if a higher priority task was woken by the callback.
+ */
+typedef bool (*dmx_subscriber_cb_t)(dmx_port_t dmx_num,
+                                    const dmx_packet_t *packet, void *context);
+
 /** @brief DMX start address which indicates the device does not have a DMX
  * start address.*/
 static const uint16_t DMX_START_ADDRESS_NONE = 0xffff;
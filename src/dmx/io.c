@@ -1,9 +1,11 @@
 #include <string.h>
 
+#include "./hal/include/dma.h"
 #include "./hal/include/gpio.h"
 #include "./hal/include/nvs.h"
 #include "./hal/include/timer.h"
 #include "./hal/include/uart.h"
+#include "./include/device.h"
 #include "./include/driver.h"
 #include "./include/parameter.h"
 #include "./include/service.h"
@@ -12,6 +14,9 @@
 #include "../rdm/responder/include/utils.h"
 
 size_t dmx_read_offset(dmx_port_t dmx_num, size_t offset, void *destination, size_t size) {
+    if (DMX_IS_PARALLEL_PORT(dmx_num)) {
+        return dmx_parallel_read(dmx_num, offset, destination, size);
+    }
     DMX_CHECK(dmx_num < DMX_NUM_MAX, 0, "dmx_num error");
     DMX_CHECK(offset < DMX_PACKET_SIZE_MAX, 0, "offset error");
     DMX_CHECK(destination, 0, "destination is null");
@@ -26,13 +31,22 @@ size_t dmx_read_offset(dmx_port_t dmx_num, size_t offset, void *destination, siz
 
     dmx_driver_t *const driver = dmx_driver[dmx_num];
 
+    // Get the buffer which holds the last complete packet
+    const uint8_t *front;
+    taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+    front = driver->dmx.front;
+    taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+
     // Copy data from the driver buffer to the destination asynchronously
-    memcpy(destination, driver->dmx.data + offset, size);
+    memcpy(destination, front + offset, size);
 
     return size;
 }
 
 size_t dmx_read(dmx_port_t dmx_num, void *destination, size_t size) {
+    if (DMX_IS_PARALLEL_PORT(dmx_num)) {
+        return dmx_parallel_read(dmx_num, 0, destination, size);
+    }
     DMX_CHECK(dmx_num < DMX_NUM_MAX, 0, "dmx_num error");
     DMX_CHECK(destination, 0, "destination is null");
     DMX_CHECK(dmx_driver_is_installed(dmx_num), 0, "driver is not installed");
@@ -41,6 +55,10 @@ size_t dmx_read(dmx_port_t dmx_num, void *destination, size_t size) {
 }
 
 int dmx_read_slot(dmx_port_t dmx_num, size_t slot_num) {
+    if (DMX_IS_PARALLEL_PORT(dmx_num)) {
+        uint8_t slot;
+        return dmx_parallel_read(dmx_num, slot_num, &slot, 1) == 1 ? slot : -1;
+    }
     DMX_CHECK(dmx_num < DMX_NUM_MAX, -1, "dmx_num error");
     DMX_CHECK(slot_num < DMX_PACKET_SIZE_MAX, -1, "slot_num error");
     DMX_CHECK(dmx_driver_is_installed(dmx_num), -1, "driver is not installed");
@@ -52,6 +70,9 @@ int dmx_read_slot(dmx_port_t dmx_num, size_t slot_num) {
 }
 
 size_t dmx_write_offset(dmx_port_t dmx_num, size_t offset, const void *source, size_t size) {
+    if (DMX_IS_PARALLEL_PORT(dmx_num)) {
+        return dmx_parallel_write(dmx_num, offset, source, size);
+    }
     DMX_CHECK(dmx_num < DMX_NUM_MAX, 0, "dmx_num error");
     DMX_CHECK(offset < DMX_PACKET_SIZE_MAX, 0, "offset error");
     DMX_CHECK(source, 0, "source is null");
@@ -66,12 +87,13 @@ size_t dmx_write_offset(dmx_port_t dmx_num, size_t offset, const void *source, s
 
     dmx_driver_t *const driver = dmx_driver[dmx_num];
 
-    // Check if the driver is currently sending an RDM packet
-    int dmx_status;
+    // Check if the driver is currently sending an RDM packet from the DMX buffer
+    const int dmx_status = DMX_STATE_STATUS(DMX_STATE_LOAD(driver));
+    bool is_rdm_buffered;
     taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
-    dmx_status = driver->dmx.status;
+    is_rdm_buffered = (driver->dmx.rdm_saved != NULL);
     taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
-    if (dmx_status == DMX_STATUS_SENDING) {
+    if (dmx_status == DMX_STATUS_SENDING && !is_rdm_buffered) {
         rdm_header_t header;
         taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
         const bool is_rdm = rdm_read_header(dmx_num, &header);
@@ -86,15 +108,25 @@ size_t dmx_write_offset(dmx_port_t dmx_num, size_t offset, const void *source, s
         dmx_uart_set_rts(dmx_num, 0);
     }
 
-    // Copy data from the source to the driver buffer asynchronously
+    // Copy data into the staged buffer outside of the critical section
+    size = dmx_write_staged(dmx_num, offset, source, size);
+
+    // Swap the staged buffer in by pointer now, or at the next DMX break if a packet is on the DMX bus
     taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
-    memcpy(driver->dmx.data + offset, source, size);
+    driver->dmx.is_staged = true;
+    const int status      = DMX_STATE_STATUS(DMX_STATE_LOAD(driver));
+    if (status == DMX_STATUS_IDLE || status == DMX_STATUS_ARMED) {
+        dmx_buffer_swap_staged(dmx_num);
+    }
     taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
 
     return size;
 }
 
 size_t dmx_write(dmx_port_t dmx_num, const void *source, size_t size) {
+    if (DMX_IS_PARALLEL_PORT(dmx_num)) {
+        return dmx_parallel_write(dmx_num, 0, source, size);
+    }
     DMX_CHECK(dmx_num < DMX_NUM_MAX, 0, "dmx_num error");
     DMX_CHECK(source, 0, "source is null");
     DMX_CHECK(dmx_driver_is_installed(dmx_num), 0, "driver is not installed");
@@ -103,6 +135,9 @@ size_t dmx_write(dmx_port_t dmx_num, const void *source, size_t size) {
 }
 
 int dmx_write_slot(dmx_port_t dmx_num, size_t slot_num, uint8_t value) {
+    if (DMX_IS_PARALLEL_PORT(dmx_num)) {
+        return dmx_parallel_write(dmx_num, slot_num, &value, 1) == 1 ? value : -1;
+    }
     DMX_CHECK(dmx_num < DMX_NUM_MAX, -1, "dmx_num error");
     DMX_CHECK(slot_num < DMX_PACKET_SIZE_MAX, -1, "slot_num error");
     DMX_CHECK(dmx_driver_is_installed(dmx_num), -1, "driver is not installed");
@@ -112,33 +147,105 @@ int dmx_write_slot(dmx_port_t dmx_num, size_t slot_num, uint8_t value) {
     return value;
 }
 
-size_t dmx_receive_num(dmx_port_t dmx_num, dmx_packet_t *packet, size_t size, TickType_t wait_ticks) {
+size_t dmx_write_staged(dmx_port_t dmx_num, size_t offset, const void *source, size_t size) {
+    DMX_CHECK(dmx_num < DMX_NUM_MAX, 0, "dmx_num error");
+    DMX_CHECK(offset < DMX_PACKET_SIZE_MAX, 0, "offset error");
+    DMX_CHECK(source, 0, "source is null");
+    DMX_CHECK(dmx_driver_is_installed(dmx_num), 0, "driver is not installed");
+
+    // Clamp size to the maximum DMX packet size
+    if (size + offset > DMX_PACKET_SIZE_MAX) {
+        size = DMX_PACKET_SIZE_MAX - offset;
+    } else if (size == 0) {
+        return 0;
+    }
+
+    dmx_driver_t *const driver = dmx_driver[dmx_num];
+
+    // The staged buffer is not swapped until every writer has finished writing it
+    taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+    ++driver->dmx.staged_writers;
+    uint8_t *const staged = driver->dmx.staged;
+    if (driver->dmx.staged_is_stale) {
+        // Start from the last sent packet, which may be written by the DMX interrupt outside of the critical section
+        memcpy(staged, driver->dmx.rdm_saved != NULL ? driver->dmx.rdm_saved : driver->dmx.data, DMX_PACKET_SIZE_MAX);
+        driver->dmx.staged_is_stale = false;
+    }
+    taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+
+    // Copy data into the staged buffer without blocking the DMX driver
+    memcpy(staged + offset, source, size);
+
+    taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+    --driver->dmx.staged_writers;
+    if (offset + size > driver->dmx.high_water) {
+        driver->dmx.high_water = offset + size;
+    }
+    taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+
+    return size;
+}
+
+bool dmx_write_commit(dmx_port_t dmx_num) {
+    DMX_CHECK(dmx_num < DMX_NUM_MAX, false, "dmx_num error");
+    DMX_CHECK(dmx_driver_is_installed(dmx_num), false, "driver is not installed");
+
+    dmx_driver_t *const driver = dmx_driver[dmx_num];
+
+    // Flip the DMX bus to write mode
+    if (dmx_uart_get_rts(dmx_num) == 1) {
+        dmx_uart_set_rts(dmx_num, 0);
+    }
+
+    // The staged buffer is swapped in at the beginning of the next DMX break
+    taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+    if (driver->dmx.staged_is_stale) {
+        // Sync the staged buffer if it has not been written since it was last sent
+        memcpy(driver->dmx.staged, driver->dmx.rdm_saved != NULL ? driver->dmx.rdm_saved : driver->dmx.data,
+               DMX_PACKET_SIZE_MAX);
+        driver->dmx.staged_is_stale = false;
+    }
+    driver->dmx.is_staged = true;
+    taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+
+    return true;
+}
+
+// Fills a packet from the last packet which was received. It must be called within a critical section.
+static void dmx_packet_fill(dmx_port_t dmx_num, dmx_packet_t *packet, dmx_err_t err, int packet_size) {
+    const dmx_driver_t *const driver = dmx_driver[dmx_num];
+    const uint8_t *const data = driver->dmx.rx_packet_data != NULL ? driver->dmx.rx_packet_data : driver->dmx.data;
+
+    packet->err             = err;
+    packet->sc              = packet_size > 0 ? data[0] : -1;
+    packet->size            = packet_size;
+    packet->is_rdm          = dmx_start_code_is_rdm(packet->sc);
+    packet->sequence        = driver->dmx.rx_sequence;
+    packet->break_timestamp = driver->dmx.rx_packet_break_timestamp;
+    packet->timestamp       = driver->dmx.rx_packet_timestamp;
+}
+
+static size_t dmx_receive_packet(dmx_port_t dmx_num, dmx_packet_t *packet, size_t size, TickType_t wait_ticks,
+                                 const uint8_t **lease) {
     DMX_CHECK(dmx_num < DMX_NUM_MAX, 0, "dmx_num error");
     DMX_CHECK(dmx_driver_is_installed(dmx_num), 0, "driver is not installed");
     DMX_CHECK(dmx_driver_is_enabled(dmx_num), 0, "driver is not enabled");
 
     dmx_driver_t *const driver = dmx_driver[dmx_num];
+    DMX_TRACE(dmx_num, DMX_TRACE_RECEIVE_ENTER, DMX_OK, size);
 
     // Block until mutex is taken and driver is idle, or until a timeout
     TimeOut_t timeout;
     vTaskSetTimeOutState(&timeout);
     if (!xSemaphoreTakeRecursive(driver->mux, wait_ticks) ||
         (wait_ticks && xTaskCheckForTimeOut(&timeout, &wait_ticks))) {
-        if (packet != NULL) {
-            packet->err    = DMX_ERR_TIMEOUT;
-            packet->sc     = -1;
-            packet->size   = 0;
-            packet->is_rdm = 0;
-        }
+        dmx_packet_set_timeout(packet);
+        DMX_TRACE(dmx_num, DMX_TRACE_RECEIVE_EXIT, DMX_ERR_TIMEOUT, 0);
         return 0;
     } else if (!dmx_wait_sent(dmx_num, wait_ticks) || (wait_ticks && xTaskCheckForTimeOut(&timeout, &wait_ticks))) {
         xSemaphoreGiveRecursive(driver->mux);
-        if (packet != NULL) {
-            packet->err    = DMX_ERR_TIMEOUT;
-            packet->sc     = -1;
-            packet->size   = 0;
-            packet->is_rdm = 0;
-        }
+        dmx_packet_set_timeout(packet);
+        DMX_TRACE(dmx_num, DMX_TRACE_RECEIVE_EXIT, DMX_ERR_TIMEOUT, 0);
         return 0;
     }
 
@@ -146,8 +253,8 @@ size_t dmx_receive_num(dmx_port_t dmx_num, dmx_packet_t *packet, size_t size, Ti
     if (dmx_uart_get_rts(dmx_num) == 0) {
         xTaskNotifyStateClear(xTaskGetCurrentTaskHandle());
         taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
-        driver->dmx.progress = DMX_PROGRESS_STALE;
-        driver->dmx.head     = DMX_HEAD_WAITING_FOR_BREAK;
+        dmx_state_update(dmx_num, DMX_STATE_PROGRESS_MASK | DMX_STATE_HEAD_MASK,
+                         DMX_STATE(0, DMX_PROGRESS_STALE, DMX_HEAD_WAITING_FOR_BREAK));
         dmx_uart_set_rts(dmx_num, 1);
         taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
     }
@@ -159,29 +266,26 @@ size_t dmx_receive_num(dmx_port_t dmx_num, dmx_packet_t *packet, size_t size, Ti
     taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
     if (size != old_size) {
         taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
-        driver->dmx.size = size;
-        if (driver->dmx.progress != DMX_PROGRESS_STALE && driver->dmx.head >= size) {
-            driver->dmx.progress = DMX_PROGRESS_COMPLETE;
+        driver->dmx.size     = size;
+        const uint32_t state = DMX_STATE_LOAD(driver);
+        if (DMX_STATE_PROGRESS(state) != DMX_PROGRESS_STALE && DMX_STATE_HEAD(state) >= size) {
+            dmx_state_set_progress(dmx_num, DMX_PROGRESS_COMPLETE);
+            if (!dmx_start_code_is_rdm(driver->dmx.data[0])) {
+                dmx_buffer_publish(dmx_num);
+            }
         }
         taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
     }
 
     // Guard against condition where this task cannot block and data isn't ready
-    int packet_status;
-    int packet_size;
-    taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
-    packet_status = driver->dmx.progress;
-    packet_size   = driver->dmx.head;
-    taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+    const uint32_t state    = DMX_STATE_LOAD(driver);
+    const int packet_status = DMX_STATE_PROGRESS(state);
+    int packet_size         = DMX_STATE_HEAD(state);
     if (packet_status != DMX_PROGRESS_COMPLETE && wait_ticks == 0) {
         // Not enough DMX data has been received yet - return early
-        if (packet != NULL) {
-            packet->err    = DMX_ERR_TIMEOUT;
-            packet->sc     = -1;
-            packet->size   = 0;
-            packet->is_rdm = 0;
-        }
+        dmx_packet_set_timeout(packet);
         xSemaphoreGiveRecursive(driver->mux);
+        DMX_TRACE(dmx_num, DMX_TRACE_RECEIVE_EXIT, DMX_ERR_TIMEOUT, 0);
         return 0;
     }
 
@@ -197,7 +301,12 @@ size_t dmx_receive_num(dmx_port_t dmx_num, dmx_packet_t *packet, size_t size, Ti
         // Determine if it is necessary to set a hardware timeout alarm
         int64_t timer_alarm;
         if (driver->is_controller) {
-            timer_alarm = RDM_TIMING_CONTROLLER_REQUEST_TO_RESPONSE_MAX;
+            taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+            timer_alarm = driver->dmx.response_timeout;
+            taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+            if (timer_alarm <= 0 || timer_alarm > RDM_TIMING_CONTROLLER_REQUEST_TO_RESPONSE_MAX) {
+                timer_alarm = RDM_TIMING_CONTROLLER_REQUEST_TO_RESPONSE_MAX;
+            }
         } else {
             timer_alarm = 0;
         }
@@ -211,18 +320,15 @@ size_t dmx_receive_num(dmx_port_t dmx_num, dmx_packet_t *packet, size_t size, Ti
             const int64_t timer_elapsed = dmx_timer_get_micros_since_boot() - last_timestamp;
             if (timer_elapsed > timer_alarm) {
                 // Return early if the time elapsed is greater than the timer alarm
-                if (packet != NULL) {
-                    packet->err    = DMX_ERR_TIMEOUT;
-                    packet->sc     = -1;
-                    packet->size   = 0;
-                    packet->is_rdm = 0;
-                }
+                dmx_packet_set_timeout(packet);
                 xSemaphoreGiveRecursive(driver->mux);
+                DMX_TRACE(dmx_num, DMX_TRACE_RECEIVE_EXIT, DMX_ERR_TIMEOUT, 0);
                 return 0;
             }
 
             // Set the timer
             taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+            driver->flags &= ~DMX_FLAGS_TIMER_IS_CONTINUOUS;  // The alarm notifies this task
             dmx_timer_set_counter(dmx_num, timer_elapsed);
             dmx_timer_set_alarm(dmx_num, timer_alarm, false);
             dmx_timer_start(dmx_num);
@@ -232,19 +338,17 @@ size_t dmx_receive_num(dmx_port_t dmx_num, dmx_packet_t *packet, size_t size, Ti
         // Wait for the DMX driver to notify this task that DMX is ready
         const bool notified = xTaskNotifyWait(0, -1, (uint32_t *)&err, wait_ticks);
         taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
-        packet_size          = driver->dmx.head;
+        packet_size          = DMX_STATE_HEAD(DMX_STATE_LOAD(driver));
         driver->task_waiting = NULL;
         taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
         if (!notified) {
             xTaskNotifyStateClear(current_task_handle);  // Avoid race condition
-            if (packet != NULL) {
-                packet->err    = DMX_ERR_TIMEOUT;
-                packet->sc     = -1;
-                packet->size   = 0;
-                packet->is_rdm = 0;
-            }
+            dmx_packet_set_timeout(packet);
             xSemaphoreGiveRecursive(driver->mux);
-            dmx_parameter_commit(dmx_num);
+            if (driver->device.commit.task == NULL) {
+                dmx_parameter_commit(dmx_num);  // Parameters are committed by the commit task if it is running
+            }
+            DMX_TRACE(dmx_num, DMX_TRACE_RECEIVE_EXIT, DMX_ERR_TIMEOUT, 0);
             return 0;
         }
     } else {
@@ -256,26 +360,34 @@ size_t dmx_receive_num(dmx_port_t dmx_num, dmx_packet_t *packet, size_t size, Ti
     }
 
     // Parse DMX packet data
-    taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
-    driver->dmx.progress = DMX_PROGRESS_STALE;  // Prevent parsing old data
-    taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
-    if (packet != NULL) {
-        if (packet_size > 0) {
-            taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
-            packet->sc = driver->dmx.data[0];
-            taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
-        } else {
-            packet->sc = -1;
+    dmx_state_set_progress(dmx_num, DMX_PROGRESS_STALE);  // Prevent parsing old data
+    if (packet != NULL || lease != NULL) {
+        // The lease is taken in the same critical section so that it holds the packet which is described
+        taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+        if (packet != NULL) {
+            dmx_packet_fill(dmx_num, packet, err, packet_size);
         }
-        packet->err    = err;
-        packet->size   = packet_size;
-        packet->is_rdm = dmx_start_code_is_rdm(packet->sc);
+        if (lease != NULL && packet_size > 0) {
+            driver->dmx.leased = driver->dmx.rx_packet_data;
+            *lease             = driver->dmx.leased;
+        }
+        taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+    }
+
+    // Record the packet if the DMX port is recording
+    if (driver->recorder != NULL && err == DMX_OK && packet_size > 0) {
+        dmx_recorder_record(dmx_num, packet_size);
     }
 
     xSemaphoreGiveRecursive(driver->mux);
+    DMX_TRACE(dmx_num, DMX_TRACE_RECEIVE_EXIT, err, packet_size);
     return packet_size;
 }
 
+size_t dmx_receive_num(dmx_port_t dmx_num, dmx_packet_t *packet, size_t size, TickType_t wait_ticks) {
+    return dmx_receive_packet(dmx_num, packet, size, wait_ticks, NULL);
+}
+
 size_t dmx_receive(dmx_port_t dmx_num, dmx_packet_t *packet, TickType_t wait_ticks) {
     DMX_CHECK(dmx_num < DMX_NUM_MAX, 0, "dmx_num error");
     DMX_CHECK(dmx_driver_is_installed(dmx_num), 0, "driver is not installed");
@@ -289,69 +401,372 @@ size_t dmx_receive(dmx_port_t dmx_num, dmx_packet_t *packet, TickType_t wait_tic
     return dmx_receive_num(dmx_num, packet, size, wait_ticks);
 }
 
-size_t dmx_send_num(dmx_port_t dmx_num, size_t size) {
+size_t dmx_receive_any(const dmx_port_t *ports, size_t n, dmx_port_t *which, dmx_packet_t *packet,
+                       TickType_t wait_ticks) {
+    DMX_CHECK(ports != NULL, 0, "ports is null");
+    DMX_CHECK(n > 0 && n <= DMX_NUM_MAX, 0, "n error");
+    DMX_CHECK(which != NULL, 0, "which is null");
+    for (int i = 0; i < n; ++i) {
+        DMX_CHECK(ports[i] < DMX_NUM_MAX, 0, "dmx_num error");
+        DMX_CHECK(dmx_driver_is_installed(ports[i]), 0, "driver is not installed");
+        DMX_CHECK(dmx_driver_is_enabled(ports[i]), 0, "driver is not enabled");
+    }
+
+    // Return a packet immediately if one is already waiting
+    for (int i = 0; i < n; ++i) {
+        const size_t size = dmx_receive(ports[i], packet, 0);
+        if (size > 0) {
+            *which = ports[i];
+            return size;
+        }
+    }
+    if (wait_ticks == 0) {
+        return 0;
+    }
+
+    // Wait until a packet is received or the timeout expires. A ready packet may be taken by another task first.
+    const TaskHandle_t current_task_handle = xTaskGetCurrentTaskHandle();
+    TimeOut_t timeout;
+    vTaskSetTimeOutState(&timeout);
+    do {
+        // Tell each DMX driver that this task is awaiting a DMX packet
+        bool is_complete = false;
+        xTaskNotifyStateClear(current_task_handle);
+        for (int i = 0; i < n; ++i) {
+            dmx_driver_t *const driver = dmx_driver[ports[i]];
+            taskENTER_CRITICAL(DMX_SPINLOCK(ports[i]));
+            driver->task_waiting_any = current_task_handle;
+            is_complete |= (DMX_STATE_PROGRESS(DMX_STATE_LOAD(driver)) == DMX_PROGRESS_COMPLETE);  // Avoid race
+            taskEXIT_CRITICAL(DMX_SPINLOCK(ports[i]));
+        }
+
+        // Wait for any DMX driver to notify this task that DMX is ready
+        uint32_t port_bits = 0;
+        if (!is_complete) {
+            xTaskNotifyWait(0, ULONG_MAX, &port_bits, wait_ticks);
+        }
+        for (int i = 0; i < n; ++i) {
+            dmx_driver_t *const driver = dmx_driver[ports[i]];
+            taskENTER_CRITICAL(DMX_SPINLOCK(ports[i]));
+            driver->task_waiting_any = NULL;
+            if (DMX_STATE_PROGRESS(DMX_STATE_LOAD(driver)) == DMX_PROGRESS_COMPLETE) {
+                port_bits |= 1 << ports[i];
+            }
+            taskEXIT_CRITICAL(DMX_SPINLOCK(ports[i]));
+        }
+        xTaskNotifyStateClear(current_task_handle);
+
+        // Receive the packet from the first DMX port that is ready
+        for (int i = 0; i < n; ++i) {
+            if (port_bits & (1 << ports[i])) {
+                const size_t size = dmx_receive(ports[i], packet, 0);
+                if (size > 0) {
+                    *which = ports[i];
+                    return size;
+                }
+            }
+        }
+
+        // Don't spin while another task holds a DMX driver whose packet is ready
+        if (is_complete) {
+            vTaskDelay(1);
+        }
+    } while (!xTaskCheckForTimeOut(&timeout, &wait_ticks));
+
+    dmx_packet_set_timeout(packet);
+    return 0;
+}
+
+bool dmx_subscribe(dmx_port_t dmx_num, dmx_subscriber_cb_t cb, void *context) {
+    DMX_CHECK(dmx_num < DMX_NUM_MAX, false, "dmx_num error");
+    DMX_CHECK(cb != NULL, false, "cb is null");
+    DMX_CHECK(dmx_driver_is_installed(dmx_num), false, "driver is not installed");
+
+    dmx_driver_t *const driver = dmx_driver[dmx_num];
+
+    // Find an unused subscriber slot
+    bool ret = false;
+    taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+    for (int i = 0; i < DMX_SUBSCRIBER_MAX; ++i) {
+        if (driver->subscribers[i].cb == NULL) {
+            driver->subscribers[i].cb      = cb;
+            driver->subscribers[i].context = context;
+            ret                            = true;
+            break;
+        }
+    }
+    taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+
+    return ret;
+}
+
+bool dmx_unsubscribe(dmx_port_t dmx_num, dmx_subscriber_cb_t cb, void *context) {
+    DMX_CHECK(dmx_num < DMX_NUM_MAX, false, "dmx_num error");
+    DMX_CHECK(cb != NULL, false, "cb is null");
+    DMX_CHECK(dmx_driver_is_installed(dmx_num), false, "driver is not installed");
+
+    dmx_driver_t *const driver = dmx_driver[dmx_num];
+
+    bool ret = false;
+    taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+    for (int i = 0; i < DMX_SUBSCRIBER_MAX; ++i) {
+        if (driver->subscribers[i].cb == cb && driver->subscribers[i].context == context) {
+            driver->subscribers[i].cb      = NULL;
+            driver->subscribers[i].context = NULL;
+            ret                            = true;
+            break;
+        }
+    }
+    taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+
+    return ret;
+}
+
+bool dmx_set_start_code_filter(dmx_port_t dmx_num, const uint8_t *start_codes, size_t count) {
+    DMX_CHECK(dmx_num < DMX_NUM_MAX, false, "dmx_num error");
+    DMX_CHECK(start_codes != NULL || count == 0, false, "start_codes is null");
+    DMX_CHECK(dmx_driver_is_installed(dmx_num), false, "driver is not installed");
+
+    dmx_driver_t *const driver = dmx_driver[dmx_num];
+
+    // Build the bitmap of the accepted start codes before it is published to the DMX interrupt
+    uint32_t bitmap[8];
+    memset(bitmap, start_codes == NULL ? 0xff : 0, sizeof(bitmap));
+    for (size_t i = 0; i < count; ++i) {
+        bitmap[start_codes[i] / 32] |= 1u << (start_codes[i] % 32);
+    }
+
+    taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+    memcpy(driver->filter.start_codes, bitmap, sizeof(bitmap));
+    taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+
+    return true;
+}
+
+bool dmx_set_rdm_filter(dmx_port_t dmx_num, bool enable) {
+    DMX_CHECK(dmx_num < DMX_NUM_MAX, false, "dmx_num error");
+    DMX_CHECK(dmx_driver_is_installed(dmx_num), false, "driver is not installed");
+
+    taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+    dmx_driver[dmx_num]->filter.is_rdm_filtered = enable;
+    taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+
+    return true;
+}
+
+size_t dmx_receive_lease(dmx_port_t dmx_num, const uint8_t **data, dmx_packet_t *packet, TickType_t wait_ticks) {
     DMX_CHECK(dmx_num < DMX_NUM_MAX, 0, "dmx_num error");
+    DMX_CHECK(data != NULL, 0, "data is null");
     DMX_CHECK(dmx_driver_is_installed(dmx_num), 0, "driver is not installed");
     DMX_CHECK(dmx_driver_is_enabled(dmx_num), 0, "driver is not enabled");
 
-    dmx_driver_t *const driver = dmx_driver[dmx_num];
+    // Release the previous lease so that the driver may receive into it
+    dmx_release(dmx_num);
 
-    // Block until the mutex can be taken
-    if (!xSemaphoreTakeRecursive(driver->mux, 0)) {
-        return 0;
+    size_t size;
+    taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+    size = dmx_driver[dmx_num]->dmx.size;
+    taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+
+    dmx_packet_t lease_packet;
+    *data              = NULL;
+    size_t packet_size = dmx_receive_packet(dmx_num, &lease_packet, size, wait_ticks, data);
+    if (packet_size > 0 && *data == NULL) {
+        // The packet was overwritten by the next packet before it could be leased
+        dmx_packet_set_timeout(&lease_packet);
+        packet_size = 0;
+    }
+    if (packet != NULL) {
+        *packet = lease_packet;
     }
 
-    // Block until the driver is done sending
-    if (!dmx_wait_sent(dmx_num, dmx_ms_to_ticks(23))) {
-        xSemaphoreGiveRecursive(driver->mux);
-        return 0;
+    return packet_size;
+}
+
+static void dmx_footprint_update(dmx_port_t dmx_num) {
+    dmx_driver_t *const driver                  = dmx_driver[dmx_num];
+    struct dmx_driver_footprint_t *const cached = &driver->device.footprint;
+
+    uint32_t version;
+    bool is_cached;
+    taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+    version   = cached->version;
+    is_cached = (cached->cached_version == version);
+    taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+    if (is_cached) {
+        return;
     }
 
-    // Determine if the packet was an RDM packet
-    bool is_rdm;
-    rdm_header_t header;
+    // Look up the footprint of the current personality
+    uint16_t start_address = dmx_get_start_address(dmx_num);
+    size_t footprint       = 0;
+    if (start_address == DMX_START_ADDRESS_NONE) {
+        start_address = 0;  // This device does not use a DMX address
+    } else if (start_address > 0) {
+        const uint8_t personality_num = dmx_get_current_personality(dmx_num);
+        if (personality_num > 0) {
+            footprint = dmx_get_footprint(dmx_num, personality_num);
+        }
+        if (start_address + footprint > DMX_PACKET_SIZE_MAX) {
+            footprint = DMX_PACKET_SIZE_MAX - start_address;
+        }
+    }
+
+    // The cache is still stale if the footprint changed while it was looked up
     taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
-    is_rdm = rdm_read_header(dmx_num, &header);
+    cached->start_address  = start_address;
+    cached->size           = footprint;
+    cached->cached_version = version;
     taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
-    if (is_rdm && !rdm_cc_is_valid(header.cc)) {
-        is_rdm = false;
+}
+
+size_t dmx_receive_footprint(dmx_port_t dmx_num, const uint8_t **slots, dmx_packet_t *packet, bool only_changed,
+                             TickType_t wait_ticks) {
+    DMX_CHECK(dmx_num < DMX_NUM_MAX, 0, "dmx_num error");
+    DMX_CHECK(slots != NULL, 0, "slots is null");
+    DMX_CHECK(dmx_driver_is_installed(dmx_num), 0, "driver is not installed");
+    DMX_CHECK(dmx_driver_is_enabled(dmx_num), 0, "driver is not enabled");
+
+    dmx_driver_t *const driver                  = dmx_driver[dmx_num];
+    struct dmx_driver_footprint_t *const cached = &driver->device.footprint;
+
+    TimeOut_t timeout;
+    vTaskSetTimeOutState(&timeout);
+    while (true) {
+        const uint8_t *data;
+        dmx_packet_t lease_packet;
+        const size_t packet_size = dmx_receive_lease(dmx_num, &data, &lease_packet, wait_ticks);
+        if (packet != NULL) {
+            *packet = lease_packet;
+        }
+        if (packet_size == 0 || lease_packet.err != DMX_OK) {
+            dmx_release(dmx_num);
+            break;
+        }
+
+        // Get the footprint slice of the received DMX packet
+        dmx_footprint_update(dmx_num);
+        size_t start_address, footprint;
+        bool is_changed;
+        taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+        start_address = cached->start_address;
+        footprint     = cached->size;
+        is_changed    = !only_changed || cached->received_version != cached->cached_version;
+        if (start_address + footprint > packet_size) {
+            footprint = packet_size > start_address ? packet_size - start_address : 0;
+        }
+#ifdef CONFIG_DMX_CHANGED_SLOTS
+        for (size_t slot = start_address; !is_changed && slot < start_address + footprint; ++slot) {
+            is_changed = driver->dmx.changed[slot / 32] & (1u << (slot % 32));
+        }
+#else
+        is_changed = true;  // Changed slots are not tracked so every packet may have changed
+#endif
+        taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+
+        if (!lease_packet.is_rdm && start_address > 0 && footprint > 0 && is_changed) {
+            cached->received_version = cached->cached_version;
+            *slots                   = &data[start_address];
+            return footprint;
+        }
+
+        // Wait for the next packet
+        dmx_release(dmx_num);
+        if (wait_ticks == 0 || xTaskCheckForTimeOut(&timeout, &wait_ticks)) {
+            break;
+        }
     }
 
-    // Determine if this device is the controller
-    driver->is_controller = !is_rdm || rdm_cc_is_request(header.cc);
+    *slots = NULL;
+    return 0;
+}
 
-    // Determine if it is necessary to set a hardware timeout alarm
+bool dmx_release(dmx_port_t dmx_num) {
+    DMX_CHECK(dmx_num < DMX_NUM_MAX, false, "dmx_num error");
+    DMX_CHECK(dmx_driver_is_installed(dmx_num), false, "driver is not installed");
+
+    dmx_driver_t *const driver = dmx_driver[dmx_num];
+
+    bool was_leased;
+    taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+    was_leased         = (driver->dmx.leased != NULL);
+    driver->dmx.leased = NULL;
+    taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+
+    return was_leased;
+}
+
+size_t dmx_get_changed_slots(dmx_port_t dmx_num, uint8_t *bitmap, size_t first, size_t count) {
+    DMX_CHECK(dmx_num < DMX_NUM_MAX, 0, "dmx_num error");
+    DMX_CHECK(bitmap != NULL, 0, "bitmap is null");
+    DMX_CHECK(first < DMX_PACKET_SIZE_MAX, 0, "first error");
+    DMX_CHECK(dmx_driver_is_installed(dmx_num), 0, "driver is not installed");
+
+    // Clamp count to the maximum DMX packet size
+    if (first + count > DMX_PACKET_SIZE_MAX) {
+        count = DMX_PACKET_SIZE_MAX - first;
+    }
+
+    uint32_t changed[DMX_SLOT_BITMAP_WORDS];
+#ifdef CONFIG_DMX_CHANGED_SLOTS
+    dmx_driver_t *const driver = dmx_driver[dmx_num];
+    taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+    memcpy(changed, driver->dmx.changed, sizeof(changed));
+    taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+#else
+    // Changed slots are not tracked so every slot is reported as changed
+    memset(changed, 0xff, sizeof(changed));
+#endif
+
+    // Copy the requested range of the bitmap so that bit 0 is the first slot
+    size_t changed_count = 0;
+    memset(bitmap, 0, (count + 7) / 8);
+    for (size_t i = 0; i < count; ++i) {
+        const size_t slot = first + i;
+        if (changed[slot / 32] & (1u << (slot % 32))) {
+            bitmap[i / 8] |= 1 << (i % 8);
+            ++changed_count;
+        }
+    }
+
+    return changed_count;
+}
+
+static int64_t dmx_get_controller_alarm(const dmx_driver_t *driver) {
     int64_t timer_alarm;
-    if (driver->is_controller) {
-        if (driver->dmx.last_controller_pid != RDM_PID_DISC_UNIQUE_BRANCH) {
-            if (driver->dmx.responder_sent_last || driver->dmx.last_controller_pid == 0 ||
-                driver->dmx.last_request_was_broadcast) {
-                timer_alarm = RDM_TIMING_CONTROLLER_REQUEST_TO_REQUEST_MIN;
-            } else {
-                timer_alarm = RDM_TIMING_CONTROLLER_RESPONSE_LOST_MIN;
-            }
+    if (driver->dmx.last_controller_pid != RDM_PID_DISC_UNIQUE_BRANCH) {
+        if (driver->dmx.responder_sent_last || driver->dmx.last_controller_pid == 0 ||
+            driver->dmx.last_request_was_broadcast) {
+            timer_alarm = RDM_TIMING_CONTROLLER_REQUEST_TO_REQUEST_MIN;
         } else {
-            if (driver->dmx.responder_sent_last) {
-                /* This is a condition in which the RDM controller sends an
-                  RDM_PID_DISC_UNIQUE_BRANCH message and a valid response has already
-                  been received. The RDM standard doesn't specify how long the RDM
-                  controller should wait before sending the next RDM request. Therefore
-                  this value is customizable by the user in the Kconfig.*/
-                timer_alarm = RDM_TIMING_CONTROLLER_DISCOVERY_TRANSACTION_MIN;
-            } else {
-                timer_alarm = RDM_TIMING_CONTROLLER_DISCOVERY_TO_REQUEST_MIN;
-            }
+            timer_alarm = RDM_TIMING_CONTROLLER_RESPONSE_LOST_MIN;
         }
     } else {
-        timer_alarm = RDM_TIMING_RESPONDER_MIN;
+        if (driver->dmx.responder_sent_last) {
+            /* This is a condition in which the RDM controller sends an
+              RDM_PID_DISC_UNIQUE_BRANCH message and a valid response has already
+              been received. The RDM standard doesn't specify how long the RDM
+              controller should wait before sending the next RDM request. Therefore
+              this value is customizable by the user in the Kconfig.*/
+            timer_alarm = RDM_TIMING_CONTROLLER_DISCOVERY_TRANSACTION_MIN;
+        } else {
+            timer_alarm = RDM_TIMING_CONTROLLER_DISCOVERY_TO_REQUEST_MIN;
+        }
     }
 
+    return timer_alarm;
+}
+
+static int64_t dmx_wait_alarm(dmx_port_t dmx_num, int64_t timer_alarm) {
+    dmx_driver_t *const driver = dmx_driver[dmx_num];
+
     // If necessary, set an alarm to wait the minimum duration before sending
     int64_t timer_elapsed;
     const TaskHandle_t this_task_handle = xTaskGetCurrentTaskHandle();
     taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
     timer_elapsed = dmx_timer_get_micros_since_boot() - driver->dmx.controller_eop_timestamp;
     if (timer_elapsed < timer_alarm) {
+        driver->flags &= ~DMX_FLAGS_TIMER_IS_CONTINUOUS;  // The alarm notifies this task
         dmx_timer_set_counter(dmx_num, timer_elapsed);
         dmx_timer_set_alarm(dmx_num, timer_alarm, false);
         dmx_timer_start(dmx_num);
@@ -367,10 +782,74 @@ size_t dmx_send_num(dmx_port_t dmx_num, size_t size) {
         driver->task_waiting = NULL;
     }
 
+    return timer_elapsed;
+}
+
+size_t dmx_send_num(dmx_port_t dmx_num, size_t size) {
+    if (DMX_IS_PARALLEL_PORT(dmx_num)) {
+        return dmx_parallel_send(&dmx_num, 1, size);
+    }
+    DMX_CHECK(dmx_num < DMX_NUM_MAX, 0, "dmx_num error");
+    DMX_CHECK(dmx_driver_is_installed(dmx_num), 0, "driver is not installed");
+    DMX_CHECK(dmx_driver_is_enabled(dmx_num), 0, "driver is not enabled");
+    DMX_CHECK(dmx_driver[dmx_num]->repeater.input < 0, 0, "port is repeating");
+
+    dmx_driver_t *const driver = dmx_driver[dmx_num];
+    DMX_TRACE(dmx_num, DMX_TRACE_SEND_ENTER, DMX_OK, size);
+
+    // Block until the mutex can be taken
+    if (!xSemaphoreTakeRecursive(driver->mux, 0)) {
+        DMX_TRACE(dmx_num, DMX_TRACE_SEND_EXIT, DMX_OK, 0);
+        return 0;
+    }
+
+    // Determine if the packet was an RDM packet
+    bool is_rdm;
+    rdm_header_t header;
+    taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+    is_rdm = rdm_read_header(dmx_num, &header);
+    taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+    if (is_rdm && !rdm_cc_is_valid(header.cc)) {
+        is_rdm = false;
+    }
+
+    // DMX packets are sent automatically when sending continuously
+    uint32_t continuous_period;
+    taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+    continuous_period = driver->continuous.period;
+    if (continuous_period > 0 && is_rdm) {
+        driver->continuous.is_paused = true;  // Pause so that the RDM packet may be sent
+    }
+    taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+    if (continuous_period > 0 && !is_rdm) {
+        dmx_continuous_resume(dmx_num);
+        xSemaphoreGiveRecursive(driver->mux);
+        DMX_TRACE(dmx_num, DMX_TRACE_SEND_EXIT, DMX_OK, driver->continuous.size);
+        return driver->continuous.size;
+    }
+
+    // Block until the driver is done sending. A packet scheduled by dmx_send_at() keeps the DMX bus until it starts.
+    if (!dmx_wait_sent(dmx_num, dmx_ms_to_ticks(23)) ||
+        DMX_STATE_STATUS(DMX_STATE_LOAD(driver)) == DMX_STATUS_ARMED) {
+        xSemaphoreGiveRecursive(driver->mux);
+        DMX_TRACE(dmx_num, DMX_TRACE_SEND_EXIT, DMX_OK, 0);
+        return 0;
+    }
+
+    // Determine if this device is the controller
+    driver->is_controller = !is_rdm || rdm_cc_is_request(header.cc);
+
+    // Determine if it is necessary to set a hardware timeout alarm
+    const int64_t timer_alarm = driver->is_controller ? dmx_get_controller_alarm(driver) : RDM_TIMING_RESPONDER_MIN;
+
+    // If necessary, set an alarm to wait the minimum duration before sending
+    const int64_t timer_elapsed = dmx_wait_alarm(dmx_num, timer_alarm);
+
     // Return early if it is too late to send a response packet
     if (!driver->is_controller) {
         if (timer_elapsed > RDM_TIMING_RESPONDER_MAX) {
             xSemaphoreGiveRecursive(driver->mux);
+            DMX_TRACE(dmx_num, DMX_TRACE_SEND_EXIT, DMX_OK, 0);
             return 0;
         }
     }
@@ -394,6 +873,9 @@ size_t dmx_send_num(dmx_port_t dmx_num, size_t size) {
     }
     taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
     driver->dmx.size = size;
+    if (!is_rdm) {
+        driver->dmx.front = driver->dmx.data;  // The sent packet is the last complete DMX packet
+    }
     taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
 
     // Record information about the packet that is being sent
@@ -420,35 +902,39 @@ size_t dmx_send_num(dmx_port_t dmx_num, size_t size) {
     if (is_rdm && header.cc == RDM_CC_DISC_COMMAND_RESPONSE && header.pid == RDM_PID_DISC_UNIQUE_BRANCH) {
         // RDM discovery responses do not send a DMX break - write immediately
         taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
-        driver->dmx.status = DMX_STATUS_SENDING;
+        dmx_state_set_status(dmx_num, DMX_STATUS_SENDING);
 
-        int write_len = driver->dmx.size;
-        dmx_uart_write_txfifo(dmx_num, driver->dmx.data, &write_len);
-        driver->dmx.head = write_len;
+        if (dmx_dma_write(dmx_num, driver->dmx.data, driver->dmx.size)) {
+            dmx_state_set_head(dmx_num, driver->dmx.size);
+            dmx_uart_clear_interrupt(dmx_num, DMX_INTR_TX_DONE);
+            dmx_uart_enable_interrupt(dmx_num, DMX_INTR_TX_DONE);
+        } else {
+            int write_len = driver->dmx.size;
+            dmx_uart_write_txfifo(dmx_num, driver->dmx.data, &write_len);
+            dmx_state_set_head(dmx_num, write_len);
 
-        // Enable DMX write interrupts
-        dmx_uart_enable_interrupt(dmx_num, DMX_INTR_TX_ALL);
+            // Enable DMX write interrupts
+            dmx_uart_enable_interrupt(dmx_num, DMX_INTR_TX_ALL);
+        }
         taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
     } else {
         // Send the packet by starting the DMX break
         taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
-        driver->dmx.head     = 0;
-        driver->dmx.progress = DMX_PROGRESS_IN_BREAK;
-        driver->dmx.status   = DMX_STATUS_SENDING;
-        dmx_timer_set_counter(dmx_num, 0);
-        dmx_timer_set_alarm(dmx_num, driver->break_len, true);
-        dmx_timer_start(dmx_num);
-
-        dmx_uart_invert_tx(dmx_num, 1);
+        dmx_packet_start_break(dmx_num);
+        size = driver->dmx.size;  // The packet may have been automatically sized
         taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
     }
 
     // Give the mutex back
     xSemaphoreGiveRecursive(driver->mux);
+    DMX_TRACE(dmx_num, DMX_TRACE_SEND_EXIT, DMX_OK, size);
     return size;
 }
 
 size_t dmx_send(dmx_port_t dmx_num) {
+    if (DMX_IS_PARALLEL_PORT(dmx_num)) {
+        return dmx_parallel_send(&dmx_num, 1, DMX_PACKET_SIZE);
+    }
     DMX_CHECK(dmx_num < DMX_NUM_MAX, 0, "dmx_num error");
     DMX_CHECK(dmx_driver_is_installed(dmx_num), 0, "driver is not installed");
     DMX_CHECK(dmx_driver_is_enabled(dmx_num), 0, "driver is not enabled");
@@ -456,12 +942,275 @@ size_t dmx_send(dmx_port_t dmx_num) {
     return dmx_send_num(dmx_num, DMX_PACKET_SIZE);
 }
 
+size_t dmx_send_group(const dmx_port_t *ports, size_t n) {
+    DMX_CHECK(ports != NULL, 0, "ports is null");
+    if (n > 0 && DMX_IS_PARALLEL_PORT(ports[0])) {
+        for (int i = 1; i < n; ++i) {
+            DMX_CHECK(DMX_IS_PARALLEL_PORT(ports[i]), 0, "UART ports can't be grouped with parallel ports");
+        }
+        return dmx_parallel_send(ports, n, DMX_PACKET_SIZE);
+    }
+    DMX_CHECK(n > 0 && n <= DMX_NUM_MAX, 0, "n error");
+    uint32_t port_mask = 0;
+    for (int i = 0; i < n; ++i) {
+        DMX_CHECK(!DMX_IS_PARALLEL_PORT(ports[i]), 0, "parallel ports can't be grouped with UART ports");
+        DMX_CHECK(ports[i] < DMX_NUM_MAX, 0, "dmx_num error");
+        DMX_CHECK(!(port_mask & (1 << ports[i])), 0, "dmx_num is duplicated");
+        DMX_CHECK(dmx_driver_is_installed(ports[i]), 0, "driver is not installed");
+        DMX_CHECK(dmx_driver_is_enabled(ports[i]), 0, "driver is not enabled");
+        port_mask |= 1 << ports[i];
+    }
+
+    // Block until every mutex can be taken
+    int taken = 0;
+    for (; taken < n; ++taken) {
+        dmx_driver_t *const driver = dmx_driver[ports[taken]];
+        if (!xSemaphoreTakeRecursive(driver->mux, 0) || driver->continuous.period > 0) {
+            if (driver->continuous.period > 0) {
+                xSemaphoreGiveRecursive(driver->mux);  // Continuous ports can't be synchronized
+            }
+            break;
+        }
+    }
+
+    // Block until each driver is done sending and the DMX bus is ready
+    bool is_ready = (taken == n);
+    TickType_t wait_ticks = dmx_ms_to_ticks(23);
+    TimeOut_t timeout;
+    vTaskSetTimeOutState(&timeout);
+    for (int i = 0; is_ready && i < n; ++i) {
+        dmx_driver_t *const driver = dmx_driver[ports[i]];
+        if (!dmx_wait_sent(ports[i], wait_ticks) || xTaskCheckForTimeOut(&timeout, &wait_ticks) ||
+            DMX_STATE_STATUS(DMX_STATE_LOAD(driver)) == DMX_STATUS_ARMED) {
+            is_ready = false;
+            break;
+        }
+        driver->is_controller = true;
+        dmx_wait_alarm(ports[i], dmx_get_controller_alarm(driver));
+    }
+    if (!is_ready) {
+        while (taken > 0) {
+            xSemaphoreGiveRecursive(dmx_driver[ports[--taken]]->mux);
+        }
+        return 0;
+    }
+
+    // Prepare each DMX driver to send a standard DMX packet
+    for (int i = 0; i < n; ++i) {
+        dmx_driver_t *const driver = dmx_driver[ports[i]];
+        taskENTER_CRITICAL(DMX_SPINLOCK(ports[i]));
+        if (dmx_uart_get_rts(ports[i]) == 1) {
+            dmx_uart_set_rts(ports[i], 0);
+        }
+        driver->dmx.size                       = DMX_PACKET_SIZE_MAX;
+        driver->dmx.front                      = driver->dmx.data;
+        driver->dmx.last_controller_pid        = 0;
+        driver->dmx.last_request_was_broadcast = false;
+        driver->dmx.responder_sent_last        = false;
+        dmx_state_set_status(ports[i], DMX_STATUS_ARMED);
+        taskEXIT_CRITICAL(DMX_SPINLOCK(ports[i]));
+    }
+
+    // Start every DMX break from a single alarm of the first port so that the packets are aligned
+    const dmx_port_t leader = ports[0];
+    dmx_driver_t *const driver = dmx_driver[leader];
+    taskENTER_CRITICAL(DMX_SPINLOCK(leader));
+    driver->send_at    = dmx_timer_get_micros_since_boot() + DMX_SEND_GROUP_LEAD_US;
+    driver->send_group = port_mask;
+    dmx_timer_stop(leader);
+    dmx_timer_set_counter(leader, 0);
+    dmx_timer_set_alarm(leader, DMX_SEND_GROUP_LEAD_US, false);
+    dmx_timer_start(leader);
+    taskEXIT_CRITICAL(DMX_SPINLOCK(leader));
+
+    // Hold the mutexes until the DMX breaks have started so that the group can't be rescheduled
+    while (DMX_STATE_STATUS(DMX_STATE_LOAD(driver)) == DMX_STATUS_ARMED) {
+        taskYIELD();
+    }
+
+    // Give the mutexes back
+    for (int i = n - 1; i >= 0; --i) {
+        xSemaphoreGiveRecursive(dmx_driver[ports[i]]->mux);
+    }
+    return n;
+}
+
+size_t dmx_send_at(dmx_port_t dmx_num, int64_t timestamp) {
+    DMX_CHECK(dmx_num < DMX_NUM_MAX, 0, "dmx_num error");
+    DMX_CHECK(timestamp - dmx_timer_get_micros_since_boot() <= DMX_SEND_AT_MAX_US, 0, "timestamp error");
+    DMX_CHECK(dmx_driver_is_installed(dmx_num), 0, "driver is not installed");
+    DMX_CHECK(dmx_driver_is_enabled(dmx_num), 0, "driver is not enabled");
+    DMX_CHECK(dmx_driver[dmx_num]->repeater.input < 0, 0, "port is repeating");
+
+    dmx_driver_t *const driver = dmx_driver[dmx_num];
+    DMX_TRACE(dmx_num, DMX_TRACE_SEND_ENTER, DMX_OK, DMX_PACKET_SIZE_MAX);
+
+    // Block until the mutex can be taken and the driver is done sending
+    if (!xSemaphoreTakeRecursive(driver->mux, 0)) {
+        DMX_TRACE(dmx_num, DMX_TRACE_SEND_EXIT, DMX_OK, 0);
+        return 0;
+    } else if (driver->continuous.period > 0 || !dmx_wait_sent(dmx_num, dmx_ms_to_ticks(23))) {
+        xSemaphoreGiveRecursive(driver->mux);  // Continuous ports are started by the DMX timer
+        DMX_TRACE(dmx_num, DMX_TRACE_SEND_EXIT, DMX_OK, 0);
+        return 0;
+    }
+
+    // Cancel a packet which is already scheduled so that it may be rescheduled
+    taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+    if (DMX_STATE_STATUS(DMX_STATE_LOAD(driver)) == DMX_STATUS_ARMED) {
+        dmx_timer_stop(dmx_num);
+        driver->send_at    = -1;
+        driver->send_group = 0;
+        dmx_state_set_status(dmx_num, DMX_STATUS_IDLE);
+    }
+    taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+    driver->is_controller = true;
+    dmx_wait_alarm(dmx_num, dmx_get_controller_alarm(driver));
+
+    // Prepare the DMX driver to send a standard DMX packet
+    size_t size;
+    taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+    if (dmx_uart_get_rts(dmx_num) == 1) {
+        dmx_uart_set_rts(dmx_num, 0);
+    }
+    driver->dmx.size                       = DMX_PACKET_SIZE_MAX;
+    driver->dmx.front                      = driver->dmx.data;
+    driver->dmx.last_controller_pid        = 0;
+    driver->dmx.last_request_was_broadcast = false;
+    driver->dmx.responder_sent_last        = false;
+
+    // Set an alarm to start the DMX break, or start it now if the timestamp has passed
+    const int64_t delay = timestamp - dmx_timer_get_micros_since_boot();
+    if (delay > 0) {
+        driver->send_at    = timestamp;
+        driver->send_group = 1u << dmx_num;
+        dmx_state_set_status(dmx_num, DMX_STATUS_ARMED);  // The packet may still be written until it starts
+        dmx_timer_stop(dmx_num);
+        dmx_timer_set_counter(dmx_num, 0);
+        dmx_timer_set_alarm(dmx_num, delay, false);
+        dmx_timer_start(dmx_num);
+        size = dmx_packet_get_size(dmx_num);
+    } else {
+        dmx_packet_start_break(dmx_num);
+        size = driver->dmx.size;  // The packet may have been automatically sized
+    }
+    taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+
+    xSemaphoreGiveRecursive(driver->mux);
+    DMX_TRACE(dmx_num, DMX_TRACE_SEND_EXIT, DMX_OK, size);
+    return size;
+}
+
+bool dmx_wait_sent_group(const dmx_port_t *ports, size_t n, TickType_t wait_ticks) {
+    DMX_CHECK(ports != NULL, false, "ports is null");
+    for (int i = 0; i < n; ++i) {
+        DMX_CHECK(ports[i] < DMX_NUM_MAX, false, "dmx_num error");
+        DMX_CHECK(dmx_driver_is_installed(ports[i]), false, "driver is not installed");
+    }
+
+    // Each port shares the same timeout
+    TimeOut_t timeout;
+    vTaskSetTimeOutState(&timeout);
+    for (int i = 0; i < n; ++i) {
+        if (!dmx_wait_sent(ports[i], wait_ticks) || (wait_ticks && xTaskCheckForTimeOut(&timeout, &wait_ticks))) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool dmx_start_continuous(dmx_port_t dmx_num, uint32_t refresh_hz, size_t size) {
+    DMX_CHECK(dmx_num < DMX_NUM_MAX, false, "dmx_num error");
+    DMX_CHECK(refresh_hz > 0 && refresh_hz <= DMX_REFRESH_HZ_MAX, false, "refresh_hz error");
+    DMX_CHECK(dmx_driver_is_installed(dmx_num), false, "driver is not installed");
+    DMX_CHECK(dmx_driver_is_enabled(dmx_num), false, "driver is not enabled");
+    DMX_CHECK(dmx_driver[dmx_num]->repeater.input < 0, false, "port is repeating");
+
+    dmx_driver_t *const driver = dmx_driver[dmx_num];
+
+    if (size == 0 || size > DMX_PACKET_SIZE_MAX) {
+        size = DMX_PACKET_SIZE_MAX;
+    }
+
+    // Block until the mutex can be taken and the driver is done sending
+    if (!xSemaphoreTakeRecursive(driver->mux, 0)) {
+        return false;
+    } else if (!dmx_wait_sent(dmx_num, dmx_ms_to_ticks(23)) ||
+               DMX_STATE_STATUS(DMX_STATE_LOAD(driver)) == DMX_STATUS_ARMED) {
+        xSemaphoreGiveRecursive(driver->mux);
+        return false;
+    }
+
+    // Send the first packet - the following packets are started by the DMX timer
+    taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+    driver->continuous.period    = 1000000 / refresh_hz;
+    driver->continuous.size      = size;
+    driver->continuous.is_paused = true;
+    taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+    dmx_continuous_resume(dmx_num);
+
+    xSemaphoreGiveRecursive(driver->mux);
+    return true;
+}
+
+bool dmx_stop_continuous(dmx_port_t dmx_num) {
+    DMX_CHECK(dmx_num < DMX_NUM_MAX, false, "dmx_num error");
+    DMX_CHECK(dmx_driver_is_installed(dmx_num), false, "driver is not installed");
+
+    dmx_driver_t *const driver = dmx_driver[dmx_num];
+
+    bool was_continuous;
+    taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+    was_continuous            = (driver->continuous.period > 0);
+    driver->continuous.period = 0;
+    driver->flags &= ~DMX_FLAGS_TIMER_IS_CONTINUOUS;
+    if (was_continuous && DMX_STATE_STATUS(DMX_STATE_LOAD(driver)) != DMX_STATUS_SENDING) {
+        dmx_timer_stop(dmx_num);  // Cancel the next DMX break
+    }
+    taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+
+    return was_continuous;
+}
+
+void dmx_continuous_resume(dmx_port_t dmx_num) {
+    assert(dmx_num < DMX_NUM_MAX);
+    assert(dmx_driver_is_installed(dmx_num));
+
+    dmx_driver_t *const driver = dmx_driver[dmx_num];
+
+    taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+    if (driver->continuous.period > 0 && driver->continuous.is_paused &&
+        DMX_STATE_STATUS(DMX_STATE_LOAD(driver)) != DMX_STATUS_SENDING) {
+        if (dmx_uart_get_rts(dmx_num) == 1) {
+            dmx_uart_set_rts(dmx_num, 0);
+        }
+        driver->continuous.is_paused    = false;
+        driver->is_controller           = true;
+        driver->dmx.size                = driver->continuous.size;
+        driver->dmx.front               = driver->dmx.data;
+        driver->dmx.last_controller_pid = 0;
+        driver->dmx.responder_sent_last = false;
+        dmx_timer_stop(dmx_num);
+        dmx_packet_start_break(dmx_num);
+    }
+    taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+}
+
 bool dmx_wait_sent(dmx_port_t dmx_num, TickType_t wait_ticks) {
+    if (DMX_IS_PARALLEL_PORT(dmx_num)) {
+        return dmx_parallel_wait_sent(dmx_num, wait_ticks);
+    }
     DMX_CHECK(dmx_num < DMX_NUM_MAX, false, "dmx_num error");
     DMX_CHECK(dmx_driver_is_installed(dmx_num), false, "driver is not installed");
 
     dmx_driver_t *const driver = dmx_driver[dmx_num];
 
+    // The mutex is only needed to block on the DMX bus when a packet is being sent
+    if (DMX_STATE_STATUS(DMX_STATE_LOAD(driver)) != DMX_STATUS_SENDING) {
+        return true;
+    }
+
     // Block until the mutex can be taken
     TimeOut_t timeout;
     vTaskSetTimeOutState(&timeout);
@@ -475,7 +1224,7 @@ bool dmx_wait_sent(dmx_port_t dmx_num, TickType_t wait_ticks) {
     if (wait_ticks > 0) {
         bool task_waiting = false;
         taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
-        if (driver->dmx.status == DMX_STATUS_SENDING) {
+        if (DMX_STATE_STATUS(DMX_STATE_LOAD(driver)) == DMX_STATUS_SENDING) {
             driver->task_waiting = xTaskGetCurrentTaskHandle();
             task_waiting         = true;
         }
@@ -487,11 +1236,7 @@ bool dmx_wait_sent(dmx_port_t dmx_num, TickType_t wait_ticks) {
             driver->task_waiting = NULL;
         }
     } else {
-        taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
-        if (driver->dmx.status == DMX_STATUS_SENDING) {
-            result = false;
-        }
-        taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+        result = DMX_STATE_STATUS(DMX_STATE_LOAD(driver)) != DMX_STATUS_SENDING;
     }
 
     // Give the mutex back and return
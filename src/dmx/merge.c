@@ -0,0 +1,361 @@
+#include "merge.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "./include/driver.h"
+#include "./include/service.h"
+
+#define DMX_MERGE_WORD_COUNT  ((DMX_PACKET_SIZE_MAX + 3) / 4)
+#define DMX_MERGE_DIRTY_COUNT ((DMX_MERGE_WORD_COUNT + 31) / 32)
+
+struct dmx_merge_source_t {
+    bool is_active;         // True if the source has been written and has not timed out.
+    uint8_t priority;       // The priority of the source.
+    TickType_t timeout;     // The number of ticks after the last write at which the source times out, or 0.
+    TickType_t last_write;  // The tick count of the last write.
+    uint32_t data[DMX_MERGE_WORD_COUNT];  // The slots of the source, packed into words so they can be merged 4 at once.
+};
+
+typedef struct dmx_merge_t {
+    uint32_t users;           // The number of callers which are using the merge stage.
+    SemaphoreHandle_t mux;    // The mutex which is taken whenever the merge stage is used.
+    dmx_merge_mode_t mode;    // The rule used to merge sources of the same priority.
+    bool hold_last_look;      // True to keep the merged packet when every source has timed out.
+    uint32_t merged;          // A bit for each active source which has the highest priority of the active sources.
+    int latest;               // The source which was written most recently, or -1.
+    struct dmx_merge_source_t *sources[DMX_MERGE_SOURCE_MAX];  // The sources, or NULL if they are not added.
+    uint8_t owner[DMX_PACKET_SIZE_MAX];    // The source which changed each slot most recently, for LTP merges.
+    uint32_t dirty[DMX_MERGE_DIRTY_COUNT];  // A bit for each word of slots which must be merged again.
+    uint32_t output[DMX_MERGE_WORD_COUNT];  // The merged packet.
+} dmx_merge_t;
+
+static uint32_t dmx_merge_max_u8x4(uint32_t a, uint32_t b) {
+    // Compare the four bytes of each word at once without letting borrows carry into the neighbouring byte
+    const uint32_t h    = 0x80808080;
+    const uint32_t x    = (a | h) - (b & ~h);                    // High bits are set where a >= b in the low 7 bits
+    const uint32_t ge   = ((a & ~b) | (~(a ^ b) & x)) & h;       // High bits are set where a >= b
+    const uint32_t mask = (ge >> 7) * 0xff;
+    return (a & mask) | (b & ~mask);
+}
+
+static void dmx_merge_set_dirty(dmx_merge_t *merge, size_t word) { merge->dirty[word / 32] |= 1u << (word % 32); }
+
+static void dmx_merge_set_all_dirty(dmx_merge_t *merge) {
+    for (int i = 0; i < DMX_MERGE_WORD_COUNT; ++i) {
+        dmx_merge_set_dirty(merge, i);
+    }
+}
+
+static void dmx_merge_update_priority(dmx_merge_t *merge) {
+    const TickType_t now = xTaskGetTickCount();
+
+    // Time out sources which have not been written and find the highest priority of the remaining sources
+    int top_priority = -1;
+    for (int i = 0; i < DMX_MERGE_SOURCE_MAX; ++i) {
+        struct dmx_merge_source_t *const source = merge->sources[i];
+        if (source == NULL || !source->is_active) {
+            continue;
+        }
+        if (source->timeout > 0 && now - source->last_write >= source->timeout) {
+            source->is_active = false;
+            continue;
+        }
+        if (source->priority > top_priority) {
+            top_priority = source->priority;
+        }
+    }
+
+    // Every slot must be merged again when the set of merged sources changes
+    uint32_t merged = 0;
+    for (int i = 0; i < DMX_MERGE_SOURCE_MAX; ++i) {
+        const struct dmx_merge_source_t *const source = merge->sources[i];
+        if (source != NULL && source->is_active && source->priority == top_priority) {
+            merged |= 1u << i;
+        }
+    }
+    if (merged != merge->merged) {
+        merge->merged = merged;
+        dmx_merge_set_all_dirty(merge);
+    }
+}
+
+static bool dmx_merge_is_merged(const dmx_merge_t *merge, int i) { return i >= 0 && (merge->merged & (1u << i)); }
+
+static void dmx_merge_commit(dmx_port_t dmx_num, dmx_merge_t *merge) {
+    if (merge->merged == 0 && merge->hold_last_look) {
+        memset(merge->dirty, 0, sizeof(merge->dirty));  // Keep sending the last merged packet
+        return;
+    }
+
+    // Find the sources which are merged
+    int merged[DMX_MERGE_SOURCE_MAX];
+    int merged_count = 0;
+    for (int i = 0; i < DMX_MERGE_SOURCE_MAX; ++i) {
+        if (dmx_merge_is_merged(merge, i)) {
+            merged[merged_count++] = i;
+        }
+    }
+
+    // Merge the dirty words only
+    int first = -1;
+    int last  = -1;
+    for (int w = 0; w < DMX_MERGE_WORD_COUNT; ++w) {
+        if (!(merge->dirty[w / 32] & (1u << (w % 32)))) {
+            continue;
+        }
+        if (merge->mode == DMX_MERGE_HTP) {
+            uint32_t word = 0;
+            for (int i = 0; i < merged_count; ++i) {
+                word = dmx_merge_max_u8x4(word, merge->sources[merged[i]]->data[w]);
+            }
+            merge->output[w] = word;
+        } else {
+            uint8_t *const output = (uint8_t *)&merge->output[w];
+            for (int b = 0; b < 4; ++b) {
+                const int slot = w * 4 + b;
+                if (slot >= DMX_PACKET_SIZE_MAX) {
+                    break;
+                }
+                // Fall back to the latest source when the source which changed the slot is not merged
+                int owner = merge->owner[slot];
+                if (!dmx_merge_is_merged(merge, owner)) {
+                    owner = merge->latest;
+                }
+                output[b] = dmx_merge_is_merged(merge, owner)
+                                ? ((uint8_t *)merge->sources[owner]->data)[slot]
+                                : 0;
+            }
+        }
+        if (first < 0) {
+            first = w;
+        }
+        last = w;
+    }
+    memset(merge->dirty, 0, sizeof(merge->dirty));
+    if (first < 0) {
+        return;
+    }
+
+    // Publish the merged slots
+    uint8_t *const output = (uint8_t *)merge->output;
+    output[0]             = DMX_SC;
+    size_t offset         = first * 4;
+    size_t size           = (last + 1) * 4 - offset;
+    if (offset + size > DMX_PACKET_SIZE_MAX) {
+        size = DMX_PACKET_SIZE_MAX - offset;
+    }
+    dmx_write_staged(dmx_num, offset, output + offset, size);
+    dmx_write_commit(dmx_num);
+}
+
+static dmx_merge_t *dmx_merge_get(dmx_port_t dmx_num) {
+    dmx_driver_t *const driver = dmx_driver[dmx_num];
+
+    // The merge stage is held by its users so that it is not freed by dmx_merge_disable() while it is used
+    dmx_merge_t *merge;
+    taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+    merge = driver->merge;
+    if (merge != NULL) {
+        __atomic_fetch_add(&merge->users, 1, __ATOMIC_ACQUIRE);
+    }
+    taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+
+    return merge;
+}
+
+static void dmx_merge_put(dmx_merge_t *merge) { __atomic_fetch_sub(&merge->users, 1, __ATOMIC_RELEASE); }
+
+bool dmx_merge_enable(dmx_port_t dmx_num, dmx_merge_mode_t mode, bool hold_last_look) {
+    DMX_CHECK(dmx_num < DMX_NUM_MAX, false, "dmx_num error");
+    DMX_CHECK(mode == DMX_MERGE_HTP || mode == DMX_MERGE_LTP, false, "mode error");
+    DMX_CHECK(dmx_driver_is_installed(dmx_num), false, "driver is not installed");
+    DMX_CHECK(!dmx_merge_is_enabled(dmx_num), false, "merge is already enabled");
+
+    dmx_driver_t *const driver = dmx_driver[dmx_num];
+
+    dmx_merge_t *merge = calloc(1, sizeof(*merge));
+    DMX_CHECK(merge != NULL, false, "merge malloc error");
+    merge->mux = xSemaphoreCreateMutex();
+    if (merge->mux == NULL) {
+        free(merge);
+        DMX_CHECK(false, false, "merge mutex malloc error");
+    }
+    merge->mode           = mode;
+    merge->hold_last_look = hold_last_look;
+    merge->latest         = -1;
+
+    taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+    driver->merge = merge;
+    taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+
+    return true;
+}
+
+bool dmx_merge_disable(dmx_port_t dmx_num) {
+    DMX_CHECK(dmx_num < DMX_NUM_MAX, false, "dmx_num error");
+    DMX_CHECK(dmx_driver_is_installed(dmx_num), false, "driver is not installed");
+
+    dmx_driver_t *const driver = dmx_driver[dmx_num];
+
+    dmx_merge_t *merge;
+    taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+    merge         = driver->merge;
+    driver->merge = NULL;
+    taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+    if (merge == NULL) {
+        return false;
+    }
+
+    // Wait for every user to leave the merge stage before freeing it
+    while (__atomic_load_n(&merge->users, __ATOMIC_ACQUIRE) > 0) {
+        vTaskDelay(1);
+    }
+    for (int i = 0; i < DMX_MERGE_SOURCE_MAX; ++i) {
+        free(merge->sources[i]);
+    }
+    vSemaphoreDelete(merge->mux);
+    free(merge);
+
+    return true;
+}
+
+bool dmx_merge_is_enabled(dmx_port_t dmx_num) {
+    DMX_CHECK(dmx_num < DMX_NUM_MAX, false, "dmx_num error");
+    DMX_CHECK(dmx_driver_is_installed(dmx_num), false, "driver is not installed");
+
+    return dmx_driver[dmx_num]->merge != NULL;
+}
+
+int dmx_merge_add_source(dmx_port_t dmx_num, uint8_t priority, uint32_t timeout_ms) {
+    DMX_CHECK(dmx_num < DMX_NUM_MAX, -1, "dmx_num error");
+    DMX_CHECK(dmx_driver_is_installed(dmx_num), -1, "driver is not installed");
+
+    dmx_merge_t *const merge = dmx_merge_get(dmx_num);
+    DMX_CHECK(merge != NULL, -1, "merge is not enabled");
+
+    struct dmx_merge_source_t *source = calloc(1, sizeof(*source));
+    if (source == NULL) {
+        dmx_merge_put(merge);
+        DMX_CHECK(false, -1, "merge source malloc error");
+    }
+    source->priority = priority;
+    source->timeout  = timeout_ms > 0 ? dmx_ms_to_ticks(timeout_ms) : 0;
+    if (timeout_ms > 0 && source->timeout == 0) {
+        source->timeout = 1;
+    }
+
+    int i;
+    xSemaphoreTake(merge->mux, portMAX_DELAY);
+    for (i = 0; i < DMX_MERGE_SOURCE_MAX; ++i) {
+        if (merge->sources[i] == NULL) {
+            merge->sources[i] = source;
+            break;
+        }
+    }
+    xSemaphoreGive(merge->mux);
+    dmx_merge_put(merge);
+    if (i == DMX_MERGE_SOURCE_MAX) {
+        free(source);
+        DMX_CHECK(false, -1, "no more merge sources");
+    }
+
+    return i;
+}
+
+bool dmx_merge_remove_source(dmx_port_t dmx_num, int source) {
+    DMX_CHECK(dmx_num < DMX_NUM_MAX, false, "dmx_num error");
+    DMX_CHECK(source >= 0 && source < DMX_MERGE_SOURCE_MAX, false, "source error");
+    DMX_CHECK(dmx_driver_is_installed(dmx_num), false, "driver is not installed");
+
+    dmx_merge_t *const merge = dmx_merge_get(dmx_num);
+    DMX_CHECK(merge != NULL, false, "merge is not enabled");
+
+    xSemaphoreTake(merge->mux, portMAX_DELAY);
+    struct dmx_merge_source_t *const removed = merge->sources[source];
+    merge->sources[source]                   = NULL;
+    if (merge->latest == source) {
+        merge->latest = -1;
+    }
+    dmx_merge_update_priority(merge);
+    dmx_merge_commit(dmx_num, merge);
+    xSemaphoreGive(merge->mux);
+    dmx_merge_put(merge);
+    free(removed);
+
+    return removed != NULL;
+}
+
+size_t dmx_merge_write(dmx_port_t dmx_num, int source, size_t offset, const void *data, size_t size) {
+    DMX_CHECK(dmx_num < DMX_NUM_MAX, 0, "dmx_num error");
+    DMX_CHECK(source >= 0 && source < DMX_MERGE_SOURCE_MAX, 0, "source error");
+    DMX_CHECK(offset < DMX_PACKET_SIZE_MAX, 0, "offset error");
+    DMX_CHECK(data != NULL, 0, "data is null");
+    DMX_CHECK(dmx_driver_is_installed(dmx_num), 0, "driver is not installed");
+
+    // Clamp size to the maximum DMX packet size
+    if (size + offset > DMX_PACKET_SIZE_MAX) {
+        size = DMX_PACKET_SIZE_MAX - offset;
+    } else if (size == 0) {
+        return 0;
+    }
+
+    dmx_merge_t *const merge = dmx_merge_get(dmx_num);
+    DMX_CHECK(merge != NULL, 0, "merge is not enabled");
+
+    xSemaphoreTake(merge->mux, portMAX_DELAY);
+    struct dmx_merge_source_t *const src = merge->sources[source];
+    if (src == NULL) {
+        xSemaphoreGive(merge->mux);
+        dmx_merge_put(merge);
+        DMX_CHECK(false, 0, "source is not added");
+    }
+    src->last_write = xTaskGetTickCount();
+    src->is_active  = true;
+    merge->latest   = source;
+
+    // Compare the source a word at a time so that only words with changed slots are merged again
+    const uint8_t *source_data = data;
+    const size_t end           = offset + size;
+    for (size_t w = offset / 4; w * 4 < end; ++w) {
+        const size_t first = w * 4 > offset ? w * 4 : offset;
+        const size_t last  = (w + 1) * 4 < end ? (w + 1) * 4 : end;
+        uint32_t word      = src->data[w];
+        memcpy((uint8_t *)&word + (first - w * 4), source_data + (first - offset), last - first);
+        if (word == src->data[w]) {
+            continue;
+        }
+        if (merge->mode == DMX_MERGE_LTP) {
+            for (size_t slot = first; slot < last; ++slot) {
+                if (((uint8_t *)&word)[slot - w * 4] != ((uint8_t *)&src->data[w])[slot - w * 4]) {
+                    merge->owner[slot] = source;
+                }
+            }
+        }
+        src->data[w] = word;
+        dmx_merge_set_dirty(merge, w);
+    }
+
+    dmx_merge_update_priority(merge);
+    dmx_merge_commit(dmx_num, merge);
+    xSemaphoreGive(merge->mux);
+    dmx_merge_put(merge);
+
+    return size;
+}
+
+bool dmx_merge_update(dmx_port_t dmx_num) {
+    DMX_CHECK(dmx_num < DMX_NUM_MAX, false, "dmx_num error");
+    DMX_CHECK(dmx_driver_is_installed(dmx_num), false, "driver is not installed");
+
+    dmx_merge_t *const merge = dmx_merge_get(dmx_num);
+    DMX_CHECK(merge != NULL, false, "merge is not enabled");
+
+    xSemaphoreTake(merge->mux, portMAX_DELAY);
+    dmx_merge_update_priority(merge);
+    dmx_merge_commit(dmx_num, merge);
+    xSemaphoreGive(merge->mux);
+    dmx_merge_put(merge);
+
+    return true;
+}
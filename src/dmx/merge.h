@@ -0,0 +1,126 @@
+/**
+ * @file dmx/merge.h
+ * @author Mitch Weisbrod (mitch@theweisbrods.com)
+ * @brief This file contains functions which allow several DMX sources, such as
+ * DMX ports or network universes, to be merged into the packet which is sent
+ * on a DMX port.
+ */
+#pragma once
+
+#include "./include/types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @brief The maximum number of sources which may be merged on a DMX port.*/
+#define DMX_MERGE_SOURCE_MAX (8)
+
+/** @brief A merge source timeout which indicates that the source never times
+ * out.*/
+#define DMX_MERGE_TIMEOUT_NONE (0)
+
+/** @brief The rules used to merge the slots of several DMX sources.*/
+typedef enum dmx_merge_mode_t {
+  /** @brief Highest takes precedence. Each slot is sent with the highest value
+   * of any source.*/
+  DMX_MERGE_HTP,
+  /** @brief Latest takes precedence. Each slot is sent with the value of the
+   * source which changed it most recently.*/
+  DMX_MERGE_LTP,
+} dmx_merge_mode_t;
+
+/**
+ * @brief Enables the merge stage of a DMX port. Once enabled, the DMX packets
+ * which are sent on the DMX port are merged from the sources which are added
+ * with dmx_merge_add_source(). Merged slots are written with
+ * dmx_write_staged() and dmx_write_commit(), so each DMX packet which is sent
+ * is internally consistent.
+ *
+ * @param dmx_num The DMX port number.
+ * @param mode The rule used to merge the sources which have the highest
+ * priority.
+ * @param hold_last_look True to keep sending the last merged packet when every
+ * source has timed out, or false to send zeros.
+ * @return true if the merge stage was enabled.
+ * @return false on failure.
+ */
+bool dmx_merge_enable(dmx_port_t dmx_num, dmx_merge_mode_t mode,
+                      bool hold_last_look);
+
+/**
+ * @brief Disables the merge stage of a DMX port and removes its sources. The
+ * last merged packet stays in the DMX buffer. This function blocks until every
+ * merge function which is using the merge stage on another task has returned.
+ *
+ * @param dmx_num The DMX port number.
+ * @return true if the merge stage was disabled.
+ * @return false if it was not enabled.
+ */
+bool dmx_merge_disable(dmx_port_t dmx_num);
+
+/**
+ * @brief Checks if the merge stage of a DMX port is enabled.
+ *
+ * @param dmx_num The DMX port number.
+ * @return true if the merge stage is enabled.
+ * @return false if it is not.
+ */
+bool dmx_merge_is_enabled(dmx_port_t dmx_num);
+
+/**
+ * @brief Adds a source to the merge stage of a DMX port. Only the sources with
+ * the highest priority of the sources which have not timed out are merged. A
+ * source does not take part in the merge until it is first written.
+ *
+ * @param dmx_num The DMX port number.
+ * @param priority The priority of the source. Higher values take precedence.
+ * @param timeout_ms The number of milliseconds after the last write at which
+ * the source times out, or DMX_MERGE_TIMEOUT_NONE.
+ * @return The source number which is passed to dmx_merge_write(), or -1 on
+ * failure.
+ */
+int dmx_merge_add_source(dmx_port_t dmx_num, uint8_t priority,
+                         uint32_t timeout_ms);
+
+/**
+ * @brief Removes a source from the merge stage of a DMX port.
+ *
+ * @param dmx_num The DMX port number.
+ * @param source The source number returned by dmx_merge_add_source().
+ * @return true if the source was removed.
+ * @return false on failure.
+ */
+bool dmx_merge_remove_source(dmx_port_t dmx_num, int source);
+
+/**
+ * @brief Writes data from a merge source and merges it into the DMX packet of
+ * the DMX port. Only the slots which changed are merged. Received DMX data can
+ * be written without being copied using dmx_receive_lease().
+ *
+ * @param dmx_num The DMX port number.
+ * @param source The source number returned by dmx_merge_add_source().
+ * @param offset The number of slots with which to offset the write. Slot 0 is
+ * the start code, which is not merged.
+ * @param[in] data The data to write from the source.
+ * @param size The size of the data.
+ * @return The number of slots which were written.
+ */
+size_t dmx_merge_write(dmx_port_t dmx_num, int source, size_t offset,
+                       const void *data, size_t size);
+
+/**
+ * @brief Checks the sources of the merge stage of a DMX port for timeouts and
+ * merges the DMX packet again if a source timed out. Sources are also checked
+ * on each call to dmx_merge_write(). This function should be called
+ * periodically if the sources might stop being written.
+ *
+ * @param dmx_num The DMX port number.
+ * @return true if the merge stage is enabled.
+ * @return false if it is not.
+ */
+bool dmx_merge_update(dmx_port_t dmx_num);
+
+#ifdef __cplusplus
+}
+#endif
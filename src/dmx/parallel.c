@@ -0,0 +1,339 @@
+#include "parallel.h"
+
+#include <string.h>
+
+#include "./hal/include/lcd.h"
+#include "./include/driver.h"
+#include "./include/service.h"
+
+#ifdef CONFIG_DMX_PARALLEL
+
+#include "esp_heap_caps.h"
+
+// One sample of the LCD bus is one DMX bit
+#define DMX_PARALLEL_CLOCK_HZ (DMX_BAUD_RATE)
+#define DMX_PARALLEL_BIT_LEN_US (4)
+// A start bit, 8 data bits, and 2 stop bits
+#define DMX_PARALLEL_SLOT_BITS (11)
+// The longest DMX break and mark-after-break which may be encoded
+#define DMX_PARALLEL_BREAK_LEN_MAX_US (DMX_BREAK_LEN_US * 4)
+#define DMX_PARALLEL_MAB_LEN_MAX_US (DMX_MAB_LEN_US * 16)
+// The number of frames which are allocated so that one may be encoded while another is sent
+#define DMX_PARALLEL_FRAME_COUNT (2)
+
+static struct dmx_parallel_t {
+    SemaphoreHandle_t mux;  // The mutex which is taken to write or send parallel DMX ports.
+    int port_count;         // The number of parallel DMX ports.
+    size_t sample_size;     // The size in bytes of one sample of the LCD bus.
+    int break_samples;      // The number of samples of the DMX break.
+    int mab_samples;        // The number of samples of the mark-after-break.
+    uint16_t spare_lanes;   // The lanes of the LCD bus which are not used by a parallel DMX port.
+    struct dmx_parallel_frame_t {
+        uint8_t *buf;            // The DMA buffer into which the frame is encoded.
+        uint32_t ports;          // A mask of the parallel DMX ports which are being sent in the frame.
+        SemaphoreHandle_t done;  // Given when the frame is not being sent.
+    } frames[DMX_PARALLEL_FRAME_COUNT];
+    int next_frame;                                           // The frame which is encoded next.
+    int done_frame;                                           // The frame which is finished next.
+    uint8_t data[DMX_PARALLEL_NUM_MAX][DMX_PACKET_SIZE_MAX];  // The slots which were written to each port.
+} *dmx_parallel = NULL;
+static portMUX_TYPE dmx_parallel_spinlock = DMX_SPINLOCK_INIT;
+
+static bool DMX_ISR_ATTR dmx_parallel_frame_done(void *context) {
+    struct dmx_parallel_t *const parallel = (struct dmx_parallel_t *)context;
+    struct dmx_parallel_frame_t *const frame = &parallel->frames[parallel->done_frame];
+
+    // Frames are finished in the order in which they were written
+    taskENTER_CRITICAL_ISR(&dmx_parallel_spinlock);
+    frame->ports         = 0;
+    parallel->done_frame = (parallel->done_frame + 1) % DMX_PARALLEL_FRAME_COUNT;
+    taskEXIT_CRITICAL_ISR(&dmx_parallel_spinlock);
+
+    BaseType_t task_awoken = pdFALSE;
+    xSemaphoreGiveFromISR(frame->done, &task_awoken);
+    return task_awoken == pdTRUE;
+}
+
+static size_t dmx_parallel_get_frame_size(const struct dmx_parallel_t *parallel, size_t packet_size) {
+    const size_t samples = parallel->break_samples + parallel->mab_samples + packet_size * DMX_PARALLEL_SLOT_BITS;
+    return samples * parallel->sample_size;
+}
+
+static inline void dmx_parallel_put(const struct dmx_parallel_t *parallel, uint8_t **sample, uint16_t lanes) {
+    // Spare lanes share the pin of the last port so they must carry the same level
+    const uint16_t last_lane = 1u << (parallel->port_count - 1);
+    lanes = (lanes & last_lane) ? (lanes | parallel->spare_lanes) : (lanes & ~parallel->spare_lanes);
+
+    // Each bit of a sample is the level of one parallel DMX port
+    if (parallel->sample_size == sizeof(uint8_t)) {
+        **sample = lanes;
+    } else {
+        memcpy(*sample, &lanes, sizeof(lanes));
+    }
+    *sample += parallel->sample_size;
+}
+
+static size_t dmx_parallel_encode(const struct dmx_parallel_t *parallel, uint8_t *buf, uint32_t ports,
+                                  size_t packet_size) {
+    uint8_t *sample = buf;
+
+    // Ports which are not being sent stay at a mark
+    for (int i = 0; i < parallel->break_samples; ++i) {
+        dmx_parallel_put(parallel, &sample, ~ports);
+    }
+    for (int i = 0; i < parallel->mab_samples; ++i) {
+        dmx_parallel_put(parallel, &sample, 0xffff);
+    }
+
+    for (size_t slot = 0; slot < packet_size; ++slot) {
+        dmx_parallel_put(parallel, &sample, ~ports);  // Start bit
+        for (int bit = 0; bit < 8; ++bit) {
+            uint16_t lanes = ~ports;
+            for (int n = 0; n < parallel->port_count; ++n) {
+                if ((ports & (1u << n)) && (parallel->data[n][slot] & (1u << bit))) {
+                    lanes |= 1u << n;  // DMX slots are sent least significant bit first
+                }
+            }
+            dmx_parallel_put(parallel, &sample, lanes);
+        }
+        dmx_parallel_put(parallel, &sample, 0xffff);  // Stop bits
+        dmx_parallel_put(parallel, &sample, 0xffff);
+    }
+
+    return sample - buf;
+}
+
+bool dmx_parallel_install(const dmx_parallel_config_t *config) {
+    DMX_CHECK(config != NULL, false, "config is null");
+    DMX_CHECK(config->port_count > 0 && config->port_count <= DMX_PARALLEL_NUM_MAX, false, "port_count error");
+    for (int i = 0; i < config->port_count; ++i) {
+        DMX_CHECK(GPIO_IS_VALID_OUTPUT_GPIO(config->tx_pins[i]), false, "tx_pin error");
+    }
+    DMX_CHECK(GPIO_IS_VALID_OUTPUT_GPIO(config->clock_pin), false, "clock_pin error");
+    DMX_CHECK(GPIO_IS_VALID_OUTPUT_GPIO(config->dc_pin), false, "dc_pin error");
+    DMX_CHECK(config->break_len >= DMX_BREAK_LEN_MIN_US && config->break_len <= DMX_PARALLEL_BREAK_LEN_MAX_US, false,
+              "break_len error");
+    DMX_CHECK(config->mab_len >= DMX_MAB_LEN_MIN_US && config->mab_len <= DMX_PARALLEL_MAB_LEN_MAX_US, false,
+              "mab_len error");
+    DMX_CHECK(dmx_parallel == NULL, false, "parallel ports are already installed");
+
+    struct dmx_parallel_t *parallel = heap_caps_calloc(1, sizeof(*parallel), MALLOC_CAP_8BIT);
+    DMX_CHECK(parallel != NULL, false, "parallel malloc error");
+
+    // The LCD bus is 8 or 16 bits wide so spare lanes are also routed to the pin of the last port
+    const int pin_count     = config->port_count > 8 ? 16 : 8;
+    parallel->port_count    = config->port_count;
+    parallel->sample_size   = pin_count / 8;
+    parallel->break_samples = (config->break_len + DMX_PARALLEL_BIT_LEN_US - 1) / DMX_PARALLEL_BIT_LEN_US;
+    parallel->mab_samples   = (config->mab_len + DMX_PARALLEL_BIT_LEN_US - 1) / DMX_PARALLEL_BIT_LEN_US;
+    parallel->spare_lanes   = ((1u << pin_count) - 1) & ~((1u << config->port_count) - 1);
+    int pins[DMX_PARALLEL_NUM_MAX];
+    for (int i = 0; i < pin_count; ++i) {
+        pins[i] = config->tx_pins[i < config->port_count ? i : config->port_count - 1];
+    }
+
+    const size_t frame_size = dmx_parallel_get_frame_size(parallel, DMX_PACKET_SIZE_MAX);
+    bool success            = (parallel->mux = xSemaphoreCreateRecursiveMutex()) != NULL;
+    for (int i = 0; success && i < DMX_PARALLEL_FRAME_COUNT; ++i) {
+        struct dmx_parallel_frame_t *const frame = &parallel->frames[i];
+        frame->buf  = heap_caps_malloc(frame_size, MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL);
+        frame->done = xSemaphoreCreateBinary();
+        success     = frame->buf != NULL && frame->done != NULL;
+        if (success) {
+            xSemaphoreGive(frame->done);
+        }
+    }
+    if (success) {
+        success = dmx_lcd_init(pins, pin_count, config->clock_pin, config->dc_pin, DMX_PARALLEL_CLOCK_HZ, frame_size,
+                               dmx_parallel_frame_done, parallel);
+    }
+    if (!success) {
+        for (int i = 0; i < DMX_PARALLEL_FRAME_COUNT; ++i) {
+            if (parallel->frames[i].done != NULL) {
+                vSemaphoreDelete(parallel->frames[i].done);
+            }
+            heap_caps_free(parallel->frames[i].buf);
+        }
+        if (parallel->mux != NULL) {
+            vSemaphoreDelete(parallel->mux);
+        }
+        heap_caps_free(parallel);
+        DMX_CHECK(false, false, "parallel bus init error");
+    }
+
+    // Parallel DMX ports begin with a null start code and all slots at 0
+    dmx_parallel = parallel;
+
+    return true;
+}
+
+bool dmx_parallel_delete() {
+    struct dmx_parallel_t *const parallel = dmx_parallel;
+    if (parallel == NULL) {
+        return false;
+    }
+
+    xSemaphoreTakeRecursive(parallel->mux, portMAX_DELAY);
+    dmx_parallel = NULL;
+    xSemaphoreGiveRecursive(parallel->mux);
+
+    dmx_lcd_deinit();  // Waits for the frames which are being sent to finish
+    for (int i = 0; i < DMX_PARALLEL_FRAME_COUNT; ++i) {
+        vSemaphoreDelete(parallel->frames[i].done);
+        heap_caps_free(parallel->frames[i].buf);
+    }
+    vSemaphoreDelete(parallel->mux);
+    heap_caps_free(parallel);
+
+    return true;
+}
+
+bool dmx_parallel_is_installed() { return dmx_parallel != NULL; }
+
+size_t dmx_parallel_write(dmx_port_t dmx_num, size_t offset, const void *source, size_t size) {
+    DMX_CHECK(offset < DMX_PACKET_SIZE_MAX, 0, "offset error");
+    DMX_CHECK(source, 0, "source is null");
+    struct dmx_parallel_t *const parallel = dmx_parallel;
+    DMX_CHECK(parallel != NULL && dmx_num - DMX_NUM_MAX < parallel->port_count, 0, "parallel port is not installed");
+
+    // Clamp size to the maximum DMX packet size
+    if (size + offset > DMX_PACKET_SIZE_MAX) {
+        size = DMX_PACKET_SIZE_MAX - offset;
+    } else if (size == 0) {
+        return 0;
+    }
+
+    // Slots are encoded from this buffer so frames which are being sent are not affected
+    xSemaphoreTakeRecursive(parallel->mux, portMAX_DELAY);
+    memcpy(&parallel->data[dmx_num - DMX_NUM_MAX][offset], source, size);
+    xSemaphoreGiveRecursive(parallel->mux);
+
+    return size;
+}
+
+size_t dmx_parallel_read(dmx_port_t dmx_num, size_t offset, void *destination, size_t size) {
+    DMX_CHECK(offset < DMX_PACKET_SIZE_MAX, 0, "offset error");
+    DMX_CHECK(destination, 0, "destination is null");
+    struct dmx_parallel_t *const parallel = dmx_parallel;
+    DMX_CHECK(parallel != NULL && dmx_num - DMX_NUM_MAX < parallel->port_count, 0, "parallel port is not installed");
+
+    // Clamp size to the maximum DMX packet size
+    if (size + offset > DMX_PACKET_SIZE_MAX) {
+        size = DMX_PACKET_SIZE_MAX - offset;
+    } else if (size == 0) {
+        return 0;
+    }
+
+    xSemaphoreTakeRecursive(parallel->mux, portMAX_DELAY);
+    memcpy(destination, &parallel->data[dmx_num - DMX_NUM_MAX][offset], size);
+    xSemaphoreGiveRecursive(parallel->mux);
+
+    return size;
+}
+
+size_t dmx_parallel_send(const dmx_port_t *ports, size_t n, size_t size) {
+    struct dmx_parallel_t *const parallel = dmx_parallel;
+    DMX_CHECK(parallel != NULL, 0, "parallel ports are not installed");
+    DMX_CHECK(n > 0 && n <= parallel->port_count, 0, "n error");
+    uint32_t port_mask = 0;
+    for (int i = 0; i < n; ++i) {
+        DMX_CHECK(ports[i] >= DMX_NUM_MAX && ports[i] - DMX_NUM_MAX < parallel->port_count, 0,
+                  "parallel port is not installed");
+        DMX_CHECK(!(port_mask & (1u << (ports[i] - DMX_NUM_MAX))), 0, "dmx_num is duplicated");
+        port_mask |= 1u << (ports[i] - DMX_NUM_MAX);
+    }
+
+    if (size == 0 || size > DMX_PACKET_SIZE_MAX) {
+        size = DMX_PACKET_SIZE_MAX;
+    }
+
+    // Block until the mutex can be taken
+    if (!xSemaphoreTakeRecursive(parallel->mux, 0)) {
+        return 0;
+    }
+
+    // Block until the frame has finished being sent, which may take two packets if both frames are queued
+    struct dmx_parallel_frame_t *const frame = &parallel->frames[parallel->next_frame];
+    if (!xSemaphoreTake(frame->done, dmx_ms_to_ticks(46))) {
+        xSemaphoreGiveRecursive(parallel->mux);
+        return 0;
+    }
+
+    // Every port in the frame is sent with the same packet size
+    const size_t frame_size = dmx_parallel_encode(parallel, frame->buf, port_mask, size);
+
+    taskENTER_CRITICAL(&dmx_parallel_spinlock);
+    frame->ports = port_mask;
+    taskEXIT_CRITICAL(&dmx_parallel_spinlock);
+    if (!dmx_lcd_write(frame->buf, frame_size)) {
+        taskENTER_CRITICAL(&dmx_parallel_spinlock);
+        frame->ports = 0;
+        taskEXIT_CRITICAL(&dmx_parallel_spinlock);
+        xSemaphoreGive(frame->done);
+        xSemaphoreGiveRecursive(parallel->mux);
+        return 0;
+    }
+    parallel->next_frame = (parallel->next_frame + 1) % DMX_PARALLEL_FRAME_COUNT;
+
+    xSemaphoreGiveRecursive(parallel->mux);
+
+    return size;
+}
+
+bool dmx_parallel_wait_sent(dmx_port_t dmx_num, TickType_t wait_ticks) {
+    struct dmx_parallel_t *const parallel = dmx_parallel;
+    DMX_CHECK(parallel != NULL && dmx_num - DMX_NUM_MAX < parallel->port_count, false,
+              "parallel port is not installed");
+
+    const uint32_t port_bit = 1u << (dmx_num - DMX_NUM_MAX);
+    TimeOut_t timeout;
+    vTaskSetTimeOutState(&timeout);
+    for (int i = 0; i < DMX_PARALLEL_FRAME_COUNT; ++i) {
+        struct dmx_parallel_frame_t *const frame = &parallel->frames[i];
+
+        bool is_sending;
+        taskENTER_CRITICAL(&dmx_parallel_spinlock);
+        is_sending = frame->ports & port_bit;
+        taskEXIT_CRITICAL(&dmx_parallel_spinlock);
+        if (!is_sending) {
+            continue;
+        }
+
+        // The semaphore is given back so that the frame may be encoded again
+        if (wait_ticks == 0 || xTaskCheckForTimeOut(&timeout, &wait_ticks) ||
+            !xSemaphoreTake(frame->done, wait_ticks)) {
+            return false;
+        }
+        xSemaphoreGive(frame->done);
+    }
+
+    return true;
+}
+
+#else
+
+bool dmx_parallel_install(const dmx_parallel_config_t *config) {
+    DMX_CHECK(false, false, "CONFIG_DMX_PARALLEL is not enabled");
+}
+
+bool dmx_parallel_delete() { return false; }
+
+bool dmx_parallel_is_installed() { return false; }
+
+size_t dmx_parallel_write(dmx_port_t dmx_num, size_t offset, const void *source, size_t size) {
+    DMX_CHECK(false, 0, "CONFIG_DMX_PARALLEL is not enabled");
+}
+
+size_t dmx_parallel_read(dmx_port_t dmx_num, size_t offset, void *destination, size_t size) {
+    DMX_CHECK(false, 0, "CONFIG_DMX_PARALLEL is not enabled");
+}
+
+size_t dmx_parallel_send(const dmx_port_t *ports, size_t n, size_t size) {
+    DMX_CHECK(false, 0, "CONFIG_DMX_PARALLEL is not enabled");
+}
+
+bool dmx_parallel_wait_sent(dmx_port_t dmx_num, TickType_t wait_ticks) {
+    DMX_CHECK(false, false, "CONFIG_DMX_PARALLEL is not enabled");
+}
+
+#endif
@@ -0,0 +1,86 @@
+/**
+ * @file dmx/parallel.h
+ * @author Mitch Weisbrod (mitch@theweisbrods.com)
+ * @brief This file contains functions which allow many transmit-only DMX ports
+ * to be driven from a single parallel LCD bus. Each DMX port is one data pin
+ * of the bus. DMX packets, including their DMX breaks and mark-after-breaks,
+ * are encoded into a DMA buffer with one bit per DMX port per sample so that
+ * every parallel DMX port is sent at the same time. Parallel DMX ports are
+ * only available when CONFIG_DMX_PARALLEL is enabled.
+ */
+#pragma once
+
+#include "./include/types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @brief The maximum number of parallel DMX ports.*/
+#define DMX_PARALLEL_NUM_MAX (16)
+
+/** @brief Gets the DMX port number of a parallel DMX port. Parallel DMX ports
+ * are numbered after the UART DMX ports so that they may be passed to
+ * dmx_write(), dmx_send(), and the other functions which write and send DMX.*/
+#define DMX_PARALLEL_NUM(n) ((dmx_port_t)(DMX_NUM_MAX + (n)))
+
+/** @brief The configuration of the parallel DMX ports.*/
+typedef struct dmx_parallel_config_t {
+  /** @brief The number of parallel DMX ports. Must be between 1 and
+     DMX_PARALLEL_NUM_MAX.*/
+  int port_count;
+  /** @brief The GPIO numbers of the transmit pins of the parallel DMX ports.
+     Element n is the pin of DMX_PARALLEL_NUM(n).*/
+  int tx_pins[DMX_PARALLEL_NUM_MAX];
+  /** @brief The GPIO number of the pixel clock of the LCD bus. It must be a
+     free GPIO but need not be connected.*/
+  int clock_pin;
+  /** @brief The GPIO number of the data/command pin of the LCD bus. It must
+     be a free GPIO but need not be connected.*/
+  int dc_pin;
+  /** @brief The length of the DMX break in microseconds. It is rounded up to
+     a multiple of the 4 microsecond length of a DMX bit.*/
+  uint32_t break_len;
+  /** @brief The length of the DMX mark-after-break in microseconds. It is
+     rounded up to a multiple of the 4 microsecond length of a DMX bit.*/
+  uint32_t mab_len;
+} dmx_parallel_config_t;
+
+/**
+ * @brief Installs the parallel DMX ports. Parallel DMX ports only transmit
+ * DMX. A packet is written with dmx_write() and is sent with dmx_send() just
+ * like a UART DMX port, using the port number DMX_PARALLEL_NUM(n). To send
+ * several parallel DMX ports in the same frame, use dmx_send_group(). Parallel
+ * DMX ports may not be grouped with UART DMX ports. Parallel DMX ports which
+ * are not being sent idle at a mark.
+ *
+ * @note Two DMA buffers of up to 6 kilobytes each, or 12 kilobytes each when
+ * more than 8 parallel DMX ports are used, are allocated so that the next frame
+ * may be encoded while the last one is sent.
+ *
+ * @param[in] config A pointer to the configuration of the parallel DMX ports.
+ * @return true if the parallel DMX ports were installed.
+ * @return false on failure.
+ */
+bool dmx_parallel_install(const dmx_parallel_config_t *config);
+
+/**
+ * @brief Deletes the parallel DMX ports. Frames which are being sent are
+ * allowed to finish.
+ *
+ * @return true if the parallel DMX ports were deleted.
+ * @return false if they were not installed.
+ */
+bool dmx_parallel_delete();
+
+/**
+ * @brief Checks if the parallel DMX ports are installed.
+ *
+ * @return true if the parallel DMX ports are installed.
+ * @return false if they are not.
+ */
+bool dmx_parallel_is_installed();
+
+#ifdef __cplusplus
+}
+#endif
@@ -11,16 +11,13 @@ int dmx_sub_device_get_count(dmx_port_t dmx_num) {
     assert(dmx_num < DMX_NUM_MAX);
     assert(dmx_driver_is_installed(dmx_num));
 
-    dmx_driver_t *const driver = dmx_driver[dmx_num];
-
-    int count            = -1;  // Don't count root device
-    dmx_device_t *device = &driver->device.root;
-    do {
-        ++count;
-        device = device->next;
-    } while (device != NULL);
+#ifndef CONFIG_RDM_RESPONDER_DISABLE
+    if (rdm_virtual_get_active(dmx_num) != NULL) {
+        return 0;  // Virtual responders have no sub-devices
+    }
+#endif
 
-    return count;
+    return dmx_driver[dmx_num]->device.sub_devices.count;
 }
 
 bool dmx_sub_device_exists(dmx_port_t dmx_num, dmx_device_num_t device_num) {
@@ -50,18 +47,15 @@ rdm_pid_t dmx_parameter_at(dmx_port_t dmx_num, rdm_sub_device_t sub_device, uint
     dmx_driver_t *const driver = dmx_driver[dmx_num];
 
     // Return early if the parameter index is out of bounds
-    if ((sub_device == RDM_SUB_DEVICE_ROOT && index > driver->device.parameter_count.root) ||
-        (sub_device > RDM_SUB_DEVICE_ROOT && index > driver->device.parameter_count.sub_devices)) {
+    if ((sub_device == RDM_SUB_DEVICE_ROOT && index >= driver->device.parameter_count.root) ||
+        (sub_device > RDM_SUB_DEVICE_ROOT && index >= driver->device.parameter_count.sub_devices)) {
         return 0;
     }
 
     // Find the desired sub-device number
-    dmx_device_t *device = &driver->device.root;
-    while (device->num != sub_device) {
-        device = device->next;
-        if (device == NULL) {
-            return 0;  // Sub-device does not exist
-        }
+    const dmx_device_t *device = dmx_device_get(dmx_num, sub_device);
+    if (device == NULL) {
+        return 0;  // Sub-device does not exist
     }
 
     return device->parameters[index].pid;
@@ -93,7 +87,7 @@ void *dmx_parameter_get_data(dmx_port_t dmx_num, rdm_sub_device_t sub_device, rd
         return NULL;
     }
 
-    return entry->data;
+    return dmx_parameter_get_value(dmx_num, sub_device, entry);
 }
 
 size_t dmx_parameter_copy(dmx_port_t dmx_num, rdm_sub_device_t sub_device, rdm_pid_t pid, void *destination,
@@ -115,8 +109,9 @@ size_t dmx_parameter_copy(dmx_port_t dmx_num, rdm_sub_device_t sub_device, rdm_p
     }
 
     // Copy the parameter
+    const void *value = dmx_parameter_get_value(dmx_num, sub_device, entry);
     taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
-    memcpy(destination, entry->data, size);
+    memcpy(destination, value, size);
     taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
 
     return size;
@@ -138,7 +133,8 @@ size_t dmx_parameter_set(dmx_port_t dmx_num, rdm_sub_device_t sub_device, rdm_pi
     if (entry == NULL) {
         return 0;
     }
-    assert(entry->data != NULL);
+    void *const value = dmx_parameter_get_value(dmx_num, sub_device, entry);
+    assert(value != NULL);
 
     // Clamp the write size to the definition size
     if (size > entry->size) {
@@ -146,16 +142,73 @@ size_t dmx_parameter_set(dmx_port_t dmx_num, rdm_sub_device_t sub_device, rdm_pi
     }
 
     taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
-    memcpy(entry->data, source, size);
-    if (entry->type == DMX_PARAMETER_TYPE_NON_VOLATILE) {
-        entry->type = DMX_PARAMETER_TYPE_NON_VOLATILE_STAGED;
-        ++dmx_driver[dmx_num]->device.parameter_count.staged;
+    memcpy(value, source, size);
+    dmx_parameter_stage(dmx_num, sub_device, entry);
+    ++dmx_driver[dmx_num]->device.generation;  // Invalidate cached RDM responses
+    if (sub_device == RDM_SUB_DEVICE_ROOT && (pid == RDM_PID_DMX_START_ADDRESS || pid == RDM_PID_DMX_PERSONALITY)) {
+        ++dmx_driver[dmx_num]->device.footprint.version;  // Invalidate the cached footprint
     }
     taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
 
     return size;
 }
 
+size_t dmx_parameter_set_all(dmx_port_t dmx_num, rdm_pid_t pid, const void *source, size_t size) {
+    assert(dmx_num < DMX_NUM_MAX);
+    assert(pid > 0);
+    assert(dmx_driver_is_installed(dmx_num));
+
+    dmx_driver_t *const driver = dmx_driver[dmx_num];
+
+    // Return early if there is nothing to write
+    if (source == NULL || size == 0) {
+        return 0;
+    }
+
+    // The root device does not share its parameters with sub-devices
+    size_t written = dmx_parameter_set(dmx_num, RDM_SUB_DEVICE_ROOT, pid, source, size);
+
+    // Only parameters with a value per sub-device can be set on each sub-device
+    dmx_parameter_t *const entry = dmx_parameter_get_shared_entry(dmx_num, pid);
+    if (entry == NULL ||
+        (entry->type != DMX_PARAMETER_TYPE_DYNAMIC && entry->type != DMX_PARAMETER_TYPE_NON_VOLATILE)) {
+        return written;
+    }
+
+    // Clamp the write size to the definition size
+    if (size > entry->size) {
+        size = entry->size;
+    }
+
+    // Visit only the pages of the sub-device table which have been allocated
+    struct dmx_driver_sub_devices_t *const sub_devices = &driver->device.sub_devices;
+    for (int p = 0; p < DMX_SUB_DEVICE_PAGE_COUNT; ++p) {
+        uint8_t **const page = sub_devices->pages[p];
+        if (page == NULL) {
+            continue;
+        }
+        taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+        for (int j = 0; j < DMX_SUB_DEVICE_PAGE_SIZE; ++j) {
+            if (page[j] != NULL) {
+                memcpy(page[j] + entry->offset, source, size);
+                written = size;
+            }
+        }
+        taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+    }
+
+    // Stage every sub-device at once so they are committed together
+    taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+    if (entry->type == DMX_PARAMETER_TYPE_NON_VOLATILE && !entry->is_staged_all) {
+        entry->is_staged_all = true;
+        ++driver->device.parameter_count.staged;
+    }
+    ++driver->device.generation;  // Invalidate cached RDM responses
+    taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+
+    return written;
+}
+
 rdm_pid_t dmx_parameter_commit(dmx_port_t dmx_num) {
     assert(dmx_num < DMX_NUM_MAX);
     assert(dmx_driver_is_installed(dmx_num));
@@ -171,26 +224,204 @@ rdm_pid_t dmx_parameter_commit(dmx_port_t dmx_num) {
     rdm_pid_t pid = 0;
     void *data    = NULL;
 
-    // Iterate through parameters and commit the first found value to NVS
+    // Iterate through the root device parameters and commit the first found value to NVS
     dmx_device_t *device = &driver->device.root;
-    for (; device != NULL && pid == 0; device = device->next) {
+    taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+    for (int i = 0; i < driver->device.parameter_count.root; ++i) {
+        if (device->parameters[i].type == DMX_PARAMETER_TYPE_NON_VOLATILE_STAGED) {
+            device->parameters[i].type = DMX_PARAMETER_TYPE_NON_VOLATILE;
+            --driver->device.parameter_count.staged;
+            sub_device = RDM_SUB_DEVICE_ROOT;
+            pid        = device->parameters[i].pid;
+            data       = device->parameters[i].data;
+            break;
+        }
+    }
+    taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+
+    // Commit sub-device parameters which were staged on every sub-device at once
+    bool is_batch = false;
+    device        = driver->device.sub_devices.table;
+    for (int i = 0; i < driver->device.parameter_count.sub_devices && device != NULL && pid == 0; ++i) {
+        dmx_parameter_t *const entry = &device->parameters[i];
+        taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+        const bool is_staged_all = entry->is_staged_all;
+        if (is_staged_all) {
+            entry->is_staged_all = false;
+            --driver->device.parameter_count.staged;
+        }
+        taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+        if (!is_staged_all) {
+            continue;
+        }
+
+        pid      = entry->pid;
+        is_batch = true;
+        for (int n = 1; n < RDM_SUB_DEVICE_MAX; ++n) {
+            uint8_t *const values = dmx_sub_device_get_values(dmx_num, n);
+            if (values == NULL) {
+                continue;
+            }
+            taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+            if (values[entry->offset - 1]) {
+                values[entry->offset - 1] = false;  // The value is committed with the batch
+                --driver->device.parameter_count.staged;
+            }
+            taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+            dmx_nvs_set(dmx_num, n, pid, values + entry->offset, entry->size);
+        }
+    }
+
+    // Iterate through the sub-device parameters if no root parameter was staged
+    device = driver->device.sub_devices.table;
+    for (int n = 1; n < RDM_SUB_DEVICE_MAX && device != NULL && pid == 0; ++n) {
+        uint8_t *const values = dmx_sub_device_get_values(dmx_num, n);
+        if (values == NULL) {
+            continue;
+        }
         taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
-        for (int i = 0; i < driver->device.parameter_count.root; ++i) {
-            if (device->parameters[i].type == DMX_PARAMETER_TYPE_NON_VOLATILE_STAGED) {
-                device->parameters[i].type = DMX_PARAMETER_TYPE_NON_VOLATILE;
+        for (int i = 0; i < driver->device.parameter_count.sub_devices; ++i) {
+            const dmx_parameter_t *const entry = &device->parameters[i];
+            if (entry->type == DMX_PARAMETER_TYPE_NON_VOLATILE && values[entry->offset - 1]) {
+                values[entry->offset - 1] = false;  // Clear the staged flag
                 --driver->device.parameter_count.staged;
-                sub_device = device->num;
-                pid        = device->parameters[i].pid;
-                data       = device->parameters[i].data;
+                sub_device = n;
+                pid        = entry->pid;
+                data       = values + entry->offset;
                 break;
             }
         }
         taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
     }
 
-    if (pid > 0) {
+    if (pid > 0 && !is_batch) {
         dmx_nvs_set(dmx_num, sub_device, pid, data, dmx_parameter_size(dmx_num, sub_device, pid));
     }
 
     return pid;
 }
+
+static void dmx_parameter_commit_all(dmx_port_t dmx_num) {
+    if (dmx_driver[dmx_num]->device.parameter_count.staged == 0) {
+        return;  // Don't open NVS when there is nothing to commit
+    }
+
+    // Write every staged parameter with a single NVS commit
+    dmx_nvs_begin();
+    while (dmx_parameter_commit(dmx_num) > 0) {
+        continue;
+    }
+    dmx_nvs_end();
+}
+
+static void dmx_parameter_commit_task(void *arg) {
+    const dmx_port_t dmx_num   = (dmx_port_t)(uintptr_t)arg;
+    dmx_driver_t *const driver = dmx_driver[dmx_num];
+
+    const TickType_t debounce   = driver->device.commit.debounce;
+    const TickType_t poll_ticks = debounce / 4 > 0 ? debounce / 4 : 1;
+    uint32_t last_generation    = 0;
+    TickType_t last_change      = xTaskGetTickCount();
+    while (true) {
+        bool is_running;
+        unsigned int staged;
+        uint32_t generation;
+        taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+        is_running = driver->device.commit.is_running;
+        staged     = driver->device.parameter_count.staged;
+        generation = driver->device.generation;
+        taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+        if (!is_running) {
+            break;
+        }
+
+        // Wait until the parameters stop changing before committing them
+        const TickType_t now = xTaskGetTickCount();
+        if (generation != last_generation) {
+            last_generation = generation;
+            last_change     = now;
+        } else if (staged > 0 && now - last_change >= debounce) {
+            dmx_parameter_commit_all(dmx_num);
+        }
+
+        vTaskDelay(poll_ticks);
+    }
+
+    // Don't lose parameters which were staged while the task was stopping
+    dmx_parameter_commit_all(dmx_num);
+
+    taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+    driver->device.commit.task = NULL;
+    taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+    vTaskDelete(NULL);
+}
+
+bool dmx_parameter_commit_start(dmx_port_t dmx_num, uint32_t debounce_ms, UBaseType_t priority,
+                                BaseType_t core_id) {
+    DMX_CHECK(dmx_num < DMX_NUM_MAX, false, "dmx_num error");
+    DMX_CHECK(priority < configMAX_PRIORITIES, false, "priority error");
+    DMX_CHECK(core_id == tskNO_AFFINITY || (core_id >= 0 && core_id < portNUM_PROCESSORS), false, "core_id error");
+    DMX_CHECK(dmx_driver_is_installed(dmx_num), false, "driver is not installed");
+
+    dmx_driver_t *const driver = dmx_driver[dmx_num];
+
+    if (dmx_parameter_commit_is_running(dmx_num)) {
+        return true;
+    }
+
+    driver->device.commit.debounce   = dmx_ms_to_ticks(debounce_ms);
+    driver->device.commit.is_running = true;
+    TaskHandle_t task;
+    if (xTaskCreatePinnedToCore(dmx_parameter_commit_task, "dmx_commit", DMX_PARAMETER_COMMIT_TASK_STACK_SIZE,
+                                (void *)(uintptr_t)dmx_num, priority, &task, core_id) != pdPASS) {
+        driver->device.commit.is_running = false;
+        DMX_ERR("parameter commit task create error");
+        return false;
+    }
+    taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+    driver->device.commit.task = task;
+    taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+
+    return true;
+}
+
+bool dmx_parameter_commit_stop(dmx_port_t dmx_num) {
+    DMX_CHECK(dmx_num < DMX_NUM_MAX, false, "dmx_num error");
+    DMX_CHECK(dmx_driver_is_installed(dmx_num), false, "driver is not installed");
+
+    dmx_driver_t *const driver = dmx_driver[dmx_num];
+
+    if (!dmx_parameter_commit_is_running(dmx_num)) {
+        return true;
+    }
+    DMX_CHECK(xTaskGetCurrentTaskHandle() != driver->device.commit.task, false,
+              "cannot stop the commit task from its own task");
+
+    // Ask the task to stop and wait for it to commit the remaining parameters
+    taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+    driver->device.commit.is_running = false;
+    taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+    TaskHandle_t task;
+    do {
+        vTaskDelay(1);
+        taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+        task = driver->device.commit.task;
+        taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+    } while (task != NULL);
+
+    return true;
+}
+
+bool dmx_parameter_commit_is_running(dmx_port_t dmx_num) {
+    DMX_CHECK(dmx_num < DMX_NUM_MAX, false, "dmx_num error");
+    DMX_CHECK(dmx_driver_is_installed(dmx_num), false, "driver is not installed");
+
+    dmx_driver_t *const driver = dmx_driver[dmx_num];
+
+    bool is_running;
+    taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+    is_running = driver->device.commit.task != NULL;
+    taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+
+    return is_running;
+}
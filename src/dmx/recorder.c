@@ -0,0 +1,400 @@
+#include "recorder.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "./include/driver.h"
+#include "./include/service.h"
+#include "esp_timer.h"
+
+#define DMX_RECORD_MAGIC         "DMXR"
+#define DMX_RECORD_VERSION       (1)
+#define DMX_RECORD_HEADER_SIZE   (8)   // The magic, the version, and three reserved bytes.
+#define DMX_RECORD_PREFIX_SIZE   (9)   // The time since the previous frame, the frame size, and the encoded size.
+#define DMX_RECORD_ENCODED_MAX   (DMX_PACKET_SIZE_MAX + (DMX_PACKET_SIZE_MAX + 63) / 64)
+
+/* Each frame is encoded against the previous frame as a sequence of runs. The
+ high bits of the first byte of each run determine its type:
+   0xxxxxxx: x + 1 slots are unchanged.
+   10xxxxxx: x + 1 slots follow literally.
+   11xxxxxx: x + 1 slots are set to the value of the following byte.
+ Literal runs absorb single unchanged slots, but alternating unchanged slots
+ and short fills can still make the delta larger than the frame. A frame whose
+ delta would not fit in DMX_RECORD_ENCODED_MAX bytes is encoded as literal runs
+ only, which never use more than one byte per 64 slots more than its size. */
+
+typedef struct dmx_recorder_t {
+    dmx_recorder_write_cb_t write_cb;  // The function which writes the recorded data.
+    void *context;                     // The context which is passed to the write function.
+    int64_t last_timestamp;            // The timestamp of the last recorded frame, or -1.
+    uint8_t last[DMX_PACKET_SIZE_MAX];   // The last recorded frame.
+    uint8_t frame[DMX_PACKET_SIZE_MAX];  // The frame which is being recorded.
+    uint8_t encoded[DMX_RECORD_PREFIX_SIZE + DMX_RECORD_ENCODED_MAX];  // The encoded frame.
+} dmx_recorder_t;
+
+typedef struct dmx_player_t {
+    dmx_port_t dmx_num;              // The DMX port number.
+    dmx_player_read_cb_t read_cb;    // The function which reads the recorded data.
+    void *context;                   // The context which is passed to the read function.
+    esp_timer_handle_t timer;        // The timer which wakes the player task when the next frame is due.
+    TaskHandle_t task;               // The player task.
+    uint8_t frame[DMX_PACKET_SIZE_MAX];            // The frame which is played.
+    uint8_t encoded[DMX_RECORD_ENCODED_MAX];       // The encoded frame which was read from the stream.
+} dmx_player_t;
+
+static size_t dmx_record_encode_literal(const uint8_t *frame, size_t size, uint8_t *encoded) {
+    size_t n = 0;
+    for (size_t i = 0; i < size; i += 64) {
+        const size_t run = size - i < 64 ? size - i : 64;
+        encoded[n++]     = 0x80 | (run - 1);
+        memcpy(&encoded[n], &frame[i], run);
+        n += run;
+    }
+    return n;
+}
+
+static size_t dmx_record_encode(const uint8_t *last, const uint8_t *frame, size_t size, uint8_t *encoded,
+                                size_t capacity) {
+    size_t n = 0;
+    for (size_t i = 0; i < size;) {
+        size_t run = 1;
+        if (frame[i] == last[i]) {
+            while (i + run < size && run < 128 && frame[i + run] == last[i + run]) {
+                ++run;
+            }
+            if (n + 1 > capacity) {
+                return dmx_record_encode_literal(frame, size, encoded);
+            }
+            encoded[n++] = run - 1;
+        } else {
+            while (i + run < size && run < 64 && frame[i + run] == frame[i]) {
+                ++run;
+            }
+            if (run >= 3) {
+                if (n + 2 > capacity) {
+                    return dmx_record_encode_literal(frame, size, encoded);
+                }
+                encoded[n++] = 0xc0 | (run - 1);
+                encoded[n++] = frame[i];
+            } else {
+                // Extend the literal run until a fill run or two unchanged slots are found
+                run = 1;
+                while (i + run < size && run < 64) {
+                    const size_t j = i + run;
+                    if ((j + 1 < size && frame[j] == last[j] && frame[j + 1] == last[j + 1]) ||
+                        (j + 2 < size && frame[j] == frame[j + 1] && frame[j] == frame[j + 2])) {
+                        break;
+                    }
+                    ++run;
+                }
+                if (n + 1 + run > capacity) {
+                    return dmx_record_encode_literal(frame, size, encoded);
+                }
+                encoded[n++] = 0x80 | (run - 1);
+                memcpy(&encoded[n], &frame[i], run);
+                n += run;
+            }
+        }
+        i += run;
+    }
+    return n;
+}
+
+static bool dmx_record_decode(const uint8_t *encoded, size_t encoded_size, uint8_t *frame, size_t size) {
+    size_t i = 0;
+    for (size_t n = 0; n < encoded_size && i < size;) {
+        const uint8_t op = encoded[n++];
+        const size_t run = (op & 0x80) ? (op & 0x3f) + 1 : op + 1;
+        if (i + run > size) {
+            return false;
+        }
+        if (!(op & 0x80)) {
+            // The slots are unchanged
+        } else if (!(op & 0x40)) {
+            if (n + run > encoded_size) {
+                return false;
+            }
+            memcpy(&frame[i], &encoded[n], run);
+            n += run;
+        } else {
+            if (n >= encoded_size) {
+                return false;
+            }
+            memset(&frame[i], encoded[n++], run);
+        }
+        i += run;
+    }
+    return i == size;
+}
+
+void dmx_recorder_record(dmx_port_t dmx_num, size_t size) {
+    dmx_driver_t *const driver     = dmx_driver[dmx_num];
+    dmx_recorder_t *const recorder = driver->recorder;
+
+    int64_t timestamp;
+    taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+    timestamp = driver->stats.last_packet_timestamp;
+    taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+    dmx_read_offset(dmx_num, 0, recorder->frame, size);
+    if (dmx_start_code_is_rdm(recorder->frame[0])) {
+        return;
+    }
+
+    // Write the time since the previous frame as a variable-length integer
+    uint32_t delta = recorder->last_timestamp < 0 ? 0 : (uint32_t)(timestamp - recorder->last_timestamp);
+    size_t n       = 0;
+    do {
+        recorder->encoded[n++] = (delta & 0x7f) | (delta > 0x7f ? 0x80 : 0);
+        delta >>= 7;
+    } while (delta > 0);
+    recorder->encoded[n++] = size & 0xff;
+    recorder->encoded[n++] = size >> 8;
+
+    // Write the frame as a delta from the last recorded frame
+    const size_t encoded_size =
+        dmx_record_encode(recorder->last, recorder->frame, size, &recorder->encoded[n + 2], DMX_RECORD_ENCODED_MAX);
+    recorder->encoded[n++]    = encoded_size & 0xff;
+    recorder->encoded[n++]    = encoded_size >> 8;
+    n += encoded_size;
+    memcpy(recorder->last, recorder->frame, size);
+    recorder->last_timestamp = timestamp;
+
+    if (!recorder->write_cb(recorder->encoded, n, recorder->context)) {
+        DMX_WARN("recorder write error, recording stopped");
+        taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+        driver->recorder = NULL;
+        taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+        free(recorder);
+    }
+}
+
+bool dmx_recorder_start(dmx_port_t dmx_num, dmx_recorder_write_cb_t write_cb, void *context) {
+    DMX_CHECK(dmx_num < DMX_NUM_MAX, false, "dmx_num error");
+    DMX_CHECK(write_cb != NULL, false, "write_cb is null");
+    DMX_CHECK(dmx_driver_is_installed(dmx_num), false, "driver is not installed");
+    DMX_CHECK(!dmx_recorder_is_running(dmx_num), false, "recorder is already running");
+
+    dmx_driver_t *const driver = dmx_driver[dmx_num];
+
+    dmx_recorder_t *const recorder = calloc(1, sizeof(*recorder));
+    DMX_CHECK(recorder != NULL, false, "recorder malloc error");
+    recorder->write_cb       = write_cb;
+    recorder->context        = context;
+    recorder->last_timestamp = -1;
+
+    // Write the stream header
+    const uint8_t header[DMX_RECORD_HEADER_SIZE] = {'D', 'M', 'X', 'R', DMX_RECORD_VERSION, 0, 0, 0};
+    if (!write_cb(header, sizeof(header), context)) {
+        free(recorder);
+        DMX_CHECK(false, false, "recorder write error");
+    }
+
+    // Frames are recorded by dmx_receive() while it holds the mutex
+    xSemaphoreTakeRecursive(driver->mux, portMAX_DELAY);
+    driver->recorder = recorder;
+    xSemaphoreGiveRecursive(driver->mux);
+
+    return true;
+}
+
+bool dmx_recorder_stop(dmx_port_t dmx_num) {
+    DMX_CHECK(dmx_num < DMX_NUM_MAX, false, "dmx_num error");
+    DMX_CHECK(dmx_driver_is_installed(dmx_num), false, "driver is not installed");
+
+    dmx_driver_t *const driver = dmx_driver[dmx_num];
+
+    xSemaphoreTakeRecursive(driver->mux, portMAX_DELAY);
+    dmx_recorder_t *const recorder = driver->recorder;
+    driver->recorder               = NULL;
+    xSemaphoreGiveRecursive(driver->mux);
+    free(recorder);
+
+    return recorder != NULL;
+}
+
+bool dmx_recorder_is_running(dmx_port_t dmx_num) {
+    DMX_CHECK(dmx_num < DMX_NUM_MAX, false, "dmx_num error");
+    DMX_CHECK(dmx_driver_is_installed(dmx_num), false, "driver is not installed");
+
+    return dmx_driver[dmx_num]->recorder != NULL;
+}
+
+static void dmx_player_timer_cb(void *arg) {
+    dmx_player_t *const player = (dmx_player_t *)arg;
+    xTaskNotifyGive(player->task);
+}
+
+static bool dmx_player_read_frame(dmx_player_t *player, uint32_t *delta, size_t *size) {
+    // Read the time since the previous frame
+    uint8_t byte;
+    *delta = 0;
+    for (int shift = 0;; shift += 7) {
+        if (shift > 28 || player->read_cb(&byte, 1, player->context) != 1) {
+            return false;
+        }
+        *delta |= (uint32_t)(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) {
+            break;
+        }
+    }
+
+    // Read the frame size and the encoded frame
+    uint8_t sizes[4];
+    if (player->read_cb(sizes, sizeof(sizes), player->context) != sizeof(sizes)) {
+        return false;
+    }
+    *size                     = sizes[0] | (sizes[1] << 8);
+    const size_t encoded_size = sizes[2] | (sizes[3] << 8);
+    if (*size == 0 || *size > DMX_PACKET_SIZE_MAX || encoded_size > DMX_RECORD_ENCODED_MAX ||
+        player->read_cb(player->encoded, encoded_size, player->context) != encoded_size) {
+        return false;
+    }
+
+    return dmx_record_decode(player->encoded, encoded_size, player->frame, *size);
+}
+
+static void dmx_player_task(void *arg) {
+    dmx_player_t *const player = (dmx_player_t *)arg;
+    const dmx_port_t dmx_num   = player->dmx_num;
+    dmx_driver_t *const driver = dmx_driver[dmx_num];
+
+    // Wait until the task handle is stored so that the task cannot exit before it is started
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+    // Validate the stream header
+    uint8_t header[DMX_RECORD_HEADER_SIZE];
+    bool is_running = player->read_cb(header, sizeof(header), player->context) == sizeof(header) &&
+                      memcmp(header, DMX_RECORD_MAGIC, 4) == 0 && header[4] == DMX_RECORD_VERSION;
+    if (!is_running) {
+        DMX_WARN("player stream is not a DMX recording");
+    }
+
+    int64_t due = esp_timer_get_time();
+    while (is_running) {
+        uint32_t delta;
+        size_t size;
+        if (!dmx_player_read_frame(player, &delta, &size)) {
+            break;  // The end of the stream
+        }
+
+        // Wait until the frame is due without drifting from the recorded timing
+        due += delta;
+        const int64_t wait = due - esp_timer_get_time();
+        if (wait > 0) {
+            esp_timer_start_once(player->timer, wait);
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        }
+
+        taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+        is_running = driver->player.is_running;
+        taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+        if (is_running) {
+            dmx_write(dmx_num, player->frame, size);
+            dmx_send_num(dmx_num, size);
+        }
+    }
+
+    esp_timer_stop(player->timer);
+    esp_timer_delete(player->timer);
+    free(player);
+
+    taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+    driver->player.task       = NULL;
+    driver->player.is_running = false;
+    taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+    vTaskDelete(NULL);
+}
+
+bool dmx_player_start(dmx_port_t dmx_num, dmx_player_read_cb_t read_cb, void *context, UBaseType_t priority,
+                      BaseType_t core_id) {
+    DMX_CHECK(dmx_num < DMX_NUM_MAX, false, "dmx_num error");
+    DMX_CHECK(read_cb != NULL, false, "read_cb is null");
+    DMX_CHECK(priority < configMAX_PRIORITIES, false, "priority error");
+    DMX_CHECK(core_id == tskNO_AFFINITY || (core_id >= 0 && core_id < portNUM_PROCESSORS), false, "core_id error");
+    DMX_CHECK(dmx_driver_is_installed(dmx_num), false, "driver is not installed");
+    DMX_CHECK(!dmx_player_is_running(dmx_num), false, "player is already running");
+
+    dmx_driver_t *const driver = dmx_driver[dmx_num];
+
+    dmx_player_t *const player = calloc(1, sizeof(*player));
+    DMX_CHECK(player != NULL, false, "player malloc error");
+    player->dmx_num = dmx_num;
+    player->read_cb = read_cb;
+    player->context = context;
+    const esp_timer_create_args_t timer_args = {
+        .callback = dmx_player_timer_cb,
+        .arg      = player,
+        .name     = "dmx_player",
+    };
+    if (esp_timer_create(&timer_args, &player->timer) != ESP_OK) {
+        free(player);
+        DMX_CHECK(false, false, "player timer create error");
+    }
+
+    driver->player.is_running = true;
+    if (xTaskCreatePinnedToCore(dmx_player_task, "dmx_player", DMX_PLAYER_TASK_STACK_SIZE, player, priority,
+                                &player->task, core_id) != pdPASS) {
+        driver->player.is_running = false;
+        esp_timer_delete(player->timer);
+        free(player);
+        DMX_ERR("player task create error");
+        return false;
+    }
+    taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+    driver->player.task = player->task;
+    taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+    xTaskNotifyGive(player->task);  // The task may now run to the end of the stream
+
+    return true;
+}
+
+bool dmx_player_stop(dmx_port_t dmx_num) {
+    DMX_CHECK(dmx_num < DMX_NUM_MAX, false, "dmx_num error");
+    DMX_CHECK(dmx_driver_is_installed(dmx_num), false, "driver is not installed");
+
+    dmx_driver_t *const driver = dmx_driver[dmx_num];
+
+    if (!dmx_player_is_running(dmx_num)) {
+        return true;
+    }
+    DMX_CHECK(xTaskGetCurrentTaskHandle() != driver->player.task, false,
+              "cannot stop the player task from its own task");
+
+    // Ask the task to stop and wake it if it is waiting for the next frame
+    TaskHandle_t task;
+    taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+    driver->player.is_running = false;
+    task                      = driver->player.task;
+    taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+    if (task != NULL) {
+        xTaskNotifyGive(task);
+    }
+    do {
+        vTaskDelay(1);
+        taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+        task = driver->player.task;
+        taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+    } while (task != NULL);
+
+    return true;
+}
+
+bool dmx_player_is_running(dmx_port_t dmx_num) {
+    DMX_CHECK(dmx_num < DMX_NUM_MAX, false, "dmx_num error");
+    DMX_CHECK(dmx_driver_is_installed(dmx_num), false, "driver is not installed");
+
+    dmx_driver_t *const driver = dmx_driver[dmx_num];
+
+    bool is_running;
+    taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+    is_running = driver->player.task != NULL;
+    taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+
+    return is_running;
+}
+
+bool dmx_recorder_file_write(const void *data, size_t size, void *file) {
+    return fwrite(data, 1, size, (FILE *)file) == size;
+}
+
+size_t dmx_player_file_read(void *data, size_t size, void *file) { return fread(data, 1, size, (FILE *)file); }
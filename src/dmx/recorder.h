@@ -0,0 +1,140 @@
+/**
+ * @file dmx/recorder.h
+ * @author Mitch Weisbrod (mitch@theweisbrods.com)
+ * @brief This file contains functions which allow received DMX packets to be
+ * recorded to a compressed stream and played back with their original timing.
+ */
+#pragma once
+
+#include <stdio.h>
+
+#include "./include/types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief A function which writes recorded data to a stream, such as a file on
+ * SPIFFS, LittleFS, or an SD card.
+ *
+ * @param[in] data The recorded data to write.
+ * @param size The size of the data in bytes.
+ * @param context The context which was passed to dmx_recorder_start().
+ * @return true if the data was written.
+ * @return false on failure, which stops the recording.
+ */
+typedef bool (*dmx_recorder_write_cb_t)(const void *data, size_t size,
+                                        void *context);
+
+/**
+ * @brief A function which reads recorded data from a stream.
+ *
+ * @param[out] data The buffer into which to read the recorded data.
+ * @param size The number of bytes to read.
+ * @param context The context which was passed to dmx_player_start().
+ * @return The number of bytes which were read. Playback stops when fewer bytes
+ * are read than were requested.
+ */
+typedef size_t (*dmx_player_read_cb_t)(void *data, size_t size, void *context);
+
+/**
+ * @brief Starts recording the DMX packets which are received on a DMX port.
+ * Each packet which is received without errors by dmx_receive() is compared
+ * with the previously recorded packet and only the slots which changed are
+ * written, run-length encoded, along with the time since the previous packet.
+ * RDM packets are not recorded.
+ *
+ * @note The write function is called from the task which calls dmx_receive().
+ * Writing to flash may delay the return of dmx_receive() so it is recommended
+ * to write to a buffered stream.
+ *
+ * @param dmx_num The DMX port number.
+ * @param write_cb The function which writes the recorded data.
+ * @param context The context which is passed to the write function.
+ * @return true if recording was started.
+ * @return false on failure.
+ */
+bool dmx_recorder_start(dmx_port_t dmx_num, dmx_recorder_write_cb_t write_cb,
+                        void *context);
+
+/**
+ * @brief Stops recording the DMX packets which are received on a DMX port.
+ *
+ * @param dmx_num The DMX port number.
+ * @return true if recording was stopped.
+ * @return false if the DMX port was not recording.
+ */
+bool dmx_recorder_stop(dmx_port_t dmx_num);
+
+/**
+ * @brief Checks if a DMX port is recording.
+ *
+ * @param dmx_num The DMX port number.
+ * @return true if the DMX port is recording.
+ * @return false if it is not.
+ */
+bool dmx_recorder_is_running(dmx_port_t dmx_num);
+
+/**
+ * @brief Starts a task which plays a recorded stream on a DMX port. Each
+ * packet is sent with dmx_send() at the time that it was recorded, relative
+ * to the first packet of the stream. The task stops on its own at the end of
+ * the stream.
+ *
+ * @param dmx_num The DMX port number.
+ * @param read_cb The function which reads the recorded data.
+ * @param context The context which is passed to the read function.
+ * @param priority The priority of the player task.
+ * @param core_id The core on which to run the player task, or tskNO_AFFINITY.
+ * @return true if the player task was started.
+ * @return false on failure.
+ */
+bool dmx_player_start(dmx_port_t dmx_num, dmx_player_read_cb_t read_cb,
+                      void *context, UBaseType_t priority, BaseType_t core_id);
+
+/**
+ * @brief Stops the player task of a DMX port. The packet that is currently
+ * being sent, if any, is allowed to finish.
+ *
+ * @param dmx_num The DMX port number.
+ * @return true if the player task is not running.
+ * @return false on failure.
+ */
+bool dmx_player_stop(dmx_port_t dmx_num);
+
+/**
+ * @brief Checks if the player task of a DMX port is running.
+ *
+ * @param dmx_num The DMX port number.
+ * @return true if the player task is running.
+ * @return false if it is not.
+ */
+bool dmx_player_is_running(dmx_port_t dmx_num);
+
+/**
+ * @brief A write function for dmx_recorder_start() which writes to a stdio
+ * file. The context must be a FILE pointer.
+ *
+ * @param[in] data The recorded data to write.
+ * @param size The size of the data in bytes.
+ * @param file The FILE pointer to write to.
+ * @return true if the data was written.
+ * @return false on failure.
+ */
+bool dmx_recorder_file_write(const void *data, size_t size, void *file);
+
+/**
+ * @brief A read function for dmx_player_start() which reads from a stdio file.
+ * The context must be a FILE pointer.
+ *
+ * @param[out] data The buffer into which to read the recorded data.
+ * @param size The number of bytes to read.
+ * @param file The FILE pointer to read from.
+ * @return The number of bytes which were read.
+ */
+size_t dmx_player_file_read(void *data, size_t size, void *file);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,224 @@
+#include "repeater.h"
+
+#include <string.h>
+
+#include "./hal/include/uart.h"
+#include "./include/driver.h"
+#include "./include/service.h"
+
+/* A repeated packet is sent while it is being received, so the repeating DMX
+ port cannot know when it ends. Its DMX status stays DMX_STATUS_SENDING until
+ the start code of the next packet is received. If the repeating port has not
+ finished sending the last packet when the next start code is received, the
+ next DMX break is started once the UART has finished sending. */
+
+static void DMX_ISR_ATTR dmx_repeater_send_break(dmx_port_t dmx_num) {
+    dmx_driver_t *const driver = dmx_driver[dmx_num];
+
+    if (DMX_STATE_STATUS(DMX_STATE_LOAD(driver)) == DMX_STATUS_SENDING) {
+        ++driver->stats.packets_sent;  // The last repeated packet is finished
+    }
+    driver->dmx.size               = driver->repeater.size;
+    driver->repeater.size          = 0;
+    driver->repeater.is_drained    = false;
+    driver->repeater.break_pending = false;
+    dmx_packet_start_break(dmx_num);
+}
+
+static void DMX_ISR_ATTR dmx_repeater_finish(dmx_port_t dmx_num) {
+    dmx_driver_t *const driver = dmx_driver[dmx_num];
+
+    ++driver->stats.packets_sent;
+    dmx_state_update(dmx_num, DMX_STATE_STATUS_MASK | DMX_STATE_PROGRESS_MASK,
+                     DMX_STATE(DMX_STATUS_IDLE, DMX_PROGRESS_COMPLETE, 0));
+}
+
+static void DMX_ISR_ATTR dmx_repeater_start_packet(dmx_port_t dmx_num, uint8_t sc) {
+    dmx_driver_t *const driver = dmx_driver[dmx_num];
+
+    driver->repeater.is_skipping = dmx_start_code_is_rdm(sc) && !driver->repeater.forward_rdm;
+    if (driver->repeater.is_skipping) {
+        return;
+    }
+
+    driver->repeater.size = 0;
+    if (DMX_STATE_STATUS(DMX_STATE_LOAD(driver)) == DMX_STATUS_SENDING && !driver->repeater.is_drained) {
+        driver->repeater.break_pending = true;  // Wait for the UART to finish sending
+    } else {
+        dmx_repeater_send_break(dmx_num);
+    }
+}
+
+static bool DMX_ISR_ATTR dmx_repeater_write(dmx_port_t dmx_num) {
+    dmx_driver_t *const driver = dmx_driver[dmx_num];
+
+    const int dmx_head = DMX_STATE_HEAD(DMX_STATE_LOAD(driver));
+    int write_len      = driver->dmx.size - dmx_head;
+    if (write_len <= 0) {
+        return false;
+    }
+    dmx_uart_write_txfifo(dmx_num, &driver->dmx.data[dmx_head], &write_len);
+    dmx_state_set_head(dmx_num, dmx_head + write_len);
+    driver->repeater.is_drained = false;
+
+    // The DMX interrupt writes any slots which did not fit in the UART FIFO
+    dmx_uart_clear_interrupt(dmx_num, DMX_INTR_TX_DONE);
+    dmx_uart_enable_interrupt(dmx_num, DMX_INTR_TX_ALL);
+
+    return true;
+}
+
+void DMX_ISR_ATTR dmx_repeater_forward(dmx_port_t dmx_num, int offset, const uint8_t *slots, int size) {
+    if (size <= 0) {
+        return;
+    }
+
+    const uint32_t outputs = dmx_driver[dmx_num]->repeater.outputs;
+    for (int i = 0; i < DMX_NUM_MAX; ++i) {
+        if (!(outputs & (1u << i))) {
+            continue;
+        }
+        dmx_driver_t *const driver = dmx_driver[i];
+
+        taskENTER_CRITICAL_ISR(DMX_SPINLOCK(i));
+        if (driver->repeater.input == dmx_num) {
+            if (offset == 0) {
+                dmx_repeater_start_packet(i, slots[0]);
+            }
+            dmx_buffer_invalidate_rdm(i);
+            if (driver->repeater.is_skipping) {
+                // This packet is not repeated
+            } else if (driver->repeater.break_pending) {
+                // Don't overwrite the slots of the last packet which have not been sent
+                if (offset + size <= DMX_STATE_HEAD(DMX_STATE_LOAD(driver))) {
+                    memcpy(&driver->dmx.data[offset], slots, size);
+                    driver->repeater.size = offset + size;
+                } else {
+                    driver->repeater.is_skipping   = true;
+                    driver->repeater.break_pending = false;
+                }
+            } else {
+                memcpy(&driver->dmx.data[offset], slots, size);
+                driver->dmx.size = offset + size;
+                if (DMX_STATE_PROGRESS(DMX_STATE_LOAD(driver)) == DMX_PROGRESS_IN_DATA) {
+                    dmx_repeater_write(i);
+                }
+            }
+        }
+        taskEXIT_CRITICAL_ISR(DMX_SPINLOCK(i));
+    }
+}
+
+void DMX_ISR_ATTR dmx_repeater_start_data(dmx_port_t dmx_num) {
+    dmx_driver_t *const driver = dmx_driver[dmx_num];
+
+    dmx_state_set_progress(dmx_num, DMX_PROGRESS_IN_DATA);
+    if (dmx_repeater_write(dmx_num)) {
+        return;
+    } else if (driver->repeater.input < 0) {
+        dmx_repeater_finish(dmx_num);  // The repeater was stopped during the DMX break
+    } else {
+        driver->repeater.is_drained = true;
+        if (driver->repeater.break_pending) {
+            dmx_repeater_send_break(dmx_num);
+        }
+    }
+}
+
+void DMX_ISR_ATTR dmx_repeater_tx_done(dmx_port_t dmx_num) {
+    dmx_driver_t *const driver = dmx_driver[dmx_num];
+
+    if (DMX_STATE_HEAD(DMX_STATE_LOAD(driver)) < driver->dmx.size || dmx_uart_get_txfifo_len(dmx_num) > 0) {
+        // More slots were written after the interrupt was raised
+        dmx_uart_enable_interrupt(dmx_num, DMX_INTR_TX_ALL);
+    } else if (driver->repeater.input < 0) {
+        dmx_repeater_finish(dmx_num);  // The repeater was stopped while this packet was sent
+    } else {
+        driver->repeater.is_drained = true;
+        if (driver->repeater.break_pending) {
+            dmx_repeater_send_break(dmx_num);
+        }
+    }
+}
+
+bool dmx_repeater_start(dmx_port_t dmx_num, dmx_port_t input_num, bool forward_rdm) {
+    DMX_CHECK(dmx_num < DMX_NUM_MAX, false, "dmx_num error");
+    DMX_CHECK(input_num < DMX_NUM_MAX && input_num != dmx_num, false, "input_num error");
+    DMX_CHECK(dmx_driver_is_installed(dmx_num), false, "driver is not installed");
+    DMX_CHECK(dmx_driver_is_installed(input_num), false, "input driver is not installed");
+    DMX_CHECK(dmx_driver_is_enabled(dmx_num), false, "driver is not enabled");
+
+    dmx_driver_t *const driver = dmx_driver[dmx_num];
+    dmx_driver_t *const input  = dmx_driver[input_num];
+
+    DMX_CHECK(driver->repeater.input < 0, false, "port is already repeating");
+    DMX_CHECK(driver->repeater.outputs == 0, false, "port is being repeated");
+    DMX_CHECK(input->repeater.input < 0, false, "input port is repeating");
+    DMX_CHECK(driver->continuous.period == 0, false, "port is sending continuously");
+
+    // Block until the mutex can be taken and the driver is done sending
+    xSemaphoreTakeRecursive(driver->mux, portMAX_DELAY);
+    if (!dmx_wait_sent(dmx_num, dmx_ms_to_ticks(23)) ||
+        DMX_STATE_STATUS(DMX_STATE_LOAD(driver)) == DMX_STATUS_ARMED) {
+        xSemaphoreGiveRecursive(driver->mux);
+        DMX_CHECK(false, false, "driver is sending");
+    }
+
+    // Turn the DMX bus around and wait for the next start code of the input
+    taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+    if (dmx_uart_get_rts(dmx_num) == 1) {
+        dmx_uart_set_rts(dmx_num, 0);
+    }
+    driver->is_controller           = true;
+    driver->dmx.last_controller_pid = 0;
+    driver->dmx.front               = driver->dmx.data;
+    driver->repeater.input          = input_num;
+    driver->repeater.forward_rdm    = forward_rdm;
+    driver->repeater.is_skipping    = true;
+    driver->repeater.is_drained     = true;
+    driver->repeater.break_pending  = false;
+    driver->repeater.size           = 0;
+    taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+
+    taskENTER_CRITICAL(DMX_SPINLOCK(input_num));
+    input->repeater.outputs |= 1u << dmx_num;
+    taskEXIT_CRITICAL(DMX_SPINLOCK(input_num));
+
+    xSemaphoreGiveRecursive(driver->mux);
+    return true;
+}
+
+bool dmx_repeater_stop(dmx_port_t dmx_num) {
+    DMX_CHECK(dmx_num < DMX_NUM_MAX, false, "dmx_num error");
+    DMX_CHECK(dmx_driver_is_installed(dmx_num), false, "driver is not installed");
+
+    dmx_driver_t *const driver = dmx_driver[dmx_num];
+
+    const int input_num = driver->repeater.input;
+    if (input_num < 0) {
+        return false;
+    }
+
+    // Stop forwarding slots from the input port
+    taskENTER_CRITICAL(DMX_SPINLOCK(input_num));
+    dmx_driver[input_num]->repeater.outputs &= ~(1u << dmx_num);
+    taskEXIT_CRITICAL(DMX_SPINLOCK(input_num));
+
+    // Finish the packet now if the UART is not sending, otherwise the DMX interrupt finishes it
+    taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+    driver->repeater.input         = -1;
+    driver->repeater.break_pending = false;
+    if (DMX_STATE_STATUS(DMX_STATE_LOAD(driver)) == DMX_STATUS_SENDING && driver->repeater.is_drained) {
+        dmx_repeater_finish(dmx_num);
+    }
+    taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+
+    return true;
+}
+
+bool dmx_repeater_is_running(dmx_port_t dmx_num) {
+    DMX_CHECK(dmx_num < DMX_NUM_MAX, false, "dmx_num error");
+    DMX_CHECK(dmx_driver_is_installed(dmx_num), false, "driver is not installed");
+
+    return dmx_driver[dmx_num]->repeater.input >= 0;
+}
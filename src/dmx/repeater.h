@@ -0,0 +1,65 @@
+/**
+ * @file dmx/repeater.h
+ * @author Mitch Weisbrod (mitch@theweisbrods.com)
+ * @brief This file contains functions which allow the DMX packets which are
+ * received on one DMX port to be repeated on other DMX ports as they are
+ * received, such as in an opto-splitter or a line repeater.
+ */
+#pragma once
+
+#include "./include/types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Starts repeating the DMX packets which are received on an input DMX
+ * port out of a DMX port. Each slot is forwarded from the DMX interrupt of the
+ * input port into the UART of the repeating port as soon as it is received, so
+ * the repeated packet trails the received packet by only a few slots instead
+ * of a whole packet. The DMX break and mark-after-break of each repeated
+ * packet are regenerated with the break and mark-after-break lengths of the
+ * repeating port. An input DMX port may be repeated by several DMX ports to
+ * split it.
+ *
+ * The input DMX port continues to receive normally so that its packets may
+ * still be read with dmx_receive(). Packets cannot be sent with dmx_send() on
+ * a DMX port which is repeating.
+ *
+ * @note RDM responses are not repeated back to the input DMX port, so RDM
+ * devices which are connected to a repeating DMX port cannot be discovered
+ * through it.
+ *
+ * @param dmx_num The DMX port number of the port which repeats the packets.
+ * @param input_num The DMX port number of the port which receives the packets.
+ * @param forward_rdm True to repeat RDM requests as well as DMX packets. If
+ * false, packets with an RDM start code are not repeated.
+ * @return true if the DMX port started repeating.
+ * @return false on failure.
+ */
+bool dmx_repeater_start(dmx_port_t dmx_num, dmx_port_t input_num,
+                        bool forward_rdm);
+
+/**
+ * @brief Stops repeating DMX packets out of a DMX port. The packet that is
+ * being sent, if any, is allowed to finish.
+ *
+ * @param dmx_num The DMX port number of the port which repeats the packets.
+ * @return true if the DMX port stopped repeating.
+ * @return false if it was not repeating.
+ */
+bool dmx_repeater_stop(dmx_port_t dmx_num);
+
+/**
+ * @brief Checks if a DMX port is repeating the packets of another DMX port.
+ *
+ * @param dmx_num The DMX port number.
+ * @return true if the DMX port is repeating.
+ * @return false if it is not.
+ */
+bool dmx_repeater_is_running(dmx_port_t dmx_num);
+
+#ifdef __cplusplus
+}
+#endif
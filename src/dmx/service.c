@@ -2,22 +2,258 @@
 
 #include <string.h>
 
+#include "./hal/include/timer.h"
+#include "./hal/include/uart.h"
 #include "./include/driver.h"
+#include "../rdm/include/uid.h"
+
+uint8_t *dmx_sub_device_get_values(dmx_port_t dmx_num, dmx_device_num_t device_num) {
+    assert(dmx_num < DMX_NUM_MAX);
+    assert(device_num > RDM_SUB_DEVICE_ROOT && device_num < RDM_SUB_DEVICE_MAX);
+    assert(dmx_driver_is_installed(dmx_num));
+
+    // Sub-devices are stored in a two-level table indexed by device number
+    const int index      = device_num - 1;
+    uint8_t **const page = dmx_driver[dmx_num]->device.sub_devices.pages[index / DMX_SUB_DEVICE_PAGE_SIZE];
+    if (page == NULL) {
+        return NULL;  // Sub-device does not exist
+    }
+
+    return page[index % DMX_SUB_DEVICE_PAGE_SIZE];
+}
+
+bool dmx_device_add(dmx_port_t dmx_num, dmx_device_num_t device_num) {
+    assert(dmx_num < DMX_NUM_MAX);
+    assert(device_num > RDM_SUB_DEVICE_ROOT && device_num < RDM_SUB_DEVICE_MAX);
+    assert(dmx_driver_is_installed(dmx_num));
+
+    struct dmx_driver_sub_devices_t *const sub_devices = &dmx_driver[dmx_num]->device.sub_devices;
+    if (sub_devices->table == NULL) {
+        return false;  // Sub-devices are not supported
+    } else if (dmx_sub_device_get_values(dmx_num, device_num) != NULL) {
+        return true;  // Sub-device already exists
+    }
+
+    // Allocate the page of the sub-device table if needed
+    const int index       = device_num - 1;
+    uint8_t ***const page = &sub_devices->pages[index / DMX_SUB_DEVICE_PAGE_SIZE];
+    if (*page == NULL) {
+        *page = calloc(DMX_SUB_DEVICE_PAGE_SIZE, sizeof(uint8_t *));
+        if (*page == NULL) {
+            DMX_ERR("sub-device page malloc error");
+            return false;
+        }
+    }
+
+    // Allocate the value block of the sub-device
+    uint8_t *const values = calloc(1, sub_devices->value_size > 0 ? sub_devices->value_size : 1);
+    if (values == NULL) {
+        DMX_ERR("sub-device malloc error");
+        return false;
+    }
+    taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+    (*page)[index % DMX_SUB_DEVICE_PAGE_SIZE] = values;
+    ++sub_devices->count;
+    ++dmx_driver[dmx_num]->device.generation;  // Invalidate cached RDM responses
+    taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+
+    return true;
+}
 
 dmx_device_t *dmx_device_get(dmx_port_t dmx_num, dmx_device_num_t device_num) {
     assert(dmx_num < DMX_NUM_MAX);
     assert(device_num < RDM_SUB_DEVICE_MAX);
     assert(dmx_driver_is_installed(dmx_num));
 
-    dmx_device_t *device = &dmx_driver[dmx_num]->device.root;
-    while (device->num != device_num) {
-        device = device->next;
-        if (device == NULL) {
-            return NULL;  // Sub-device does not exist
+    dmx_driver_t *const driver = dmx_driver[dmx_num];
+
+#ifndef CONFIG_RDM_RESPONDER_DISABLE
+    // Virtual responders have their own root device and no sub-devices
+    const struct dmx_driver_virtual_responder_t *const responder = rdm_virtual_get_active(dmx_num);
+    if (responder != NULL) {
+        return device_num == RDM_SUB_DEVICE_ROOT ? responder->root : NULL;
+    }
+#endif
+
+    if (device_num == RDM_SUB_DEVICE_ROOT) {
+        return &driver->device.root;
+    } else if (dmx_sub_device_get_values(dmx_num, device_num) == NULL) {
+        return NULL;  // Sub-device does not exist
+    }
+
+    return driver->device.sub_devices.table;
+}
+
+void *dmx_parameter_get_value(dmx_port_t dmx_num, dmx_device_num_t device_num, const dmx_parameter_t *entry) {
+    assert(dmx_num < DMX_NUM_MAX);
+    assert(device_num < RDM_SUB_DEVICE_MAX);
+    assert(entry != NULL);
+    assert(dmx_driver_is_installed(dmx_num));
+
+    // Static parameters of sub-devices are shared by every sub-device
+    if (device_num == RDM_SUB_DEVICE_ROOT ||
+        (entry->type != DMX_PARAMETER_TYPE_DYNAMIC && entry->type != DMX_PARAMETER_TYPE_NON_VOLATILE)) {
+        return entry->data;
+    }
+
+    uint8_t *const values = dmx_sub_device_get_values(dmx_num, device_num);
+    return values != NULL ? values + entry->offset : NULL;
+}
+
+void dmx_parameter_stage(dmx_port_t dmx_num, dmx_device_num_t device_num, dmx_parameter_t *entry) {
+    assert(dmx_num < DMX_NUM_MAX);
+    assert(device_num < RDM_SUB_DEVICE_MAX);
+    assert(entry != NULL);
+    assert(dmx_driver_is_installed(dmx_num));
+
+    dmx_driver_t *const driver = dmx_driver[dmx_num];
+
+    if (entry->type != DMX_PARAMETER_TYPE_NON_VOLATILE) {
+        return;  // Parameter is not non-volatile or is already staged
+    }
+
+    if (device_num == RDM_SUB_DEVICE_ROOT) {
+        entry->type = DMX_PARAMETER_TYPE_NON_VOLATILE_STAGED;
+        ++driver->device.parameter_count.staged;
+    } else {
+        // Non-volatile sub-device parameters are preceded by their staged flag
+        uint8_t *const is_staged = (uint8_t *)dmx_parameter_get_value(dmx_num, device_num, entry) - 1;
+        if (!*is_staged) {
+            *is_staged = true;
+            ++driver->device.parameter_count.staged;
+        }
+    }
+}
+
+void *dmx_parameter_alloc(dmx_port_t dmx_num, size_t size) {
+    assert(dmx_num < DMX_NUM_MAX);
+    assert(dmx_driver_is_installed(dmx_num));
+
+    dmx_parameter_chunk_t **const arena = &dmx_driver[dmx_num]->device.arena;
+
+    // Keep parameter data word-aligned
+    size = (size + (sizeof(uint32_t) - 1)) & ~(sizeof(uint32_t) - 1);
+
+    // Allocate a new chunk if the current chunk is full
+    if (*arena == NULL || (*arena)->size - (*arena)->used < size) {
+        const size_t chunk_size = size > DMX_PARAMETER_ARENA_CHUNK_SIZE ? size : DMX_PARAMETER_ARENA_CHUNK_SIZE;
+#ifdef CONFIG_RDM_RESPONDER_IRAM_SAFE
+        // Cached RDM responses are read by the DMX interrupt while the flash cache is disabled
+        dmx_parameter_chunk_t *const chunk =
+            heap_caps_malloc(sizeof(dmx_parameter_chunk_t) + chunk_size, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+#else
+        dmx_parameter_chunk_t *const chunk = malloc(sizeof(dmx_parameter_chunk_t) + chunk_size);
+#endif
+        if (chunk == NULL) {
+            return NULL;
+        }
+        chunk->next = *arena;
+        chunk->size = chunk_size;
+        chunk->used = 0;
+        *arena      = chunk;
+    }
+
+    void *const data = &(*arena)->data[(*arena)->used];
+    (*arena)->used += size;
+
+    return data;
+}
+
+/**
+ * @brief Finds the index of the first parameter of a device which has a PID
+ * that is greater than or equal to the desired PID. Parameters are stored in
+ * ascending PID order followed by unused parameters, which have a PID of 0.
+ *
+ * @param device A pointer to the device.
+ * @param param_count The number of parameters allocated for the device.
+ * @param pid The parameter ID.
+ * @return The index of the parameter, or param_count if no such parameter
+ * exists.
+ */
+static int dmx_parameter_search(const dmx_device_t *device, int param_count, rdm_pid_t pid) {
+    int low  = 0;
+    int high = param_count;
+    while (low < high) {
+        const int mid         = low + (high - low) / 2;
+        const rdm_pid_t found = device->parameters[mid].pid;
+        if (found != 0 && found < pid) {
+            low = mid + 1;
+        } else {
+            high = mid;
         }
     }
 
-    return device;
+    return low;
+}
+
+/**
+ * @brief Grows the value block of every sub-device. Every new value block is
+ * allocated before any is swapped in so that the value blocks are unchanged if
+ * an allocation fails.
+ *
+ * @param dmx_num The DMX port number.
+ * @param value_size The new size of each value block in bytes.
+ * @param offset The offset of the value which is added to each value block.
+ * @param[in] data The initial value, or NULL to initialize it to zero.
+ * @param size The size of the value which is added.
+ * @return true on success.
+ * @return false if a value block could not be allocated.
+ */
+static bool dmx_sub_device_resize(dmx_port_t dmx_num, size_t value_size, size_t offset, const void *data,
+                                  size_t size) {
+    struct dmx_driver_sub_devices_t *const sub_devices = &dmx_driver[dmx_num]->device.sub_devices;
+    const int count                                    = sub_devices->count;
+    if (count == 0) {
+        sub_devices->value_size = value_size;
+        return true;
+    }
+
+    uint8_t **const blocks = calloc(count, sizeof(uint8_t *));
+    if (blocks == NULL) {
+        return false;
+    }
+    for (int n = 0; n < count; ++n) {
+        blocks[n] = calloc(1, value_size);
+        if (blocks[n] == NULL) {
+            for (int k = 0; k < n; ++k) {
+                free(blocks[k]);
+            }
+            free(blocks);
+            return false;
+        }
+        if (data != NULL) {
+            memcpy(blocks[n] + offset, data, size);
+        }
+    }
+
+    // Swap in the new value blocks one page at a time, keeping the old value blocks to be freed
+    int n = 0;
+    for (int p = 0; p < DMX_SUB_DEVICE_PAGE_COUNT; ++p) {
+        uint8_t **const page = sub_devices->pages[p];
+        if (page == NULL) {
+            continue;
+        }
+        taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+        for (int j = 0; j < DMX_SUB_DEVICE_PAGE_SIZE && n < count; ++j) {
+            if (page[j] != NULL) {
+                uint8_t *const values = blocks[n];
+                memcpy(values, page[j], sub_devices->value_size);
+                blocks[n++] = page[j];
+                page[j]     = values;
+            }
+        }
+        taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+    }
+    taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+    sub_devices->value_size = value_size;
+    taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+
+    for (int k = 0; k < count; ++k) {
+        free(blocks[k]);  // Old value blocks, or new value blocks which were not needed
+    }
+    free(blocks);
+
+    return true;
 }
 
 bool dmx_parameter_add(dmx_port_t dmx_num, dmx_device_num_t device_num, rdm_pid_t pid, int type, void *data,
@@ -34,49 +270,92 @@ bool dmx_parameter_add(dmx_port_t dmx_num, dmx_device_num_t device_num, rdm_pid_
     if (device == NULL) {
         return false;  // Device does not exist
     }
+    const bool is_sub_device = (device_num != RDM_SUB_DEVICE_ROOT);
 
-    // Iterate through parameters until an empty parameter is found
-    const uint32_t parameter_count = device_num == RDM_SUB_DEVICE_ROOT ? driver->device.parameter_count.root
-                                                                       : driver->device.parameter_count.sub_devices;
-    for (int i = 0; i < parameter_count; ++i) {
-        if (device->parameters[i].pid == pid) {
-            return true;  // Parameter already exists
-        } else if (device->parameters[i].pid == 0) {
-            // Initialize parameter memory
-            switch (type) {
-                case DMX_PARAMETER_TYPE_DYNAMIC:
-                case DMX_PARAMETER_TYPE_NON_VOLATILE:
-                    device->parameters[i].data = malloc(size);
-                    if (device->parameters[i].data == NULL) {
-                        DMX_ERR("parameter malloc error");
-                        return false;
-                    }
-                    if (data == NULL) {
-                        memset(device->parameters[i].data, 0, size);
-                    } else {
-                        memcpy(device->parameters[i].data, data, size);
-                    }
-                    break;
-                case DMX_PARAMETER_TYPE_STATIC:
-                    device->parameters[i].data = data;
-                    break;
-                case DMX_PARAMETER_TYPE_NULL:
-                    device->parameters[i].data = NULL;
-                    break;
-                default:
-                    return false;
-            }
+#ifndef CONFIG_RDM_RESPONDER_DISABLE
+    // Virtual responders would share the NVS keys of the DMX port so their parameters are only kept in RAM
+    if (type == DMX_PARAMETER_TYPE_NON_VOLATILE && rdm_virtual_get_active(dmx_num) != NULL) {
+        type = DMX_PARAMETER_TYPE_DYNAMIC;
+    }
+#endif
 
-            device->parameters[i].pid        = pid;
-            device->parameters[i].size       = size;
-            device->parameters[i].type       = type;
-            device->parameters[i].definition = NULL;
-            device->parameters[i].callback   = NULL;
-            return true;
+    // Find where the parameter belongs so that parameters remain sorted by PID
+    const uint32_t parameter_count = is_sub_device ? driver->device.parameter_count.sub_devices
+                                                   : driver->device.parameter_count.root;
+    const int i = dmx_parameter_search(device, parameter_count, pid);
+    if (i < parameter_count && device->parameters[i].pid == pid) {
+        // Sub-devices share parameters so the value of this sub-device is set
+        if (is_sub_device && data != NULL &&
+            (device->parameters[i].type == DMX_PARAMETER_TYPE_DYNAMIC ||
+             device->parameters[i].type == DMX_PARAMETER_TYPE_NON_VOLATILE)) {
+            const size_t copy_size = size < device->parameters[i].size ? size : device->parameters[i].size;
+            taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+            memcpy(dmx_parameter_get_value(dmx_num, device_num, &device->parameters[i]), data, copy_size);
+            ++driver->device.generation;  // Invalidate cached RDM responses
+            taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
         }
+        return true;  // Parameter already exists
+    } else if (parameter_count == 0 || device->parameters[parameter_count - 1].pid != 0) {
+        return false;  // No more parameters available on this sub-device
     }
 
-    return false;  // No more parameters available on this sub-device
+    // Initialize parameter memory
+    void *parameter_data = NULL;
+    size_t offset        = 0;
+    switch (type) {
+        case DMX_PARAMETER_TYPE_DYNAMIC:
+        case DMX_PARAMETER_TYPE_NON_VOLATILE:
+            if (is_sub_device) {
+                // Word-align the value so that multi-byte parameters can be accessed directly
+                struct dmx_driver_sub_devices_t *const sub_devices = &driver->device.sub_devices;
+                const size_t flag_size = (type == DMX_PARAMETER_TYPE_NON_VOLATILE);  // Staged flag
+                offset = (sub_devices->value_size + flag_size + (sizeof(uint32_t) - 1)) & ~(sizeof(uint32_t) - 1);
+                if (!dmx_sub_device_resize(dmx_num, offset + size, offset, data, size)) {
+                    DMX_ERR("parameter malloc error");
+                    return false;
+                }
+                break;
+            }
+            parameter_data = dmx_parameter_alloc(dmx_num, size);
+            if (parameter_data == NULL) {
+                DMX_ERR("parameter malloc error");
+                return false;
+            }
+            if (data == NULL) {
+                memset(parameter_data, 0, size);
+            } else {
+                memcpy(parameter_data, data, size);
+            }
+            break;
+        case DMX_PARAMETER_TYPE_STATIC:
+            parameter_data = data;
+            break;
+        case DMX_PARAMETER_TYPE_NULL:
+            parameter_data = NULL;
+            break;
+        default:
+            return false;
+    }
+
+    // Make room for the new parameter. The DMX interrupt searches the parameters when answering cached RDM requests.
+    taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+    memmove(&device->parameters[i + 1], &device->parameters[i],
+            (parameter_count - i - 1) * sizeof(dmx_parameter_t));
+
+    device->parameters[i].pid           = pid;
+    device->parameters[i].data          = parameter_data;
+    device->parameters[i].size          = size;
+    device->parameters[i].type          = type;
+    device->parameters[i].definition    = NULL;
+    device->parameters[i].callback      = NULL;
+    device->parameters[i].context       = NULL;
+    device->parameters[i].offset        = offset;
+    device->parameters[i].cache         = NULL;
+    device->parameters[i].is_staged_all = false;
+    ++driver->device.generation;  // Invalidate cached RDM responses
+    taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+
+    return true;
 }
 
 dmx_parameter_t *dmx_parameter_get_entry(dmx_port_t dmx_num, dmx_device_num_t device_num, rdm_pid_t pid) {
@@ -95,12 +374,372 @@ dmx_parameter_t *dmx_parameter_get_entry(dmx_port_t dmx_num, dmx_device_num_t de
                                 ? dmx_driver[dmx_num]->device.parameter_count.root
                                 : dmx_driver[dmx_num]->device.parameter_count.sub_devices;
 
-    // Iterate the device's parameters
-    for (int i = 0; i < param_count; ++i) {
-        if (device->parameters[i].pid == pid) {
-            return &device->parameters[i];
-        }
+    // Parameters are sorted by PID so they can be found with a binary search
+    const int i = dmx_parameter_search(device, param_count, pid);
+    if (i < param_count && device->parameters[i].pid == pid) {
+        return &device->parameters[i];
     }
 
     return NULL;  // Parameter does not exist
 }
+
+dmx_parameter_t *dmx_parameter_get_shared_entry(dmx_port_t dmx_num, rdm_pid_t pid) {
+    assert(dmx_num < DMX_NUM_MAX);
+    assert(pid > 0);
+    assert(dmx_driver_is_installed(dmx_num));
+
+    dmx_driver_t *const driver = dmx_driver[dmx_num];
+
+    dmx_device_t *const device = driver->device.sub_devices.table;
+    if (device == NULL) {
+        return NULL;  // Sub-devices are not supported
+    }
+
+    const int param_count = driver->device.parameter_count.sub_devices;
+    const int i           = dmx_parameter_search(device, param_count, pid);
+    if (i < param_count && device->parameters[i].pid == pid) {
+        return &device->parameters[i];
+    }
+
+    return NULL;  // Parameter does not exist
+}
+
+void DMX_ISR_ATTR dmx_buffer_rotate(dmx_port_t dmx_num) {
+    dmx_driver_t *const driver = dmx_driver[dmx_num];
+
+    // RDM transactions are received into the RDM buffer until dmx_buffer_end_rdm() is called
+    if (driver->dmx.data == driver->dmx.rdm_buffer) {
+        return;
+    }
+
+    // Only move the receive buffer if it holds the last complete packet
+    if (driver->dmx.data == driver->dmx.front || driver->dmx.data == driver->dmx.leased) {
+        // Buffers are used in order so the next buffer is the least recently used
+        const int i = (driver->dmx.data - driver->dmx.buffer[0]) / DMX_PACKET_SIZE_MAX;
+        for (int n = 1; n < DMX_BUFFER_COUNT; ++n) {
+            uint8_t *const next = driver->dmx.buffer[(i + n) % DMX_BUFFER_COUNT];
+            if (next != driver->dmx.front && next != driver->dmx.leased && next != driver->dmx.staged) {
+                driver->dmx.data = next;
+                break;
+            }
+        }
+    }
+
+    // Drop the packet if there are no buffers available
+    if (driver->dmx.data == driver->dmx.leased) {
+        dmx_state_set_head(dmx_num, DMX_HEAD_WAITING_FOR_BREAK);
+    } else if (driver->dmx.data == driver->dmx.rx_packet_data) {
+        driver->dmx.rx_packet_data = NULL;  // The last packet can no longer be leased
+    }
+}
+
+void DMX_ISR_ATTR dmx_buffer_publish(dmx_port_t dmx_num) {
+    dmx_driver_t *const driver = dmx_driver[dmx_num];
+
+#ifdef CONFIG_DMX_CHANGED_SLOTS
+    // Only DMX packets with a null start code are compared to each other
+    if (driver->dmx.data != driver->dmx.rdm_buffer && driver->dmx.data[0] == DMX_SC) {
+        int size = DMX_STATE_HEAD(DMX_STATE_LOAD(driver));
+        if (size > DMX_PACKET_SIZE_MAX) {
+            size = DMX_PACKET_SIZE_MAX;
+        }
+        memcpy(driver->dmx.changed_last, driver->dmx.data, size);
+        for (int i = 0; i < DMX_SLOT_BITMAP_WORDS; ++i) {
+            driver->dmx.changed[i] = driver->dmx.changed_pending[i];
+        }
+    }
+    for (int i = 0; i < DMX_SLOT_BITMAP_WORDS; ++i) {
+        driver->dmx.changed_pending[i] = 0;
+    }
+#endif
+
+    // Packets received during an RDM transaction are not DMX data
+    if (driver->dmx.data == driver->dmx.rdm_buffer) {
+        return;
+    }
+
+    driver->dmx.front = driver->dmx.data;
+}
+
+void dmx_buffer_begin_rdm(dmx_port_t dmx_num) {
+    dmx_driver_t *const driver = dmx_driver[dmx_num];
+
+    if (driver->dmx.rdm_saved == NULL) {
+        driver->dmx.rdm_saved = driver->dmx.data;
+        driver->dmx.data      = driver->dmx.rdm_buffer;
+        if (driver->dmx.rx_packet_data == driver->dmx.rdm_buffer) {
+            driver->dmx.rx_packet_data = NULL;  // The RDM request overwrites the last RDM packet
+        }
+        dmx_buffer_invalidate_rdm(dmx_num);
+    }
+}
+
+void dmx_buffer_end_rdm(dmx_port_t dmx_num) {
+    dmx_driver_t *const driver = dmx_driver[dmx_num];
+
+    if (driver->dmx.rdm_saved != NULL) {
+        driver->dmx.data      = driver->dmx.rdm_saved;
+        driver->dmx.rdm_saved = NULL;
+        dmx_buffer_invalidate_rdm(dmx_num);
+    }
+}
+
+uint32_t DMX_ISR_ATTR dmx_state_update(dmx_port_t dmx_num, uint32_t mask, uint32_t state) {
+    uint32_t *const word = &dmx_driver[dmx_num]->dmx.state;
+
+    uint32_t expected = __atomic_load_n(word, __ATOMIC_RELAXED);
+    uint32_t desired;
+    do {
+        desired = (expected & ~mask) | (state & mask);
+    } while (!__atomic_compare_exchange_n(word, &expected, desired, true, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED));
+
+    return desired;
+}
+
+void DMX_ISR_ATTR dmx_state_set_head(dmx_port_t dmx_num, int head) {
+    if (head > INT16_MAX) {
+        head = INT16_MAX;  // Overlong packets are only counted for error reporting
+    }
+    dmx_state_update(dmx_num, DMX_STATE_HEAD_MASK, DMX_STATE(0, 0, head));
+}
+
+void DMX_ISR_ATTR dmx_state_set_progress(dmx_port_t dmx_num, int progress) {
+    dmx_state_update(dmx_num, DMX_STATE_PROGRESS_MASK, DMX_STATE(0, progress, 0));
+}
+
+void DMX_ISR_ATTR dmx_state_set_status(dmx_port_t dmx_num, int status) {
+    dmx_state_update(dmx_num, DMX_STATE_STATUS_MASK, DMX_STATE(status, 0, 0));
+}
+
+void dmx_packet_set_timeout(dmx_packet_t *packet) {
+    if (packet != NULL) {
+        packet->err             = DMX_ERR_TIMEOUT;
+        packet->sc              = -1;
+        packet->size            = 0;
+        packet->is_rdm          = 0;
+        packet->sequence        = 0;
+        packet->break_timestamp = -1;
+        packet->timestamp       = -1;
+    }
+}
+
+void DMX_ISR_ATTR dmx_buffer_invalidate_rdm(dmx_port_t dmx_num) { dmx_driver[dmx_num]->rdm.decoded.data = NULL; }
+
+bool DMX_ISR_ATTR rdm_port_is_target(dmx_port_t dmx_num, const rdm_uid_t *uid) {
+    if (rdm_uid_is_target(&dmx_driver[dmx_num]->uid, uid)) {
+        return true;
+    }
+#ifndef CONFIG_RDM_RESPONDER_DISABLE
+    return rdm_virtual_find(dmx_num, uid, 0) >= 0;
+#else
+    return false;
+#endif
+}
+
+#ifndef CONFIG_RDM_RESPONDER_DISABLE
+struct dmx_driver_virtual_responder_t *rdm_virtual_get_active(dmx_port_t dmx_num) {
+    struct dmx_driver_virtual_t *const virtuals = dmx_driver[dmx_num]->rdm.virtuals;
+
+    // The virtual responder is only active for the task which is handling it
+    if (virtuals == NULL || virtuals->active == NULL || virtuals->task != xTaskGetCurrentTaskHandle()) {
+        return NULL;
+    }
+
+    return virtuals->active;
+}
+
+void rdm_virtual_set_active(dmx_port_t dmx_num, struct dmx_driver_virtual_responder_t *responder) {
+    struct dmx_driver_virtual_t *const virtuals = dmx_driver[dmx_num]->rdm.virtuals;
+    if (virtuals == NULL) {
+        return;
+    }
+
+    virtuals->task   = responder != NULL ? xTaskGetCurrentTaskHandle() : NULL;
+    virtuals->active = responder;
+}
+
+int DMX_ISR_ATTR rdm_virtual_find(dmx_port_t dmx_num, const rdm_uid_t *uid, int start) {
+    const struct dmx_driver_virtual_t *const virtuals = dmx_driver[dmx_num]->rdm.virtuals;
+    if (virtuals == NULL) {
+        return -1;
+    }
+
+    // Virtual responders are sorted by UID so unicast UIDs are found with a binary search
+    if (!rdm_uid_is_broadcast(uid)) {
+        int low  = start;
+        int high = virtuals->count;
+        while (low < high) {
+            const int mid = low + (high - low) / 2;
+            if (rdm_uid_is_lt(&virtuals->responders[mid].uid, uid)) {
+                low = mid + 1;
+            } else {
+                high = mid;
+            }
+        }
+        return low < virtuals->count && rdm_uid_is_eq(&virtuals->responders[low].uid, uid) ? low : -1;
+    }
+
+    for (int i = start; i < virtuals->count; ++i) {
+        if (rdm_uid_is_target(&virtuals->responders[i].uid, uid)) {
+            return i;
+        }
+    }
+
+    return -1;
+}
+#endif
+
+void DMX_ISR_ATTR dmx_stats_record_isr(dmx_port_t dmx_num, uint32_t start) {
+    struct dmx_driver_stats_t *const stats = &dmx_driver[dmx_num]->stats;
+
+    const uint32_t elapsed = dmx_timer_get_cycle_count() - start;
+    taskENTER_CRITICAL_ISR(DMX_SPINLOCK(dmx_num));
+    if (elapsed < stats->isr_min || stats->isr_count == 0) {
+        stats->isr_min = elapsed;
+    }
+    if (elapsed > stats->isr_max) {
+        stats->isr_max = elapsed;
+    }
+    stats->isr_total += elapsed;
+    ++stats->isr_count;
+    taskEXIT_CRITICAL_ISR(DMX_SPINLOCK(dmx_num));
+}
+
+void DMX_ISR_ATTR dmx_stats_record_packet(dmx_port_t dmx_num, int64_t now) {
+    struct dmx_driver_stats_t *const stats = &dmx_driver[dmx_num]->stats;
+
+    // Keep a moving average of the packet period, ignoring signal loss
+    const int64_t period = now - stats->last_packet_timestamp;
+    if (stats->last_packet_timestamp > 0 && period < DMX_TIMEOUT_TICK * portTICK_PERIOD_MS * 1000) {
+        if (stats->packet_period == 0) {
+            stats->packet_period = period;
+        } else {
+            stats->packet_period = (stats->packet_period * 7 + period) / 8;
+        }
+    }
+    stats->last_packet_timestamp = now;
+}
+
+void DMX_ISR_ATTR dmx_buffer_swap_staged(dmx_port_t dmx_num) {
+    dmx_driver_t *const driver = dmx_driver[dmx_num];
+
+    if (!driver->dmx.is_staged || driver->dmx.staged_writers > 0 || driver->dmx.data == driver->dmx.leased) {
+        return;
+    }
+
+    // Don't replace an RDM request of the controller or an RDM response of the responder
+    if (driver->dmx.rdm_saved != NULL || (!driver->is_controller && dmx_start_code_is_rdm(driver->dmx.data[0]))) {
+        return;
+    }
+
+    // Swap the buffers so that the staged packet is sent without being copied
+    uint8_t *const sent = driver->dmx.data;
+    if (driver->dmx.front == sent) {
+        driver->dmx.front = driver->dmx.staged;
+    }
+    driver->dmx.data            = driver->dmx.staged;
+    driver->dmx.staged          = sent;
+    driver->dmx.is_staged       = false;
+    driver->dmx.staged_is_stale = true;
+    dmx_buffer_invalidate_rdm(dmx_num);
+}
+
+int DMX_ISR_ATTR dmx_packet_get_size(dmx_port_t dmx_num) {
+    const dmx_driver_t *const driver = dmx_driver[dmx_num];
+
+    // Send DMX packets which are just long enough to include the highest written slot
+    if (driver->dmx.auto_size > 0 && driver->repeater.input < 0 && !dmx_start_code_is_rdm(driver->dmx.data[0])) {
+        return driver->dmx.high_water > driver->dmx.auto_size ? driver->dmx.high_water : driver->dmx.auto_size;
+    }
+
+    return driver->dmx.size;
+}
+
+static void DMX_ISR_ATTR dmx_packet_prepare(dmx_port_t dmx_num, int64_t now) {
+    dmx_driver_t *const driver = dmx_driver[dmx_num];
+
+    dmx_buffer_swap_staged(dmx_num);
+    driver->dmx.size = dmx_packet_get_size(dmx_num);
+    dmx_fade_apply(dmx_num, now);
+}
+
+static void DMX_ISR_ATTR dmx_packet_begin_break(dmx_port_t dmx_num, int64_t now) {
+    dmx_driver_t *const driver = dmx_driver[dmx_num];
+
+    dmx_state_update(dmx_num, DMX_STATE_MASK, DMX_STATE(DMX_STATUS_SENDING, DMX_PROGRESS_IN_BREAK, 0));
+    driver->continuous.break_timestamp = now;
+    dmx_timer_set_counter(dmx_num, 0);
+    dmx_timer_set_alarm(dmx_num, driver->break_len, true);
+    dmx_timer_start(dmx_num);
+
+    dmx_uart_invert_tx(dmx_num, 1);
+}
+
+void DMX_ISR_ATTR dmx_packet_start_break(dmx_port_t dmx_num) {
+    const int64_t now = dmx_timer_get_micros_since_boot();
+    dmx_packet_prepare(dmx_num, now);
+    dmx_packet_begin_break(dmx_num, now);
+}
+
+void DMX_ISR_ATTR dmx_packet_start_group_isr(uint32_t group) {
+    const int64_t now = dmx_timer_get_micros_since_boot();
+
+    // Prepare every packet first so that only the DMX breaks themselves are started together
+    for (dmx_port_t i = 0; i < DMX_NUM_MAX; ++i) {
+        if (group & (1u << i)) {
+            taskENTER_CRITICAL_ISR(DMX_SPINLOCK(i));
+            dmx_packet_prepare(i, now);
+            taskEXIT_CRITICAL_ISR(DMX_SPINLOCK(i));
+        }
+    }
+
+    // Spinlocks are always taken in port order so that groups cannot deadlock
+    for (dmx_port_t i = 0; i < DMX_NUM_MAX; ++i) {
+        if (group & (1u << i)) {
+            taskENTER_CRITICAL_ISR(DMX_SPINLOCK(i));
+        }
+    }
+    for (dmx_port_t i = 0; i < DMX_NUM_MAX; ++i) {
+        if (group & (1u << i)) {
+            dmx_packet_begin_break(i, now);
+        }
+    }
+    for (int i = DMX_NUM_MAX - 1; i >= 0; --i) {
+        if (group & (1u << i)) {
+            taskEXIT_CRITICAL_ISR(DMX_SPINLOCK(i));
+        }
+    }
+}
+
+struct dmx_core_call_t {
+    bool (*func)(void *);  // The function to call.
+    void *arg;             // The argument of the function.
+    bool result;           // The return value of the function.
+    TaskHandle_t caller;   // The task which is waiting for the function to return.
+};
+
+static void dmx_core_call_task(void *arg) {
+    struct dmx_core_call_t *const call = (struct dmx_core_call_t *)arg;
+    call->result                       = call->func(call->arg);
+    xTaskNotifyGive(call->caller);
+    vTaskDelete(NULL);
+}
+
+bool dmx_call_on_core(int core, bool (*func)(void *), void *arg) {
+    assert(core >= -1 && core < portNUM_PROCESSORS);
+    assert(func != NULL);
+
+    if (core < 0) {
+        return func(arg);
+    }
+
+    // Call the function from a task which cannot migrate off of the requested core
+    struct dmx_core_call_t call = {.func = func, .arg = arg, .result = false, .caller = xTaskGetCurrentTaskHandle()};
+    if (xTaskCreatePinnedToCore(dmx_core_call_task, "dmx_core_call", DMX_CORE_CALL_STACK_SIZE, &call,
+                                uxTaskPriorityGet(NULL), NULL, core) != pdPASS) {
+        return false;
+    }
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+    return call.result;
+}
@@ -1,9 +1,41 @@
 #include "sniffer.h"
 
-#include "./hal/include/gpio.h"
 #include "./include/driver.h"
 #include "./include/service.h"
 
+#ifndef CONFIG_DMX_SNIFFER_DISABLE
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "./hal/include/gpio.h"
+#include "./hal/include/rmt.h"
+#include "./hal/include/timer.h"
+
+struct dmx_sniffer_init_t {
+    dmx_driver_t *driver;  // The DMX driver which owns the sniffer.
+    int pin;               // The sniffer pin GPIO number.
+};
+
+static bool dmx_sniffer_init_isr(void *arg) {
+    const struct dmx_sniffer_init_t *init = (struct dmx_sniffer_init_t *)arg;
+    dmx_driver_t *const driver            = init->driver;
+
+#ifdef CONFIG_DMX_SNIFFER_RMT
+    // Capture the sniffer pin with the RMT receiver
+    return dmx_rmt_init(driver->dmx_num, driver, init->pin, driver->isr_flags);
+#else
+    if (driver->isr_core >= 0) {
+        // Install the GPIO ISR service on the DMX interrupt core unless the user already installed it
+        const int flags = DMX_SNIFFER_INTR_FLAGS_DEFAULT | (driver->isr_flags & ESP_INTR_FLAG_LEVELMASK);
+        gpio_install_isr_service(flags);
+    }
+
+    // Add the GPIO interrupt handler
+    return dmx_gpio_init(driver->dmx_num, driver, init->pin);
+#endif
+}
+
 bool dmx_sniffer_enable(dmx_port_t dmx_num, int intr_pin) {
     DMX_CHECK(dmx_num < DMX_NUM_MAX, false, "dmx_num error");
     DMX_CHECK(dmx_sniffer_pin_is_valid(intr_pin), false, "intr_pin error");
@@ -14,20 +46,57 @@ bool dmx_sniffer_enable(dmx_port_t dmx_num, int intr_pin) {
     // Set sniffer default values
     driver->sniffer.last_neg_edge_ts = -1;  // Negative edge hasn't been seen yet
 
-    dmx_driver[dmx_num]->sniffer.is_enabled = true;
+    // Allocate the sniffer history
+    if (DMX_SNIFFER_HISTORY_SIZE > 0) {
+        dmx_metadata_t *history = malloc(DMX_SNIFFER_HISTORY_SIZE * sizeof(*history));
+        DMX_CHECK(history != NULL, false, "sniffer history malloc error");
+        taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+        driver->sniffer.history         = history;
+        driver->sniffer.history_head    = 0;
+        driver->sniffer.history_tail    = 0;
+        driver->sniffer.history_overrun = false;
+        driver->sniffer.last_break_ts   = -1;
+        driver->sniffer.flags           = 0;
+        taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+    }
 
-    // Add the GPIO interrupt handler
-    return dmx_gpio_init(dmx_num, driver, intr_pin);
+    // Install the sniffer interrupt on the DMX interrupt core
+    struct dmx_sniffer_init_t init = {.driver = driver, .pin = intr_pin};
+    const bool success             = dmx_call_on_core(driver->isr_core, dmx_sniffer_init_isr, &init);
+
+    dmx_driver[dmx_num]->sniffer.is_enabled = success;
+    if (!success) {
+        taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+        dmx_metadata_t *history = driver->sniffer.history;
+        driver->sniffer.history = NULL;
+        taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+        free(history);
+    }
+
+    return success;
 }
 
 bool dmx_sniffer_disable(dmx_port_t dmx_num) {
     DMX_CHECK(dmx_num < DMX_NUM_MAX, false, "dmx_num error");
     DMX_CHECK(dmx_sniffer_is_enabled(dmx_num), false, "sniffer is not enabled");
 
+#ifdef CONFIG_DMX_SNIFFER_RMT
+    // Release the RMT receive channel
+    dmx_rmt_deinit(dmx_num);
+#else
     // Disable the interrupt and remove the interrupt handler
     dmx_gpio_deinit(dmx_num);
+#endif
 
-    dmx_driver[dmx_num]->sniffer.is_enabled = false;
+    dmx_driver_t *const driver = dmx_driver[dmx_num];
+    driver->sniffer.is_enabled = false;
+
+    // Free the sniffer history once the DMX ISR can no longer write to it
+    taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+    dmx_metadata_t *history = driver->sniffer.history;
+    driver->sniffer.history = NULL;
+    taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+    free(history);
 
     return true;
 }
@@ -43,9 +112,69 @@ bool dmx_sniffer_get_data(dmx_port_t dmx_num, dmx_metadata_t *metadata) {
 
     dmx_driver_t *const driver = dmx_driver[dmx_num];
 
+    dmx_metadata_t raw;
     taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
-    *metadata = driver->sniffer.metadata[driver->sniffer.buffer_index];
+    raw = driver->sniffer.metadata[driver->sniffer.buffer_index];
     taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+    memset(metadata, 0, sizeof(*metadata));
+
+#ifdef CONFIG_DMX_SNIFFER_RMT
+    // The RMT receiver counts in microseconds
+    *metadata = raw;
+#else
+    // Convert the timestamps which were recorded by the sniffer interrupt
+    metadata->break_len = dmx_timer_timestamp_to_micros(raw.break_len);
+    metadata->mab_len   = dmx_timer_timestamp_to_micros(raw.mab_len);
+#endif
 
     return true;
 }
+
+size_t dmx_sniffer_read_history(dmx_port_t dmx_num, dmx_metadata_t *metadata, size_t count) {
+    DMX_CHECK(dmx_num < DMX_NUM_MAX, 0, "dmx_num error");
+    DMX_CHECK(metadata != NULL || count == 0, 0, "metadata is null");
+    DMX_CHECK(dmx_sniffer_is_enabled(dmx_num), 0, "sniffer is not enabled");
+
+    struct dmx_driver_sniffer_t *const sniffer = &dmx_driver[dmx_num]->sniffer;
+    if (sniffer->history == NULL) {
+        return 0;  // The sniffer history is disabled
+    }
+
+    // Only the reader writes the tail so the DMX ISR never has to be locked out
+    const uint32_t head = __atomic_load_n(&sniffer->history_head, __ATOMIC_ACQUIRE);
+    uint32_t tail       = sniffer->history_tail;
+    size_t num_read     = 0;
+    for (; num_read < count && tail != head; ++num_read, ++tail) {
+        metadata[num_read] = sniffer->history[tail % DMX_SNIFFER_HISTORY_SIZE];
+#ifndef CONFIG_DMX_SNIFFER_RMT
+        // Convert the timestamps which were recorded by the sniffer interrupt
+        metadata[num_read].break_len = dmx_timer_timestamp_to_micros(metadata[num_read].break_len);
+        metadata[num_read].mab_len   = dmx_timer_timestamp_to_micros(metadata[num_read].mab_len);
+#endif
+    }
+    __atomic_store_n(&sniffer->history_tail, tail, __ATOMIC_RELEASE);
+
+    return num_read;
+}
+
+#else
+
+bool dmx_sniffer_enable(dmx_port_t dmx_num, int intr_pin) {
+    DMX_CHECK(false, false, "CONFIG_DMX_SNIFFER_DISABLE is enabled");
+}
+
+bool dmx_sniffer_disable(dmx_port_t dmx_num) {
+    DMX_CHECK(false, false, "CONFIG_DMX_SNIFFER_DISABLE is enabled");
+}
+
+bool dmx_sniffer_is_enabled(dmx_port_t dmx_num) { return false; }
+
+bool dmx_sniffer_get_data(dmx_port_t dmx_num, dmx_metadata_t *metadata) {
+    DMX_CHECK(false, false, "CONFIG_DMX_SNIFFER_DISABLE is enabled");
+}
+
+size_t dmx_sniffer_read_history(dmx_port_t dmx_num, dmx_metadata_t *metadata, size_t count) {
+    DMX_CHECK(false, 0, "CONFIG_DMX_SNIFFER_DISABLE is enabled");
+}
+
+#endif
@@ -71,6 +71,24 @@ bool dmx_sniffer_is_enabled(dmx_port_t dmx_num);
  */
 bool dmx_sniffer_get_data(dmx_port_t dmx_num, dmx_metadata_t *metadata);
 
+/**
+ * @brief Reads packets from the DMX sniffer history, oldest first. The
+ * sniffer records each packet when the DMX break of the following packet is
+ * received, including its start code, size, period, and any receive errors.
+ * The history holds CONFIG_DMX_SNIFFER_HISTORY_SIZE packets. When it is full,
+ * newer packets are dropped and the next recorded packet is flagged with
+ * DMX_SNIFFER_FLAG_HISTORY_OVERRUN. The history does not lock out the DMX
+ * interrupt, so it must only be read from one task at a time.
+ *
+ * @param dmx_num The DMX port number.
+ * @param[out] metadata An array of dmx_metadata_t into which to copy the
+ * sniffed packets.
+ * @param count The number of elements in the metadata array.
+ * @return The number of packets which were read.
+ */
+size_t dmx_sniffer_read_history(dmx_port_t dmx_num, dmx_metadata_t *metadata,
+                                size_t count);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,213 @@
+#include "trace.h"
+
+#include "./include/driver.h"
+#include "./include/service.h"
+
+#ifdef CONFIG_DMX_TRACE
+
+#include <inttypes.h>
+#include <stdlib.h>
+
+#include "./hal/include/timer.h"
+
+#define DMX_TRACE_SIZE (CONFIG_DMX_TRACE_SIZE)
+
+enum {
+    DMX_TRACE_TID_UART = 1,  // The trace viewer thread of the DMX UART interrupt.
+    DMX_TRACE_TID_TIMER,     // The trace viewer thread of the DMX timer interrupt.
+    DMX_TRACE_TID_GPIO,      // The trace viewer thread of the DMX sniffer interrupt.
+    DMX_TRACE_TID_TASK,      // The trace viewer thread of the tasks which send and receive.
+};
+
+static const struct dmx_trace_event_info_t {
+    const char *name;  // The name of the event.
+    char phase;        // The Trace Event Format phase of the event.
+    uint8_t tid;       // The trace viewer thread of the event.
+} dmx_trace_event_info[DMX_TRACE_EVENT_MAX] = {
+    [DMX_TRACE_UART_ISR_ENTER]  = {"uart_isr", 'B', DMX_TRACE_TID_UART},
+    [DMX_TRACE_UART_ISR_EXIT]   = {"uart_isr", 'E', DMX_TRACE_TID_UART},
+    [DMX_TRACE_UART_INTR]       = {"uart_intr", 'i', DMX_TRACE_TID_UART},
+    [DMX_TRACE_RX_BREAK]        = {"rx_break", 'i', DMX_TRACE_TID_UART},
+    [DMX_TRACE_RX_PACKET]       = {"rx_packet", 'i', DMX_TRACE_TID_UART},
+    [DMX_TRACE_TX_DONE]         = {"tx_done", 'i', DMX_TRACE_TID_UART},
+    [DMX_TRACE_TIMER_ISR_ENTER] = {"timer_isr", 'B', DMX_TRACE_TID_TIMER},
+    [DMX_TRACE_TIMER_ISR_EXIT]  = {"timer_isr", 'E', DMX_TRACE_TID_TIMER},
+    [DMX_TRACE_GPIO_EDGE]       = {"gpio_edge", 'i', DMX_TRACE_TID_GPIO},
+    [DMX_TRACE_SEND_ENTER]      = {"dmx_send_num", 'B', DMX_TRACE_TID_TASK},
+    [DMX_TRACE_SEND_EXIT]       = {"dmx_send_num", 'E', DMX_TRACE_TID_TASK},
+    [DMX_TRACE_RECEIVE_ENTER]   = {"dmx_receive_num", 'B', DMX_TRACE_TID_TASK},
+    [DMX_TRACE_RECEIVE_EXIT]    = {"dmx_receive_num", 'E', DMX_TRACE_TID_TASK},
+};
+
+static struct dmx_trace_t {
+    uint32_t head;                               // The index of the next event which is recorded.
+    uint32_t tail;                               // The index of the oldest event since the trace was cleared.
+    uint32_t seq[DMX_TRACE_SIZE];                // The index plus one of the event in each slot, or 0 while it is written.
+    dmx_trace_record_t records[DMX_TRACE_SIZE];  // The recorded events.
+} dmx_trace[DMX_NUM_MAX];
+
+void DMX_ISR_ATTR dmx_trace_record(dmx_port_t dmx_num, int event, int err, int32_t value) {
+    struct dmx_trace_t *const trace = &dmx_trace[dmx_num];
+
+    /* Each writer claims a slot by incrementing the head, so the UART and timer
+    interrupts and the tasks on either core may record events without a lock.
+    The sequence number of the slot is cleared while the event is written so
+    that readers discard events which are torn. */
+    const uint32_t index = __atomic_fetch_add(&trace->head, 1, __ATOMIC_RELAXED);
+    const uint32_t slot  = index % DMX_TRACE_SIZE;
+    __atomic_store_n(&trace->seq[slot], 0, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    dmx_trace_record_t *const record = &trace->records[slot];
+    record->timestamp                = dmx_timer_get_micros_since_boot();
+    record->event                    = event;
+    record->err                      = err;
+    record->value                    = value < 0 ? 0 : value > UINT16_MAX ? UINT16_MAX : value;
+    __atomic_store_n(&trace->seq[slot], index + 1, __ATOMIC_RELEASE);
+}
+
+size_t dmx_trace_get(dmx_port_t dmx_num, dmx_trace_record_t *records, size_t size) {
+    DMX_CHECK(dmx_num < DMX_NUM_MAX, 0, "dmx_num error");
+    DMX_CHECK(records != NULL || size == 0, 0, "records is null");
+
+    struct dmx_trace_t *const trace = &dmx_trace[dmx_num];
+    const uint32_t head             = __atomic_load_n(&trace->head, __ATOMIC_ACQUIRE);
+    uint32_t available              = head - __atomic_load_n(&trace->tail, __ATOMIC_RELAXED);
+    if (available > DMX_TRACE_SIZE) {
+        available = DMX_TRACE_SIZE;
+    }
+    if (available > size) {
+        available = size;  // Copy the newest events
+    }
+
+    size_t count = 0;
+    for (uint32_t index = head - available; index != head; ++index) {
+        const uint32_t slot = index % DMX_TRACE_SIZE;
+        if (__atomic_load_n(&trace->seq[slot], __ATOMIC_ACQUIRE) != index + 1) {
+            continue;  // The event is being written or was overwritten
+        }
+        records[count] = trace->records[slot];
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&trace->seq[slot], __ATOMIC_RELAXED) == index + 1) {
+            ++count;  // The event was not overwritten while it was copied
+        }
+    }
+
+    return count;
+}
+
+uint32_t dmx_trace_get_overwritten(dmx_port_t dmx_num) {
+    DMX_CHECK(dmx_num < DMX_NUM_MAX, 0, "dmx_num error");
+
+    struct dmx_trace_t *const trace = &dmx_trace[dmx_num];
+    const uint32_t tail             = __atomic_load_n(&trace->tail, __ATOMIC_RELAXED);
+    const uint32_t recorded         = __atomic_load_n(&trace->head, __ATOMIC_RELAXED) - tail;
+    return recorded > DMX_TRACE_SIZE ? recorded - DMX_TRACE_SIZE : 0;
+}
+
+bool dmx_trace_clear(dmx_port_t dmx_num) {
+    DMX_CHECK(dmx_num < DMX_NUM_MAX, false, "dmx_num error");
+
+    struct dmx_trace_t *const trace = &dmx_trace[dmx_num];
+    __atomic_store_n(&trace->tail, __atomic_load_n(&trace->head, __ATOMIC_RELAXED), __ATOMIC_RELAXED);
+
+    return true;
+}
+
+size_t dmx_trace_print(dmx_port_t dmx_num) {
+    DMX_CHECK(dmx_num < DMX_NUM_MAX, 0, "dmx_num error");
+
+    dmx_trace_record_t *const records = malloc(sizeof(dmx_trace_record_t) * DMX_TRACE_SIZE);
+    DMX_CHECK(records != NULL, 0, "trace malloc error");
+    const size_t count = dmx_trace_get(dmx_num, records, DMX_TRACE_SIZE);
+
+    for (size_t i = 0; i < count; ++i) {
+        const dmx_trace_record_t *const record = &records[i];
+        const char *name = record->event < DMX_TRACE_EVENT_MAX ? dmx_trace_event_info[record->event].name : "unknown";
+        const char *phase = "";
+        if (record->event < DMX_TRACE_EVENT_MAX) {
+            phase = dmx_trace_event_info[record->event].phase == 'B'   ? " enter"
+                    : dmx_trace_event_info[record->event].phase == 'E' ? " exit"
+                                                                       : "";
+        }
+        printf("%10" PRIu32 " dmx%i %s%s value=%u err=%u\n", record->timestamp, dmx_num, name, phase, record->value,
+               record->err);
+    }
+
+    free(records);
+    return count;
+}
+
+size_t dmx_trace_write_json(FILE *stream) {
+    DMX_CHECK(stream != NULL, 0, "stream is null");
+
+    dmx_trace_record_t *const records = malloc(sizeof(dmx_trace_record_t) * DMX_TRACE_SIZE);
+    DMX_CHECK(records != NULL, 0, "trace malloc error");
+
+    static const char *thread_names[] = {
+        [DMX_TRACE_TID_UART]  = "UART ISR",
+        [DMX_TRACE_TID_TIMER] = "Timer ISR",
+        [DMX_TRACE_TID_GPIO]  = "Sniffer ISR",
+        [DMX_TRACE_TID_TASK]  = "Tasks",
+    };
+
+    size_t written = 0;
+    bool is_first  = true;
+    fputs("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[", stream);
+    for (dmx_port_t dmx_num = 0; dmx_num < DMX_NUM_MAX; ++dmx_num) {
+        const size_t count = dmx_trace_get(dmx_num, records, DMX_TRACE_SIZE);
+        if (count == 0) {
+            continue;
+        }
+
+        // Name the process and threads of the DMX port
+        fprintf(stream, "%s\n{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%i,\"args\":{\"name\":\"DMX port %i\"}}",
+                is_first ? "" : ",", dmx_num, dmx_num);
+        is_first = false;
+        for (int tid = DMX_TRACE_TID_UART; tid <= DMX_TRACE_TID_TASK; ++tid) {
+            fprintf(stream, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%i,\"tid\":%i,\"args\":{\"name\":\"%s\"}}",
+                    dmx_num, tid, thread_names[tid]);
+        }
+
+        for (size_t i = 0; i < count; ++i) {
+            const dmx_trace_record_t *const record = &records[i];
+            if (record->event >= DMX_TRACE_EVENT_MAX) {
+                continue;
+            }
+            const struct dmx_trace_event_info_t *const info = &dmx_trace_event_info[record->event];
+            fprintf(stream,
+                    ",\n{\"name\":\"%s\",\"ph\":\"%c\",%s\"ts\":%" PRIu32
+                    ",\"pid\":%i,\"tid\":%i,\"args\":{\"value\":%u,\"err\":%u}}",
+                    info->name, info->phase, info->phase == 'i' ? "\"s\":\"t\"," : "", record->timestamp, dmx_num,
+                    info->tid, record->value, record->err);
+            ++written;
+        }
+    }
+    fputs("\n]}\n", stream);
+
+    free(records);
+    return written;
+}
+
+#else
+
+size_t dmx_trace_get(dmx_port_t dmx_num, dmx_trace_record_t *records, size_t size) {
+    DMX_CHECK(false, 0, "CONFIG_DMX_TRACE is not enabled");
+}
+
+uint32_t dmx_trace_get_overwritten(dmx_port_t dmx_num) {
+    DMX_CHECK(false, 0, "CONFIG_DMX_TRACE is not enabled");
+}
+
+bool dmx_trace_clear(dmx_port_t dmx_num) {
+    DMX_CHECK(false, false, "CONFIG_DMX_TRACE is not enabled");
+}
+
+size_t dmx_trace_print(dmx_port_t dmx_num) {
+    DMX_CHECK(false, 0, "CONFIG_DMX_TRACE is not enabled");
+}
+
+size_t dmx_trace_write_json(FILE *stream) {
+    DMX_CHECK(false, 0, "CONFIG_DMX_TRACE is not enabled");
+}
+
+#endif
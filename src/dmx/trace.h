@@ -0,0 +1,133 @@
+/**
+ * @file dmx/trace.h
+ * @author Mitch Weisbrod (mitch@theweisbrods.com)
+ * @brief This file contains functions to read the event trace of each DMX
+ * port. When CONFIG_DMX_TRACE is enabled, the DMX interrupts and the
+ * dmx_send_num() and dmx_receive_num() functions record compact timestamped
+ * events into a lock-free ring on each DMX port. The trace may be read back,
+ * printed, or written as JSON which can be opened in Perfetto or in the Chrome
+ * trace viewer. When CONFIG_DMX_TRACE is disabled, no events are recorded and
+ * the trace does not use any memory.
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "./include/types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @brief The events which are recorded in the trace of a DMX port.*/
+typedef enum dmx_trace_event_t {
+  /** @brief The DMX UART interrupt was entered.*/
+  DMX_TRACE_UART_ISR_ENTER,
+  /** @brief The DMX UART interrupt was exited.*/
+  DMX_TRACE_UART_ISR_EXIT,
+  /** @brief The DMX UART interrupt handled a set of UART interrupt flags. The
+     value is the UART interrupt flags.*/
+  DMX_TRACE_UART_INTR,
+  /** @brief A DMX break was received. The value is the number of slots which
+     were received since the last DMX break, including the null slot of the
+     DMX break.*/
+  DMX_TRACE_RX_BREAK,
+  /** @brief A packet was received. The value is the size of the packet. The
+     error is the error of the packet.*/
+  DMX_TRACE_RX_PACKET,
+  /** @brief The UART finished sending a packet.*/
+  DMX_TRACE_TX_DONE,
+  /** @brief The DMX timer interrupt was entered. The value is the progress of
+     the packet which is being sent.*/
+  DMX_TRACE_TIMER_ISR_ENTER,
+  /** @brief The DMX timer interrupt was exited.*/
+  DMX_TRACE_TIMER_ISR_EXIT,
+  /** @brief The DMX sniffer pin changed level. The value is the new level.*/
+  DMX_TRACE_GPIO_EDGE,
+  /** @brief dmx_send_num() was entered. The value is the requested size.*/
+  DMX_TRACE_SEND_ENTER,
+  /** @brief dmx_send_num() returned. The value is the returned size.*/
+  DMX_TRACE_SEND_EXIT,
+  /** @brief dmx_receive_num() was entered. The value is the requested size.*/
+  DMX_TRACE_RECEIVE_ENTER,
+  /** @brief dmx_receive_num() returned. The value is the returned size. The
+     error is the error of the packet.*/
+  DMX_TRACE_RECEIVE_EXIT,
+  /** @brief The number of DMX trace events.*/
+  DMX_TRACE_EVENT_MAX
+} dmx_trace_event_t;
+
+/** @brief An event which was recorded in the trace of a DMX port.*/
+typedef struct __attribute__((packed)) dmx_trace_record_t {
+  /** @brief The time at which the event was recorded in microseconds since
+     boot. It wraps every 71 minutes.*/
+  uint32_t timestamp;
+  /** @brief The type of the event. It is a dmx_trace_event_t.*/
+  uint8_t event;
+  /** @brief The error of the event, or DMX_OK.*/
+  uint8_t err;
+  /** @brief The value of the event. Its meaning depends on the type of the
+     event. Values are saturated to the range 0 to 65535.*/
+  uint16_t value;
+} dmx_trace_record_t;
+
+/**
+ * @brief Copies the events in the trace of a DMX port, from the oldest to the
+ * newest. If the trace holds more events than will fit, the newest events are
+ * copied. Events may continue to be recorded while the trace is copied. Events
+ * which are overwritten while they are copied are not copied.
+ *
+ * @param dmx_num The DMX port number.
+ * @param[out] records A pointer to an array into which the events are copied.
+ * @param size The number of events which fit in the array.
+ * @return The number of events which were copied.
+ */
+size_t dmx_trace_get(dmx_port_t dmx_num, dmx_trace_record_t *records,
+                     size_t size);
+
+/**
+ * @brief Gets the number of events which have been overwritten by newer
+ * events since the trace of the DMX port was last cleared.
+ *
+ * @param dmx_num The DMX port number.
+ * @return The number of overwritten events.
+ */
+uint32_t dmx_trace_get_overwritten(dmx_port_t dmx_num);
+
+/**
+ * @brief Discards the events in the trace of a DMX port.
+ *
+ * @param dmx_num The DMX port number.
+ * @return true on success.
+ * @return false on failure.
+ */
+bool dmx_trace_clear(dmx_port_t dmx_num);
+
+/**
+ * @brief Prints the events in the trace of a DMX port to the standard output,
+ * one event per line.
+ *
+ * @param dmx_num The DMX port number.
+ * @return The number of events which were printed.
+ */
+size_t dmx_trace_print(dmx_port_t dmx_num);
+
+/**
+ * @brief Writes the events in the traces of every DMX port to a stream as a
+ * JSON object in the Trace Event Format, which can be opened in Perfetto
+ * (https://ui.perfetto.dev) or in the Chrome trace viewer. Each DMX port is
+ * shown as a process. The UART interrupt, timer interrupt, sniffer interrupt,
+ * and the calling tasks of each DMX port are shown as separate threads so
+ * that nested interrupts are shown correctly.
+ *
+ * @param[inout] stream The stream to which the JSON is written.
+ * @return The number of events which were written.
+ */
+size_t dmx_trace_write_json(FILE *stream);
+
+#ifdef __cplusplus
+}
+#endif
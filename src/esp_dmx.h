@@ -56,6 +56,25 @@ extern "C" {
         ESP_DMX_VERSION_ID,           /*software_version_id*/         \
         ESP_DMX_VERSION_LABEL,        /*software_version_label*/      \
         32,                           /*queue_size_max*/              \
+        DMX_INTR_CORE_DEFAULT,        /*interrupt_core*/              \
+        0,                            /*interrupt_level*/             \
+  }
+
+/** @brief The configuration for a DMX or RDM controller which does not
+ * respond to RDM requests. No RDM responder parameters are registered, which
+ * reduces the memory and time needed to install the DMX driver.*/
+#define DMX_CONFIG_CONTROLLER                                         \
+  (dmx_config_t) {                                                    \
+    DMX_INTR_FLAGS_DEFAULT,           /*interrupt_flags*/             \
+        0,                            /*root_device_parameter_count*/ \
+        0,                            /*sub_device_parameter_count*/  \
+        0,                            /*model_id*/                    \
+        RDM_PRODUCT_CATEGORY_FIXTURE, /*product_category*/            \
+        ESP_DMX_VERSION_ID,           /*software_version_id*/         \
+        ESP_DMX_VERSION_LABEL,        /*software_version_label*/      \
+        0,                            /*queue_size_max*/              \
+        DMX_INTR_CORE_DEFAULT,        /*interrupt_core*/              \
+        0,                            /*interrupt_level*/             \
   }
 
 #ifdef __cplusplus
@@ -0,0 +1,620 @@
+/**
+ * @file esp_dmx.hpp
+ * @author Mitch Weisbrod (mitch@theweisbrods.com)
+ * @brief This is a header-only C++17 interface to esp_dmx. It provides RAII
+ * ownership of the DMX driver, typed views of received DMX packets using
+ * constexpr channel maps, and RDM parameter descriptions which encode and
+ * decode RDM parameter data at compile time. It is built on top of the C
+ * functions in esp_dmx.h which may still be called alongside it.
+ */
+#pragma once
+
+#if __cplusplus < 201703L
+#error "esp_dmx.hpp requires C++17 or later"
+#endif
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#if __has_include(<span>) && __cplusplus > 201703L
+#include <span>
+#endif
+
+#include "esp_dmx.h"
+#include "rdm/controller/include/utils.h"
+#include "rdm/include/driver.h"
+
+namespace esp_dmx {
+
+#ifdef __cpp_lib_span
+/** @brief A non-owning view of contiguous slots.*/
+template <typename T>
+using Span = std::span<T>;
+#else
+/** @brief A non-owning view of contiguous slots. This provides the subset of
+ * std::span which is used by this header when std::span is not available.*/
+template <typename T>
+class Span {
+ public:
+  constexpr Span() noexcept = default;
+  constexpr Span(T *data, size_t size) noexcept : data_(data), size_(size) {}
+  template <size_t N>
+  constexpr Span(T (&array)[N]) noexcept : data_(array), size_(N) {}
+  template <typename U, size_t N>
+  constexpr Span(std::array<U, N> &array) noexcept
+      : data_(array.data()), size_(N) {}
+  template <typename U, size_t N>
+  constexpr Span(const std::array<U, N> &array) noexcept
+      : data_(array.data()), size_(N) {}
+  template <typename U,
+            typename = std::enable_if_t<std::is_convertible_v<U *, T *>>>
+  constexpr Span(const Span<U> &other) noexcept
+      : data_(other.data()), size_(other.size()) {}
+
+  constexpr T *data() const noexcept { return data_; }
+  constexpr size_t size() const noexcept { return size_; }
+  constexpr bool empty() const noexcept { return size_ == 0; }
+  constexpr T &operator[](size_t i) const { return data_[i]; }
+  constexpr T *begin() const noexcept { return data_; }
+  constexpr T *end() const noexcept { return data_ + size_; }
+  constexpr Span first(size_t count) const { return {data_, count}; }
+  constexpr Span subspan(size_t offset, size_t count) const {
+    return {data_ + offset, count};
+  }
+
+ private:
+  T *data_{nullptr};
+  size_t size_{0};
+};
+#endif
+
+/**
+ * @brief Maps an 8-bit channel onto a slot of a DMX packet. The offset is
+ * relative to the first slot of the view which is read or written. When the
+ * view is a whole DMX packet, offset 0 is the DMX start code and offset 1 is
+ * the first DMX slot.
+ */
+struct Channel8 {
+  /** @brief The type of the value of the channel.*/
+  using value_type = uint8_t;
+
+  /** @brief The offset of the slot of the channel.*/
+  size_t offset;
+
+  /** @brief The number of slots needed to hold this channel.*/
+  constexpr size_t end() const { return offset + 1; }
+  constexpr value_type decode(const uint8_t *slots) const {
+    return slots[offset];
+  }
+  constexpr void encode(uint8_t *slots, value_type value) const {
+    slots[offset] = value;
+  }
+};
+
+/**
+ * @brief Maps a 16-bit channel onto a pair of coarse and fine slots of a DMX
+ * packet. The coarse slot holds the most significant byte. The slots are
+ * usually adjacent but need not be. Offsets are relative to the first slot of
+ * the view which is read or written.
+ */
+struct Channel16 {
+  /** @brief The type of the value of the channel.*/
+  using value_type = uint16_t;
+
+  /** @brief The offset of the slot of the most significant byte.*/
+  size_t coarse;
+  /** @brief The offset of the slot of the least significant byte.*/
+  size_t fine;
+
+  /** @brief Maps a 16-bit channel onto two adjacent slots.*/
+  constexpr explicit Channel16(size_t coarse)
+      : coarse(coarse), fine(coarse + 1) {}
+  constexpr Channel16(size_t coarse, size_t fine)
+      : coarse(coarse), fine(fine) {}
+
+  /** @brief The number of slots needed to hold this channel.*/
+  constexpr size_t end() const { return (coarse > fine ? coarse : fine) + 1; }
+  constexpr value_type decode(const uint8_t *slots) const {
+    return (slots[coarse] << 8) | slots[fine];
+  }
+  constexpr void encode(uint8_t *slots, value_type value) const {
+    slots[coarse] = value >> 8;
+    slots[fine] = value & 0xff;
+  }
+};
+
+/**
+ * @brief Gets the number of slots needed to hold all of the channels in a
+ * channel map. This can be used with static_assert() to check the footprint
+ * of a DMX personality at compile time.
+ */
+template <typename... Channels>
+constexpr size_t footprint_of(const Channels &...channels) {
+  size_t footprint = 0;
+  ((footprint = channels.end() > footprint ? channels.end() : footprint), ...);
+  return footprint;
+}
+
+/**
+ * @brief A read-only view of the slots of a DMX packet which are read using
+ * channel maps. Channels which are not within the view are read as 0.
+ */
+class Universe {
+ public:
+  constexpr Universe() noexcept = default;
+  constexpr explicit Universe(Span<const uint8_t> slots) noexcept
+      : slots_(slots) {}
+  constexpr Universe(const uint8_t *slots, size_t size) noexcept
+      : slots_(slots, size) {}
+
+  /** @brief The number of slots in the view.*/
+  constexpr size_t size() const noexcept { return slots_.size(); }
+  constexpr bool empty() const noexcept { return slots_.empty(); }
+  constexpr Span<const uint8_t> slots() const noexcept { return slots_; }
+
+  /** @brief Checks if a channel is within the view.*/
+  template <typename Channel>
+  constexpr bool contains(const Channel &channel) const {
+    return channel.end() <= slots_.size();
+  }
+
+  /** @brief Reads the value of a channel, or 0 if it is not in the view.*/
+  template <typename Channel>
+  constexpr typename Channel::value_type operator[](
+      const Channel &channel) const {
+    return contains(channel) ? channel.decode(slots_.data()) : 0;
+  }
+
+  /** @brief Gets a slice of slots of the view. The slice is shortened to the
+   * end of the view.*/
+  constexpr Span<const uint8_t> slice(size_t offset, size_t count) const {
+    if (offset >= slots_.size()) {
+      return {};
+    }
+    const size_t remaining = slots_.size() - offset;
+    return slots_.subspan(offset, count < remaining ? count : remaining);
+  }
+
+ private:
+  Span<const uint8_t> slots_{};
+};
+
+/**
+ * @brief Owns a DMX packet which is leased from the DMX driver. The lease is
+ * returned to the DMX driver when this object is destroyed. Only one lease may
+ * be held per DMX port.
+ */
+class Lease {
+ public:
+  Lease() noexcept = default;
+  Lease(const Lease &) = delete;
+  Lease &operator=(const Lease &) = delete;
+  Lease(Lease &&other) noexcept { *this = std::move(other); }
+  Lease &operator=(Lease &&other) noexcept {
+    if (this != &other) {
+      release();
+      dmx_num_ = std::exchange(other.dmx_num_, DMX_NUM_MAX);
+      universe_ = std::exchange(other.universe_, Universe{});
+      packet_ = other.packet_;
+    }
+    return *this;
+  }
+  ~Lease() { release(); }
+
+  /** @brief Evaluates to true if a packet was received.*/
+  explicit operator bool() const noexcept { return dmx_num_ < DMX_NUM_MAX; }
+
+  /** @brief The slots of the received packet.*/
+  const Universe &universe() const noexcept { return universe_; }
+  const Universe *operator->() const noexcept { return &universe_; }
+
+  /** @brief Information about the received packet.*/
+  const dmx_packet_t &packet() const noexcept { return packet_; }
+
+  /** @brief Returns the lease to the DMX driver early.*/
+  void release() noexcept {
+    if (dmx_num_ < DMX_NUM_MAX) {
+      dmx_release(dmx_num_);
+      dmx_num_ = DMX_NUM_MAX;
+      universe_ = Universe{};
+    }
+  }
+
+ private:
+  friend class Driver;
+
+  dmx_port_t dmx_num_{DMX_NUM_MAX};
+  Universe universe_{};
+  dmx_packet_t packet_{};
+};
+
+/**
+ * @brief Owns an installed DMX driver. The DMX driver is installed and its
+ * pins are set when this object is constructed and it is deleted when this
+ * object is destroyed. Because exceptions are typically disabled, a driver
+ * which failed to install evaluates to false.
+ */
+class Driver {
+ public:
+  Driver(dmx_port_t dmx_num, const dmx_config_t &config, int tx_pin,
+         int rx_pin, int rts_pin,
+         const dmx_personality_t *personalities = nullptr,
+         int personality_count = 0) noexcept {
+    if (dmx_driver_install(dmx_num, &config, personalities,
+                           personality_count)) {
+      if (dmx_set_pin(dmx_num, tx_pin, rx_pin, rts_pin)) {
+        dmx_num_ = dmx_num;
+      } else {
+        dmx_driver_delete(dmx_num);
+      }
+    }
+  }
+  Driver(const Driver &) = delete;
+  Driver &operator=(const Driver &) = delete;
+  Driver(Driver &&other) noexcept
+      : dmx_num_(std::exchange(other.dmx_num_, DMX_NUM_MAX)) {}
+  Driver &operator=(Driver &&other) noexcept {
+    if (this != &other) {
+      reset();
+      dmx_num_ = std::exchange(other.dmx_num_, DMX_NUM_MAX);
+    }
+    return *this;
+  }
+  ~Driver() { reset(); }
+
+  /** @brief Evaluates to true if the DMX driver is installed.*/
+  explicit operator bool() const noexcept { return dmx_num_ < DMX_NUM_MAX; }
+
+  /** @brief The DMX port number of the DMX driver.*/
+  dmx_port_t port() const noexcept { return dmx_num_; }
+
+  /** @brief Deletes the DMX driver early.*/
+  void reset() noexcept {
+    if (dmx_num_ < DMX_NUM_MAX) {
+      dmx_driver_delete(dmx_num_);
+      dmx_num_ = DMX_NUM_MAX;
+    }
+  }
+
+  /** @brief Receives a DMX packet and leases it. See dmx_receive_lease().*/
+  Lease receive(TickType_t wait_ticks) const {
+    Lease lease;
+    const uint8_t *data = nullptr;
+    const size_t size =
+        dmx_receive_lease(dmx_num_, &data, &lease.packet_, wait_ticks);
+    if (data != nullptr) {
+      lease.dmx_num_ = dmx_num_;
+      lease.universe_ = Universe(data, size);
+    }
+    return lease;
+  }
+
+  /** @brief Receives a DMX packet and leases this device's footprint. Offset 0
+   * of the view is the slot at the DMX start address. See
+   * dmx_receive_footprint().*/
+  Lease receive_footprint(bool only_changed, TickType_t wait_ticks) const {
+    Lease lease;
+    const uint8_t *slots = nullptr;
+    const size_t size = dmx_receive_footprint(
+        dmx_num_, &slots, &lease.packet_, only_changed, wait_ticks);
+    if (slots != nullptr) {
+      lease.dmx_num_ = dmx_num_;
+      lease.universe_ = Universe(slots, size);
+    }
+    return lease;
+  }
+
+  /** @brief Copies slots from the DMX driver. See dmx_read_offset().*/
+  size_t read(Span<uint8_t> destination, size_t offset = 0) const {
+    return dmx_read_offset(dmx_num_, offset, destination.data(),
+                           destination.size());
+  }
+
+  /** @brief Copies slots into the DMX driver. See dmx_write_offset().*/
+  size_t write(Span<const uint8_t> source, size_t offset = 0) const {
+    return dmx_write_offset(dmx_num_, offset, source.data(), source.size());
+  }
+
+  /** @brief Writes the value of a channel into the DMX driver. Offset 0 of
+   * the channel map is the DMX start code.*/
+  bool write(const Channel8 &channel, uint8_t value) const {
+    return dmx_write_offset(dmx_num_, channel.offset, &value, 1) == 1;
+  }
+  bool write(const Channel16 &channel, uint16_t value) const {
+    const uint8_t coarse = value >> 8, fine = value & 0xff;
+    return dmx_write_offset(dmx_num_, channel.coarse, &coarse, 1) == 1 &&
+           dmx_write_offset(dmx_num_, channel.fine, &fine, 1) == 1;
+  }
+
+  /** @brief Sends a DMX packet. See dmx_send_num().*/
+  size_t send(size_t size = 0) const { return dmx_send_num(dmx_num_, size); }
+
+ private:
+  dmx_port_t dmx_num_{DMX_NUM_MAX};
+};
+
+namespace rdm {
+
+/**
+ * @brief Encodes and decodes one field of RDM parameter data in big-endian
+ * order. Specializations are provided for integers, bools, enums, rdm_uid_t, and
+ * std::array of any of these. Variable-length fields, such as ASCII strings
+ * and optional UIDs, must be read and written with RDM format strings.
+ */
+template <typename T, typename = void>
+struct Field;
+
+template <typename T>
+struct Field<T, std::enable_if_t<std::is_integral_v<T> &&
+                                 !std::is_same_v<T, bool>>> {
+  static constexpr size_t size = sizeof(T);
+  static constexpr void encode(uint8_t *pd, T value) {
+    using U = std::make_unsigned_t<T>;
+    for (size_t i = 0; i < size; ++i) {
+      pd[i] = static_cast<U>(value) >> (8 * (size - 1 - i));
+    }
+  }
+  static constexpr T decode(const uint8_t *pd) {
+    std::make_unsigned_t<T> value = 0;
+    for (size_t i = 0; i < size; ++i) {
+      value = (value << 8) | pd[i];
+    }
+    return static_cast<T>(value);
+  }
+};
+
+template <>
+struct Field<bool> {
+  static constexpr size_t size = 1;
+  static constexpr void encode(uint8_t *pd, bool value) { pd[0] = value; }
+  static constexpr bool decode(const uint8_t *pd) { return pd[0] != 0; }
+};
+
+template <typename T>
+struct Field<T, std::enable_if_t<std::is_enum_v<T>>> {
+  using underlying = Field<std::underlying_type_t<T>>;
+  static constexpr size_t size = underlying::size;
+  static constexpr void encode(uint8_t *pd, T value) {
+    underlying::encode(pd, static_cast<std::underlying_type_t<T>>(value));
+  }
+  static constexpr T decode(const uint8_t *pd) {
+    return static_cast<T>(underlying::decode(pd));
+  }
+};
+
+template <>
+struct Field<rdm_uid_t> {
+  static constexpr size_t size = 6;
+  static constexpr void encode(uint8_t *pd, const rdm_uid_t &uid) {
+    Field<uint16_t>::encode(pd, uid.man_id);
+    Field<uint32_t>::encode(pd + 2, uid.dev_id);
+  }
+  static constexpr rdm_uid_t decode(const uint8_t *pd) {
+    return {Field<uint16_t>::decode(pd), Field<uint32_t>::decode(pd + 2)};
+  }
+};
+
+template <typename T, size_t N>
+struct Field<std::array<T, N>> {
+  static constexpr size_t size = Field<T>::size * N;
+  static constexpr void encode(uint8_t *pd, const std::array<T, N> &values) {
+    for (size_t i = 0; i < N; ++i) {
+      Field<T>::encode(pd + i * Field<T>::size, values[i]);
+    }
+  }
+  static constexpr std::array<T, N> decode(const uint8_t *pd) {
+    std::array<T, N> values{};
+    for (size_t i = 0; i < N; ++i) {
+      values[i] = Field<T>::decode(pd + i * Field<T>::size);
+    }
+    return values;
+  }
+};
+
+namespace detail {
+
+template <typename... Fields>
+struct value_of {
+  using type = std::tuple<Fields...>;
+};
+
+template <typename Field>
+struct value_of<Field> {
+  using type = Field;
+};
+
+/* RDM requires that at least one RDM format string is passed to rdm_write()
+ and rdm_send_request() when parameter data is sent. Parameter data which was
+ already encoded by a Parameter is sent and received as bytes, which are
+ copied without being swapped. */
+constexpr const char *raw_format = "b";
+
+}  // namespace detail
+
+/**
+ * @brief Describes the fields of the parameter data of an RDM parameter. The
+ * size and layout of the parameter data are known at compile time, so it is
+ * encoded and decoded without parsing an RDM format string. A parameter with
+ * a single field uses that field's type as its value_type; otherwise its
+ * value_type is a std::tuple of its fields.
+ *
+ * For example, RDM_PID_DMX_START_ADDRESS is described as
+ * Parameter<RDM_PID_DMX_START_ADDRESS, uint16_t> and RDM_PID_DISC_MUTE as
+ * Parameter<RDM_PID_DISC_MUTE, uint16_t>.
+ */
+template <rdm_pid_t Pid, typename... Fields>
+struct Parameter {
+  /** @brief The PID of the parameter.*/
+  static constexpr rdm_pid_t pid = Pid;
+
+  /** @brief The decoded value of the parameter data.*/
+  using value_type = typename detail::value_of<Fields...>::type;
+
+  /** @brief The parameter data length of the encoded parameter data.*/
+  static constexpr size_t size = (Field<Fields>::size + ... + 0);
+  static_assert(size <= 231, "RDM parameter data is too long");
+
+  /** @brief Encodes a value into RDM parameter data.*/
+  static constexpr std::array<uint8_t, size> encode(const value_type &value) {
+    std::array<uint8_t, size> pd{};
+    if constexpr (sizeof...(Fields) == 1) {
+      (Field<Fields>::encode(pd.data(), value), ...);
+    } else if constexpr (sizeof...(Fields) > 1) {
+      encode(pd.data(), value, std::index_sequence_for<Fields...>{});
+    }
+    return pd;
+  }
+
+  /** @brief Decodes a value from RDM parameter data which is at least size
+   * bytes long.*/
+  static constexpr value_type decode(const uint8_t *pd) {
+    if constexpr (sizeof...(Fields) == 1) {
+      return (Field<Fields>::decode(pd), ...);
+    } else if constexpr (sizeof...(Fields) > 1) {
+      return decode(pd, std::index_sequence_for<Fields...>{});
+    } else {
+      return value_type{};
+    }
+  }
+
+ private:
+  static constexpr std::array<size_t, sizeof...(Fields) + 1> offsets() {
+    std::array<size_t, sizeof...(Fields) + 1> offsets{};
+    size_t i = 0;
+    ((offsets[i + 1] = offsets[i] + Field<Fields>::size, ++i), ...);
+    return offsets;
+  }
+
+  template <size_t... I>
+  static constexpr void encode(uint8_t *pd, const value_type &value,
+                               std::index_sequence<I...>) {
+    constexpr auto offset = offsets();
+    (Field<Fields>::encode(pd + offset[I], std::get<I>(value)), ...);
+  }
+
+  template <size_t... I>
+  static constexpr value_type decode(const uint8_t *pd,
+                                     std::index_sequence<I...>) {
+    constexpr auto offset = offsets();
+    return value_type{Field<Fields>::decode(pd + offset[I])...};
+  }
+};
+
+/**
+ * @brief Sends an RDM GET request and decodes the response. See
+ * rdm_send_request().
+ *
+ * @tparam Param The Parameter which describes the response parameter data.
+ * @param dmx_num The DMX port number.
+ * @param uid The UID of the RDM responder.
+ * @param sub_device The sub-device of the RDM responder.
+ * @param[out] value The decoded response parameter data.
+ * @param[out] ack An optional pointer to an rdm_ack_t which stores information
+ * about the RDM response.
+ * @return true if an RDM_RESPONSE_TYPE_ACK was received with enough parameter
+ * data to decode the value.
+ * @return false on failure.
+ */
+template <typename Param>
+bool get(dmx_port_t dmx_num, const rdm_uid_t &uid,
+         rdm_sub_device_t sub_device, typename Param::value_type &value,
+         rdm_ack_t *ack = nullptr) {
+  const rdm_request_t request = {&uid,       sub_device, RDM_CC_GET_COMMAND,
+                                 Param::pid, nullptr,    nullptr,
+                                 0};
+  rdm_ack_t local_ack;
+  if (ack == nullptr) {
+    ack = &local_ack;
+  }
+  std::array<uint8_t, Param::size> pd{};
+  rdm_send_request(dmx_num, &request, detail::raw_format, pd.data(),
+                   pd.size(), ack);
+  if (ack->type != RDM_RESPONSE_TYPE_ACK || ack->pdl < Param::size) {
+    return false;
+  }
+  value = Param::decode(pd.data());
+  return true;
+}
+
+/**
+ * @brief Encodes parameter data and sends it in an RDM SET request. See
+ * rdm_send_request().
+ *
+ * @tparam Param The Parameter which describes the request parameter data.
+ * @param dmx_num The DMX port number.
+ * @param uid The UID of the RDM responder.
+ * @param sub_device The sub-device of the RDM responder.
+ * @param value The value to encode into the request parameter data.
+ * @param[out] ack An optional pointer to an rdm_ack_t which stores information
+ * about the RDM response.
+ * @return true if an RDM_RESPONSE_TYPE_ACK was received.
+ * @return false on failure.
+ */
+template <typename Param>
+bool set(dmx_port_t dmx_num, const rdm_uid_t &uid, rdm_sub_device_t sub_device,
+         const typename Param::value_type &value, rdm_ack_t *ack = nullptr) {
+  const auto pd = Param::encode(value);
+  const rdm_request_t request = {
+      &uid,
+      sub_device,
+      RDM_CC_SET_COMMAND,
+      Param::pid,
+      Param::size > 0 ? detail::raw_format : nullptr,
+      Param::size > 0 ? pd.data() : nullptr,
+      Param::size};
+  rdm_ack_t local_ack;
+  if (ack == nullptr) {
+    ack = &local_ack;
+  }
+  rdm_send_request(dmx_num, &request, nullptr, nullptr, 0, ack);
+  return ack->type == RDM_RESPONSE_TYPE_ACK;
+}
+
+/**
+ * @brief Reads and decodes the parameter data of the RDM packet in the DMX
+ * driver buffer. See rdm_read_pd().
+ *
+ * @tparam Param The Parameter which describes the parameter data.
+ * @param dmx_num The DMX port number.
+ * @param[out] value The decoded parameter data.
+ * @return true if the parameter data was long enough to decode the value.
+ * @return false on failure.
+ */
+template <typename Param>
+bool read_pd(dmx_port_t dmx_num, typename Param::value_type &value) {
+  std::array<uint8_t, Param::size> pd{};
+  if (rdm_read_pd(dmx_num, detail::raw_format, pd.data(), pd.size()) <
+      Param::size) {
+    return false;
+  }
+  value = Param::decode(pd.data());
+  return true;
+}
+
+/**
+ * @brief Decodes parameter data which was already copied from an RDM packet,
+ * such as the parameter data received by rdm_send_request().
+ *
+ * @tparam Param The Parameter which describes the parameter data.
+ * @param pd The raw RDM parameter data.
+ * @param[out] value The decoded parameter data.
+ * @return true if the parameter data was long enough to decode the value.
+ * @return false on failure.
+ */
+template <typename Param>
+constexpr bool decode(Span<const uint8_t> pd,
+                      typename Param::value_type &value) {
+  if (pd.size() < Param::size) {
+    return false;
+  }
+  value = Param::decode(pd.data());
+  return true;
+}
+
+}  // namespace rdm
+
+}  // namespace esp_dmx
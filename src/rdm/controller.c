@@ -0,0 +1,575 @@
+#include "./controller.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "../dmx/hal/include/timer.h"
+#include "../dmx/include/driver.h"
+#include "../dmx/include/service.h"
+#include "./controller/include/utils.h"
+#include "./include/uid.h"
+
+/** @brief An RDM request which is waiting to be sent by the bus scheduler
+ * task. Jobs are owned by the task which submitted them.*/
+typedef struct rdm_controller_job_t {
+    const rdm_request_t *request;  // The request to send.
+    const char *format;            // The format of the response parameter data.
+    void *pd;                      // The destination of the response parameter data.
+    size_t size;                   // The size of the destination of the response parameter data.
+    rdm_ack_t *ack;                // The ACK of the response, or NULL.
+    size_t result;                 // The value returned from rdm_send_request().
+    TaskHandle_t waiter;           // The task that is waiting for the job to be done, or NULL if asynchronous.
+} rdm_controller_job_t;
+
+/** @brief An RDM request which was sent with rdm_send_request_async(). The
+ * request is copied so that only its parameter data is owned by the user.*/
+typedef struct rdm_controller_async_job_t {
+    rdm_controller_job_t job;  // The job which is queued. Must be the first member.
+    rdm_request_t request;     // The copy of the request.
+    rdm_uid_t dest_uid;        // The copy of the destination UID of the request.
+    rdm_ack_t ack;             // The ACK of the response.
+    rdm_request_cb_t cb;       // The callback which is called when the request is done.
+    void *context;             // The user context of the callback.
+    bool is_used;              // True if the job is waiting to be sent.
+    bool is_waiting;           // True if the job is waiting for its ACK_TIMER to expire.
+    TickType_t retry_tick;     // The tick at which the response of the job may be retrieved.
+    int retries;               // The number of times that the response has been retrieved.
+} rdm_controller_async_job_t;
+
+/** @brief The raw parameter data of an RDM GET response which was cached with
+ * rdm_controller_cache_put().*/
+typedef struct rdm_controller_cache_entry_t {
+    rdm_uid_t uid;                                 // The UID of the device which responded.
+    rdm_sub_device_t sub_device;                   // The sub-device of the request.
+    rdm_pid_t pid;                                 // The PID of the request.
+    uint8_t key_size;                              // The size of the request parameter data.
+    uint8_t key[RDM_RESPONSE_CACHE_KEY_SIZE_MAX];  // The request parameter data.
+    uint32_t last_used;                            // The cache clock when the response was last used.
+    size_t pdl;                                    // The length of the response parameter data.
+    uint8_t *pd;                                   // The response parameter data, or NULL if the entry is unused.
+} rdm_controller_cache_entry_t;
+
+static bool rdm_controller_cache_is_cacheable(const rdm_request_t *request) {
+    if (request->cc != RDM_CC_GET_COMMAND || rdm_uid_is_broadcast(request->dest_uid) ||
+        request->pdl > RDM_RESPONSE_CACHE_KEY_SIZE_MAX) {
+        return false;
+    }
+
+    // Only parameters which rarely change are cached
+    switch (request->pid) {
+        case RDM_PID_SUPPORTED_PARAMETERS:
+        case RDM_PID_PARAMETER_DESCRIPTION:
+        case RDM_PID_DEVICE_INFO:
+        case RDM_PID_PRODUCT_DETAIL_ID_LIST:
+        case RDM_PID_DEVICE_MODEL_DESCRIPTION:
+        case RDM_PID_MANUFACTURER_LABEL:
+        case RDM_PID_DEVICE_LABEL:
+        case RDM_PID_LANGUAGE_CAPABILITIES:
+        case RDM_PID_LANGUAGE:
+        case RDM_PID_SOFTWARE_VERSION_LABEL:
+        case RDM_PID_BOOT_SOFTWARE_VERSION_ID:
+        case RDM_PID_BOOT_SOFTWARE_VERSION_LABEL:
+        case RDM_PID_DMX_PERSONALITY:
+        case RDM_PID_DMX_PERSONALITY_DESCRIPTION:
+        case RDM_PID_DMX_START_ADDRESS:
+        case RDM_PID_SLOT_INFO:
+        case RDM_PID_SLOT_DESCRIPTION:
+        case RDM_PID_DEFAULT_SLOT_VALUE:
+        case RDM_PID_SENSOR_DEFINITION:
+            return true;
+        default:
+            return false;
+    }
+}
+
+static rdm_controller_cache_entry_t *rdm_controller_cache_find(dmx_port_t dmx_num, const rdm_request_t *request) {
+    dmx_driver_t *const driver = dmx_driver[dmx_num];
+
+    rdm_controller_cache_entry_t *const cache = driver->rdm.controller.cache;
+    for (int i = 0; i < driver->rdm.controller.cache_size; ++i) {
+        rdm_controller_cache_entry_t *const entry = &cache[i];
+        if (entry->pd != NULL && entry->pid == request->pid && entry->sub_device == request->sub_device &&
+            rdm_uid_is_eq(&entry->uid, request->dest_uid) && entry->key_size == request->pdl &&
+            (request->pdl == 0 || memcmp(entry->key, request->pd, request->pdl) == 0)) {
+            return entry;
+        }
+    }
+
+    return NULL;
+}
+
+bool rdm_controller_cache_get(dmx_port_t dmx_num, const rdm_request_t *request, const char *format, void *pd,
+                              size_t size, rdm_ack_t *ack, size_t *result) {
+    assert(dmx_num < DMX_NUM_MAX);
+    assert(request != NULL);
+    assert(result != NULL);
+    assert(dmx_driver_is_installed(dmx_num));
+
+    dmx_driver_t *const driver = dmx_driver[dmx_num];
+
+    if (driver->rdm.controller.cache_mux == NULL || !rdm_controller_cache_is_cacheable(request)) {
+        return false;
+    }
+    if (!xSemaphoreTake(driver->rdm.controller.cache_mux, portMAX_DELAY)) {
+        return false;
+    }
+    rdm_controller_cache_entry_t *const entry = rdm_controller_cache_find(dmx_num, request);
+    if (entry == NULL) {
+        xSemaphoreGive(driver->rdm.controller.cache_mux);
+        return false;
+    }
+
+    // Read the cached response as if it had been received
+    entry->last_used = ++driver->rdm.controller.cache_clock;
+    rdm_pd_decode(format, pd, size, entry->pd, entry->pdl);
+    if (ack != NULL) {
+        ack->err           = DMX_OK;
+        ack->size          = 0;
+        ack->src_uid       = entry->uid;
+        ack->pid           = entry->pid;
+        ack->type          = RDM_RESPONSE_TYPE_ACK;
+        ack->message_count = 0;
+        ack->pdl           = entry->pdl;
+    }
+    *result = entry->pdl > 0 ? entry->pdl : 1;
+    xSemaphoreGive(driver->rdm.controller.cache_mux);
+
+    return true;
+}
+
+void rdm_controller_cache_put(dmx_port_t dmx_num, const rdm_request_t *request, const void *pd, size_t pdl) {
+    assert(dmx_num < DMX_NUM_MAX);
+    assert(request != NULL);
+    assert(pd != NULL || pdl == 0);
+    assert(dmx_driver_is_installed(dmx_num));
+
+    dmx_driver_t *const driver = dmx_driver[dmx_num];
+
+    if (driver->rdm.controller.cache_mux == NULL || !rdm_controller_cache_is_cacheable(request)) {
+        return;
+    }
+    uint8_t *const copy = malloc(pdl > 0 ? pdl : 1);
+    if (copy == NULL) {
+        return;  // The response is not cached
+    }
+    memcpy(copy, pd, pdl);
+    if (!xSemaphoreTake(driver->rdm.controller.cache_mux, portMAX_DELAY)) {
+        free(copy);
+        return;
+    }
+
+    // Replace the same response, or an unused response, or the least recently used response
+    rdm_controller_cache_entry_t *entry = rdm_controller_cache_find(dmx_num, request);
+    if (entry == NULL) {
+        rdm_controller_cache_entry_t *const cache = driver->rdm.controller.cache;
+        entry                                     = &cache[0];
+        for (int i = 0; i < driver->rdm.controller.cache_size && entry->pd != NULL; ++i) {
+            if (cache[i].pd == NULL || cache[i].last_used < entry->last_used) {
+                entry = &cache[i];
+            }
+        }
+    }
+    free(entry->pd);
+    entry->uid        = *request->dest_uid;
+    entry->sub_device = request->sub_device;
+    entry->pid        = request->pid;
+    entry->key_size   = request->pdl;
+    memcpy(entry->key, request->pd, request->pdl);
+    entry->last_used = ++driver->rdm.controller.cache_clock;
+    entry->pdl       = pdl;
+    entry->pd        = copy;
+    xSemaphoreGive(driver->rdm.controller.cache_mux);
+}
+
+bool rdm_controller_cache_invalidate(dmx_port_t dmx_num, const rdm_uid_t *uid) {
+    DMX_CHECK(dmx_num < DMX_NUM_MAX, false, "dmx_num error");
+    DMX_CHECK(dmx_driver_is_installed(dmx_num), false, "driver is not installed");
+
+    dmx_driver_t *const driver = dmx_driver[dmx_num];
+
+    if (driver->rdm.controller.cache_mux == NULL) {
+        return true;  // The cache is disabled
+    }
+    if (!xSemaphoreTake(driver->rdm.controller.cache_mux, portMAX_DELAY)) {
+        return false;
+    }
+    rdm_controller_cache_entry_t *const cache = driver->rdm.controller.cache;
+    for (int i = 0; i < driver->rdm.controller.cache_size; ++i) {
+        if (uid == NULL || rdm_uid_is_target(&cache[i].uid, uid)) {
+            free(cache[i].pd);
+            cache[i].pd = NULL;
+        }
+    }
+    xSemaphoreGive(driver->rdm.controller.cache_mux);
+
+    return true;
+}
+
+bool rdm_controller_cache_enable(dmx_port_t dmx_num, int num_responses) {
+    DMX_CHECK(dmx_num < DMX_NUM_MAX, false, "dmx_num error");
+    DMX_CHECK(num_responses >= 0, false, "num_responses error");
+    DMX_CHECK(dmx_driver_is_installed(dmx_num), false, "driver is not installed");
+
+    dmx_driver_t *const driver = dmx_driver[dmx_num];
+
+    // Allocate the new cache before the old cache is freed
+    rdm_controller_cache_entry_t *cache = NULL;
+    if (num_responses > 0) {
+        cache = calloc(num_responses, sizeof(rdm_controller_cache_entry_t));
+        if (cache == NULL) {
+            DMX_ERR("RDM controller cache malloc error");
+            return false;
+        }
+    }
+    if (driver->rdm.controller.cache_mux == NULL) {
+        if (num_responses == 0) {
+            return true;
+        }
+        driver->rdm.controller.cache_mux = xSemaphoreCreateMutex();
+        if (driver->rdm.controller.cache_mux == NULL) {
+            free(cache);
+            DMX_ERR("RDM controller cache mutex malloc error");
+            return false;
+        }
+    }
+
+    // Swap the caches so that cached responses are never used while they are freed
+    xSemaphoreTake(driver->rdm.controller.cache_mux, portMAX_DELAY);
+    rdm_controller_cache_entry_t *const old_cache = driver->rdm.controller.cache;
+    const int old_size                            = driver->rdm.controller.cache_size;
+    driver->rdm.controller.cache                  = cache;
+    driver->rdm.controller.cache_size             = num_responses;
+    xSemaphoreGive(driver->rdm.controller.cache_mux);
+    for (int i = 0; i < old_size; ++i) {
+        free(old_cache[i].pd);
+    }
+    free(old_cache);
+
+    return true;
+}
+
+static void rdm_controller_complete(dmx_port_t dmx_num, rdm_controller_async_job_t *async) {
+    rdm_controller_job_t *const job = &async->job;
+
+    // Defer the request if the responder needs more time to handle it
+    if (job->result == 0 && async->ack.type == RDM_RESPONSE_TYPE_ACK_TIMER &&
+        async->retries < RDM_CONTROLLER_ACK_TIMER_RETRIES_MAX) {
+        ++async->retries;
+        async->retry_tick = xTaskGetTickCount() + async->ack.timer;
+        async->is_waiting = true;
+        return;
+    }
+
+    // Complete the asynchronous request and free its storage
+    async->cb(dmx_num, job->result, &async->ack, async->context);
+    taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+    async->is_waiting = false;
+    async->is_used    = false;
+    taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+}
+
+static void rdm_controller_run(dmx_port_t dmx_num, rdm_controller_job_t *job) {
+    job->result = rdm_send_request(dmx_num, job->request, job->format, job->pd, job->size, job->ack);
+    if (job->waiter != NULL) {
+        xTaskNotifyGive(job->waiter);
+        return;
+    }
+    rdm_controller_complete(dmx_num, (rdm_controller_async_job_t *)job);
+}
+
+static void rdm_controller_retry(dmx_port_t dmx_num, rdm_controller_async_job_t *async) {
+    rdm_controller_job_t *const job = &async->job;
+    async->is_waiting               = false;
+
+    // Retrieve the deferred response with RDM_PID_QUEUED_MESSAGE
+    const uint8_t status_type = RDM_STATUS_ERROR;
+    const rdm_request_t queued_message = {.dest_uid   = &async->dest_uid,
+                                          .sub_device = RDM_SUB_DEVICE_ROOT,
+                                          .cc         = RDM_CC_GET_COMMAND,
+                                          .pid        = RDM_PID_QUEUED_MESSAGE,
+                                          .format     = "b$",
+                                          .pd         = &status_type,
+                                          .pdl        = sizeof(status_type)};
+    job->result = rdm_send_request(dmx_num, &queued_message, job->format, job->pd, job->size, job->ack);
+
+    // Responders may answer with another queued message or with a status
+    // message, so the original request is sent again if it was not answered
+    if (job->result > 0 && async->ack.pid != async->request.pid) {
+        rdm_controller_run(dmx_num, job);
+    } else if (job->result == 0 && async->ack.type != RDM_RESPONSE_TYPE_ACK_TIMER) {
+        rdm_controller_run(dmx_num, job);
+    } else {
+        rdm_controller_complete(dmx_num, async);
+    }
+}
+
+static bool rdm_controller_retry_due(dmx_port_t dmx_num, bool force) {
+    dmx_driver_t *const driver = dmx_driver[dmx_num];
+
+    rdm_controller_async_job_t *const async_jobs = driver->rdm.controller.async_jobs;
+    const TickType_t now                         = xTaskGetTickCount();
+    for (int i = 0; i < RDM_CONTROLLER_QUEUE_SIZE; ++i) {
+        rdm_controller_async_job_t *const async = &async_jobs[i];
+        if (!async->is_waiting) {
+            continue;
+        }
+        if (force) {
+            // Complete the job with the ACK_TIMER response
+            async->retries = RDM_CONTROLLER_ACK_TIMER_RETRIES_MAX;
+            rdm_controller_complete(dmx_num, async);
+            return true;
+        } else if ((int32_t)(now - async->retry_tick) >= 0) {
+            rdm_controller_retry(dmx_num, async);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static void rdm_controller_task(void *arg) {
+    const dmx_port_t dmx_num   = (dmx_port_t)(uintptr_t)arg;
+    dmx_driver_t *const driver = dmx_driver[dmx_num];
+
+    int64_t next_packet = dmx_timer_get_micros_since_boot();
+    while (true) {
+        bool is_running;
+        taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+        is_running = driver->rdm.controller.is_running;
+        taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+        if (!is_running) {
+            break;
+        }
+
+        // Send the DMX packet, then schedule the next one at the refresh rate
+        dmx_send_num(dmx_num, driver->rdm.controller.size);
+        dmx_wait_sent(dmx_num, dmx_ms_to_ticks(23));
+        const int64_t now = dmx_timer_get_micros_since_boot();
+        next_packet += driver->rdm.controller.period;
+        if (next_packet < now) {
+            next_packet = now;  // The packet is late so don't try to catch up
+        }
+
+        // Send queued RDM requests in the gap between DMX packets. At least one
+        // request is sent per gap so that RDM is never starved by DMX.
+        bool is_first = true;
+        while (true) {
+            const int64_t remaining = next_packet - dmx_timer_get_micros_since_boot();
+            if (remaining <= 0 && !is_first) {
+                break;
+            }
+            if (rdm_controller_retry_due(dmx_num, false)) {
+                is_first = false;
+                continue;
+            }
+            const TickType_t wait_ticks = remaining > 0 ? remaining / (portTICK_PERIOD_MS * 1000) : 0;
+            rdm_controller_job_t *job;
+            if (!xQueueReceive(driver->rdm.controller.jobs, &job, wait_ticks)) {
+                break;
+            }
+            rdm_controller_run(dmx_num, job);
+            is_first = false;
+        }
+    }
+
+    // Send the requests which were queued before the task was asked to stop
+    rdm_controller_job_t *job;
+    while (xQueueReceive(driver->rdm.controller.jobs, &job, 0)) {
+        rdm_controller_run(dmx_num, job);
+    }
+    while (rdm_controller_retry_due(dmx_num, true)) {
+        continue;  // Requests which are still deferred complete with their ACK_TIMER
+    }
+
+    // Let rdm_controller_stop() know that the task is done
+    taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+    driver->rdm.controller.task = NULL;
+    taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+    vTaskDelete(NULL);
+}
+
+bool rdm_controller_submit(dmx_port_t dmx_num, const rdm_request_t *request, const char *format, void *pd,
+                           size_t size, rdm_ack_t *ack, size_t *result) {
+    assert(dmx_num < DMX_NUM_MAX);
+    assert(request != NULL);
+    assert(result != NULL);
+    assert(dmx_driver_is_installed(dmx_num));
+
+    dmx_driver_t *const driver = dmx_driver[dmx_num];
+
+    // Requests are sent directly by the scheduler task and by tasks which hold
+    // the driver mutex, such as during discovery, because the scheduler would
+    // otherwise wait for the mutex that the task holds
+    TaskHandle_t task;
+    taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+    task = driver->rdm.controller.task;
+    taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+    const TaskHandle_t this_task = xTaskGetCurrentTaskHandle();
+    if (task == NULL || task == this_task || xSemaphoreGetMutexHolder(driver->mux) == this_task) {
+        return false;
+    }
+
+    // Queue the request and wait for the scheduler task to send it
+    rdm_controller_job_t job = {.request = request,
+                                .format  = format,
+                                .pd      = pd,
+                                .size    = size,
+                                .ack     = ack,
+                                .result  = 0,
+                                .waiter  = this_task};
+    rdm_controller_job_t *const job_ptr = &job;
+    if (!xQueueSend(driver->rdm.controller.jobs, &job_ptr, portMAX_DELAY)) {
+        return false;
+    }
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    *result = job.result;
+
+    return true;
+}
+
+bool rdm_send_request_async(dmx_port_t dmx_num, const rdm_request_t *request, const char *format, void *pd,
+                            size_t size, rdm_request_cb_t cb, void *context) {
+    DMX_CHECK(dmx_num < DMX_NUM_MAX, false, "dmx_num error");
+    DMX_CHECK(request != NULL, false, "request is null");
+    DMX_CHECK(request->dest_uid != NULL, false, "dest_uid is null");
+    DMX_CHECK(cb != NULL, false, "cb is null");
+    DMX_CHECK(dmx_driver_is_installed(dmx_num), false, "driver is not installed");
+    DMX_CHECK(rdm_controller_is_running(dmx_num), false, "controller is not started");
+
+    dmx_driver_t *const driver = dmx_driver[dmx_num];
+
+    // Claim unused storage for the request
+    rdm_controller_async_job_t *const async_jobs = driver->rdm.controller.async_jobs;
+    rdm_controller_async_job_t *async            = NULL;
+    taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+    for (int i = 0; i < RDM_CONTROLLER_QUEUE_SIZE; ++i) {
+        if (!async_jobs[i].is_used) {
+            async          = &async_jobs[i];
+            async->is_used = true;
+            break;
+        }
+    }
+    taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+    if (async == NULL) {
+        return false;  // Too many requests are in flight
+    }
+
+    // Copy the request and queue it without waiting for it to be sent
+    async->dest_uid         = *request->dest_uid;
+    async->request          = *request;
+    async->request.dest_uid = &async->dest_uid;
+    async->cb               = cb;
+    async->context          = context;
+    async->is_waiting       = false;
+    async->retries          = 0;
+    async->job = (rdm_controller_job_t){.request = &async->request,
+                                        .format  = format,
+                                        .pd      = pd,
+                                        .size    = size,
+                                        .ack     = &async->ack,
+                                        .result  = 0,
+                                        .waiter  = NULL};
+    rdm_controller_job_t *const job_ptr = &async->job;
+    if (!xQueueSend(driver->rdm.controller.jobs, &job_ptr, 0)) {
+        taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+        async->is_used = false;
+        taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+        return false;
+    }
+
+    return true;
+}
+
+bool rdm_controller_start(dmx_port_t dmx_num, uint32_t refresh_hz, size_t size, UBaseType_t priority,
+                          BaseType_t core_id) {
+    DMX_CHECK(dmx_num < DMX_NUM_MAX, false, "dmx_num error");
+    DMX_CHECK(refresh_hz > 0 && refresh_hz <= DMX_REFRESH_HZ_MAX, false, "refresh_hz error");
+    DMX_CHECK(priority < configMAX_PRIORITIES, false, "priority error");
+    DMX_CHECK(core_id == tskNO_AFFINITY || (core_id >= 0 && core_id < portNUM_PROCESSORS), false, "core_id error");
+    DMX_CHECK(dmx_driver_is_installed(dmx_num), false, "driver is not installed");
+    DMX_CHECK(dmx_driver_is_enabled(dmx_num), false, "driver is not enabled");
+    DMX_CHECK(dmx_driver[dmx_num]->continuous.period == 0, false, "driver is sending continuously");
+
+    dmx_driver_t *const driver = dmx_driver[dmx_num];
+
+    if (rdm_controller_is_running(dmx_num)) {
+        return true;
+    }
+
+    if (size == 0 || size > DMX_PACKET_SIZE_MAX) {
+        size = DMX_PACKET_SIZE_MAX;
+    }
+
+    // Allocate the queue once and reuse it if the task is restarted
+    if (driver->rdm.controller.jobs == NULL) {
+        driver->rdm.controller.jobs = xQueueCreate(RDM_CONTROLLER_QUEUE_SIZE, sizeof(rdm_controller_job_t *));
+        if (driver->rdm.controller.jobs == NULL) {
+            DMX_ERR("RDM controller queue malloc error");
+            return false;
+        }
+    }
+    if (driver->rdm.controller.async_jobs == NULL) {
+        driver->rdm.controller.async_jobs = calloc(RDM_CONTROLLER_QUEUE_SIZE, sizeof(rdm_controller_async_job_t));
+        if (driver->rdm.controller.async_jobs == NULL) {
+            DMX_ERR("RDM controller async malloc error");
+            return false;
+        }
+    }
+
+    driver->rdm.controller.period     = 1000000 / refresh_hz;
+    driver->rdm.controller.size       = size;
+    driver->rdm.controller.is_running = true;
+    TaskHandle_t task;
+    if (xTaskCreatePinnedToCore(rdm_controller_task, "rdm_controller", RDM_CONTROLLER_TASK_STACK_SIZE,
+                                (void *)(uintptr_t)dmx_num, priority, &task, core_id) != pdPASS) {
+        driver->rdm.controller.is_running = false;
+        DMX_ERR("RDM controller task create error");
+        return false;
+    }
+    taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+    driver->rdm.controller.task = task;
+    taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+
+    return true;
+}
+
+bool rdm_controller_stop(dmx_port_t dmx_num) {
+    DMX_CHECK(dmx_num < DMX_NUM_MAX, false, "dmx_num error");
+    DMX_CHECK(dmx_driver_is_installed(dmx_num), false, "driver is not installed");
+
+    dmx_driver_t *const driver = dmx_driver[dmx_num];
+
+    if (!rdm_controller_is_running(dmx_num)) {
+        return true;
+    }
+    DMX_CHECK(xTaskGetCurrentTaskHandle() != driver->rdm.controller.task, false,
+              "cannot stop the controller from its own task");
+
+    // Ask the task to stop and wait for it to finish its current packet
+    taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+    driver->rdm.controller.is_running = false;
+    taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+    TaskHandle_t task;
+    do {
+        vTaskDelay(1);
+        taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+        task = driver->rdm.controller.task;
+        taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+    } while (task != NULL);
+
+    return true;
+}
+
+bool rdm_controller_is_running(dmx_port_t dmx_num) {
+    DMX_CHECK(dmx_num < DMX_NUM_MAX, false, "dmx_num error");
+    DMX_CHECK(dmx_driver_is_installed(dmx_num), false, "driver is not installed");
+
+    dmx_driver_t *const driver = dmx_driver[dmx_num];
+
+    bool is_running;
+    taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+    is_running = driver->rdm.controller.task != NULL;
+    taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+
+    return is_running;
+}
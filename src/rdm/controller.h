@@ -6,6 +6,9 @@
  */
 #pragma once
 
+#include <stdbool.h>
+
+#include "../dmx/include/types.h"
 #include "./include/types.h"
 
 #ifdef __cplusplus
@@ -43,6 +46,87 @@ typedef struct rdm_ack_t {
   };
 } rdm_ack_t;
 
+/**
+ * @brief Starts a task which owns the DMX bus and schedules RDM requests
+ * between DMX packets. The task sends the data most recently written with
+ * dmx_write() at the specified refresh rate. After each DMX packet, RDM
+ * requests sent with any rdm_send_ function are sent in the gap before the next
+ * DMX packet is due. At least one RDM request is sent between each DMX packet,
+ * so that the DMX refresh rate is kept while RDM requests are not starved. The
+ * RDM controller timing is enforced between each packet. Users should not call
+ * dmx_send() while the task is running, and the DMX driver must not be sending
+ * continuously.
+ *
+ * @note Functions which send several requests while holding the DMX driver,
+ * such as RDM discovery, send their requests directly. DMX packets are not sent
+ * until they are done.
+ *
+ * @param dmx_num The DMX port number.
+ * @param refresh_hz The number of DMX packets to send per second.
+ * @param size The size of the DMX packets to send. If 0, sends full DMX
+ * packets.
+ * @param priority The FreeRTOS priority of the task. It is recommended to use a
+ * priority higher than any task which sends RDM requests.
+ * @param core_id The core to which the task is pinned, or tskNO_AFFINITY.
+ * @return true if the task was started or was already running.
+ * @return false on failure.
+ */
+bool rdm_controller_start(dmx_port_t dmx_num, uint32_t refresh_hz, size_t size,
+                          UBaseType_t priority, BaseType_t core_id);
+
+/**
+ * @brief Stops the task which was started with rdm_controller_start(). Any RDM
+ * requests which are waiting to be sent are sent before the task stops. This
+ * function blocks until the task has stopped.
+ *
+ * @param dmx_num The DMX port number.
+ * @return true if the task was stopped or was not running.
+ * @return false on failure.
+ */
+bool rdm_controller_stop(dmx_port_t dmx_num);
+
+/**
+ * @brief Returns true if the task started with rdm_controller_start() is
+ * running.
+ *
+ * @param dmx_num The DMX port number.
+ * @return true if the task is running.
+ * @return false if the task is not running.
+ */
+bool rdm_controller_is_running(dmx_port_t dmx_num);
+
+/**
+ * @brief Enables a cache of RDM GET responses in front of rdm_send_request()
+ * and the rdm_send_get_ functions. Responses are cached by UID, sub-device,
+ * PID, and request parameter data for parameters which rarely change, such as
+ * RDM_PID_DEVICE_INFO, RDM_PID_DEVICE_LABEL, RDM_PID_SUPPORTED_PARAMETERS, and
+ * RDM_PID_DMX_PERSONALITY_DESCRIPTION. Cached responses of a device are
+ * invalidated when the device responds with a message count which indicates
+ * that it has queued messages, or when a SET request is sent to the device on
+ * the same DMX port. When the cache is full, the least recently used response
+ * is replaced.
+ *
+ * @param dmx_num The DMX port number.
+ * @param num_responses The number of responses which may be cached. If 0, the
+ * cache is disabled and its memory is freed.
+ * @return true if the cache was enabled or disabled.
+ * @return false on failure.
+ */
+bool rdm_controller_cache_enable(dmx_port_t dmx_num, int num_responses);
+
+/**
+ * @brief Invalidates the cached RDM responses of a device. This may be used
+ * when a device is known to have changed without sending a SET request, such as
+ * when its parameters were changed on its own user interface.
+ *
+ * @param dmx_num The DMX port number.
+ * @param[in] uid A pointer to the UID of the device. If it is NULL or the
+ * broadcast UID, the responses of every device are invalidated.
+ * @return true if the responses were invalidated or the cache is disabled.
+ * @return false on failure.
+ */
+bool rdm_controller_cache_invalidate(dmx_port_t dmx_num, const rdm_uid_t *uid);
+
 #ifdef __cplusplus
 }
 #endif
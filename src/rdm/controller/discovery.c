@@ -31,7 +31,7 @@ bool rdm_send_disc_mute(dmx_port_t dmx_num, const rdm_uid_t *dest_uid, rdm_disc_
         .dest_uid = dest_uid, .sub_device = RDM_SUB_DEVICE_ROOT, .cc = RDM_CC_DISC_COMMAND, .pid = RDM_PID_DISC_MUTE};
 
     const char *format = "wv";
-    return rdm_send_request(dmx_num, &request, format, &mute, sizeof(*mute), ack);
+    return rdm_send_request(dmx_num, &request, format, mute, sizeof(*mute), ack);
 }
 
 bool rdm_send_disc_un_mute(dmx_port_t dmx_num, const rdm_uid_t *dest_uid, rdm_disc_mute_t *mute, rdm_ack_t *ack) {
@@ -45,21 +45,45 @@ bool rdm_send_disc_un_mute(dmx_port_t dmx_num, const rdm_uid_t *dest_uid, rdm_di
                                    .pid        = RDM_PID_DISC_UN_MUTE};
 
     const char *format = "wv";
-    return rdm_send_request(dmx_num, &request, format, &mute, sizeof(*mute), ack);
+    return rdm_send_request(dmx_num, &request, format, mute, sizeof(*mute), ack);
 }
 
-int rdm_discover_with_callback(dmx_port_t dmx_num, rdm_disc_cb_t cb, void *context) {
-    DMX_CHECK(dmx_num < DMX_NUM_MAX, 0, "dmx_num error");
-    DMX_CHECK(cb != NULL, 0, "cb is null");
-    DMX_CHECK(dmx_driver_is_installed(dmx_num), 0, "driver is not installed");
+#ifndef CONFIG_RDM_DEBUG_DEVICE_DISCOVERY
+static bool rdm_disc_response_is_clean(const rdm_disc_unique_branch_t *branch, const rdm_ack_t *ack) {
+    // UART framing errors and bad checksums are caused by colliding responses
+    if (ack->type != RDM_RESPONSE_TYPE_ACK || ack->err != DMX_OK) {
+        return false;
+    }
+
+    // A corrupted response may have a valid checksum, but not a UID in range
+    const uint64_t uid   = ((uint64_t)ack->src_uid.man_id << 32) | ack->src_uid.dev_id;
+    const uint64_t lower = ((uint64_t)branch->lower_bound.man_id << 32) | branch->lower_bound.dev_id;
+    const uint64_t upper = ((uint64_t)branch->upper_bound.man_id << 32) | branch->upper_bound.dev_id;
+    return uid >= lower && uid <= upper;
+}
+#endif
+
+/**
+ * @brief Searches the RDM address space for devices which are not muted. The
+ * caller must hold the DMX driver mutex. Devices which are found are muted and
+ * reported to the callback, which is called without the mutex.
+ *
+ * @param dmx_num The DMX port number.
+ * @param cb A callback function which is called when a new device is found.
+ * @param[inout] context Context which is passed to the callback function.
+ * @param num_found The number of devices which have already been found.
+ * @return The number of devices which have been found, including num_found.
+ */
+static int rdm_disc_search(dmx_port_t dmx_num, rdm_disc_cb_t cb, void *context, int num_found) {
+    dmx_driver_t *const driver = dmx_driver[dmx_num];
 
     // Allocate the instruction stack. The max binary tree depth is 49.
 #ifdef CONFIG_RDM_STATIC_DISCOVERY_INSTRUCTIONS
-    static rdm_disc_unique_branch_t stack[49];
+    rdm_disc_unique_branch_t *const stack = driver->rdm.discovery_stack;
 #else
     rdm_disc_unique_branch_t *stack;
-    stack = malloc(sizeof(rdm_disc_unique_branch_t) * 49);
-    DMX_CHECK(stack != NULL, 0, "discovery malloc error");
+    stack = malloc(sizeof(rdm_disc_unique_branch_t) * RDM_DISCOVERY_STACK_SIZE);
+    DMX_CHECK(stack != NULL, num_found, "discovery malloc error");
 #endif
 
     // Initialize the stack with the initial branch instruction
@@ -70,14 +94,6 @@ int rdm_discover_with_callback(dmx_port_t dmx_num, rdm_disc_cb_t cb, void *conte
     rdm_uid_t dest_uid;
     rdm_disc_mute_t mute;  // Mute parameters returned from devices.
     rdm_ack_t ack;         // Request response information.
-    int num_found = 0;
-
-    dmx_driver_t *const driver = dmx_driver[dmx_num];
-    xSemaphoreTakeRecursive(driver->mux, 0);
-
-    // Un-mute all devices
-    dest_uid = RDM_UID_BROADCAST_ALL;
-    rdm_send_disc_un_mute(dmx_num, &dest_uid, NULL, NULL);
 
     while (stack_size > 0) {
         // Pop a DISC_UNIQUE_BRANCH instruction parameter from the stack
@@ -106,39 +122,46 @@ int rdm_discover_with_callback(dmx_port_t dmx_num, rdm_disc_cb_t cb, void *conte
             if (ack.type != RDM_RESPONSE_TYPE_NONE) {
                 bool devices_remaining = true;
 
-#if false  // FIXME: This should temporarily allow discovery to work.
-// #ifndef CONFIG_RDM_DEBUG_DEVICE_DISCOVERY
-        /*
-        Stop the RDM controller from branching all the way down to the
-        individual address if it is not necessary. When debugging, this code
-        should not be called as it can hide bugs in the discovery algorithm.
-        Users can use the sdkconfig to enable or disable discovery debugging if
-        it is desired, but it isn't necessary unless the user makes changes to
-        this function.
-        */
-        if (ack.type == RDM_RESPONSE_TYPE_ACK) {
-          do {
-            // Attempt to mute the device
-            attempts = 0;
-            dest_uid = ack.src_uid;
-            do {
-              rdm_send_disc_mute(dmx_num, &dest_uid, &mute, &ack);
-            } while (ack.type == RDM_RESPONSE_TYPE_NONE && ++attempts < 3);
-
-            // Call the callback function and report a device has been found
-            if (ack.type == RDM_RESPONSE_TYPE_ACK) {
-              cb(dmx_num, ack.src_uid, num_found, &mute, context);
-              ++num_found;
-            }
-
-            // Check if there are more devices in this branch
-            attempts = 0;
-            do {
-              rdm_send_disc_unique_branch(dmx_num, branch, &ack);
-            } while (ack.type == RDM_RESPONSE_TYPE_NONE && ++attempts < 3);
-          } while (ack.type == RDM_RESPONSE_TYPE_ACK);
-          devices_remaining = (ack.err && ack.err != DMX_ERR_TIMEOUT);
-        }
+#ifndef CONFIG_RDM_DEBUG_DEVICE_DISCOVERY
+                /*
+                Stop the RDM controller from branching all the way down to the
+                individual address if it is not necessary. A clean response to
+                DISC_UNIQUE_BRANCH is likely to be from a single device, so the
+                device is muted and the same branch is searched again. A
+                response is only trusted if it was received without UART errors,
+                its checksum is valid, its UID is within the branch, and the
+                device with that UID acknowledges the mute request. Anything
+                else is treated as a collision and the branch is split. When
+                debugging, this code should not be called as it can hide bugs in
+                the discovery algorithm.
+                */
+                while (rdm_disc_response_is_clean(branch, &ack)) {
+                    // Attempt to mute the device
+                    attempts = 0;
+                    dest_uid = ack.src_uid;
+                    do {
+                        rdm_send_disc_mute(dmx_num, &dest_uid, &mute, &ack);
+                    } while (ack.type == RDM_RESPONSE_TYPE_NONE && ++attempts < 3);
+                    if (ack.type != RDM_RESPONSE_TYPE_ACK || !rdm_uid_is_eq(&ack.src_uid, &dest_uid)) {
+                        break;  // The response was likely the result of a collision
+                    }
+
+                    // Call the callback function and report a device has been found
+                    xSemaphoreGiveRecursive(driver->mux);
+                    cb(dmx_num, ack.src_uid, num_found, &mute, context);
+                    xSemaphoreTakeRecursive(driver->mux, portMAX_DELAY);
+                    ++num_found;
+
+                    // Check if there are more devices in this branch
+                    attempts = 0;
+                    do {
+                        rdm_send_disc_unique_branch(dmx_num, branch, &ack);
+                    } while (ack.type == RDM_RESPONSE_TYPE_NONE && ++attempts < 3);
+                    if (ack.type == RDM_RESPONSE_TYPE_NONE) {
+                        devices_remaining = false;  // Every device in this branch is muted
+                        break;
+                    }
+                }
 #endif
 
                 // Iteratively search the next two RDM address spaces
@@ -165,8 +188,6 @@ int rdm_discover_with_callback(dmx_port_t dmx_num, rdm_disc_cb_t cb, void *conte
         }
     }
 
-    xSemaphoreGiveRecursive(driver->mux);
-
 #ifndef CONFIG_RDM_STATIC_DISCOVERY_INSTRUCTIONS
     free(stack);
 #endif
@@ -174,6 +195,162 @@ int rdm_discover_with_callback(dmx_port_t dmx_num, rdm_disc_cb_t cb, void *conte
     return num_found;
 }
 
+int rdm_discover_with_callback(dmx_port_t dmx_num, rdm_disc_cb_t cb, void *context) {
+    DMX_CHECK(dmx_num < DMX_NUM_MAX, 0, "dmx_num error");
+    DMX_CHECK(cb != NULL, 0, "cb is null");
+    DMX_CHECK(dmx_driver_is_installed(dmx_num), 0, "driver is not installed");
+
+    dmx_driver_t *const driver = dmx_driver[dmx_num];
+    if (!xSemaphoreTakeRecursive(driver->mux, portMAX_DELAY)) {
+        return 0;
+    }
+
+    // Un-mute all devices
+    const rdm_uid_t dest_uid = RDM_UID_BROADCAST_ALL;
+    rdm_send_disc_un_mute(dmx_num, &dest_uid, NULL, NULL);
+
+    const int num_found = rdm_disc_search(dmx_num, cb, context, 0);
+
+    xSemaphoreGiveRecursive(driver->mux);
+
+    return num_found;
+}
+
+int rdm_discover_incremental(dmx_port_t dmx_num, const rdm_uid_t *known_uids, int num_known, rdm_disc_cb_t cb,
+                             rdm_disc_lost_cb_t lost_cb, void *context) {
+    DMX_CHECK(dmx_num < DMX_NUM_MAX, 0, "dmx_num error");
+    DMX_CHECK(known_uids != NULL || num_known == 0, 0, "known_uids is null");
+    DMX_CHECK(num_known >= 0, 0, "num_known error");
+    DMX_CHECK(cb != NULL, 0, "cb is null");
+    DMX_CHECK(dmx_driver_is_installed(dmx_num), 0, "driver is not installed");
+
+    dmx_driver_t *const driver = dmx_driver[dmx_num];
+    if (!xSemaphoreTakeRecursive(driver->mux, portMAX_DELAY)) {
+        return 0;
+    }
+
+    // Un-mute all devices
+    rdm_uid_t dest_uid = RDM_UID_BROADCAST_ALL;
+    rdm_send_disc_un_mute(dmx_num, &dest_uid, NULL, NULL);
+
+    // Verify the known devices by muting each of them directly
+    rdm_disc_mute_t mute;
+    rdm_ack_t ack;
+    int num_found = 0;
+    for (int i = 0; i < num_known; ++i) {
+        dest_uid        = known_uids[i];
+        size_t attempts = 0;
+        do {
+            rdm_send_disc_mute(dmx_num, &dest_uid, &mute, &ack);
+        } while (ack.type != RDM_RESPONSE_TYPE_ACK && ++attempts < 3);
+
+        // Report whether the device is still present
+        xSemaphoreGiveRecursive(driver->mux);
+        if (ack.type == RDM_RESPONSE_TYPE_ACK) {
+            cb(dmx_num, dest_uid, num_found, &mute, context);
+            ++num_found;
+        } else if (lost_cb != NULL) {
+            lost_cb(dmx_num, dest_uid, context);
+        }
+        xSemaphoreTakeRecursive(driver->mux, portMAX_DELAY);
+    }
+
+    // Known devices are muted so only new devices respond while searching
+    num_found = rdm_disc_search(dmx_num, cb, context, num_found);
+
+    xSemaphoreGiveRecursive(driver->mux);
+
+    return num_found;
+}
+
+/** @brief The state shared by every port in rdm_discover_ports_with_callback().*/
+struct rdm_disc_ports_ctx {
+    rdm_disc_cb_t cb;          // The user callback.
+    void *context;             // The user context.
+    SemaphoreHandle_t cb_mux;  // Serializes calls to the user callback.
+    SemaphoreHandle_t done;    // Given by each discovery task when it is done.
+};
+
+/** @brief The discovery job of a single port.*/
+struct rdm_disc_port_job {
+    dmx_port_t dmx_num;                // The DMX port number.
+    int num_found;                     // The number of devices found on the port.
+    struct rdm_disc_ports_ctx *ports;  // The shared state.
+};
+
+static void rdm_disc_ports_cb(dmx_port_t dmx_num, rdm_uid_t uid, int num_found, const rdm_disc_mute_t *mute,
+                              void *context) {
+    struct rdm_disc_ports_ctx *const ports = context;
+    xSemaphoreTake(ports->cb_mux, portMAX_DELAY);
+    ports->cb(dmx_num, uid, num_found, mute, ports->context);
+    xSemaphoreGive(ports->cb_mux);
+}
+
+static void rdm_disc_port_task(void *arg) {
+    struct rdm_disc_port_job *const job = arg;
+    job->num_found = rdm_discover_with_callback(job->dmx_num, rdm_disc_ports_cb, job->ports);
+    xSemaphoreGive(job->ports->done);
+    vTaskDelete(NULL);
+}
+
+int rdm_discover_ports_with_callback(const dmx_port_t *dmx_nums, int count, rdm_disc_cb_t cb, void *context) {
+    DMX_CHECK(dmx_nums != NULL, 0, "dmx_nums is null");
+    DMX_CHECK(count > 0 && count <= DMX_NUM_MAX, 0, "count error");
+    DMX_CHECK(cb != NULL, 0, "cb is null");
+    for (int i = 0; i < count; ++i) {
+        DMX_CHECK(dmx_nums[i] < DMX_NUM_MAX, 0, "dmx_num error");
+        DMX_CHECK(dmx_driver_is_installed(dmx_nums[i]), 0, "driver is not installed");
+        for (int j = 0; j < i; ++j) {
+            DMX_CHECK(dmx_nums[i] != dmx_nums[j], 0, "dmx_nums must be unique");
+        }
+    }
+
+    struct rdm_disc_ports_ctx ports = {.cb = cb, .context = context};
+    ports.cb_mux = xSemaphoreCreateMutex();
+    ports.done   = xSemaphoreCreateCounting(DMX_NUM_MAX, 0);
+    if (ports.cb_mux == NULL || ports.done == NULL) {
+        if (ports.cb_mux != NULL) {
+            vSemaphoreDelete(ports.cb_mux);
+        }
+        if (ports.done != NULL) {
+            vSemaphoreDelete(ports.done);
+        }
+        DMX_CHECK(false, 0, "discovery malloc error");
+    }
+
+    // Discover each additional port in its own task so that every port sends
+    // requests while the others are waiting for responses
+    struct rdm_disc_port_job jobs[DMX_NUM_MAX];
+    const UBaseType_t priority = uxTaskPriorityGet(NULL);
+    int num_tasks              = 0;
+    for (int i = 0; i < count; ++i) {
+        jobs[i] = (struct rdm_disc_port_job){.dmx_num = dmx_nums[i], .num_found = 0, .ports = &ports};
+        if (i > 0 && xTaskCreate(rdm_disc_port_task, "rdm_disc", RDM_DISCOVERY_TASK_STACK_SIZE, &jobs[i], priority,
+                                 NULL) == pdPASS) {
+            ++num_tasks;
+        } else if (i > 0) {
+            // Discover the port in this task if a task could not be created
+            jobs[i].num_found = rdm_discover_with_callback(dmx_nums[i], rdm_disc_ports_cb, &ports);
+        }
+    }
+
+    // Discover the first port in this task and wait for the other ports
+    jobs[0].num_found = rdm_discover_with_callback(dmx_nums[0], rdm_disc_ports_cb, &ports);
+    for (int i = 0; i < num_tasks; ++i) {
+        xSemaphoreTake(ports.done, portMAX_DELAY);
+    }
+
+    vSemaphoreDelete(ports.cb_mux);
+    vSemaphoreDelete(ports.done);
+
+    int num_found = 0;
+    for (int i = 0; i < count; ++i) {
+        num_found += jobs[i].num_found;
+    }
+
+    return num_found;
+}
+
 struct rdm_disc_default_ctx {
     unsigned int num;
     rdm_uid_t *uids;
@@ -31,6 +31,16 @@ extern "C" {
 typedef void (*rdm_disc_cb_t)(dmx_port_t dmx_num, rdm_uid_t uid, int num_found, const rdm_disc_mute_t *mute,
                               void *context);
 
+/**
+ * @brief A callback function type for use with rdm_discover_incremental() which
+ * is called when a previously discovered device no longer responds.
+ *
+ * @param dmx_num The DMX port number.
+ * @param uid The UID of the lost device.
+ * @param[inout] context A pointer to a user context.
+ */
+typedef void (*rdm_disc_lost_cb_t)(dmx_port_t dmx_num, rdm_uid_t uid, void *context);
+
 /**
  * @brief Sends an RDM discovery unique branch request and reads the response,
  * if any.
@@ -104,8 +114,8 @@ bool rdm_send_disc_un_mute(dmx_port_t dmx_num, const rdm_uid_t *dest_uid, rdm_di
  * recursive. This significantly reduces the memory needed to perform the
  * discovery algorithm which allows it to be safely performed on an embedded
  * platform. However, the iterative algorithm still requires the allocation of
- * 588 bytes. By default, this is heap allocated but may be allocated on the
- * stack by configuring settings in this library's Kconfig.
+ * 588 bytes. By default, this is heap allocated but may be allocated with the
+ * DMX driver by configuring settings in this library's Kconfig.
  *
  * @param dmx_num The DMX port number.
  * @param cb A callback function which is called when a new device is found.
@@ -115,6 +125,47 @@ bool rdm_send_disc_un_mute(dmx_port_t dmx_num, const rdm_uid_t *dest_uid, rdm_di
  */
 int rdm_discover_with_callback(dmx_port_t dmx_num, rdm_disc_cb_t cb, void *context);
 
+/**
+ * @brief Performs RDM device discovery using the results of a previous
+ * discovery. Each known device is verified with a direct discovery mute
+ * request, which also prevents it from responding while the RDM address space
+ * is searched. The address space is then searched only for devices which were
+ * not known. This allows periodic discovery to complete in a fraction of the
+ * time of rdm_discover_with_callback() when few devices have changed. The
+ * callback is called for every device which is present, including known
+ * devices, so the caller may rebuild its table of UIDs from the callback.
+ *
+ * @param dmx_num The DMX port number.
+ * @param[in] known_uids An array of UIDs which were previously discovered. May
+ * be NULL if num_known is 0.
+ * @param num_known The number of UIDs in the known_uids array.
+ * @param cb A callback function which is called for each device which is found.
+ * @param lost_cb A callback function which is called for each known device
+ * which did not respond. May be NULL.
+ * @param[inout] context Context which is passed to the callback functions.
+ * @return The number of devices found, including known devices which are still
+ * present.
+ */
+int rdm_discover_incremental(dmx_port_t dmx_num, const rdm_uid_t *known_uids, int num_known, rdm_disc_cb_t cb,
+                             rdm_disc_lost_cb_t lost_cb, void *context);
+
+/**
+ * @brief Performs the RDM device discovery algorithm on several ports at once
+ * and executes a callback function whenever a new device is found. Each port
+ * after the first is discovered by its own task at the priority of the calling
+ * task, so that requests are sent on every port while the other ports are
+ * waiting for responses. The callback is never called by more than one port at
+ * a time.
+ *
+ * @param[in] dmx_nums An array of unique DMX port numbers.
+ * @param count The number of DMX port numbers in the array.
+ * @param cb A callback function which is called when a new device is found.
+ * @param[inout] context Context which is passed to the callback function when a
+ * new device is found.
+ * @return The total number of devices found on every port.
+ */
+int rdm_discover_ports_with_callback(const dmx_port_t *dmx_nums, int count, rdm_disc_cb_t cb, void *context);
+
 /**
  * @brief Performs the RDM device discovery algorithm with a default callback
  * function to store the UIDs of found devices in an array.
@@ -125,8 +176,8 @@ int rdm_discover_with_callback(dmx_port_t dmx_num, rdm_disc_cb_t cb, void *conte
  * recursive. This significantly reduces the memory needed to perform the
  * discovery algorithm which allows it to be safely performed on an embedded
  * platform. However, the iterative algorithm still requires the allocation of
- * 588 bytes. By default, this is heap allocated but may be allocated on the
- * stack by configuring settings in this library's Kconfig.
+ * 588 bytes. By default, this is heap allocated but may be allocated with the
+ * DMX driver by configuring settings in this library's Kconfig.
  *
  * @param dmx_num The DMX port number.
  * @param[out] uids An array of UIDs used to store found device UIDs.
@@ -64,6 +64,13 @@ typedef struct rdm_request_t {
  * RDM_RESPONSE_TYPE_NACK_REASON, ack.nack_reason should be read to get the NACK
  * reason.
  *
+ * If the responder answers with RDM_RESPONSE_TYPE_ACK_OVERFLOW, the request is
+ * sent again until the final RDM_RESPONSE_TYPE_ACK page is received and the
+ * pages are concatenated into pd. In that case ack.pdl and the return value are
+ * the length of the concatenated parameter data. If pd is too small to hold
+ * every page, the remaining pages are not requested and ack.type is
+ * RDM_RESPONSE_TYPE_ACK_OVERFLOW.
+ *
  * @param dmx_num The DMX port number.
  * @param[in] request A pointer to a request constructor.
  * @param[in] format The RDM parameter format string for the response data. More
@@ -80,6 +87,112 @@ typedef struct rdm_request_t {
 size_t rdm_send_request(dmx_port_t dmx_num, const rdm_request_t *request, const char *format, void *pd, size_t size,
                         rdm_ack_t *ack);
 
+/**
+ * @brief Sends several RDM controller requests back-to-back while holding the
+ * DMX port once. Each transaction is sent as soon as the RDM controller timing
+ * allows. The responses are read with the same format into consecutive
+ * elements of the pd array, which makes this function suited for polling the
+ * same parameter from many devices. DMX packets are not sent while the
+ * requests are being sent, including by the bus scheduler task started with
+ * rdm_controller_start().
+ *
+ * @param dmx_num The DMX port number.
+ * @param[in] requests An array of n RDM requests to send.
+ * @param n The number of requests to send.
+ * @param format The format of the response parameter data.
+ * @param[out] pd An optional array of n elements into which to read the
+ * response parameter data of each request.
+ * @param size The size of each element of the pd array.
+ * @param[out] acks An optional array of n ACKs which receive information about
+ * the response to each request.
+ * @return The number of requests for which an RDM_RESPONSE_TYPE_ACK was
+ * received.
+ */
+size_t rdm_send_requests(dmx_port_t dmx_num, const rdm_request_t *requests, size_t n, const char *format, void *pd,
+                         size_t size, rdm_ack_t *acks);
+
+/**
+ * @brief The function type used for callbacks when an RDM request which was
+ * sent with rdm_send_request_async() is done.
+ *
+ * @param dmx_num The DMX port number.
+ * @param result The value which rdm_send_request() would have returned.
+ * @param[in] ack A pointer to the ACK of the response.
+ * @param[inout] context A pointer to a user context.
+ */
+typedef void (*rdm_request_cb_t)(dmx_port_t dmx_num, size_t result, const rdm_ack_t *ack, void *context);
+
+/**
+ * @brief Sends an RDM controller request without blocking the calling task.
+ * The request is queued on the bus scheduler task started with
+ * rdm_controller_start(), which sends it, reads the response, and calls the
+ * callback from the scheduler task. The request itself is copied, but the
+ * request parameter data and the response parameter data buffer must remain
+ * valid until the callback is called. Up to RDM_CONTROLLER_QUEUE_SIZE requests
+ * may be in flight on each DMX port.
+ *
+ * If the responder answers with RDM_RESPONSE_TYPE_ACK_TIMER, the callback is
+ * not called yet. Instead, the scheduler task waits for the advertised delay
+ * and retrieves the response with RDM_PID_QUEUED_MESSAGE, re-sending the
+ * request if the queued message is not its response. This is repeated up to
+ * RDM_CONTROLLER_ACK_TIMER_RETRIES_MAX times before the callback is called with
+ * the last RDM_RESPONSE_TYPE_ACK_TIMER.
+ *
+ * @param dmx_num The DMX port number.
+ * @param[in] request A pointer to the RDM request to send.
+ * @param format The format of the response parameter data.
+ * @param[out] pd A pointer into which to read the response parameter data.
+ * @param size The size of the pd buffer.
+ * @param cb A callback which is called when the request is done.
+ * @param[inout] context A pointer to a user context which is passed to the
+ * callback.
+ * @return true if the request was queued.
+ * @return false if the scheduler is not running or too many requests are in
+ * flight.
+ */
+bool rdm_send_request_async(dmx_port_t dmx_num, const rdm_request_t *request, const char *format, void *pd,
+                            size_t size, rdm_request_cb_t cb, void *context);
+
+/**
+ * @brief Hands an RDM request to the bus scheduler task started with
+ * rdm_controller_start() and blocks until the scheduler has sent it. Requests
+ * are not handed to the scheduler if it is not running, if this function is
+ * called from the scheduler task, or if the calling task holds the DMX driver
+ * mutex. The arguments are the same as in rdm_send_request().
+ *
+ * @param[out] result The value returned from rdm_send_request() by the
+ * scheduler task.
+ * @return true if the request was sent by the scheduler task.
+ * @return false if the request must be sent by the calling task.
+ */
+bool rdm_controller_submit(dmx_port_t dmx_num, const rdm_request_t *request, const char *format, void *pd,
+                           size_t size, rdm_ack_t *ack, size_t *result);
+
+/**
+ * @brief Reads an RDM GET response from the cache enabled with
+ * rdm_controller_cache_enable(). The arguments are the same as in
+ * rdm_send_request().
+ *
+ * @param[out] result The value which rdm_send_request() returned when the
+ * response was cached.
+ * @return true if the response was read from the cache.
+ * @return false if the response is not cached.
+ */
+bool rdm_controller_cache_get(dmx_port_t dmx_num, const rdm_request_t *request, const char *format, void *pd,
+                              size_t size, rdm_ack_t *ack, size_t *result);
+
+/**
+ * @brief Stores the raw parameter data of an RDM_RESPONSE_TYPE_ACK response in
+ * the cache enabled with rdm_controller_cache_enable() if the request may be
+ * cached.
+ *
+ * @param dmx_num The DMX port number.
+ * @param[in] request A pointer to the request which was answered.
+ * @param[in] pd A pointer to the raw parameter data of the response.
+ * @param pdl The length of the raw parameter data.
+ */
+void rdm_controller_cache_put(dmx_port_t dmx_num, const rdm_request_t *request, const void *pd, size_t pdl);
+
 /**
  * @brief Get the transaction number of the RDM controller. This number is
  * included in every RDM controller request. It is incremented after every RDM
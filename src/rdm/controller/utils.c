@@ -1,137 +1,244 @@
 #include "./include/utils.h"
 
+#include <stdlib.h>
 #include <string.h>
 
+#include "../../dmx/hal/include/timer.h"
 #include "../../dmx/include/driver.h"
 #include "../../dmx/include/service.h"
 #include "../include/driver.h"
 #include "../include/uid.h"
 
-size_t rdm_send_request(dmx_port_t dmx_num, const rdm_request_t *request, const char *format, void *pd, size_t size,
-                        rdm_ack_t *ack) {
-    assert(dmx_num < DMX_NUM_MAX);
-    assert(request != NULL);
-    assert(request->dest_uid != NULL);
-    assert(request->sub_device < RDM_SUB_DEVICE_MAX || request->sub_device == RDM_SUB_DEVICE_ALL);
-    assert(request->pid > 0);
-    assert(rdm_cc_is_valid(request->cc) && rdm_cc_is_request(request->cc));
-    assert(request->sub_device != RDM_SUB_DEVICE_ALL || request->cc == RDM_CC_SET_COMMAND);
-    assert(rdm_format_is_valid(request->format));
-    assert(request->format != NULL || request->pd == NULL);
-    assert(request->pd != NULL || request->pdl == 0);
-    assert(request->pdl < RDM_PD_SIZE_MAX);
-    assert(rdm_format_is_valid(format));
-    assert(dmx_driver_is_installed(dmx_num));
+static void rdm_restore_dmx(dmx_port_t dmx_num) {
+    // Point the driver back at the DMX packet and resume sending it if it was sent continuously
+    taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+    dmx_buffer_end_rdm(dmx_num);
+    taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+    dmx_continuous_resume(dmx_num);
+}
 
+static void rdm_ack_clear(rdm_ack_t *ack, dmx_err_t err, size_t size, rdm_response_type_t type) {
+    if (ack != NULL) {
+        ack->err           = err;
+        ack->size          = size;
+        ack->src_uid       = (rdm_uid_t){0, 0};
+        ack->pid           = 0;
+        ack->type          = type;
+        ack->message_count = 0;
+        ack->pdl           = 0;
+    }
+}
+
+static struct dmx_driver_latency_t *rdm_latency_get(dmx_port_t dmx_num, const rdm_uid_t *uid) {
     dmx_driver_t *const driver = dmx_driver[dmx_num];
 
-    // Attempt to take the mutex and wait until the driver is done sending
-    if (!xSemaphoreTakeRecursive(driver->mux, portMAX_DELAY)) {
-        return 0;
+    // Find the responder, or replace the responder which was sent a request least recently
+    struct dmx_driver_latency_t *oldest = &driver->rdm.latency[0];
+    for (int i = 0; i < RDM_RESPONDER_LATENCY_MAX; ++i) {
+        struct dmx_driver_latency_t *const entry = &driver->rdm.latency[i];
+        if (rdm_uid_is_eq(&entry->uid, uid)) {
+            return entry;
+        } else if (entry->last_request < oldest->last_request) {
+            oldest = entry;
+        }
     }
-    if (!dmx_wait_sent(dmx_num, dmx_ms_to_ticks(23))) {
-        xSemaphoreGiveRecursive(driver->mux);
-        return 0;
+    *oldest = (struct dmx_driver_latency_t){.uid = *uid, .latency = 0, .misses = 0, .last_request = 0};
+
+    return oldest;
+}
+
+static int32_t rdm_latency_get_timeout(const struct dmx_driver_latency_t *entry) {
+    if (entry->latency == 0) {
+        return RDM_TIMING_CONTROLLER_REQUEST_TO_RESPONSE_MAX;  // The latency is unknown
     }
 
-    // Construct the header using the default arguments and the caller's arguments
-    rdm_header_t header = {
-        .message_len   = 24 + request->pdl,
-        .tn            = rdm_get_transaction_num(dmx_num),
-        .port_id       = dmx_num + 1,
-        .message_count = 0,
-        .sub_device    = request->sub_device,
-        .cc            = request->cc,
-        .pid           = request->pid,
-        .pdl           = request->pdl,
-    };
-    memcpy(&header.dest_uid, request->dest_uid, sizeof(header.dest_uid));
-    memcpy(&header.src_uid, rdm_uid_get(dmx_num), sizeof(header.src_uid));
-
-    // Copy the old data in the DMX buffer to a temporary buffer
-    uint8_t old_data[257];
-    const size_t packet_size = header.message_len + 2;
-    dmx_read(dmx_num, old_data, packet_size);
-
-    // Write and send the RDM request
-    rdm_write(dmx_num, &header, request->format, request->pd);
-    if (!dmx_send(dmx_num)) {
-        dmx_write(dmx_num, old_data, packet_size);  // Write old data back
-        xSemaphoreGiveRecursive(driver->mux);
-        if (ack != NULL) {
-            ack->err           = DMX_OK;
-            ack->size          = 0;
-            ack->src_uid       = (rdm_uid_t){0, 0};
-            ack->pid           = 0;
-            ack->type          = RDM_RESPONSE_TYPE_NONE;
-            ack->message_count = 0;
-            ack->pdl           = 0;
-        }
-        return 0;
+    // Allow twice the usual latency, but never less than the RDM standard allows responders to take
+    int32_t timeout = entry->latency * 2;
+    if (timeout < RDM_TIMING_RESPONDER_MAX) {
+        timeout = RDM_TIMING_RESPONDER_MAX;
+    } else if (timeout > RDM_TIMING_CONTROLLER_REQUEST_TO_RESPONSE_MAX) {
+        timeout = RDM_TIMING_CONTROLLER_REQUEST_TO_RESPONSE_MAX;
     }
 
-    // Return early if no response is expected
-    if (rdm_uid_is_broadcast(request->dest_uid) && request->pid != RDM_PID_DISC_UNIQUE_BRANCH) {
-        dmx_wait_sent(dmx_num, dmx_ms_to_ticks(23));
-        dmx_write(dmx_num, old_data, packet_size);  // Write old data back
-        xSemaphoreGiveRecursive(driver->mux);
-        if (ack != NULL) {
-            ack->err           = DMX_OK;
-            ack->size          = 0;
-            ack->src_uid       = (rdm_uid_t){0, 0};
-            ack->pid           = 0;
-            ack->type          = RDM_RESPONSE_TYPE_NONE;
-            ack->message_count = 0;
-            ack->pdl           = 0;
+    return timeout;
+}
+
+static void rdm_latency_update(dmx_port_t dmx_num, struct dmx_driver_latency_t *entry, size_t response_size,
+                               bool is_valid) {
+    dmx_driver_t *const driver = dmx_driver[dmx_num];
+
+    if (!is_valid) {
+        // Use the maximum timeout until the responder answers again with a valid response
+        entry->latency = 0;
+        if (response_size == 0 && entry->misses < UINT8_MAX) {
+            ++entry->misses;
         }
-        return 0;
+        return;
     }
 
-    // Attempt to receive the RDM response
-    dmx_packet_t packet;
-    dmx_receive(dmx_num, &packet, dmx_ms_to_ticks(23));
-    if (ack != NULL) {
-        ack->err  = packet.err;
-        ack->size = packet.size;
+    // Subtract the time that it took to receive the response from the end-of-packet timestamps
+    int64_t controller_eop, responder_eop;
+    taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+    controller_eop = driver->dmx.controller_eop_timestamp;
+    responder_eop  = driver->dmx.responder_eop_timestamp;
+    taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+    const int64_t slot_time = 11 * 1000000 / DMX_BAUD_RATE;  // Each slot is 11 bits
+    int64_t latency         = responder_eop - controller_eop - (int64_t)response_size * slot_time;
+    if (latency < RDM_TIMING_RESPONDER_MIN) {
+        latency = RDM_TIMING_RESPONDER_MIN;
+    } else if (latency > RDM_TIMING_CONTROLLER_REQUEST_TO_RESPONSE_MAX) {
+        latency = RDM_TIMING_CONTROLLER_REQUEST_TO_RESPONSE_MAX;
     }
+    entry->latency = entry->latency == 0 ? latency : (entry->latency * 3 + latency) / 4;
+    entry->misses  = 0;
+}
 
-    // Return early if no response was received
-    if (packet.size == 0) {
-        dmx_write(dmx_num, old_data, packet_size);  // Write old data back
-        xSemaphoreGiveRecursive(driver->mux);
-        if (ack != NULL) {
-            ack->src_uid       = (rdm_uid_t){0, 0};
-            ack->pid           = 0;
-            ack->type          = RDM_RESPONSE_TYPE_NONE;
-            ack->message_count = 0;
-            ack->pdl           = 0;
+/**
+ * @brief Writes, sends, receives, and reads a single RDM transaction. If the
+ * response is an RDM_RESPONSE_TYPE_ACK_OVERFLOW, the request is repeated and
+ * the pages are concatenated until the final RDM_RESPONSE_TYPE_ACK page is
+ * received. The caller must hold the DMX driver mutex and must have pointed
+ * the DMX driver at its RDM buffer with dmx_buffer_begin_rdm().
+ */
+static size_t rdm_transact(dmx_port_t dmx_num, const rdm_request_t *request, const char *format, void *pd,
+                           size_t size, rdm_ack_t *ack) {
+    dmx_driver_t *const driver = dmx_driver[dmx_num];
+
+    uint8_t *overflow   = NULL;  // The concatenated pages of an ACK_OVERFLOW response.
+    size_t overflow_pdl = 0;     // The length of the concatenated pages.
+
+    // A SET request may change any parameter of the device, including ones which are not in the request
+    if (request->cc == RDM_CC_SET_COMMAND) {
+        rdm_controller_cache_invalidate(dmx_num, request->dest_uid);
+    }
+
+    // Fail without using the bus if the responder has repeatedly not responded. Discovery requests are always sent
+    // so that responders which are found again by discovery may be muted.
+    struct dmx_driver_latency_t *latency = NULL;
+    if (!rdm_uid_is_broadcast(request->dest_uid)) {
+        latency = rdm_latency_get(dmx_num, request->dest_uid);
+        const int64_t now = dmx_timer_get_micros_since_boot();
+        if (request->cc != RDM_CC_DISC_COMMAND && latency->misses >= RDM_RESPONDER_MISSES_MAX &&
+            now - latency->last_request < RDM_RESPONDER_MISSED_RETRY_PERIOD) {
+            rdm_ack_clear(ack, DMX_ERR_TIMEOUT, 0, RDM_RESPONSE_TYPE_NONE);
+            return 0;
         }
-        return 0;
+        latency->last_request = now;
     }
+    rdm_header_t header;
+    dmx_packet_t packet;
+    while (true) {
+        // Construct the header using the default arguments and the caller's arguments
+        header = (rdm_header_t){
+            .message_len   = 24 + request->pdl,
+            .tn            = rdm_get_transaction_num(dmx_num),
+            .port_id       = dmx_num + 1,
+            .message_count = 0,
+            .sub_device    = request->sub_device,
+            .cc            = request->cc,
+            .pid           = request->pid,
+            .pdl           = request->pdl,
+        };
+        memcpy(&header.dest_uid, request->dest_uid, sizeof(header.dest_uid));
+        memcpy(&header.src_uid, rdm_uid_get(dmx_num), sizeof(header.src_uid));
 
-    // Return early if the response checksum was invalid
-    if (!rdm_read_header(dmx_num, &header)) {
-        dmx_write(dmx_num, old_data, packet_size);  // Write old data back
-        xSemaphoreGiveRecursive(driver->mux);
-        if (ack != NULL) {
-            ack->src_uid       = (rdm_uid_t){0, 0};
-            ack->pid           = 0;
-            ack->type          = RDM_RESPONSE_TYPE_INVALID;
-            ack->message_count = 0;
-            ack->pdl           = 0;
+        // Write and send the RDM request
+        rdm_write(dmx_num, &header, request->format, request->pd);
+        if (!dmx_send(dmx_num)) {
+            free(overflow);
+            rdm_ack_clear(ack, DMX_OK, 0, RDM_RESPONSE_TYPE_NONE);
+            return 0;
+        }
+
+        // Return early if no response is expected
+        if (rdm_uid_is_broadcast(request->dest_uid) && request->pid != RDM_PID_DISC_UNIQUE_BRANCH) {
+            dmx_wait_sent(dmx_num, dmx_ms_to_ticks(23));
+            rdm_ack_clear(ack, DMX_OK, 0, RDM_RESPONSE_TYPE_NONE);
+            return 0;
+        }
+
+        // Attempt to receive the RDM response, waiting only as long as the responder usually takes
+        if (latency != NULL) {
+            taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+            driver->dmx.response_timeout = rdm_latency_get_timeout(latency);
+            taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+        }
+        dmx_receive(dmx_num, &packet, dmx_ms_to_ticks(23));
+        const bool is_valid = packet.size > 0 && packet.err == DMX_OK && rdm_read_header(dmx_num, &header);
+        if (latency != NULL) {
+            taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+            driver->dmx.response_timeout = 0;
+            taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+            rdm_latency_update(dmx_num, latency, packet.size, is_valid);
+        }
+
+        // Return early if no response was received
+        if (packet.size == 0) {
+            free(overflow);
+            rdm_ack_clear(ack, packet.err, packet.size, RDM_RESPONSE_TYPE_NONE);
+            return 0;
+        }
+
+        // Return early if the response had UART errors or its checksum was invalid
+        if (!is_valid) {
+            free(overflow);
+            rdm_ack_clear(ack, packet.err, packet.size, RDM_RESPONSE_TYPE_INVALID);
+            return 0;
+        }
+
+        // Concatenate the pages of ACK_OVERFLOW responses
+        const bool is_page = (header.response_type == RDM_RESPONSE_TYPE_ACK_OVERFLOW ||
+                              (header.response_type == RDM_RESPONSE_TYPE_ACK && overflow != NULL));
+        if (!is_page || header.pid != request->pid || pd == NULL) {
+            break;
+        }
+        if (overflow == NULL) {
+            overflow = malloc(size);
+            if (overflow == NULL) {
+                DMX_WARN("RDM overflow malloc error");
+                break;  // Only the first page can be read
+            }
+        }
+        size_t page_pdl = header.pdl;
+        if (page_pdl > size - overflow_pdl) {
+            page_pdl = size - overflow_pdl;
+        }
+        memcpy(overflow + overflow_pdl, &driver->dmx.data[24], page_pdl);
+        overflow_pdl += page_pdl;
+        if (header.response_type == RDM_RESPONSE_TYPE_ACK || overflow_pdl == size) {
+            break;  // The final page was received, or the caller's buffer is full
         }
-        return 0;
     }
 
-    // Copy the parameter data into the output
-    if (header.response_type == RDM_RESPONSE_TYPE_ACK && header.pid != RDM_PID_DISC_UNIQUE_BRANCH) {
-        if (pd == NULL) {
-            rdm_read_pd(dmx_num, format, pd, size);
+    // Invalidate the cached responses of a device which has queued messages
+    if (header.message_count > 0) {
+        rdm_controller_cache_invalidate(dmx_num, &header.src_uid);
+    }
+
+    // Cache the raw parameter data of complete responses
+    if (header.response_type == RDM_RESPONSE_TYPE_ACK && header.pid == request->pid) {
+        if (overflow != NULL) {
+            rdm_controller_cache_put(dmx_num, request, overflow, overflow_pdl);
+        } else {
+            rdm_controller_cache_put(dmx_num, request, &driver->dmx.data[24], header.pdl);
         }
     }
 
+    // Copy the parameter data into the output
+    if (overflow != NULL) {
+        rdm_pd_decode(format, pd, size, overflow, overflow_pdl);
+        free(overflow);
+        header.pdl = overflow_pdl;
+    } else if ((header.response_type == RDM_RESPONSE_TYPE_ACK ||
+                header.response_type == RDM_RESPONSE_TYPE_ACK_OVERFLOW) &&
+               header.pid != RDM_PID_DISC_UNIQUE_BRANCH) {
+        rdm_read_pd(dmx_num, format, pd, size);
+    }
+
     // Copy the results into the ack struct
     if (ack != NULL) {
+        ack->err  = packet.err;
+        ack->size = packet.size;
         memcpy(&ack->src_uid, &header.src_uid, sizeof(rdm_uid_t));
         ack->pid = header.pid;
         if (!rdm_response_type_is_valid(header.response_type)) {
@@ -143,24 +250,19 @@ size_t rdm_send_request(dmx_port_t dmx_num, const rdm_request_t *request, const
             if (header.response_type == RDM_RESPONSE_TYPE_ACK_TIMER) {
                 uint16_t timer;
                 rdm_read_pd(dmx_num, word_format, &timer, sizeof(timer));
-                ack->timer = dmx_ms_to_ticks(timer * 10);
+                ack->timer = dmx_ms_to_ticks(timer * 100);  // The timer is in units of 100 milliseconds
             } else if (header.response_type == RDM_RESPONSE_TYPE_NACK_REASON) {
                 uint16_t nack_reason;
                 rdm_read_pd(dmx_num, word_format, &nack_reason, sizeof(nack_reason));
                 ack->nack_reason = nack_reason;
             } else {
-                rdm_read_pd(dmx_num, format, pd, size);
                 ack->pdl = header.pdl;
             }
         }
         ack->message_count = header.message_count;
     }
 
-    // Write the old data from before the request back into the DMX driver
-    dmx_write(dmx_num, old_data, packet_size);
-
-    // Give the mutex back and return the PDL or true on success
-    xSemaphoreGiveRecursive(driver->mux);
+    // Return the PDL or true on success
     if (header.response_type == RDM_RESPONSE_TYPE_ACK) {
         if (header.pdl == 0) {
             return 1;
@@ -172,6 +274,110 @@ size_t rdm_send_request(dmx_port_t dmx_num, const rdm_request_t *request, const
     }
 }
 
+size_t rdm_send_request(dmx_port_t dmx_num, const rdm_request_t *request, const char *format, void *pd, size_t size,
+                        rdm_ack_t *ack) {
+    assert(dmx_num < DMX_NUM_MAX);
+    assert(request != NULL);
+    assert(request->dest_uid != NULL);
+    assert(request->sub_device < RDM_SUB_DEVICE_MAX || request->sub_device == RDM_SUB_DEVICE_ALL);
+    assert(request->pid > 0);
+    assert(rdm_cc_is_valid(request->cc) && rdm_cc_is_request(request->cc));
+    assert(request->sub_device != RDM_SUB_DEVICE_ALL || request->cc == RDM_CC_SET_COMMAND);
+    assert(rdm_format_is_valid(request->format));
+    assert(request->format != NULL || request->pd == NULL);
+    assert(request->pd != NULL || request->pdl == 0);
+    assert(request->pdl < RDM_PD_SIZE_MAX);
+    assert(rdm_format_is_valid(format));
+    assert(dmx_driver_is_installed(dmx_num));
+
+    // Read responses which rarely change from the cache if it is enabled
+    size_t result;
+    if (rdm_controller_cache_get(dmx_num, request, format, pd, size, ack, &result)) {
+        return result;
+    }
+
+    // Let the bus scheduler send the request between DMX packets if it is running
+    if (rdm_controller_submit(dmx_num, request, format, pd, size, ack, &result)) {
+        return result;
+    }
+
+    dmx_driver_t *const driver = dmx_driver[dmx_num];
+
+    // Attempt to take the mutex and wait until the driver is done sending
+    if (!xSemaphoreTakeRecursive(driver->mux, portMAX_DELAY)) {
+        return 0;
+    }
+    if (!dmx_wait_sent(dmx_num, dmx_ms_to_ticks(23))) {
+        xSemaphoreGiveRecursive(driver->mux);
+        return 0;
+    }
+
+    // Send and receive using the RDM buffer so that the DMX packet is untouched
+    taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+    dmx_buffer_begin_rdm(dmx_num);
+    taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+
+    result = rdm_transact(dmx_num, request, format, pd, size, ack);
+
+    // Point the DMX driver back at the DMX packet and give the mutex back
+    rdm_restore_dmx(dmx_num);
+    xSemaphoreGiveRecursive(driver->mux);
+
+    return result;
+}
+
+size_t rdm_send_requests(dmx_port_t dmx_num, const rdm_request_t *requests, size_t n, const char *format, void *pd,
+                         size_t size, rdm_ack_t *acks) {
+    DMX_CHECK(dmx_num < DMX_NUM_MAX, 0, "dmx_num error");
+    DMX_CHECK(requests != NULL || n == 0, 0, "requests is null");
+    DMX_CHECK(rdm_format_is_valid(format), 0, "format error");
+    DMX_CHECK(dmx_driver_is_installed(dmx_num), 0, "driver is not installed");
+    for (size_t i = 0; i < n; ++i) {
+        const rdm_request_t *const request = &requests[i];
+        DMX_CHECK(request->dest_uid != NULL, 0, "dest_uid is null");
+        DMX_CHECK(request->sub_device < RDM_SUB_DEVICE_MAX || request->sub_device == RDM_SUB_DEVICE_ALL, 0,
+                  "sub_device error");
+        DMX_CHECK(request->pid > 0, 0, "pid error");
+        DMX_CHECK(rdm_cc_is_valid(request->cc) && rdm_cc_is_request(request->cc), 0, "cc error");
+        DMX_CHECK(request->sub_device != RDM_SUB_DEVICE_ALL || request->cc == RDM_CC_SET_COMMAND, 0,
+                  "sub_device error");
+        DMX_CHECK(rdm_format_is_valid(request->format), 0, "format error");
+        DMX_CHECK(request->format != NULL || request->pd == NULL, 0, "format is null");
+        DMX_CHECK(request->pd != NULL || request->pdl == 0, 0, "pd is null");
+        DMX_CHECK(request->pdl < RDM_PD_SIZE_MAX, 0, "pdl error");
+    }
+
+    dmx_driver_t *const driver = dmx_driver[dmx_num];
+
+    // Take the port once for every transaction
+    if (!xSemaphoreTakeRecursive(driver->mux, portMAX_DELAY)) {
+        return 0;
+    }
+    if (!dmx_wait_sent(dmx_num, dmx_ms_to_ticks(23))) {
+        xSemaphoreGiveRecursive(driver->mux);
+        return 0;
+    }
+    taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+    dmx_buffer_begin_rdm(dmx_num);
+    taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+
+    // Send the transactions back-to-back. dmx_send() waits only as long as the
+    // RDM controller timing requires between each transaction.
+    size_t num_acks = 0;
+    for (size_t i = 0; i < n; ++i) {
+        void *const response_pd = pd != NULL ? (uint8_t *)pd + i * size : NULL;
+        rdm_ack_t *const ack    = acks != NULL ? &acks[i] : NULL;
+        if (rdm_transact(dmx_num, &requests[i], format, response_pd, size, ack) > 0) {
+            ++num_acks;
+        }
+    }
+
+    rdm_restore_dmx(dmx_num);
+    xSemaphoreGiveRecursive(driver->mux);
+
+    return num_acks;
+}
+
 uint32_t rdm_get_transaction_num(dmx_port_t dmx_num) {
     assert(dmx_num < DMX_NUM_MAX);
     assert(dmx_driver_is_installed(dmx_num));
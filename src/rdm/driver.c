@@ -10,116 +10,376 @@
 #include "./include/driver.h"
 #include "./include/uid.h"
 
-static size_t rdm_format_encode(void *restrict dest, const char *restrict format, const void *restrict src,
-                                size_t src_size, bool encode_nulls) {
-    assert(dest != NULL);
-    assert(rdm_format_is_valid(format));
-    assert(src != NULL);
+#ifndef CONFIG_IDF_TARGET_LINUX
+#if ESP_IDF_VERSION_MAJOR >= 5
+#include "esp_memory_utils.h"
+#else
+#include "soc/soc_memory_layout.h"
+#endif
+#endif
+
+/** @brief The number of compiled RDM formats which may be cached.*/
+#define RDM_FORMAT_CACHE_SIZE (32)
+
+/** @brief The maximum size in bytes of the ops of a cached RDM format.*/
+#define RDM_FORMAT_OPS_MAX (24)
+
+/** @brief Compiled RDM format op types. Each op is a single byte with the op
+ * type in the upper 3 bits and the repeat count minus one in the lower 5 bits.
+ * Literal ops are followed by one literal byte per repeat.*/
+enum rdm_format_op_t {
+    RDM_FORMAT_OP_BYTE = 0,
+    RDM_FORMAT_OP_WORD,
+    RDM_FORMAT_OP_DWORD,
+    RDM_FORMAT_OP_UID,
+    RDM_FORMAT_OP_OPTIONAL_UID,
+    RDM_FORMAT_OP_ASCII,
+    RDM_FORMAT_OP_LITERAL,
+    RDM_FORMAT_OP_TERMINATOR,
+};
+
+#define RDM_FORMAT_OP_TYPE(op)  ((op) >> 5)
+#define RDM_FORMAT_OP_COUNT(op) (((op) & 0x1f) + 1)
+#define RDM_FORMAT_OP_MAX_COUNT (32)
+
+typedef struct rdm_format_t {
+    const char *format;              // The format string from which the ops were compiled or NULL if the slot is free.
+    uint8_t size;                    // The size of the compiled ops in bytes.
+    uint8_t ops[RDM_FORMAT_OPS_MAX];  // The compiled ops.
+} rdm_format_t;
+
+static rdm_format_t rdm_formats[RDM_FORMAT_CACHE_SIZE];
+static portMUX_TYPE rdm_format_spinlock = DMX_SPINLOCK_INIT;
+
+static int rdm_format_hex_to_int(char c) {
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    } else if (c >= 'a' && c <= 'f') {
+        return c - 'a' + 10;
+    } else {
+        return c - 'A' + 10;
+    }
+}
 
-    size_t encoded = 0;
-    while (src_size > 0) {
-        const char *f = format;
-        for (char c = *f; c != '\0'; c = *(++f)) {
-            // Skip whitespaces
-            if (c == ' ') {
-                continue;
-            }
+// Compiles as much of a format as fits into the ops and advances the format past the compiled tokens
+static size_t rdm_format_compile_ops(const char **format, uint8_t *ops, size_t size) {
+    assert(format != NULL && *format != NULL);
+    assert(ops != NULL);
+
+    size_t compiled = 0;
+    size_t last_op  = 0;
+    const char *f   = *format;
+    for (; *f != '\0'; ++f) {
+        // Skip whitespaces
+        if (*f == ' ') {
+            continue;
+        }
+        const char *const token = f;
 
-            // Check for terminator
-            if (c == '$') {
-                return encoded;
-            }
+        // Get the op type of the token
+        int type;
+        uint8_t literal = 0;
+        switch (tolower((unsigned char)*f)) {
+            case 'b':
+                type = RDM_FORMAT_OP_BYTE;
+                break;
+            case 'w':
+                type = RDM_FORMAT_OP_WORD;
+                break;
+            case 'd':
+                type = RDM_FORMAT_OP_DWORD;
+                break;
+            case 'u':
+                type = RDM_FORMAT_OP_UID;
+                break;
+            case 'v':
+                type = RDM_FORMAT_OP_OPTIONAL_UID;
+                break;
+            case 'a':
+                type = RDM_FORMAT_OP_ASCII;
+                break;
+            case 'x':
+                type    = RDM_FORMAT_OP_LITERAL;
+                literal = (rdm_format_hex_to_int(f[1]) << 4) | rdm_format_hex_to_int(f[2]);
+                f += 2;  // Skip to the next token
+                break;
+            default:  // '$'
+                type = RDM_FORMAT_OP_TERMINATOR;
+                break;
+        }
 
-            // Copy the token to the destination buffer
-            size_t token_size;
-            if (c >= 'A' && c <= 'Z') {
-                c += 'A';  // Convert token to lowercase
+        // Merge the token into the previous op if it is repeated
+        const bool is_repeatable = type != RDM_FORMAT_OP_OPTIONAL_UID && type != RDM_FORMAT_OP_ASCII &&
+                                   type != RDM_FORMAT_OP_TERMINATOR;
+        if (compiled > 0 && is_repeatable && RDM_FORMAT_OP_TYPE(ops[last_op]) == type &&
+            RDM_FORMAT_OP_COUNT(ops[last_op]) < RDM_FORMAT_OP_MAX_COUNT) {
+            if (type == RDM_FORMAT_OP_LITERAL) {
+                if (compiled >= size) {
+                    f = token;  // Not enough space for the rest of the format
+                    break;
+                }
+                ops[compiled++] = literal;
             }
-            if (c == 'b') {
-                token_size = sizeof(uint8_t);
-                memcpy(dest, src, token_size);
-                // Don't need to swap endianness on single byte
-                encoded += token_size;
-            } else if (c == 'w') {
-                token_size = sizeof(uint16_t);
-                memcpy(dest, src, token_size);
-                *(uint16_t *)dest = bswap16(*(uint16_t *)dest);
-                encoded += token_size;
-            } else if (c == 'd') {
-                token_size = sizeof(uint32_t);
-                memcpy(dest, src, token_size);
-                *(uint32_t *)dest = bswap32(*(uint32_t *)dest);
-                encoded += token_size;
-            } else if (c == 'u' || c == 'v') {
-                token_size = sizeof(rdm_uid_t);
-                if (c == 'v' && (src_size < token_size || rdm_uid_is_null(src))) {
-                    // Handle condition where an optional UID was not provided
-                    if (encode_nulls) {
-                        memset(dest, 0, token_size);
-                        encoded += token_size;
+            ++ops[last_op];
+        } else {
+            const size_t op_size = type == RDM_FORMAT_OP_LITERAL ? 2 : 1;
+            if (compiled + op_size > size) {
+                f = token;  // Not enough space for the rest of the format
+                break;
+            }
+            last_op         = compiled;
+            ops[compiled++] = type << 5;
+            if (type == RDM_FORMAT_OP_LITERAL) {
+                ops[compiled++] = literal;
+            }
+        }
+
+        // End compilation if the format is terminated
+        if (!is_repeatable) {
+            f += strlen(f);
+            break;
+        }
+    }
+
+    *format = f;
+    return compiled;
+}
+
+static const rdm_format_t *rdm_format_get(const char *format) {
+    if (format == NULL) {
+        return NULL;
+    }
+
+    const size_t hash = ((uintptr_t)format >> 2) % RDM_FORMAT_CACHE_SIZE;
+    for (int i = 0; i < RDM_FORMAT_CACHE_SIZE; ++i) {
+        // The format is published last, so its ops are complete once the format can be read
+        const rdm_format_t *const cached = &rdm_formats[(hash + i) % RDM_FORMAT_CACHE_SIZE];
+        const char *const key            = __atomic_load_n(&cached->format, __ATOMIC_ACQUIRE);
+        if (key == format) {
+            return cached;
+        } else if (key == NULL) {
+            break;
+        }
+    }
+
+    return NULL;
+}
+
+static bool rdm_format_is_read_only(const char *format) {
+#ifdef CONFIG_IDF_TARGET_LINUX
+    return false;  // Read-only data can't be identified on the host
+#else
+    return esp_ptr_in_drom(format);
+#endif
+}
+
+typedef struct rdm_format_cursor_t {
+    uint8_t *d;         // The next byte of the destination.
+    const uint8_t *s;   // The next byte of the source.
+    size_t src_size;    // The number of bytes remaining in the source.
+    size_t encoded;     // The number of bytes which have been encoded.
+    bool encode_nulls;  // True to encode optional UIDs and null terminators.
+} rdm_format_cursor_t;
+
+// Runs each op once. Returns false if encoding ended before the last op.
+static bool rdm_format_run_ops(rdm_format_cursor_t *c, const uint8_t *ops, size_t ops_size) {
+    for (const uint8_t *op = ops; op < ops + ops_size; ++op) {
+        const int type  = RDM_FORMAT_OP_TYPE(*op);
+        const int count = RDM_FORMAT_OP_COUNT(*op);
+        switch (type) {
+            case RDM_FORMAT_OP_BYTE:
+                for (int i = 0; i < count; ++i) {
+                    if (c->src_size < sizeof(uint8_t)) {
+                        return false;
+                    }
+                    *c->d = *c->s;  // Don't need to swap endianness on single byte
+                    c->d += sizeof(uint8_t);
+                    c->s += sizeof(uint8_t);
+                    c->src_size -= sizeof(uint8_t);
+                    c->encoded += sizeof(uint8_t);
+                }
+                break;
+
+            case RDM_FORMAT_OP_WORD:
+                for (int i = 0; i < count; ++i) {
+                    if (c->src_size < sizeof(uint16_t)) {
+                        return false;
+                    }
+                    uint16_t word;
+                    memcpy(&word, c->s, sizeof(word));
+                    word = bswap16(word);
+                    memcpy(c->d, &word, sizeof(word));
+                    c->d += sizeof(uint16_t);
+                    c->s += sizeof(uint16_t);
+                    c->src_size -= sizeof(uint16_t);
+                    c->encoded += sizeof(uint16_t);
+                }
+                break;
+
+            case RDM_FORMAT_OP_DWORD:
+                for (int i = 0; i < count; ++i) {
+                    if (c->src_size < sizeof(uint32_t)) {
+                        return false;
+                    }
+                    uint32_t dword;
+                    memcpy(&dword, c->s, sizeof(dword));
+                    dword = bswap32(dword);
+                    memcpy(c->d, &dword, sizeof(dword));
+                    c->d += sizeof(uint32_t);
+                    c->s += sizeof(uint32_t);
+                    c->src_size -= sizeof(uint32_t);
+                    c->encoded += sizeof(uint32_t);
+                }
+                break;
+
+            case RDM_FORMAT_OP_UID:
+            case RDM_FORMAT_OP_OPTIONAL_UID:
+                for (int i = 0; i < count; ++i) {
+                    const bool is_null = c->src_size < sizeof(rdm_uid_t) || rdm_uid_is_null((const rdm_uid_t *)c->s);
+                    if (c->src_size < sizeof(rdm_uid_t) || (type == RDM_FORMAT_OP_OPTIONAL_UID && is_null)) {
+                        // Handle condition where an optional UID was not provided
+                        if (type == RDM_FORMAT_OP_OPTIONAL_UID && c->encode_nulls) {
+                            memset(c->d, 0, sizeof(rdm_uid_t));
+                            c->encoded += sizeof(rdm_uid_t);
+                        }
+                        return false;
                     }
-                    return encoded;
+                    memcpy(c->d, c->s, sizeof(rdm_uid_t));
+                    rdm_uid_t *const uid = (rdm_uid_t *)c->d;
+                    uid->man_id          = bswap16(uid->man_id);
+                    uid->dev_id          = bswap32(uid->dev_id);
+                    c->d += sizeof(rdm_uid_t);
+                    c->s += sizeof(rdm_uid_t);
+                    c->src_size -= sizeof(rdm_uid_t);
+                    c->encoded += sizeof(rdm_uid_t);
                 }
-                memcpy(dest, src, token_size);
-                rdm_uid_t *const uid = dest;
-                uid->man_id          = bswap16(uid->man_id);
-                uid->dev_id          = bswap32(uid->dev_id);
-                encoded += token_size;
-                if (c == 'v') {
-                    return encoded;
+                if (type == RDM_FORMAT_OP_OPTIONAL_UID) {
+                    return false;
                 }
-            } else if (c == 'a') {
-                token_size = strnlen(src, (src_size < 32 ? src_size : 32));
-                memcpy(dest, src, token_size);
-                if (encode_nulls) {
+                break;
+
+            case RDM_FORMAT_OP_ASCII: {
+                size_t token_size = strnlen((const char *)c->s, (c->src_size < 32 ? c->src_size : 32));
+                memcpy(c->d, c->s, token_size);
+                if (c->encode_nulls) {
                     // Only null-terminate the string if desired by the caller
-                    ((uint8_t *)dest)[token_size] = '\0';
+                    c->d[token_size] = '\0';
                     token_size += 1;
                 }
-                encoded += token_size;
-                return encoded;
-            } else if (c == 'x') {
-                // Copy the hex literal format string to a null-terminated string
-                char str[3];
-                str[2] = '\0';
-                memcpy(str, (f + 1), 2);
-
-                // Get the hex literal as an integer and copy it to the destination
-                token_size            = sizeof(uint8_t);
-                const uint8_t literal = (uint8_t)strtol(str, NULL, 16);
-                memcpy(dest, &literal, token_size);
-                encoded += token_size;
-                // Don't need to swap endianness on single byte
-                f += 2;  // Skip to the next token
-            } else {
-                __unreachable();  // Unknown symbol
+                c->encoded += token_size;
+                return false;
             }
 
-            // Update cursor
-            dest += token_size;
-            src += token_size;
-            src_size -= token_size;
+            case RDM_FORMAT_OP_LITERAL:
+                for (int i = 0; i < count; ++i) {
+                    if (c->src_size < sizeof(uint8_t)) {
+                        return false;
+                    }
+                    *c->d = op[1 + i];  // Literals are written regardless of the source value
+                    c->d += sizeof(uint8_t);
+                    c->s += sizeof(uint8_t);
+                    c->src_size -= sizeof(uint8_t);
+                    c->encoded += sizeof(uint8_t);
+                }
+                op += count;  // Skip the literal bytes
+                break;
+
+            default:  // RDM_FORMAT_OP_TERMINATOR
+                return false;
         }
     }
 
-    return encoded;
+    return true;
 }
 
-bool DMX_ISR_ATTR rdm_read_header(dmx_port_t dmx_num, rdm_header_t *header) {
-    DMX_CHECK(dmx_num < DMX_NUM_MAX, 0, "dmx_num error");
-    DMX_CHECK(dmx_driver[dmx_num] != NULL, 0, "driver is not installed");
+static size_t rdm_format_run(void *restrict dest, const uint8_t *ops, size_t ops_size, const void *restrict src,
+                             size_t src_size, bool encode_nulls) {
+    rdm_format_cursor_t c = {.d = dest, .s = src, .src_size = src_size, .encoded = 0, .encode_nulls = encode_nulls};
+    while (c.src_size > 0 && rdm_format_run_ops(&c, ops, ops_size)) {
+        continue;  // Formats are repeated until the source is encoded
+    }
 
-    dmx_driver_t *const driver = dmx_driver[dmx_num];
+    return c.encoded;
+}
+
+static size_t rdm_format_encode(void *restrict dest, const char *restrict format, const void *restrict src,
+                                size_t src_size, bool encode_nulls) {
+    assert(dest != NULL);
+    assert(rdm_format_is_valid(format));
+    assert(src != NULL);
+
+    if (format == NULL) {
+        return 0;
+    }
+
+    // Run the precompiled format if it has been compiled
+    const rdm_format_t *cached = rdm_format_get(format);
+    if (cached != NULL) {
+        return rdm_format_run(dest, cached->ops, cached->size, src, src_size, encode_nulls);
+    }
+
+    // Compile and run the format a few ops at a time so that it doesn't need a large buffer
+    uint8_t ops[RDM_FORMAT_OPS_MAX];
+    rdm_format_cursor_t c = {.d = dest, .s = src, .src_size = src_size, .encoded = 0, .encode_nulls = encode_nulls};
+    while (c.src_size > 0) {
+        for (const char *f = format; *f != '\0';) {
+            const size_t ops_size = rdm_format_compile_ops(&f, ops, sizeof(ops));
+            if (!rdm_format_run_ops(&c, ops, ops_size)) {
+                return c.encoded;
+            }
+        }
+    }
 
-    const uint8_t *data = driver->dmx.data;
-    uint16_t checksum   = 0;
+    return c.encoded;
+}
+
+static void rdm_header_encode(uint8_t *data, const rdm_header_t *header) {
+    data[0]  = RDM_SC;
+    data[1]  = RDM_SUB_SC;
+    data[2]  = header->message_len;
+    data[3]  = header->dest_uid.man_id >> 8;
+    data[4]  = header->dest_uid.man_id;
+    data[5]  = header->dest_uid.dev_id >> 24;
+    data[6]  = header->dest_uid.dev_id >> 16;
+    data[7]  = header->dest_uid.dev_id >> 8;
+    data[8]  = header->dest_uid.dev_id;
+    data[9]  = header->src_uid.man_id >> 8;
+    data[10] = header->src_uid.man_id;
+    data[11] = header->src_uid.dev_id >> 24;
+    data[12] = header->src_uid.dev_id >> 16;
+    data[13] = header->src_uid.dev_id >> 8;
+    data[14] = header->src_uid.dev_id;
+    data[15] = header->tn;
+    data[16] = header->port_id;  // Also encodes the response type
+    data[17] = header->message_count;
+    data[18] = header->sub_device >> 8;
+    data[19] = header->sub_device;
+    data[20] = header->cc;
+    data[21] = header->pid >> 8;
+    data[22] = header->pid;
+    data[23] = header->pdl;
+}
+
+static void DMX_ISR_ATTR rdm_header_copy(rdm_header_t *dest, const rdm_header_t *src) {
+    // Copy the header without function calls for IRAM ISR
+    for (int i = 0; i < sizeof(rdm_header_t); ++i) {
+        ((uint8_t *)dest)[i] = ((const uint8_t *)src)[i];
+    }
+}
+
+static bool DMX_ISR_ATTR rdm_header_decode(const uint8_t *data, int running_checksum, rdm_header_t *header) {
+    uint16_t checksum = 0;
 
     // Check if packet is standard RDM packet or RDM discovery response packet
     if (*(uint16_t *)data == (RDM_SC | (RDM_SUB_SC << 8))) {
-        // Verify checksum
+        // Verify checksum, which may have been summed while the packet was received
         const uint8_t message_len = data[2];
-        for (int i = 0; i < message_len; ++i) {
-            checksum += data[i];
+        if (running_checksum >= 0) {
+            checksum = running_checksum;
+        } else {
+            for (int i = 0; i < message_len; ++i) {
+                checksum += data[i];
+            }
         }
         if (checksum != bswap16(*(uint16_t *)(data + message_len))) {
             return false;
@@ -150,6 +410,15 @@ bool DMX_ISR_ATTR rdm_read_header(dmx_port_t dmx_num, rdm_header_t *header) {
         }
         data += preamble_len + 1;
 
+        // Verify the encoding of the EUID and checksum. Each byte is sent twice,
+        // once OR'ed with 0xaa and once OR'ed with 0x55. Colliding responses
+        // often corrupt these bits even when the checksum happens to be valid.
+        for (int i = 0; i < 16; i += 2) {
+            if ((data[i] & 0xaa) != 0xaa || (data[i + 1] & 0x55) != 0x55) {
+                return false;
+            }
+        }
+
         // Verify checksum
         for (int i = 0; i < 12; ++i) {
             checksum += data[i];
@@ -189,9 +458,73 @@ bool DMX_ISR_ATTR rdm_read_header(dmx_port_t dmx_num, rdm_header_t *header) {
     return false;
 }
 
+bool DMX_ISR_ATTR rdm_read_header(dmx_port_t dmx_num, rdm_header_t *header) {
+    DMX_CHECK(dmx_num < DMX_NUM_MAX, 0, "dmx_num error");
+    DMX_CHECK(dmx_driver[dmx_num] != NULL, 0, "driver is not installed");
+
+    dmx_driver_t *const driver = dmx_driver[dmx_num];
+
+    // Reuse the header if it was decoded when the packet was received or written
+    if (driver->rdm.decoded.data == driver->dmx.data) {
+        if (header != NULL) {
+            rdm_header_copy(header, &driver->rdm.decoded.header);
+        }
+        return true;
+    }
+
+    return rdm_header_decode(driver->dmx.data, -1, header);
+}
+
+bool DMX_ISR_ATTR rdm_read_header_isr(dmx_port_t dmx_num, int checksum) {
+    dmx_driver_t *const driver = dmx_driver[dmx_num];
+
+    rdm_header_t header;
+    if (!rdm_header_decode(driver->dmx.data, checksum, &header)) {
+        return false;
+    }
+
+    taskENTER_CRITICAL_ISR(DMX_SPINLOCK(dmx_num));
+    rdm_header_copy(&driver->rdm.decoded.header, &header);
+    driver->rdm.decoded.data = driver->dmx.data;
+    taskEXIT_CRITICAL_ISR(DMX_SPINLOCK(dmx_num));
+
+    return true;
+}
+
+size_t rdm_encode_disc_response(void *data, const rdm_uid_t *uid) {
+    DMX_CHECK(data != NULL, 0, "data is null");
+    DMX_CHECK(uid != NULL, 0, "uid is null");
+
+    // Encode the preamble bytes
+    const size_t preamble_len = 7;
+    memset(data, RDM_PREAMBLE, preamble_len);
+    ((uint8_t *)data)[preamble_len] = RDM_DELIMITER;
+    uint8_t *euid                   = (uint8_t *)data + preamble_len + 1;
+
+    // Encode the UID and calculate the checksum
+    uint8_t buf[6];
+    ((rdm_uid_t *)buf)->man_id = bswap16(uid->man_id);
+    ((rdm_uid_t *)buf)->dev_id = bswap32(uid->dev_id);
+    uint16_t checksum          = 0;
+    for (int i = 0, j = 0; j < sizeof(rdm_uid_t); i += 2, ++j) {
+        euid[i]     = buf[j] | 0xaa;
+        euid[i + 1] = buf[j] | 0x55;
+        checksum += buf[j] + (0xaa | 0x55);
+    }
+
+    // Encode the checksum
+    const int cs_offset = sizeof(rdm_uid_t) * 2;
+    euid[cs_offset + 0] = (uint8_t)(checksum >> 8) | 0xaa;
+    euid[cs_offset + 1] = (uint8_t)(checksum >> 8) | 0x55;
+    euid[cs_offset + 2] = (uint8_t)(checksum) | 0xaa;
+    euid[cs_offset + 3] = (uint8_t)(checksum) | 0x55;
+
+    return preamble_len + 1 + 16;
+}
+
 size_t rdm_read_pd(dmx_port_t dmx_num, const char *format, void *destination, size_t size) {
     DMX_CHECK(dmx_num < DMX_NUM_MAX, 0, "dmx_num error");
-    DMX_CHECK(rdm_format_is_valid(format), 0, "format is invalid");
+    DMX_CHECK(rdm_format_get(format) != NULL || rdm_format_is_valid(format), 0, "format is invalid");
     DMX_CHECK(dmx_driver_is_installed(dmx_num), 0, "driver is not installed");
 
     dmx_driver_t *const driver = dmx_driver[dmx_num];
@@ -213,6 +546,20 @@ size_t rdm_read_pd(dmx_port_t dmx_num, const char *format, void *destination, si
     return pdl;
 }
 
+size_t rdm_pd_decode(const char *format, void *destination, size_t size, const void *pd, size_t pdl) {
+    DMX_CHECK(rdm_format_get(format) != NULL || rdm_format_is_valid(format), 0, "format is invalid");
+    DMX_CHECK(pd != NULL || pdl == 0, 0, "pd is null");
+
+    // Deserialize the parameter data into the destination buffer
+    if (destination != NULL && pdl > 0) {
+        size                    = pdl < size ? pdl : size;
+        const bool encode_nulls = true;
+        rdm_format_encode(destination, format, pd, size, encode_nulls);
+    }
+
+    return pdl;
+}
+
 size_t rdm_write(dmx_port_t dmx_num, const rdm_header_t *header, const char *format, const void *pd) {
     DMX_CHECK(dmx_num < DMX_NUM_MAX, 0, "dmx_num error");
     DMX_CHECK(header != NULL, 0, "header is null");
@@ -226,7 +573,8 @@ size_t rdm_write(dmx_port_t dmx_num, const rdm_header_t *header, const char *for
     } else {
         DMX_CHECK(rdm_response_type_is_valid(header->response_type), 0, "header->response_type error");
     }
-    DMX_CHECK(rdm_format_is_valid(format), 0, "format is invalid");
+    DMX_CHECK(format == NULL || rdm_format_get(format) != NULL || rdm_format_is_valid(format), 0,
+              "format is invalid");
     DMX_CHECK(header->pdl == 0 || (format != NULL && pd != NULL), 0, "pd or format is null");
     DMX_CHECK(dmx_driver_is_installed(dmx_num), 0, "driver is not installed");
 
@@ -236,36 +584,10 @@ size_t rdm_write(dmx_port_t dmx_num, const rdm_header_t *header, const char *for
     size_t written;
     const bool encode_nulls = false;
     if (header->cc == RDM_CC_DISC_COMMAND_RESPONSE && header->pid == RDM_PID_DISC_UNIQUE_BRANCH) {
-        // Encode the preamble bytes
-        const size_t preamble_len = 7;
-        memset(driver->dmx.data, RDM_PREAMBLE, preamble_len);
-        driver->dmx.data[preamble_len] = RDM_DELIMITER;
-        uint8_t *data                  = &driver->dmx.data[preamble_len + 1];
-
-        // Encode the UID and calculate the checksum
-        uint8_t uid[6];
-        ((rdm_uid_t *)uid)->man_id = bswap16(header->src_uid.man_id);
-        ((rdm_uid_t *)uid)->dev_id = bswap32(header->src_uid.dev_id);
-        uint16_t checksum          = 0;
-        for (int i = 0, j = 0; j < sizeof(rdm_uid_t); i += 2, ++j) {
-            data[i]     = uid[j] | 0xaa;
-            data[i + 1] = uid[j] | 0x55;
-            checksum += uid[j] + (0xaa | 0x55);
-        }
-
-        // Encode the checksum
-        const int cs_offset = sizeof(rdm_uid_t) * 2;
-        data[cs_offset + 0] = (uint8_t)(checksum >> 8) | 0xaa;
-        data[cs_offset + 1] = (uint8_t)(checksum >> 8) | 0x55;
-        data[cs_offset + 2] = (uint8_t)(checksum) | 0xaa;
-        data[cs_offset + 3] = (uint8_t)(checksum) | 0x55;
-
-        // Update written size
-        written = preamble_len + 1 + 16;
+        written = rdm_encode_disc_response(driver->dmx.data, &header->src_uid);
     } else {
         // Serialize the header and pd into the driver buffer
-        const char *header_format = "xCCx01buubbbwbwb";
-        rdm_format_encode(driver->dmx.data, header_format, header, sizeof(*header), encode_nulls);
+        rdm_header_encode(driver->dmx.data, header);
         size_t message_len;
         void *data = &driver->dmx.data[24];
         if (pd != NULL && header->pdl > 0) {
@@ -293,14 +615,72 @@ size_t rdm_write(dmx_port_t dmx_num, const rdm_header_t *header, const char *for
         written = message_len + 2;
     }
 
+    // Keep the decoded header so that it is not decoded again when the packet is sent
+    rdm_header_t decoded;
+    if (header->cc == RDM_CC_DISC_COMMAND_RESPONSE && header->pid == RDM_PID_DISC_UNIQUE_BRANCH) {
+        rdm_header_decode(driver->dmx.data, -1, &decoded);
+    } else {
+        decoded             = *header;
+        decoded.message_len = written - 2;
+        decoded.pdl         = driver->dmx.data[23];
+    }
+    taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+    driver->rdm.decoded.header = decoded;
+    driver->rdm.decoded.data   = driver->dmx.data;
+    taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+
     return written;
 }
 
-bool rdm_format_is_valid(const char *format) {
-    if (format == NULL) {
+bool rdm_format_compile(const char *format) {
+    DMX_CHECK(format != NULL, false, "format is null");
+    DMX_CHECK(rdm_format_is_valid(format), false, "format is invalid");
+
+    // Return early if the format has already been compiled
+    if (rdm_format_get(format) != NULL) {
         return true;
     }
 
+    // Formats are cached by address, so only formats which can't change may be cached
+    if (!rdm_format_is_read_only(format)) {
+        return false;
+    }
+
+    // Compile the format outside of the critical section
+    uint8_t ops[RDM_FORMAT_OPS_MAX];
+    const char *f     = format;
+    const size_t size = rdm_format_compile_ops(&f, ops, sizeof(ops));
+    if (*f != '\0') {
+        return false;  // Format is too long to be cached
+    }
+
+    // Insert the compiled format into the first free slot
+    bool compiled     = false;
+    const size_t hash = ((uintptr_t)format >> 2) % RDM_FORMAT_CACHE_SIZE;
+    taskENTER_CRITICAL(&rdm_format_spinlock);
+    for (int i = 0; i < RDM_FORMAT_CACHE_SIZE; ++i) {
+        rdm_format_t *const cached = &rdm_formats[(hash + i) % RDM_FORMAT_CACHE_SIZE];
+        if (cached->format == format) {
+            compiled = true;  // Format was compiled by another task
+            break;
+        } else if (cached->format == NULL) {
+            memcpy(cached->ops, ops, size);
+            cached->size = size;
+            __atomic_store_n(&cached->format, format, __ATOMIC_RELEASE);  // Publish the format after its ops
+            compiled = true;
+            break;
+        }
+    }
+    taskEXIT_CRITICAL(&rdm_format_spinlock);
+
+    return compiled;
+}
+
+size_t rdm_format_get_size(const char *format, size_t max_size) {
+    if (format == NULL || max_size > 231) {
+        return 0;
+    }
+
     size_t parameter_size = 0;
 
     bool format_is_terminated = false;
@@ -340,7 +720,7 @@ bool rdm_format_is_valid(const char *format) {
                 for (int i = 0; i < 2; ++i) {
                     c = *(++format);
                     if (!isxdigit(c)) {
-                        return false;  // Hex literals must be 2 characters wide
+                        return 0;  // Hex literals must be 2 characters wide
                     }
                 }
                 break;
@@ -354,13 +734,13 @@ bool rdm_format_is_valid(const char *format) {
                 format_is_terminated = true;
                 break;
             default:
-                return false;  // Unknown symbol
+                return 0;  // Unknown symbol
         }
 
         // Update the parameter size with the new token
         parameter_size += token_size;
-        if (parameter_size > 231) {
-            return false;  // Parameter size is too big
+        if (parameter_size > max_size) {
+            return 0;  // Parameter size is too big
         }
 
         // End loop if parameter is terminated
@@ -372,12 +752,16 @@ bool rdm_format_is_valid(const char *format) {
     if (format_is_terminated) {
         ++format;
         if (*format != '\0' && *format != '$') {
-            return false;  // Invalid token after terminator
+            return 0;  // Invalid token after terminator
         }
-    } else {
+    } else if (parameter_size > 0) {
         // Get the maximum possible size if parameter is unterminated
-        parameter_size = 231 - (231 % parameter_size);
+        parameter_size = max_size - (max_size % parameter_size);
     }
 
-    return parameter_size > 0;
+    return parameter_size;
+}
+
+bool rdm_format_is_valid(const char *format) {
+    return format == NULL || rdm_format_get_size(format, 231) > 0;
 }
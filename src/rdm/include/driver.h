@@ -73,6 +73,22 @@ bool rdm_read_header(dmx_port_t dmx_num, rdm_header_t *header);
  */
 size_t rdm_read_pd(dmx_port_t dmx_num, const char *format, void *destination, size_t size);
 
+/**
+ * @brief Reads RDM parameter data from a buffer instead of from the DMX driver.
+ * This is used to read parameter data which was received over several packets,
+ * such as the pages of an RDM_RESPONSE_TYPE_ACK_OVERFLOW response. The format
+ * string is the same as in rdm_read_pd().
+ *
+ * @param[in] format The format string of the RDM parameter data.
+ * @param[out] destination A pointer to a destination buffer into which to copy
+ * parameter data.
+ * @param size The size of the destination buffer.
+ * @param[in] pd A pointer to the raw RDM parameter data.
+ * @param pdl The length of the raw RDM parameter data.
+ * @return The length of the RDM parameter data or 0 on error.
+ */
+size_t rdm_pd_decode(const char *format, void *destination, size_t size, const void *pd, size_t pdl);
+
 /**
  * @brief Writes an RDM packet into the DMX driver buffer so it may be sent with
  * dmx_send().
@@ -122,6 +138,44 @@ size_t rdm_read_pd(dmx_port_t dmx_num, const char *format, void *destination, si
  */
 size_t rdm_write(dmx_port_t dmx_num, const rdm_header_t *header, const char *format, const void *pd);
 
+/**
+ * @brief Encodes an RDM_PID_DISC_UNIQUE_BRANCH response into a buffer. The
+ * response is encoded with a full 7-byte preamble so the buffer must be at
+ * least 24 bytes long.
+ *
+ * @param[out] data The buffer into which to encode the response.
+ * @param[in] uid The UID of the responding device.
+ * @return The size of the encoded response.
+ */
+size_t rdm_encode_disc_response(void *data, const rdm_uid_t *uid);
+
+/**
+ * @brief Compiles an RDM format string so that it does not need to be parsed
+ * each time it is used by rdm_read_pd() or rdm_write(). Compiled formats are
+ * identified by the address of the format string, so only format strings in
+ * read-only flash, such as string literals, may be compiled. Format strings in
+ * RAM are parsed each time they are used. Format strings of parameters
+ * registered with rdm_definition_set() are compiled automatically.
+ *
+ * @param[in] format The RDM format string.
+ * @return true if the format was compiled.
+ * @return false if the format is invalid, is not in read-only flash, or if
+ * there is no space to store it.
+ */
+bool rdm_format_compile(const char *format);
+
+/**
+ * @brief Gets the maximum size of parameter data that an RDM format string can
+ * encode. Formats which are not terminated repeat, so the size is the largest
+ * multiple of the format which fits in the maximum size.
+ *
+ * @param[in] format The RDM format string.
+ * @param max_size The maximum size of the parameter data. Must not exceed 231.
+ * @return The maximum size of the parameter data or 0 if the format is invalid
+ * or does not fit in the maximum size.
+ */
+size_t rdm_format_get_size(const char *format, size_t max_size);
+
 /**
  * @brief Returns true if the RDM format string is valid.
  *
@@ -9,96 +9,434 @@
 #include "./include/types.h"
 #include "./include/uid.h"
 
-bool rdm_send_response(dmx_port_t dmx_num) {
-    DMX_CHECK(dmx_num < DMX_NUM_MAX, 0, "dmx_num error");
-    DMX_CHECK(dmx_driver_is_installed(dmx_num), 0, "driver is not installed");
+#ifdef CONFIG_RDM_RESPONDER_IRAM_SAFE
+#if ESP_IDF_VERSION_MAJOR >= 5
+#include "esp_private/cache_utils.h"
+#else
+#include "esp_spi_flash.h"
+#endif
+#endif
 
+static size_t rdm_response_cache_write(dmx_port_t dmx_num, const dmx_parameter_t *parameter,
+                                       const rdm_header_t *header, const uint8_t *key) {
     dmx_driver_t *const driver = dmx_driver[dmx_num];
 
-    if (!xSemaphoreTakeRecursive(driver->mux, 0)) {
-        return false;
+    // Only use the cached response if it is valid for this request
+    const dmx_parameter_cache_t *cache = parameter->cache;
+    uint32_t generation;
+    taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+    generation = driver->device.generation;
+    taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+    if (cache == NULL || cache->generation != generation || cache->sub_device != header->sub_device ||
+        cache->key_size != header->pdl || memcmp(cache->key, key, header->pdl) != 0) {
+        return 0;
     }
 
-    // Get the RDM header information and update miscellaneous RDM driver fields
-    bool is_rdm;
-    rdm_header_t header;
+    // Copy the cached response and patch the fields which change per request
+    uint8_t *const data         = driver->dmx.data;
+    const size_t message_len    = cache->message_len;
+    const uint8_t message_count = rdm_queue_size(dmx_num);
+    memcpy(data, cache->data, message_len);
+    data[3]  = header->src_uid.man_id >> 8;
+    data[4]  = header->src_uid.man_id;
+    data[5]  = header->src_uid.dev_id >> 24;
+    data[6]  = header->src_uid.dev_id >> 16;
+    data[7]  = header->src_uid.dev_id >> 8;
+    data[8]  = header->src_uid.dev_id;
+    data[15] = header->tn;
+    data[17] = message_count;
+
+    // Fix up the checksum using the sum of the bytes which were not patched
+    uint16_t checksum = cache->sum + data[15] + data[17];
+    for (int i = 3; i < 9; ++i) {
+        checksum += data[i];
+    }
+    data[message_len]     = checksum >> 8;
+    data[message_len + 1] = checksum;
+
+    return message_len + 2;
+}
+
+static void rdm_response_cache_store(dmx_port_t dmx_num, dmx_parameter_t *parameter, const rdm_header_t *header,
+                                     const uint8_t *key, uint32_t generation, size_t packet_size) {
+    dmx_driver_t *const driver = dmx_driver[dmx_num];
+
+    // Only cache complete ACK responses
+    const uint8_t *const data = driver->dmx.data;
+    const size_t message_len  = data[2];
+    if (packet_size != message_len + 2 || data[16] != RDM_RESPONSE_TYPE_ACK ||
+        data[20] != RDM_CC_GET_COMMAND_RESPONSE) {
+        return;
+    }
+
+    // Allocate the cache the first time the parameter is cached, or if it's too small
+    dmx_parameter_cache_t *cache = parameter->cache;
+    if (cache == NULL || cache->capacity < message_len) {
+        cache = dmx_parameter_alloc(dmx_num, sizeof(*cache) + message_len);
+        if (cache == NULL) {
+            return;  // The response will not be cached
+        }
+        cache->capacity  = message_len;
+        parameter->cache = cache;
+    }
+
+    // Sum the bytes which are not patched by rdm_response_cache_write()
+    uint16_t sum = 0;
+    for (int i = 0; i < message_len; ++i) {
+        if ((i < 3 || i > 8) && i != 15 && i != 17) {
+            sum += data[i];
+        }
+    }
+
+    // The DMX interrupt may read the cache so it must never see a partially written response
     taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
-    is_rdm = rdm_read_header(dmx_num, &header);
+    memcpy(cache->data, data, message_len);
+    memcpy(cache->key, key, header->pdl);
+    cache->key_size    = header->pdl;
+    cache->sub_device  = header->sub_device;
+    cache->message_len = message_len;
+    cache->sum         = sum;
+    cache->generation  = generation;
     taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
-    if (!rdm_cc_is_valid(header.cc)) {
-        is_rdm = false;  // Packet is not RDM if CC is invalid
+}
+
+#ifdef CONFIG_RDM_RESPONDER_IRAM_SAFE
+bool DMX_ISR_ATTR rdm_response_cache_isr(dmx_port_t dmx_num) {
+    dmx_driver_t *const driver                     = dmx_driver[dmx_num];
+    struct dmx_driver_fast_discovery_t *const fast = &driver->rdm.fast_discovery;
+    const uint8_t *const data                      = driver->dmx.data;
+
+    // The RDM responder task answers requests whenever it is able to run
+    if (spi_flash_cache_enabled() || data[20] != RDM_CC_GET_COMMAND || data[18] != 0 || data[19] != 0) {
+        return false;
     }
-    const rdm_uid_t *this_uid = rdm_uid_get(dmx_num);
-    if (is_rdm) {
-        // Packet is an RDM request packet
-        if (rdm_uid_is_target(this_uid, &header.dest_uid)) {
-            if (header.pid == driver->dmx.last_request_pid) {
-                ++driver->dmx.last_request_pid_repeats;
-            } else {
-                driver->dmx.last_request_pid_repeats = 0;
-            }
+    rdm_header_t request;
+    if (!rdm_read_header(dmx_num, &request) || request.pdl > RDM_RESPONSE_CACHE_KEY_SIZE_MAX ||
+        !rdm_uid_is_eq(&driver->uid, &request.dest_uid)) {
+        return false;  // Virtual responders are only answered by the RDM responder task
+    }
+
+    taskENTER_CRITICAL_ISR(DMX_SPINLOCK(dmx_num));
+
+    // Find the parameter without function calls for IRAM ISR
+    const dmx_parameter_t *const parameters = driver->device.root.parameters;
+    int low                                 = 0;
+    int high                                = driver->device.parameter_count.root;
+    while (low < high) {
+        const int mid = low + (high - low) / 2;
+        if (parameters[mid].pid != 0 && parameters[mid].pid < request.pid) {
+            low = mid + 1;
+        } else {
+            high = mid;
         }
     }
+    const dmx_parameter_cache_t *cache = NULL;
+    if (low < driver->device.parameter_count.root && parameters[low].pid == request.pid) {
+        cache = parameters[low].cache;
+    }
 
-    // Return early if this packet isn't relevant to this device
-    if (!is_rdm || !rdm_uid_is_target(this_uid, &header.dest_uid)) {
-        xSemaphoreGiveRecursive(driver->mux);
+    // Only use the cached response if it is valid for this request and fits in the UART FIFO
+    bool is_valid = cache != NULL && cache->generation == driver->device.generation &&
+                    cache->sub_device == RDM_SUB_DEVICE_ROOT && cache->key_size == request.pdl &&
+                    cache->message_len + 2 <= SOC_UART_FIFO_LEN;
+    for (int i = 0; is_valid && i < request.pdl; ++i) {
+        is_valid = cache->key[i] == data[24 + i];
+    }
+    if (!is_valid || fast->size > 0 || fast->is_sending) {
+        taskEXIT_CRITICAL_ISR(DMX_SPINLOCK(dmx_num));
         return false;
     }
 
-    // Update PID of the last request to target this device
-    driver->dmx.last_request_pid = header.pid;
+    // Copy the cached response and patch the fields which change per request
+    uint8_t *const response     = fast->cached;
+    const int message_len       = cache->message_len;
+    const uint8_t message_count = fast->queue_size > 255 ? 255 : fast->queue_size;
+    for (int i = 0; i < message_len; ++i) {
+        response[i] = cache->data[i];
+    }
+    for (int i = 0; i < 6; ++i) {
+        response[3 + i] = data[9 + i];  // The source UID of the request, which is already encoded
+    }
+    response[15]      = request.tn;
+    response[17]      = message_count;
+    uint16_t checksum = cache->sum + response[15] + response[17];
+    for (int i = 3; i < 9; ++i) {
+        checksum += response[i];
+    }
+    response[message_len]     = checksum >> 8;
+    response[message_len + 1] = checksum;
+
+    // Schedule the response after the minimum responder turnaround time
+    rdm_header_t *const response_header = &fast->response_header;
+    for (int i = 0; i < sizeof(*response_header); ++i) {
+        ((uint8_t *)response_header)[i] = 0;
+    }
+    response_header->message_len   = message_len;
+    response_header->dest_uid      = request.src_uid;
+    response_header->src_uid       = driver->uid;
+    response_header->tn            = request.tn;
+    response_header->response_type = RDM_RESPONSE_TYPE_ACK;
+    response_header->message_count = message_count;
+    response_header->cc            = RDM_CC_GET_COMMAND_RESPONSE;
+    response_header->pid           = request.pid;
+    response_header->pdl           = response[23];
+    fast->request                  = request;
+    fast->responded                = true;
+    fast->response                 = response;
+    fast->size                     = message_len + 2;
+    fast->has_break                = true;
+    fast->progress                 = DMX_PROGRESS_STALE;
+    dmx_timer_set_counter(dmx_num, 0);
+    dmx_timer_set_alarm(dmx_num, RDM_TIMING_RESPONDER_MIN, false);
+    dmx_timer_start(dmx_num);
+    taskEXIT_CRITICAL_ISR(DMX_SPINLOCK(dmx_num));
+
+    return true;
+}
+#endif
+
+/** @brief The index of the DMX port's own RDM responder when iterating the
+ * responders which are targeted by a request. Virtual responders have an index
+ * of 0 or greater.*/
+#define RDM_RESPONDER_PORT (-1)
+
+/** @brief The index which begins and ends the iteration of the responders which
+ * are targeted by a request.*/
+#define RDM_RESPONDER_NONE (-2)
+
+/** @brief A callback which is called after a request is handled and the DMX
+ * driver is released.*/
+typedef struct rdm_responder_callback_t {
+    rdm_callback_t callback;       // The callback of the parameter.
+    void *context;                 // The user context of the callback.
+    rdm_header_t response_header;  // The header of the response, or zeroed if there was no response.
+} rdm_responder_callback_t;
+
+static void rdm_responder_set_active(dmx_port_t dmx_num, int index) {
+    struct dmx_driver_virtual_t *const virtuals = dmx_driver[dmx_num]->rdm.virtuals;
+    rdm_virtual_set_active(dmx_num, index >= 0 ? &virtuals->responders[index] : NULL);
+}
+
+static int rdm_responder_next_target(dmx_port_t dmx_num, const rdm_uid_t *uid, int index) {
+    if (index == RDM_RESPONDER_NONE && rdm_uid_is_target(&dmx_driver[dmx_num]->uid, uid)) {
+        return RDM_RESPONDER_PORT;
+    }
+
+    // The virtual responders do not change while the DMX driver mutex is held
+    const int next = rdm_virtual_find(dmx_num, uid, index < 0 ? 0 : index + 1);
+
+    return next >= 0 ? next : RDM_RESPONDER_NONE;
+}
 
-    // Get parameter definition
+static size_t rdm_responder_handle(dmx_port_t dmx_num, const rdm_header_t *header, dmx_parameter_t **entry) {
+    dmx_driver_t *const driver = dmx_driver[dmx_num];
+
+    // Resolve the parameter once and get its definition
     size_t packet_size;  // Size of the response packet
-    const rdm_parameter_definition_t *def = rdm_definition_get(dmx_num, header.sub_device, header.pid);
+    dmx_parameter_t *parameter = NULL;
+    if (header->pid > 0 && (header->sub_device < RDM_SUB_DEVICE_MAX || header->sub_device == RDM_SUB_DEVICE_ALL)) {
+        const rdm_sub_device_t sub_device =
+            header->sub_device == RDM_SUB_DEVICE_ALL ? RDM_SUB_DEVICE_ROOT : header->sub_device;
+        parameter = dmx_parameter_get_entry(dmx_num, sub_device, header->pid);
+    }
+    *entry                                = parameter;
+    const rdm_parameter_definition_t *def = parameter != NULL ? parameter->definition : NULL;
     if (def == NULL) {
         // Unknown PID
-        packet_size = rdm_write_nack_reason(dmx_num, &header, RDM_NR_UNKNOWN_PID);
-    } else if ((header.sub_device >= RDM_SUB_DEVICE_MAX && header.sub_device != RDM_SUB_DEVICE_ALL) ||
-               header.pdl >= RDM_PD_SIZE_MAX) {
+        packet_size = rdm_write_nack_reason(dmx_num, header, RDM_NR_UNKNOWN_PID);
+    } else if ((header->sub_device >= RDM_SUB_DEVICE_MAX && header->sub_device != RDM_SUB_DEVICE_ALL) ||
+               header->pdl >= RDM_PD_SIZE_MAX) {
         // Header format is invalid
-        packet_size = rdm_write_nack_reason(dmx_num, &header, RDM_NR_FORMAT_ERROR);
+        packet_size = rdm_write_nack_reason(dmx_num, header, RDM_NR_FORMAT_ERROR);
     } else {
         // Request is valid, handle the response
 
         // Validate the header against definition information
         const rdm_pid_cc_t pid_cc = def->pid_cc;
-        if (pid_cc == RDM_CC_DISC && header.cc != RDM_CC_DISC_COMMAND) {
+        if (pid_cc == RDM_CC_DISC && header->cc != RDM_CC_DISC_COMMAND) {
             packet_size = 0;  // Cannot send NACK to RDM_CC_DISC_COMMAND
-        } else if ((pid_cc == RDM_CC_GET_SET && header.cc == RDM_CC_DISC_COMMAND) ||
-                   (pid_cc == RDM_CC_GET && header.cc != RDM_CC_GET_COMMAND) ||
-                   (pid_cc == RDM_CC_SET && header.cc != RDM_CC_SET_COMMAND)) {
+        } else if ((pid_cc == RDM_CC_GET_SET && header->cc == RDM_CC_DISC_COMMAND) ||
+                   (pid_cc == RDM_CC_GET && header->cc != RDM_CC_GET_COMMAND) ||
+                   (pid_cc == RDM_CC_SET && header->cc != RDM_CC_SET_COMMAND)) {
             // Unsupported command class
-            packet_size = rdm_write_nack_reason(dmx_num, &header, RDM_NR_UNSUPPORTED_COMMAND_CLASS);
+            packet_size = rdm_write_nack_reason(dmx_num, header, RDM_NR_UNSUPPORTED_COMMAND_CLASS);
         } else {
-            // Call the response handler for the parameter
-            if (header.cc == RDM_CC_SET_COMMAND) {
-                packet_size = def->set.handler(dmx_num, def, &header);
-            } else {
-                // RDM_CC_DISC_COMMAND uses get.handler()
-                packet_size = def->get.handler(dmx_num, def, &header);
+            // GET responses which only depend on parameter data may be cached
+            const bool is_cacheable = def->is_cacheable && header->cc == RDM_CC_GET_COMMAND &&
+                                      header->sub_device != RDM_SUB_DEVICE_ALL &&
+                                      header->pdl <= RDM_RESPONSE_CACHE_KEY_SIZE_MAX;
+            uint8_t key[RDM_RESPONSE_CACHE_KEY_SIZE_MAX];
+            uint32_t generation = 0;
+            if (is_cacheable) {
+                taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+                memcpy(key, &driver->dmx.data[24], header->pdl);
+                generation = driver->device.generation;
+                taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+            }
+
+            // Call the response handler for the parameter if there is no cached response
+            packet_size = is_cacheable ? rdm_response_cache_write(dmx_num, parameter, header, key) : 0;
+            if (packet_size == 0) {
+                if (header->cc == RDM_CC_SET_COMMAND) {
+                    packet_size = def->set.handler(dmx_num, def, header);
+                } else {
+                    // RDM_CC_DISC_COMMAND uses get.handler()
+                    packet_size = def->get.handler(dmx_num, def, header);
+                    if (is_cacheable) {
+                        rdm_response_cache_store(dmx_num, parameter, header, key, generation, packet_size);
+                    }
+                }
             }
 
             // Validate the response
-            if (header.pid == RDM_PID_DISC_UNIQUE_BRANCH &&
+            if (header->pid == RDM_PID_DISC_UNIQUE_BRANCH &&
                 ((packet_size > 0 && packet_size < 17) || packet_size > 24)) {
                 // Invalid RDM_CC_DISC_COMMAND_RESPONSE packet size
                 packet_size = 0;  // Silence invalid discovery responses
                 rdm_set_boot_loader(dmx_num);
-            } else if (packet_size > 255 || (packet_size == 0 && !rdm_uid_is_broadcast(&header.dest_uid))) {
+            } else if (packet_size > 255 || (packet_size == 0 && !rdm_uid_is_broadcast(&header->dest_uid))) {
                 // Response size is too large or zero after a non-broadcast request
-                packet_size = rdm_write_nack_reason(dmx_num, &header, RDM_NR_HARDWARE_FAULT);
+                packet_size = rdm_write_nack_reason(dmx_num, header, RDM_NR_HARDWARE_FAULT);
                 rdm_set_boot_loader(dmx_num);
             }
         }
     }
 
     // Do not send a response to non-discovery broadcast packets
-    if (rdm_uid_is_broadcast(&header.dest_uid) && header.pid != RDM_PID_DISC_UNIQUE_BRANCH) {
+    if (rdm_uid_is_broadcast(&header->dest_uid) && header->pid != RDM_PID_DISC_UNIQUE_BRANCH) {
         packet_size = 0;
     }
 
+    return packet_size;
+}
+
+bool rdm_send_response(dmx_port_t dmx_num) {
+    DMX_CHECK(dmx_num < DMX_NUM_MAX, 0, "dmx_num error");
+    DMX_CHECK(dmx_driver_is_installed(dmx_num), 0, "driver is not installed");
+
+    dmx_driver_t *const driver = dmx_driver[dmx_num];
+
+    // Controller-only drivers have no root device parameters and never respond
+    if (driver->device.parameter_count.root == 0) {
+        return false;
+    }
+
+    if (!xSemaphoreTakeRecursive(driver->mux, 0)) {
+        return false;
+    }
+
+    // Get the RDM header information and update miscellaneous RDM driver fields
+    bool is_rdm;
+    bool is_target = false;
+    rdm_header_t header;
+    taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+    is_rdm = rdm_read_header(dmx_num, &header);
+    if (is_rdm) {
+        is_target = rdm_port_is_target(dmx_num, &header.dest_uid);
+    }
+    taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+    if (!rdm_cc_is_valid(header.cc)) {
+        is_rdm = false;  // Packet is not RDM if CC is invalid
+    }
+    if (is_rdm && is_target) {
+        // Packet is an RDM request packet
+        if (header.pid == driver->dmx.last_request_pid) {
+            ++driver->dmx.last_request_pid_repeats;
+        } else {
+            driver->dmx.last_request_pid_repeats = 0;
+        }
+    }
+
+    // Return early if this packet isn't relevant to this device
+    if (!is_rdm || !is_target) {
+        xSemaphoreGiveRecursive(driver->mux);
+        return false;
+    }
+
+    // Update PID of the last request to target this device
+    driver->dmx.last_request_pid = header.pid;
+
+    // Every responder which is targeted by the request calls its callback after the driver is released
+    rdm_responder_callback_t callbacks[1 + RDM_VIRTUAL_RESPONDER_MAX];
+    int callback_count = 0;
+
+    // Discovery requests may have already been answered by the DMX interrupt
+    bool isr_responded;
+    rdm_header_t isr_response_header;
+    taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+    isr_responded = driver->rdm.fast_discovery.responded;
+    if (isr_responded) {
+        isr_response_header                  = driver->rdm.fast_discovery.response_header;
+        driver->rdm.fast_discovery.responded = false;
+    }
+    taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+    if (isr_responded) {
+        for (int index = rdm_responder_next_target(dmx_num, &header.dest_uid, RDM_RESPONDER_NONE);
+             index != RDM_RESPONDER_NONE; index = rdm_responder_next_target(dmx_num, &header.dest_uid, index)) {
+            rdm_responder_set_active(dmx_num, index);
+            const dmx_parameter_t *parameter = dmx_parameter_get_entry(dmx_num, RDM_SUB_DEVICE_ROOT, header.pid);
+            if (parameter != NULL && parameter->callback != NULL) {
+                // Only the responder which sent the response is given its header
+                rdm_responder_callback_t *const callback = &callbacks[callback_count++];
+                callback->callback                       = parameter->callback;
+                callback->context                        = parameter->context;
+                if (rdm_uid_is_eq(&isr_response_header.src_uid, rdm_uid_get(dmx_num))) {
+                    callback->response_header = isr_response_header;
+                } else {
+                    memset(&callback->response_header, 0, sizeof(callback->response_header));
+                }
+            }
+        }
+        rdm_responder_set_active(dmx_num, RDM_RESPONDER_PORT);
+        xSemaphoreGiveRecursive(driver->mux);
+        for (int i = 0; i < callback_count; ++i) {
+            callbacks[i].callback(dmx_num, &header, &callbacks[i].response_header, callbacks[i].context);
+        }
+        return isr_response_header.message_len > 0;
+    }
+
+    // Keep a copy of broadcast requests so that each virtual responder may handle them
+    struct dmx_driver_virtual_t *const virtuals = driver->rdm.virtuals;
+    const bool is_shared                        = virtuals != NULL && rdm_uid_is_broadcast(&header.dest_uid);
+    const size_t request_size                   = header.message_len + 2;  // Include the checksum
+    if (is_shared) {
+        taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+        memcpy(virtuals->request, driver->dmx.data, request_size);
+        taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+    }
+
+    // Handle the request with each responder which it targets until one of them responds
+    size_t packet_size = 0;  // Size of the response packet
+    for (int index = rdm_responder_next_target(dmx_num, &header.dest_uid, RDM_RESPONDER_NONE);
+         index != RDM_RESPONDER_NONE; index = rdm_responder_next_target(dmx_num, &header.dest_uid, index)) {
+        if (is_shared && callback_count > 0) {
+            // Restore the request which the last responder overwrote with its response
+            taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+            memcpy(driver->dmx.data, virtuals->request, request_size);
+            dmx_buffer_invalidate_rdm(dmx_num);
+            taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+        }
+
+        rdm_responder_set_active(dmx_num, index);
+        dmx_parameter_t *parameter;
+        packet_size = rdm_responder_handle(dmx_num, &header, &parameter);
+        rdm_responder_set_active(dmx_num, RDM_RESPONDER_PORT);
+
+        // Read the response header before the request is restored
+        rdm_responder_callback_t *const callback = &callbacks[callback_count++];
+        callback->callback                       = parameter != NULL ? parameter->callback : NULL;
+        callback->context                        = parameter != NULL ? parameter->context : NULL;
+        if (callback->callback != NULL && !rdm_read_header(dmx_num, &callback->response_header)) {
+            // Set the response header to NULL if an RDM header can't be read
+            memset(&callback->response_header, 0, sizeof(callback->response_header));
+        }
+
+        // Only one responder may answer so that responses do not collide
+        if (packet_size > 0) {
+            break;
+        }
+    }
+
     // Send the RDM response
     if (packet_size > 0) {
         if (!dmx_send_num(dmx_num, packet_size)) {
@@ -115,22 +453,166 @@ bool rdm_send_response(dmx_port_t dmx_num) {
         } else {
             dmx_wait_sent(dmx_num, dmx_ms_to_ticks(23));
             taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
-            driver->dmx.head = DMX_HEAD_WAITING_FOR_BREAK;
+            dmx_state_set_head(dmx_num, DMX_HEAD_WAITING_FOR_BREAK);
             dmx_uart_set_rts(dmx_num, 1);
             taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
         }
     }
+    xSemaphoreGiveRecursive(driver->mux);
 
-    // Call the after-response callback
-    const dmx_parameter_t *parameter = dmx_parameter_get_entry(dmx_num, header.sub_device, header.pid);
-    if (parameter != NULL && parameter->callback != NULL) {
-        rdm_header_t response_header;
-        if (!rdm_read_header(dmx_num, &response_header)) {
-            // Set the response header to NULL if an RDM header can't be read
-            memset(&response_header, 0, sizeof(response_header));
+    // Call the after-response callbacks outside of the driver mutex
+    for (int i = 0; i < callback_count; ++i) {
+        if (callbacks[i].callback != NULL) {
+            callbacks[i].callback(dmx_num, &header, &callbacks[i].response_header, callbacks[i].context);
         }
-        parameter->callback(dmx_num, &header, &response_header, parameter->context);
     }
 
     return (packet_size > 0);
+}
+
+/** @brief A DMX packet which is handed to the user by the RDM responder service
+ * task.*/
+typedef struct rdm_responder_frame_t {
+    dmx_packet_t packet;                // Information about the DMX packet.
+    uint8_t data[DMX_PACKET_SIZE_MAX];  // The slot data of the DMX packet.
+} rdm_responder_frame_t;
+
+static void rdm_responder_task(void *arg) {
+    const dmx_port_t dmx_num   = (dmx_port_t)(uintptr_t)arg;
+    dmx_driver_t *const driver = dmx_driver[dmx_num];
+
+    rdm_responder_frame_t frame;
+    while (true) {
+        bool is_running;
+        taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+        is_running = driver->rdm.responder.is_running;
+        taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+        if (!is_running) {
+            break;
+        }
+
+        const size_t size = dmx_receive(dmx_num, &frame.packet, DMX_TIMEOUT_TICK);
+        if (size == 0) {
+            continue;  // Check if the task should stop after each timeout
+        }
+
+        if (frame.packet.is_rdm) {
+            // Callbacks are called after the response is sent and the driver is released
+            rdm_send_response(dmx_num);
+        } else {
+            // Hand the packet to the user, replacing any packet that wasn't received
+            dmx_read(dmx_num, frame.data, size);
+            xQueueOverwrite(driver->rdm.responder.frames, &frame);
+        }
+    }
+
+    // Let rdm_responder_stop() know that the task is done
+    taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+    driver->rdm.responder.task = NULL;
+    taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+    vTaskDelete(NULL);
+}
+
+bool rdm_responder_start(dmx_port_t dmx_num, UBaseType_t priority, BaseType_t core_id) {
+    DMX_CHECK(dmx_num < DMX_NUM_MAX, false, "dmx_num error");
+    DMX_CHECK(priority < configMAX_PRIORITIES, false, "priority error");
+    DMX_CHECK(core_id == tskNO_AFFINITY || (core_id >= 0 && core_id < portNUM_PROCESSORS), false, "core_id error");
+    DMX_CHECK(dmx_driver_is_installed(dmx_num), false, "driver is not installed");
+
+    dmx_driver_t *const driver = dmx_driver[dmx_num];
+
+    if (rdm_responder_is_running(dmx_num)) {
+        return true;
+    }
+
+    // Allocate the queue once and reuse it if the task is restarted
+    if (driver->rdm.responder.frames == NULL) {
+        driver->rdm.responder.frames = xQueueCreate(1, sizeof(rdm_responder_frame_t));
+        if (driver->rdm.responder.frames == NULL) {
+            DMX_ERR("RDM responder queue malloc error");
+            return false;
+        }
+    }
+    xQueueReset(driver->rdm.responder.frames);
+
+    driver->rdm.responder.is_running = true;
+    TaskHandle_t task;
+    if (xTaskCreatePinnedToCore(rdm_responder_task, "rdm_responder", RDM_RESPONDER_TASK_STACK_SIZE,
+                                (void *)(uintptr_t)dmx_num, priority, &task, core_id) != pdPASS) {
+        driver->rdm.responder.is_running = false;
+        DMX_ERR("RDM responder task create error");
+        return false;
+    }
+    taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+    driver->rdm.responder.task = task;
+    taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+
+    return true;
+}
+
+bool rdm_responder_stop(dmx_port_t dmx_num) {
+    DMX_CHECK(dmx_num < DMX_NUM_MAX, false, "dmx_num error");
+    DMX_CHECK(dmx_driver_is_installed(dmx_num), false, "driver is not installed");
+
+    dmx_driver_t *const driver = dmx_driver[dmx_num];
+
+    if (!rdm_responder_is_running(dmx_num)) {
+        return true;
+    }
+    DMX_CHECK(xTaskGetCurrentTaskHandle() != driver->rdm.responder.task, false,
+              "cannot stop the responder from its own task");
+
+    // Ask the task to stop and wait for it to finish its current dmx_receive()
+    taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+    driver->rdm.responder.is_running = false;
+    taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+    TaskHandle_t task;
+    do {
+        vTaskDelay(1);
+        taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+        task = driver->rdm.responder.task;
+        taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+    } while (task != NULL);
+
+    return true;
+}
+
+bool rdm_responder_is_running(dmx_port_t dmx_num) {
+    DMX_CHECK(dmx_num < DMX_NUM_MAX, false, "dmx_num error");
+    DMX_CHECK(dmx_driver_is_installed(dmx_num), false, "driver is not installed");
+
+    dmx_driver_t *const driver = dmx_driver[dmx_num];
+
+    bool is_running;
+    taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+    is_running = driver->rdm.responder.task != NULL;
+    taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+
+    return is_running;
+}
+
+size_t rdm_responder_receive(dmx_port_t dmx_num, dmx_packet_t *packet, void *destination, size_t size,
+                             TickType_t wait_ticks) {
+    DMX_CHECK(dmx_num < DMX_NUM_MAX, 0, "dmx_num error");
+    DMX_CHECK(destination != NULL || size == 0, 0, "destination is null");
+    DMX_CHECK(dmx_driver_is_installed(dmx_num), 0, "driver is not installed");
+    DMX_CHECK(dmx_driver[dmx_num]->rdm.responder.frames != NULL, 0, "responder is not started");
+
+    dmx_driver_t *const driver = dmx_driver[dmx_num];
+
+    rdm_responder_frame_t frame;
+    if (!xQueueReceive(driver->rdm.responder.frames, &frame, wait_ticks)) {
+        dmx_packet_set_timeout(packet);
+        return 0;
+    }
+
+    if (packet != NULL) {
+        *packet = frame.packet;
+    }
+    if (size > frame.packet.size) {
+        size = frame.packet.size;
+    }
+    memcpy(destination, frame.data, size);
+
+    return frame.packet.size;
 }
\ No newline at end of file
@@ -27,6 +27,20 @@ extern "C" {
 typedef void (*rdm_callback_t)(dmx_port_t dmx_num, rdm_header_t *request_header,
                                rdm_header_t *response_header, void *context);
 
+/**
+ * @brief The function type used to perform the work of an RDM request after the
+ * responder has answered it with RDM_RESPONSE_TYPE_ACK_TIMER. Deferred work is
+ * run by the FreeRTOS timer service task so it is not bound by the RDM
+ * responder timing requirements.
+ *
+ * @param dmx_num The DMX port number of the request.
+ * @param[in] request_header The header of the deferred RDM request.
+ * @param[inout] context The user context provided to the function.
+ */
+typedef void (*rdm_deferred_cb_t)(dmx_port_t dmx_num,
+                                  const rdm_header_t *request_header,
+                                  void *context);
+
 /**
  * @brief Sends an RDM response based on the most recently received RDM request
  * that was received. In order to send a response to an RDM request the RDM
@@ -43,6 +57,63 @@ typedef void (*rdm_callback_t)(dmx_port_t dmx_num, rdm_header_t *request_header,
  */
 bool rdm_send_response(dmx_port_t dmx_num);
 
+/**
+ * @brief Starts a task which services RDM requests on behalf of the user. The
+ * task receives every packet on the DMX port, sends responses to RDM requests
+ * with rdm_send_response(), and calls RDM response callbacks after the response
+ * has been sent and the DMX driver has been released. Non-RDM packets are
+ * handed to the user through a queue and may be received with
+ * rdm_responder_receive(). The queue only holds the most recent packet. Users
+ * should not call dmx_receive() while the task is running.
+ *
+ * @param dmx_num The DMX port number.
+ * @param priority The FreeRTOS priority of the task. It is recommended to use a
+ * priority higher than any task which uses the DMX port.
+ * @param core_id The core to which the task is pinned, or tskNO_AFFINITY.
+ * @return true if the task was started or was already running.
+ * @return false on failure.
+ */
+bool rdm_responder_start(dmx_port_t dmx_num, UBaseType_t priority,
+                         BaseType_t core_id);
+
+/**
+ * @brief Stops the task which was started with rdm_responder_start(). This
+ * function blocks until the task has stopped.
+ *
+ * @param dmx_num The DMX port number.
+ * @return true if the task was stopped or was not running.
+ * @return false on failure.
+ */
+bool rdm_responder_stop(dmx_port_t dmx_num);
+
+/**
+ * @brief Returns true if the task started with rdm_responder_start() is
+ * running.
+ *
+ * @param dmx_num The DMX port number.
+ * @return true if the task is running.
+ * @return false if the task is not running.
+ */
+bool rdm_responder_is_running(dmx_port_t dmx_num);
+
+/**
+ * @brief Receives a DMX packet which was handed to the user by the task started
+ * with rdm_responder_start(). The packet slot data is copied into the
+ * destination buffer.
+ *
+ * @param dmx_num The DMX port number.
+ * @param[out] packet An optional pointer to a dmx_packet_t which stores
+ * information about the received DMX packet.
+ * @param[out] destination An optional pointer to a buffer into which to copy
+ * the packet slot data.
+ * @param size The maximum number of slots to copy into the destination.
+ * @param wait_ticks The number of ticks to wait before this function times out.
+ * @return The size of the received DMX packet or 0 if no packet was received.
+ */
+size_t rdm_responder_receive(dmx_port_t dmx_num, dmx_packet_t *packet,
+                             void *destination, size_t size,
+                             TickType_t wait_ticks);
+
 #ifdef __cplusplus
 }
 #endif
@@ -54,3 +125,4 @@ bool rdm_send_response(dmx_port_t dmx_num);
 #include "./responder/include/queue_status.h"
 #include "./responder/include/rdm_info.h"
 #include "./responder/include/sensor_parameter.h"
+#include "./responder/include/virtual.h"
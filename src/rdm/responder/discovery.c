@@ -2,12 +2,46 @@
 
 #include <string.h>
 
+#include "../../dmx/hal/include/timer.h"
 #include "../../dmx/include/driver.h"
 #include "../../dmx/include/service.h"
 #include "include/utils.h"
 #include "../include/driver.h"
 #include "../include/uid.h"
 
+static void rdm_get_binding_uid(dmx_port_t dmx_num, rdm_uid_t *binding_uid) {
+    int num_ports = 0;
+    for (int i = 0; i < DMX_NUM_MAX; ++i) {
+        if (dmx_driver_is_installed(i)) {
+            ++num_ports;
+        }
+    }
+    if (num_ports == 1) {
+        *binding_uid = (rdm_uid_t){0, 0};  // Don't report a binding UID
+    } else {
+        for (int i = 0; i < DMX_NUM_MAX; ++i) {
+            if (dmx_driver_is_installed(i)) {
+                memcpy(binding_uid, &dmx_driver[i]->uid, sizeof(*binding_uid));
+                break;
+            }
+        }
+    }
+}
+
+static void DMX_ISR_ATTR rdm_fast_discovery_decode_uid(const uint8_t *data, rdm_uid_t *uid) {
+    uid->man_id = (data[0] << 8) | data[1];
+    uid->dev_id = ((uint32_t)data[2] << 24) | (data[3] << 16) | (data[4] << 8) | data[5];
+}
+
+static void DMX_ISR_ATTR rdm_fast_discovery_encode_uid(uint8_t *data, const rdm_uid_t *uid) {
+    data[0] = uid->man_id >> 8;
+    data[1] = uid->man_id;
+    data[2] = uid->dev_id >> 24;
+    data[3] = uid->dev_id >> 16;
+    data[4] = uid->dev_id >> 8;
+    data[5] = uid->dev_id;
+}
+
 static size_t rdm_rhd_discovery(dmx_port_t dmx_num, const rdm_parameter_definition_t *definition,
                                 const rdm_header_t *header) {
     // Return early if the sub-device is out of range
@@ -42,23 +76,8 @@ static size_t rdm_rhd_discovery(dmx_port_t dmx_num, const rdm_parameter_definiti
         dmx_parameter_set(dmx_num, RDM_SUB_DEVICE_ROOT, header->pid, &set_mute, sizeof(set_mute));
 
         // Get the binding UID of this device
-        int num_ports = 0;
         rdm_disc_mute_t mute;
-        for (int i = 0; i < DMX_NUM_MAX; ++i) {
-            if (dmx_driver_is_installed(i)) {
-                ++num_ports;
-            }
-        }
-        if (num_ports == 1) {
-            mute.binding_uid = (rdm_uid_t){0, 0};  // Don't report a binding UID
-        } else {
-            for (int i = 0; i < DMX_NUM_MAX; ++i) {
-                if (dmx_driver_is_installed(i)) {
-                    memcpy(&mute.binding_uid, rdm_uid_get(i), sizeof(mute.binding_uid));
-                    break;
-                }
-            }
-        }
+        rdm_get_binding_uid(dmx_num, &mute.binding_uid);
 
         // Get the mute control field of this port
         mute.managed_proxy  = 0;  // TODO: managed proxy flag
@@ -171,4 +190,197 @@ bool rdm_register_disc_un_mute(dmx_port_t dmx_num, rdm_callback_t cb, void *cont
     rdm_definition_set(dmx_num, RDM_SUB_DEVICE_ROOT, pid, &definition);
 
     return rdm_callback_set(dmx_num, RDM_SUB_DEVICE_ROOT, pid, cb, context);
-}
\ No newline at end of file
+}
+
+bool rdm_set_fast_discovery(dmx_port_t dmx_num, bool enable) {
+    DMX_CHECK(dmx_num < DMX_NUM_MAX, false, "dmx_num error");
+    DMX_CHECK(dmx_driver_is_installed(dmx_num), false, "driver is not installed");
+
+    dmx_driver_t *const driver                     = dmx_driver[dmx_num];
+    struct dmx_driver_fast_discovery_t *const fast = &driver->rdm.fast_discovery;
+
+    if (!enable) {
+        taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+        fast->is_enabled = false;
+        taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+        return true;
+    }
+
+    // The DMX interrupt writes the mute parameter directly
+    uint8_t *is_muted = dmx_parameter_get_data(dmx_num, RDM_SUB_DEVICE_ROOT, RDM_PID_DISC_MUTE);
+    DMX_CHECK(is_muted != NULL, false, "RDM_PID_DISC_MUTE is not registered");
+
+    // Pre-encode the parts of the responses which do not change
+    uint8_t branch[RDM_DISC_RESPONSE_SIZE];
+    rdm_uid_t binding_uid;
+    rdm_encode_disc_response(branch, rdm_uid_get(dmx_num));
+    rdm_get_binding_uid(dmx_num, &binding_uid);
+
+    taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+    memcpy(fast->branch, branch, sizeof(branch));
+    fast->binding_uid = binding_uid;
+    fast->is_muted    = is_muted;
+    fast->responded   = false;
+    fast->is_enabled  = true;
+    taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+
+    return true;
+}
+
+bool DMX_ISR_ATTR rdm_fast_discovery_isr(dmx_port_t dmx_num) {
+    dmx_driver_t *const driver                     = dmx_driver[dmx_num];
+    struct dmx_driver_fast_discovery_t *const fast = &driver->rdm.fast_discovery;
+    const uint8_t *const data                      = driver->dmx.data;
+
+    // Only discovery requests to the root device are answered from the interrupt
+    const rdm_pid_t pid         = (data[21] << 8) | data[22];
+    const uint8_t message_count = fast->queue_size > 255 ? 255 : fast->queue_size;
+    if (!fast->is_enabled || data[20] != RDM_CC_DISC_COMMAND || data[18] != 0 || data[19] != 0 ||
+        (pid != RDM_PID_DISC_UNIQUE_BRANCH && pid != RDM_PID_DISC_MUTE && pid != RDM_PID_DISC_UN_MUTE)) {
+        return false;
+    }
+    rdm_header_t request;
+    if (!rdm_read_header(dmx_num, &request)) {
+        return false;
+    }
+    const bool is_port_target = rdm_uid_is_target(&driver->uid, &request.dest_uid);
+
+    // Build the response without function calls for IRAM ISR
+    rdm_header_t response_header;
+    for (int i = 0; i < sizeof(response_header); ++i) {
+        ((uint8_t *)&response_header)[i] = 0;
+    }
+    const uint8_t *response = NULL;
+    int size                = 0;
+    bool has_break          = false;
+    bool is_target          = is_port_target;
+    rdm_uid_t this_uid      = driver->uid;  // The UID of the responder which answers the request
+    if (pid == RDM_PID_DISC_UNIQUE_BRANCH) {
+        // Respond if this device is not muted and is within the discovery branch
+        rdm_uid_t lower_bound;
+        rdm_uid_t upper_bound;
+        rdm_fast_discovery_decode_uid(&data[24], &lower_bound);
+        rdm_fast_discovery_decode_uid(&data[24 + sizeof(rdm_uid_t)], &upper_bound);
+        const bool is_valid = request.pdl == sizeof(rdm_disc_unique_branch_t);
+        if (is_valid && is_port_target && !*fast->is_muted && !rdm_uid_is_lt(&driver->uid, &lower_bound) &&
+            !rdm_uid_is_gt(&driver->uid, &upper_bound)) {
+            response = fast->branch;
+        }
+
+        // Otherwise one virtual responder in the branch answers so that their responses never collide
+        taskENTER_CRITICAL_ISR(DMX_SPINLOCK(dmx_num));
+        for (int i = rdm_virtual_find(dmx_num, &request.dest_uid, 0); i >= 0;
+             i = rdm_virtual_find(dmx_num, &request.dest_uid, i + 1)) {
+            const struct dmx_driver_virtual_responder_t *const responder = &driver->rdm.virtuals->responders[i];
+            is_target                                                    = true;
+            if (response == NULL && is_valid && !*responder->is_muted &&
+                !rdm_uid_is_lt(&responder->uid, &lower_bound) && !rdm_uid_is_gt(&responder->uid, &upper_bound)) {
+                for (int j = 0; j < RDM_DISC_RESPONSE_SIZE; ++j) {
+                    fast->mute[j] = responder->branch[j];  // The responders may move once the lock is released
+                }
+                response = fast->mute;
+                this_uid = responder->uid;
+                break;
+            }
+        }
+        taskEXIT_CRITICAL_ISR(DMX_SPINLOCK(dmx_num));
+
+        if (response != NULL) {
+            size                          = RDM_DISC_RESPONSE_SIZE;
+            response_header.message_len   = RDM_DISC_RESPONSE_SIZE;
+            response_header.dest_uid      = RDM_UID_BROADCAST_ALL;
+            response_header.src_uid       = this_uid;
+            response_header.response_type = RDM_RESPONSE_TYPE_ACK;
+            response_header.cc            = RDM_CC_DISC_COMMAND_RESPONSE;
+            response_header.pid           = RDM_PID_DISC_UNIQUE_BRANCH;
+        }
+    } else {
+        // Set or unset the mute parameter of every responder which is targeted
+        const uint8_t set_mute = (pid == RDM_PID_DISC_MUTE);
+        if (is_port_target) {
+            *fast->is_muted = set_mute;
+        }
+        taskENTER_CRITICAL_ISR(DMX_SPINLOCK(dmx_num));
+        for (int i = rdm_virtual_find(dmx_num, &request.dest_uid, 0); i >= 0;
+             i = rdm_virtual_find(dmx_num, &request.dest_uid, i + 1)) {
+            const struct dmx_driver_virtual_responder_t *const responder = &driver->rdm.virtuals->responders[i];
+            *responder->is_muted                                         = set_mute;
+            if (!is_target) {
+                this_uid = responder->uid;  // Unicast requests only target one responder
+            }
+            is_target = true;
+        }
+        taskEXIT_CRITICAL_ISR(DMX_SPINLOCK(dmx_num));
+
+        // Mute responses are not sent to broadcast requests
+        if (is_target && !rdm_uid_is_broadcast(&request.dest_uid)) {
+            const int pdl = rdm_uid_is_null(&fast->binding_uid) ? sizeof(uint16_t) : sizeof(rdm_disc_mute_t);
+            uint8_t *const mute = fast->mute;
+            mute[0]             = RDM_SC;
+            mute[1]             = RDM_SUB_SC;
+            mute[2]             = 24 + pdl;
+            rdm_fast_discovery_encode_uid(&mute[3], &request.src_uid);
+            rdm_fast_discovery_encode_uid(&mute[9], &this_uid);
+            mute[15] = request.tn;
+            mute[16] = RDM_RESPONSE_TYPE_ACK;
+            mute[17] = message_count;
+            mute[18] = 0;  // RDM_SUB_DEVICE_ROOT
+            mute[19] = 0;
+            mute[20] = RDM_CC_DISC_COMMAND_RESPONSE;
+            mute[21] = pid >> 8;
+            mute[22] = pid;
+            mute[23] = pdl;
+
+            // Encode the control field
+            mute[24] = 0;
+            mute[25] = (is_port_target && driver->device.sub_devices.count > 0 ? 0x02 : 0) |
+                       (driver->rdm.boot_loader ? 0x04 : 0);
+            if (pdl > sizeof(uint16_t)) {
+                rdm_fast_discovery_encode_uid(&mute[26], &fast->binding_uid);
+            }
+
+            // Calculate and encode the checksum
+            uint16_t checksum = 0;
+            for (int i = 0; i < 24 + pdl; ++i) {
+                checksum += mute[i];
+            }
+            mute[24 + pdl]     = checksum >> 8;
+            mute[24 + pdl + 1] = checksum;
+
+            response                      = mute;
+            size                          = 24 + pdl + 2;
+            has_break                     = true;
+            response_header.message_len   = 24 + pdl;
+            response_header.dest_uid      = request.src_uid;
+            response_header.src_uid       = this_uid;
+            response_header.tn            = request.tn;
+            response_header.response_type = RDM_RESPONSE_TYPE_ACK;
+            response_header.message_count = message_count;
+            response_header.cc            = RDM_CC_DISC_COMMAND_RESPONSE;
+            response_header.pid           = pid;
+            response_header.pdl           = pdl;
+        }
+    }
+
+    if (!is_target) {
+        return false;  // The request is not for any responder of this port
+    }
+
+    // Schedule the response after the minimum responder turnaround time
+    taskENTER_CRITICAL_ISR(DMX_SPINLOCK(dmx_num));
+    fast->request         = request;
+    fast->response_header = response_header;
+    fast->responded       = true;
+    if (size > 0) {
+        fast->response  = response;
+        fast->size      = size;
+        fast->has_break = has_break;
+        fast->progress  = DMX_PROGRESS_STALE;
+        dmx_timer_set_counter(dmx_num, 0);
+        dmx_timer_set_alarm(dmx_num, RDM_TIMING_RESPONDER_MIN, false);
+        dmx_timer_start(dmx_num);
+    }
+    taskEXIT_CRITICAL_ISR(DMX_SPINLOCK(dmx_num));
+
+    return size > 0;
+}
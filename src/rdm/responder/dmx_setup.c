@@ -181,16 +181,19 @@ bool rdm_register_dmx_personality_description(dmx_port_t dmx_num, rdm_dmx_person
 
     // Define the parameter
     static const rdm_parameter_definition_t definition = {
-        .pid_cc = RDM_CC_GET,
-        .ds     = RDM_DS_NOT_DEFINED,
-        .get = {.handler = rdm_rhd_get_dmx_personality_description, .request.format = "b$", .response.format = "bwa"},
-        .set = {.handler = NULL, .request.format = NULL, .response.format = NULL},
-        .pdl_size    = 0,
-        .max_value   = 0,
-        .min_value   = 0,
-        .units       = RDM_UNITS_NONE,
-        .prefix      = RDM_PREFIX_NONE,
-        .description = NULL};
+        .pid_cc       = RDM_CC_GET,
+        .ds           = RDM_DS_NOT_DEFINED,
+        .get          = {.handler         = rdm_rhd_get_dmx_personality_description,
+                         .request.format  = "b$",
+                         .response.format = "bwa"},
+        .set          = {.handler = NULL, .request.format = NULL, .response.format = NULL},
+        .pdl_size     = 0,
+        .max_value    = 0,
+        .min_value    = 0,
+        .units        = RDM_UNITS_NONE,
+        .prefix       = RDM_PREFIX_NONE,
+        .description  = NULL,
+        .is_cacheable = true};
     rdm_definition_set(dmx_num, RDM_SUB_DEVICE_ROOT, pid, &definition);
 
     return rdm_callback_set(dmx_num, RDM_SUB_DEVICE_ROOT, pid, cb, context);
@@ -230,7 +233,7 @@ bool rdm_register_dmx_start_address(dmx_port_t dmx_num, rdm_callback_t cb, void
         .get         = {.handler = rdm_simple_response_handler, .request.format = NULL, .response.format = "w$"},
         .set         = {.handler = rdm_simple_response_handler, .request.format = "w$", .response.format = NULL},
         .pdl_size    = sizeof(uint16_t),
-        .max_value   = 512,
+        .max_value   = DMX_PACKET_SIZE_MAX - 1,
         .min_value   = 1,
         .units       = RDM_UNITS_NONE,
         .prefix      = RDM_PREFIX_NONE,
@@ -59,6 +59,23 @@ bool rdm_register_disc_mute(dmx_port_t dmx_num, rdm_callback_t cb, void *context
  */
 bool rdm_register_disc_un_mute(dmx_port_t dmx_num, rdm_callback_t cb, void *context);
 
+/**
+ * @brief Enables or disables fast discovery. When fast discovery is enabled,
+ * RDM_PID_DISC_UNIQUE_BRANCH, RDM_PID_DISC_MUTE, and RDM_PID_DISC_UN_MUTE
+ * requests are answered from the DMX interrupt using a pre-encoded response so
+ * that task scheduling latency cannot cause the responder to miss its response
+ * window. The request is still received by dmx_receive() and rdm_send_response()
+ * still calls any registered callbacks, but it does not send another response.
+ * This function should be called after every DMX driver has been installed so
+ * that the correct binding UID is reported.
+ *
+ * @param dmx_num The DMX port number.
+ * @param enable True to enable fast discovery, false to disable it.
+ * @return true on success.
+ * @return false if RDM_PID_DISC_MUTE is not registered.
+ */
+bool rdm_set_fast_discovery(dmx_port_t dmx_num, bool enable);
+
 #ifdef __cplusplus
 }
 #endif
@@ -38,6 +38,8 @@ bool rdm_register_queued_message(dmx_port_t dmx_num, uint32_t max_count,
 
 /**
  * @brief Push a parameter ID to the RDM queue, if it has been instantiated.
+ * Pushing a parameter ID which is already queued has no effect, so the RDM
+ * queue only holds distinct parameter IDs.
  *
  * @param dmx_num The DMX port number.
  * @param pid The parameter ID to push to the RDM queue.
@@ -100,6 +100,9 @@ size_t rdm_sensor_get(dmx_port_t dmx_num, rdm_sub_device_t sub_device,
 /**
  * @brief Sets a value to a specified sensor. This function should be called
  * periodically as RDM controllers may request sensor data at any given time.
+ * The lowest and highest values of the sensor are updated with the value. The
+ * first value which is set after the sensor is reset becomes both its lowest
+ * and its highest values.
  *
  * @param dmx_num The DMX port number.
  * @param sub_device The sub-device number.
@@ -111,6 +114,26 @@ size_t rdm_sensor_get(dmx_port_t dmx_num, rdm_sub_device_t sub_device,
 bool rdm_sensor_set(dmx_port_t dmx_num, rdm_sub_device_t sub_device,
                     uint8_t sensor_num, int16_t value);
 
+/**
+ * @brief Sets the values of a range of consecutive sensors at once. The lowest
+ * and highest values of each sensor are updated as with rdm_sensor_set(). All
+ * of the values are written together, so RDM controllers always receive values
+ * from the same call. This is faster than calling rdm_sensor_set() for each
+ * sensor. Reading sensor values, whether with rdm_sensor_get() or in response
+ * to an RDM request, does not block this function.
+ *
+ * @param dmx_num The DMX port number.
+ * @param sub_device The sub-device number.
+ * @param first The number of the first sensor to set.
+ * @param[in] values An array of values to be written to the sensors, in order,
+ * starting with the first sensor.
+ * @param n The number of values in the array.
+ * @return true on success.
+ * @return false on failure.
+ */
+bool rdm_sensor_set_many(dmx_port_t dmx_num, rdm_sub_device_t sub_device,
+                         uint8_t first, const int16_t *values, size_t n);
+
 /**
  * @brief Records the current value set in a specified sensor. The value
  * recorded on the sensor is the last value that was set using rdm_sensor_set().
@@ -53,6 +53,10 @@ typedef struct rdm_parameter_definition_t {
     uint8_t prefix;
     /** @brief The ASCII description of the parameter.*/
     const char *description;
+    /** @brief True if GET responses for this parameter only depend on DMX
+       parameter data and may be cached by the DMX driver. Cached responses are
+       invalidated whenever parameter data is changed by the DMX driver.*/
+    bool is_cacheable;
 } rdm_parameter_definition_t;
 
 /**
@@ -81,18 +85,84 @@ size_t rdm_write_ack(dmx_port_t dmx_num, const rdm_header_t *header, const char
  */
 size_t rdm_write_nack_reason(dmx_port_t dmx_num, const rdm_header_t *header, rdm_nr_t nack_reason);
 
-/*
-// TODO: implement rdm_write_ack_timer()
-size_t rdm_write_ack_timer(dmx_port_t dmx_num, const rdm_header_t *header,
-                           TickType_t ready_ticks);
-*/
+/**
+ * @brief Writes an ACK_TIMER packet response to a RDM request packet. This
+ * function uses the header of an RDM request packet to write a response. The
+ * header for the RDM request must be a valid RDM request header. The estimated
+ * response time is rounded up to the nearest 100 milliseconds.
+ *
+ * @param dmx_num The DMX port number.
+ * @param[in] header A pointer to the header of the RDM request packet.
+ * @param ready_ticks The estimated number of ticks until the response is ready.
+ * @return The number of bytes written.
+ */
+size_t rdm_write_ack_timer(dmx_port_t dmx_num, const rdm_header_t *header, TickType_t ready_ticks);
 
-/*
-// TODO: implement rdm_write_ack_overflow()
-size_t rdm_write_ack_overflow(dmx_port_t dmx_num, const rdm_header_t *header,
-                              const char *format, const void *pd, size_t pdl,
-                              int page);
-*/
+/**
+ * @brief Writes one page of parameter data which may be too large to fit into
+ * a single RDM packet. Pages are sized to the largest multiple of the format
+ * which fits in a packet. Every page but the last is sent with response type
+ * RDM_RESPONSE_TYPE_ACK_OVERFLOW and the last page is sent with
+ * RDM_RESPONSE_TYPE_ACK. Pages are usually selected by the number of times the
+ * controller has repeated the request for the PID. Pages which are out of range
+ * restart at the first page.
+ *
+ * @param dmx_num The DMX port number.
+ * @param[in] header A pointer to the header of the RDM request packet.
+ * @param[in] format The format string of the RDM parameter data.
+ * @param[in] pd A pointer to the full parameter data.
+ * @param pdl The size of the full parameter data.
+ * @param page The page of the parameter data to write.
+ * @return The number of bytes written.
+ */
+size_t rdm_write_ack_overflow(dmx_port_t dmx_num, const rdm_header_t *header, const char *format, const void *pd,
+                              size_t pdl, int page);
+
+/**
+ * @brief Defers the work of an RDM request so that it may be performed outside
+ * of the RDM responder window. The request is answered with an ACK_TIMER
+ * response and the work is performed by the deferred work task of the DMX
+ * port, which is started the first time a request is deferred and has a stack
+ * of RDM_DEFERRED_TASK_STACK_SIZE bytes. Deferred work functions of a port are
+ * run one at a time, in slot order. When the work is done, the PID is pushed onto the RDM queue so that the controller
+ * may collect the response with RDM_PID_QUEUED_MESSAGE. Deferred GET requests
+ * are answered with the GET response of the parameter and deferred SET requests
+ * are answered with an empty SET response. The RDM queue must be enabled to
+ * defer requests.
+ *
+ * @param dmx_num The DMX port number.
+ * @param[in] header A pointer to the header of the RDM request packet.
+ * @param cb The function which performs the deferred work.
+ * @param[inout] context The user context provided to the function.
+ * @param ready_ticks The estimated number of ticks until the work is done.
+ * @return The number of bytes written.
+ */
+size_t rdm_write_deferred(dmx_port_t dmx_num, const rdm_header_t *header, rdm_deferred_cb_t cb, void *context,
+                          TickType_t ready_ticks);
+
+/**
+ * @brief Takes the completed deferred request for a PID, if there is one. This
+ * is used when answering RDM_PID_QUEUED_MESSAGE requests.
+ *
+ * @param dmx_num The DMX port number.
+ * @param pid The PID which was popped from the RDM queue.
+ * @param[out] header A pointer into which to copy the deferred request header.
+ * @return true if a completed deferred request was taken.
+ * @return false if there is no completed deferred request for the PID.
+ */
+bool rdm_deferred_take(dmx_port_t dmx_num, rdm_pid_t pid, rdm_header_t *header);
+
+/**
+ * @brief Stops the deferred work task of a DMX port, if it is running. Blocks
+ * until the deferred work function which is running, if any, returns. Deferred
+ * work which has not started is discarded. It must not be called from a
+ * deferred work function.
+ *
+ * @param dmx_num The DMX port number.
+ * @return true if the task is stopped.
+ * @return false if it was called from the deferred work task.
+ */
+bool rdm_deferred_stop(dmx_port_t dmx_num);
 
 /**
  * @brief Gets the RDM boot-loader flag. The boot-loader flag is true when the
@@ -116,6 +186,32 @@ bool rdm_get_boot_loader(dmx_port_t dmx_num);
  */
 void rdm_set_boot_loader(dmx_port_t dmx_num);
 
+/**
+ * @brief Answers an RDM discovery request from the DMX interrupt when fast
+ * discovery is enabled. This function should only be called from the DMX
+ * interrupt after a complete, valid RDM request has been received.
+ *
+ * @param dmx_num The DMX port number.
+ * @return true if a discovery response was scheduled.
+ * @return false if no response was scheduled.
+ */
+bool rdm_fast_discovery_isr(dmx_port_t dmx_num);
+
+#ifdef CONFIG_RDM_RESPONDER_IRAM_SAFE
+/**
+ * @brief Answers an RDM GET request to the root device from the DMX interrupt
+ * using the cached response of the parameter. Requests are only answered while
+ * the flash cache is disabled, when the RDM responder task cannot run. This
+ * function should only be called from the DMX interrupt after a complete,
+ * valid RDM request has been received.
+ *
+ * @param dmx_num The DMX port number.
+ * @return true if a cached response was scheduled.
+ * @return false if no response was scheduled.
+ */
+bool rdm_response_cache_isr(dmx_port_t dmx_num);
+#endif
+
 size_t rdm_simple_response_handler(dmx_port_t dmx_num, const rdm_parameter_definition_t *definition,
                                    const rdm_header_t *header);
 
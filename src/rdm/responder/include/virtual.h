@@ -0,0 +1,95 @@
+/**
+ * @file rdm/responder/include/virtual.h
+ * @author Mitch Weisbrod
+ * @brief This file contains functions to add virtual RDM responders to a DMX
+ * port. Each virtual responder has its own UID, root device parameters, and
+ * discovery mute state, so that one DMX port may appear as several RDM devices
+ * to RDM controllers. Requests are dispatched to the virtual responder whose
+ * UID they target, and broadcast requests are handled by every responder they
+ * target.
+ */
+#pragma once
+
+#include <stdbool.h>
+
+#include "../../../dmx/include/types.h"
+#include "../../include/types.h"
+#include "../../responder.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief The function type used to set up or access a virtual RDM responder.
+ * While the function is called, the RDM responder functions of the DMX port,
+ * such as the rdm_register_ and rdm_set_ functions, act on the virtual
+ * responder instead of the DMX port's own responder.
+ *
+ * @param dmx_num The DMX port number of the virtual responder.
+ * @param[in] uid The UID of the virtual responder.
+ * @param[inout] context The user context provided to the function.
+ * @return true on success.
+ * @return false on failure.
+ */
+typedef bool (*rdm_virtual_cb_t)(dmx_port_t dmx_num, const rdm_uid_t *uid,
+                                 void *context);
+
+/**
+ * @brief Adds a virtual RDM responder to a DMX port. The virtual responder has
+ * room for as many root device parameters as the DMX port's own responder. The
+ * parameters required by the RDM specification are registered automatically
+ * and the DMX port's device info, software version label, and manufacturer
+ * label are copied. Then the setup function is called so that the user may
+ * register the remaining parameters of the virtual responder. The virtual
+ * responder does not answer requests until the setup function has returned.
+ *
+ * Virtual responders have no sub-devices. Their parameters are not stored in
+ * non-volatile storage because they would share the keys of the DMX port, but
+ * they are initialized from the values stored for the DMX port. The RDM queue
+ * and the boot-loader flag are shared by every responder of the DMX port.
+ * Callbacks of virtual responder parameters are called with the DMX port's own
+ * responder active, so rdm_virtual_responder_call() should be used to access
+ * the parameters of a virtual responder from a callback. Virtual responders may
+ * not be removed; they are freed when the DMX driver is deleted.
+ *
+ * @param dmx_num The DMX port number.
+ * @param[in] uid The UID of the virtual responder. It must not be the UID of
+ * the DMX port or of another virtual responder.
+ * @param setup An optional function which registers the parameters of the
+ * virtual responder.
+ * @param[inout] context The user context provided to the setup function.
+ * @return true if the virtual responder was added.
+ * @return false on failure.
+ */
+bool rdm_virtual_responder_add(dmx_port_t dmx_num, const rdm_uid_t *uid,
+                               rdm_virtual_cb_t setup, void *context);
+
+/**
+ * @brief Calls a function with a virtual RDM responder of a DMX port active,
+ * so that the function may get or set the parameters of the virtual responder.
+ * The DMX driver is held while the function is called, so the function should
+ * not block.
+ *
+ * @param dmx_num The DMX port number.
+ * @param[in] uid The UID of the virtual responder.
+ * @param func The function to call.
+ * @param[inout] context The user context provided to the function.
+ * @return The return value of the function, or false if the virtual responder
+ * does not exist.
+ */
+bool rdm_virtual_responder_call(dmx_port_t dmx_num, const rdm_uid_t *uid,
+                                rdm_virtual_cb_t func, void *context);
+
+/**
+ * @brief Gets the number of virtual RDM responders which were added to a DMX
+ * port.
+ *
+ * @param dmx_num The DMX port number.
+ * @return The number of virtual responders.
+ */
+int rdm_virtual_responder_get_count(dmx_port_t dmx_num);
+
+#ifdef __cplusplus
+}
+#endif
@@ -68,16 +68,19 @@ bool rdm_register_device_info(dmx_port_t dmx_num, uint16_t model_id, uint16_t pr
 
     // Define the parameter
     static const rdm_parameter_definition_t definition = {
-        .pid_cc   = RDM_CC_GET,
-        .ds       = RDM_DS_NOT_DEFINED,
-        .get      = {.handler = rdm_rhd_get_device_info, .request.format = NULL, .response.format = "x01x00wwdwbbwwb$"},
-        .set      = {.handler = NULL, .request.format = NULL, .response.format = NULL},
-        .pdl_size = 0,
-        .max_value   = 0,
-        .min_value   = 0,
-        .units       = RDM_UNITS_NONE,
-        .prefix      = RDM_PREFIX_NONE,
-        .description = NULL};
+        .pid_cc       = RDM_CC_GET,
+        .ds           = RDM_DS_NOT_DEFINED,
+        .get          = {.handler         = rdm_rhd_get_device_info,
+                         .request.format  = NULL,
+                         .response.format = "x01x00wwdwbbwwb$"},
+        .set          = {.handler = NULL, .request.format = NULL, .response.format = NULL},
+        .pdl_size     = 0,
+        .max_value    = 0,
+        .min_value    = 0,
+        .units        = RDM_UNITS_NONE,
+        .prefix       = RDM_PREFIX_NONE,
+        .description  = NULL,
+        .is_cacheable = true};
     rdm_definition_set(dmx_num, RDM_SUB_DEVICE_ROOT, pid, &definition);
 
     return rdm_callback_set(dmx_num, RDM_SUB_DEVICE_ROOT, pid, cb, context);
@@ -138,16 +141,17 @@ bool rdm_register_device_label(dmx_port_t dmx_num, const char *device_label, rdm
 
     // Define the parameter
     static const rdm_parameter_definition_t definition = {
-        .pid_cc      = RDM_CC_GET_SET,
-        .ds          = RDM_DS_ASCII,
-        .get         = {.handler = rdm_simple_response_handler, .request.format = NULL, .response.format = "a"},
-        .set         = {.handler = rdm_simple_response_handler, .request.format = "a", .response.format = NULL},
-        .pdl_size    = 32,
-        .max_value   = 0,
-        .min_value   = 0,
-        .units       = RDM_UNITS_NONE,
-        .prefix      = RDM_PREFIX_NONE,
-        .description = NULL};
+        .pid_cc       = RDM_CC_GET_SET,
+        .ds           = RDM_DS_ASCII,
+        .get          = {.handler = rdm_simple_response_handler, .request.format = NULL, .response.format = "a"},
+        .set          = {.handler = rdm_simple_response_handler, .request.format = "a", .response.format = NULL},
+        .pdl_size     = 32,
+        .max_value    = 0,
+        .min_value    = 0,
+        .units        = RDM_UNITS_NONE,
+        .prefix       = RDM_PREFIX_NONE,
+        .description  = NULL,
+        .is_cacheable = true};
     rdm_definition_set(dmx_num, RDM_SUB_DEVICE_ROOT, pid, &definition);
 
     return rdm_callback_set(dmx_num, RDM_SUB_DEVICE_ROOT, pid, cb, context);
@@ -196,16 +200,17 @@ bool rdm_register_software_version_label(dmx_port_t dmx_num, const char *softwar
 
     // Define the parameter
     static const rdm_parameter_definition_t definition = {
-        .pid_cc      = RDM_CC_GET,
-        .ds          = RDM_DS_ASCII,
-        .get         = {.handler = rdm_simple_response_handler, .request.format = NULL, .response.format = "a$"},
-        .set         = {.handler = NULL, .request.format = NULL, .response.format = NULL},
-        .pdl_size    = RDM_ASCII_SIZE_MAX,
-        .max_value   = 0,
-        .min_value   = 0,
-        .units       = RDM_UNITS_NONE,
-        .prefix      = RDM_PREFIX_NONE,
-        .description = NULL};
+        .pid_cc       = RDM_CC_GET,
+        .ds           = RDM_DS_ASCII,
+        .get          = {.handler = rdm_simple_response_handler, .request.format = NULL, .response.format = "a$"},
+        .set          = {.handler = NULL, .request.format = NULL, .response.format = NULL},
+        .pdl_size     = RDM_ASCII_SIZE_MAX,
+        .max_value    = 0,
+        .min_value    = 0,
+        .units        = RDM_UNITS_NONE,
+        .prefix       = RDM_PREFIX_NONE,
+        .description  = NULL,
+        .is_cacheable = true};
     rdm_definition_set(dmx_num, RDM_SUB_DEVICE_ROOT, pid, &definition);
 
     return rdm_callback_set(dmx_num, RDM_SUB_DEVICE_ROOT, pid, cb, context);
@@ -240,16 +245,17 @@ bool rdm_register_manufacturer_label(dmx_port_t dmx_num, char *manufacturer_labe
 
     // Define the parameter
     static const rdm_parameter_definition_t definition = {
-        .pid_cc      = RDM_CC_GET,
-        .ds          = RDM_DS_ASCII,
-        .get         = {.handler = rdm_simple_response_handler, .request.format = NULL, .response.format = "a$"},
-        .set         = {.handler = NULL, .request.format = NULL, .response.format = NULL},
-        .pdl_size    = RDM_ASCII_SIZE_MAX,
-        .max_value   = 0,
-        .min_value   = 0,
-        .units       = RDM_UNITS_NONE,
-        .prefix      = RDM_PREFIX_NONE,
-        .description = NULL};
+        .pid_cc       = RDM_CC_GET,
+        .ds           = RDM_DS_ASCII,
+        .get          = {.handler = rdm_simple_response_handler, .request.format = NULL, .response.format = "a$"},
+        .set          = {.handler = NULL, .request.format = NULL, .response.format = NULL},
+        .pdl_size     = RDM_ASCII_SIZE_MAX,
+        .max_value    = 0,
+        .min_value    = 0,
+        .units        = RDM_UNITS_NONE,
+        .prefix       = RDM_PREFIX_NONE,
+        .description  = NULL,
+        .is_cacheable = true};
     rdm_definition_set(dmx_num, RDM_SUB_DEVICE_ROOT, pid, &definition);
 
     return rdm_callback_set(dmx_num, RDM_SUB_DEVICE_ROOT, pid, cb, context);
@@ -286,16 +292,17 @@ bool rdm_register_device_model_description(dmx_port_t dmx_num, const char *devic
 
     // Define the parameter
     static const rdm_parameter_definition_t definition = {
-        .pid_cc      = RDM_CC_GET,
-        .ds          = RDM_DS_ASCII,
-        .get         = {.handler = rdm_simple_response_handler, .request.format = NULL, .response.format = "a$"},
-        .set         = {.handler = NULL, .request.format = NULL, .response.format = NULL},
-        .pdl_size    = RDM_ASCII_SIZE_MAX,
-        .max_value   = 0,
-        .min_value   = 0,
-        .units       = RDM_UNITS_NONE,
-        .prefix      = RDM_PREFIX_NONE,
-        .description = NULL};
+        .pid_cc       = RDM_CC_GET,
+        .ds           = RDM_DS_ASCII,
+        .get          = {.handler = rdm_simple_response_handler, .request.format = NULL, .response.format = "a$"},
+        .set          = {.handler = NULL, .request.format = NULL, .response.format = NULL},
+        .pdl_size     = RDM_ASCII_SIZE_MAX,
+        .max_value    = 0,
+        .min_value    = 0,
+        .units        = RDM_UNITS_NONE,
+        .prefix       = RDM_PREFIX_NONE,
+        .description  = NULL,
+        .is_cacheable = true};
     rdm_definition_set(dmx_num, RDM_SUB_DEVICE_ROOT, pid, &definition);
 
     return rdm_callback_set(dmx_num, RDM_SUB_DEVICE_ROOT, pid, cb, context);
@@ -331,16 +338,17 @@ bool rdm_register_language(dmx_port_t dmx_num, const char *language, rdm_callbac
 
     // Define the parameter
     static const rdm_parameter_definition_t definition = {
-        .pid_cc      = RDM_CC_GET_SET,
-        .ds          = RDM_DS_ASCII,
-        .get         = {.handler = rdm_rhd_get_set_language, .request.format = NULL, .response.format = "a$"},
-        .set         = {.handler = rdm_rhd_get_set_language, .request.format = "a$", .response.format = NULL},
-        .pdl_size    = 2,
-        .max_value   = 0,
-        .min_value   = 0,
-        .units       = RDM_UNITS_NONE,
-        .prefix      = RDM_PREFIX_NONE,
-        .description = NULL};
+        .pid_cc       = RDM_CC_GET_SET,
+        .ds           = RDM_DS_ASCII,
+        .get          = {.handler = rdm_rhd_get_set_language, .request.format = NULL, .response.format = "a$"},
+        .set          = {.handler = rdm_rhd_get_set_language, .request.format = "a$", .response.format = NULL},
+        .pdl_size     = 2,
+        .max_value    = 0,
+        .min_value    = 0,
+        .units        = RDM_UNITS_NONE,
+        .prefix       = RDM_PREFIX_NONE,
+        .description  = NULL,
+        .is_cacheable = true};
     rdm_definition_set(dmx_num, RDM_SUB_DEVICE_ROOT, pid, &definition);
 
     return rdm_callback_set(dmx_num, RDM_SUB_DEVICE_ROOT, pid, cb, context);
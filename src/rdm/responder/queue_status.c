@@ -8,20 +8,63 @@
 /**
  * @brief The implementation for the RDM queue. The RDM queue is implemented
  * using a deque with an additional field to recall the previous PID which was
- * popped from the deque.
+ * popped from the deque. The deque is followed by an open-addressed hash set of
+ * the queued PIDs so that pushing a PID which is already queued is detected in
+ * constant time. Each PID is queued at most once so that the message count
+ * reflects the number of distinct pending changes.
  */
 typedef struct rdm_queue_t {
     uint16_t head;       // The head of the deque.
     uint16_t tail;       // The tail of the deque.
     rdm_pid_t previous;  // The PID that was previously popped from the RDM queue.
     uint16_t max_size;   // The maximum size of the RDM queue.
-    rdm_pid_t data[];    // The buffer containing the RDM queue information.
+    uint16_t set_mask;   // The size of the hash set minus one. The size of the hash set is a power of two.
+    rdm_pid_t data[];    // The buffer containing the RDM queue information, followed by the hash set.
 } rdm_queue_t;
 
 static rdm_queue_t *rdm_get_queue(dmx_port_t dmx_num) {
     return dmx_parameter_get_data(dmx_num, RDM_SUB_DEVICE_ROOT, RDM_PID_QUEUED_MESSAGE);
 }
 
+static size_t rdm_queue_get_set_size(uint32_t max_count) {
+    // Keep the hash set at most half full so probe sequences stay short
+    size_t set_size = 4;
+    while (set_size < max_count * 2) {
+        set_size <<= 1;
+    }
+    return set_size;
+}
+
+static int rdm_queue_set_find(const rdm_queue_t *queue, rdm_pid_t pid) {
+    const rdm_pid_t *set = &queue->data[queue->max_size];
+    int i                = (pid * 40503u) & queue->set_mask;  // Fibonacci hash
+    while (set[i] != 0 && set[i] != pid) {
+        i = (i + 1) & queue->set_mask;
+    }
+    return i;
+}
+
+static void rdm_queue_set_remove(rdm_queue_t *queue, rdm_pid_t pid) {
+    rdm_pid_t *set = &queue->data[queue->max_size];
+    int i          = rdm_queue_set_find(queue, pid);
+    if (set[i] == 0) {
+        return;  // PID is not in the hash set
+    }
+
+    // Shift subsequent entries back so that no tombstones are needed
+    set[i] = 0;
+    for (int j = (i + 1) & queue->set_mask; set[j] != 0; j = (j + 1) & queue->set_mask) {
+        // Entries may stay if their home slot is cyclically within (i, j]
+        const int k = (set[j] * 40503u) & queue->set_mask;
+        if (i <= j ? (i < k && k <= j) : (i < k || k <= j)) {
+            continue;
+        }
+        set[i] = set[j];
+        set[j] = 0;
+        i      = j;
+    }
+}
+
 static size_t rdm_rhd_get_queued_message(dmx_port_t dmx_num, const rdm_parameter_definition_t *definition,
                                          const rdm_header_t *header) {
     if (header->sub_device != RDM_SUB_DEVICE_ROOT) {
@@ -56,6 +99,17 @@ static size_t rdm_rhd_get_queued_message(dmx_port_t dmx_num, const rdm_parameter
     }
 
     response_header.pid = pid;
+
+    // Answer requests which were deferred with RDM_RESPONSE_TYPE_ACK_TIMER
+    rdm_header_t deferred_header;
+    if (rdm_deferred_take(dmx_num, pid, &deferred_header)) {
+        response_header.sub_device = deferred_header.sub_device;
+        if (deferred_header.cc == RDM_CC_SET_COMMAND) {
+            response_header.cc = RDM_CC_SET_COMMAND;
+            return rdm_write_ack(dmx_num, &response_header, NULL, NULL, 0);
+        }
+    }
+
     return response_definition->get.handler(dmx_num, response_definition, &response_header);
 }
 
@@ -67,13 +121,17 @@ bool rdm_register_queued_message(dmx_port_t dmx_num, uint32_t max_count, rdm_cal
     const rdm_pid_t pid = RDM_PID_QUEUED_MESSAGE;
 
     // Add the parameter
-    const size_t size = sizeof(rdm_queue_t) + (sizeof(rdm_pid_t) * max_count);
+    const size_t set_size = rdm_queue_get_set_size(max_count);
+    const size_t size     = sizeof(rdm_queue_t) + (sizeof(rdm_pid_t) * (max_count + set_size));
     if (!dmx_parameter_add(dmx_num, RDM_SUB_DEVICE_ROOT, pid, DMX_PARAMETER_TYPE_DYNAMIC, NULL, size)) {
         return false;
     }
     rdm_queue_t *queue = rdm_get_queue(dmx_num);
     assert(queue != NULL);
-    queue->max_size = max_count;
+    if (queue->max_size == 0) {
+        queue->max_size = max_count;
+        queue->set_mask = set_size - 1;
+    }
 
     // Define the parameter
     static const rdm_parameter_definition_t definition = {
@@ -102,28 +160,27 @@ bool rdm_queue_push(dmx_port_t dmx_num, rdm_pid_t pid) {
         return false;
     }
 
-    bool success        = false;
-    bool already_queued = false;
+    bool success = false;
     taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
-    // Iterate the queue to ensure that the PID isn't already queued
-    for (int i = queue->tail; i != queue->head; ++i) {
-        if (i == queue->max_size) {
-            i = 0;
-        }
-        if (queue->data[i] == pid) {
-            already_queued = true;
-            success        = true;
-            break;
-        }
+    // Pushing a PID which is already queued coalesces with the queued PID
+    rdm_pid_t *const set      = &queue->data[queue->max_size];
+    const int slot            = rdm_queue_set_find(queue, pid);
+    const bool already_queued = (set[slot] == pid);
+    if (already_queued) {
+        success = true;
     }
 
     // Push the new PID and increment the queue head
     if (!already_queued && (queue->head + 1) % queue->max_size != queue->tail) {
+        set[slot]                = pid;
         queue->data[queue->head] = pid;
         ++queue->head;
         if (queue->head == queue->max_size) {
             queue->head = 0;
         }
+#ifndef CONFIG_RDM_RESPONDER_DISABLE
+        ++dmx_driver[dmx_num]->rdm.fast_discovery.queue_size;  // Mirrored for the DMX interrupt
+#endif
         success = true;
     }
     taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
@@ -141,11 +198,15 @@ rdm_pid_t rdm_queue_pop(dmx_port_t dmx_num) {
         assert(queue != NULL);
         taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
         pid = queue->data[queue->tail];
+        rdm_queue_set_remove(queue, pid);
         ++queue->tail;
         if (queue->tail == queue->max_size) {
             queue->tail = 0;
         }
         queue->previous = pid;
+#ifndef CONFIG_RDM_RESPONDER_DISABLE
+        --dmx_driver[dmx_num]->rdm.fast_discovery.queue_size;  // Mirrored for the DMX interrupt
+#endif
         taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
     } else {
         pid = 0;
@@ -93,16 +93,17 @@ bool rdm_register_supported_parameters(dmx_port_t dmx_num, rdm_callback_t cb, vo
 
     // Define the parameter
     static const rdm_parameter_definition_t definition = {
-        .pid_cc      = RDM_CC_GET,
-        .ds          = RDM_DS_UNSIGNED_WORD,
-        .get         = {.handler = rdm_rhd_get_supported_parameters, .request.format = NULL, .response.format = "w"},
-        .set         = {.handler = NULL, .request.format = NULL, .response.format = NULL},
-        .pdl_size    = 0,
-        .max_value   = 0,
-        .min_value   = 0,
-        .units       = RDM_UNITS_NONE,
-        .prefix      = RDM_PREFIX_NONE,
-        .description = NULL};
+        .pid_cc       = RDM_CC_GET,
+        .ds           = RDM_DS_UNSIGNED_WORD,
+        .get          = {.handler = rdm_rhd_get_supported_parameters, .request.format = NULL, .response.format = "w"},
+        .set          = {.handler = NULL, .request.format = NULL, .response.format = NULL},
+        .pdl_size     = 0,
+        .max_value    = 0,
+        .min_value    = 0,
+        .units        = RDM_UNITS_NONE,
+        .prefix       = RDM_PREFIX_NONE,
+        .description  = NULL,
+        .is_cacheable = true};
     rdm_definition_set(dmx_num, RDM_SUB_DEVICE_ROOT, pid, &definition);
 
     return rdm_callback_set(dmx_num, RDM_SUB_DEVICE_ROOT, pid, cb, context);
@@ -163,18 +164,19 @@ bool rdm_register_parameter_description(dmx_port_t dmx_num, rdm_callback_t cb, v
 
     // Define the parameter
     static const rdm_parameter_definition_t definition = {
-        .pid_cc      = RDM_CC_GET,
-        .ds          = RDM_DS_ASCII,
-        .get         = {.handler         = rdm_rhd_get_parameter_description,
-                        .request.format  = "w$",
-                        .response.format = "wbbbx00bbddda"},
-        .set         = {.handler = NULL, .request.format = NULL, .response.format = NULL},
-        .pdl_size    = sizeof(uint16_t),
-        .max_value   = RDM_PID_MANUFACTURER_SPECIFIC_END,
-        .min_value   = RDM_PID_MANUFACTURER_SPECIFIC_BEGIN,
-        .units       = RDM_UNITS_NONE,
-        .prefix      = RDM_PREFIX_NONE,
-        .description = NULL};
+        .pid_cc       = RDM_CC_GET,
+        .ds           = RDM_DS_ASCII,
+        .get          = {.handler         = rdm_rhd_get_parameter_description,
+                         .request.format  = "w$",
+                         .response.format = "wbbbx00bbddda"},
+        .set          = {.handler = NULL, .request.format = NULL, .response.format = NULL},
+        .pdl_size     = sizeof(uint16_t),
+        .max_value    = RDM_PID_MANUFACTURER_SPECIFIC_END,
+        .min_value    = RDM_PID_MANUFACTURER_SPECIFIC_BEGIN,
+        .units        = RDM_UNITS_NONE,
+        .prefix       = RDM_PREFIX_NONE,
+        .description  = NULL,
+        .is_cacheable = true};
     rdm_definition_set(dmx_num, RDM_SUB_DEVICE_ROOT, pid, &definition);
 
     return rdm_callback_set(dmx_num, RDM_SUB_DEVICE_ROOT, pid, cb, context);
@@ -10,13 +10,69 @@
 
 typedef struct rdm_sensors_t {
     uint8_t sensor_count;
+    uint32_t sequence;                                    // Incremented before and after the values are written.
+    uint32_t is_sampled[(RDM_SENSOR_NUM_MAX + 31) / 32];  // The sensors which were set since they were reset.
     rdm_sensor_value_t sensor_value[];
 } rdm_sensors_t;
 
+/* Sensor values are written by the task which samples the sensors and read by
+the task which responds to RDM requests. Writers hold the DMX spinlock so that
+they do not race each other, and increment the sequence number before and after
+the values are written. Readers do not take the spinlock. Instead, they copy the
+values and retry if the sequence number was odd or changed during the copy, so
+that reading a sensor never blocks the sampling task. */
+
 static rdm_sensors_t *rdm_get_sensors(dmx_port_t dmx_num, rdm_sub_device_t sub_device) {
     return dmx_parameter_get_data(dmx_num, sub_device, RDM_PID_SENSOR_VALUE);
 }
 
+static void rdm_sensors_write_begin(rdm_sensors_t *sensors) {
+    __atomic_store_n(&sensors->sequence, sensors->sequence + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+static void rdm_sensors_write_end(rdm_sensors_t *sensors) {
+    __atomic_store_n(&sensors->sequence, sensors->sequence + 1, __ATOMIC_RELEASE);
+}
+
+static void rdm_sensors_read(const rdm_sensors_t *sensors, uint8_t sensor_num, rdm_sensor_value_t *sensor_value) {
+    uint32_t sequence;
+    do {
+        sequence = __atomic_load_n(&sensors->sequence, __ATOMIC_ACQUIRE);
+        if (sequence & 1) {
+            continue;  // The values are being written
+        }
+        *sensor_value = sensors->sensor_value[sensor_num];
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    } while ((sequence & 1) || __atomic_load_n(&sensors->sequence, __ATOMIC_RELAXED) != sequence);
+}
+
+static void rdm_sensors_update(rdm_sensors_t *sensors, uint8_t sensor_num, int16_t value) {
+    rdm_sensor_value_t *const sensor = &sensors->sensor_value[sensor_num];
+    uint32_t *const is_sampled       = &sensors->is_sampled[sensor_num / 32];
+    const uint32_t mask              = 1u << (sensor_num % 32);
+    if (!(*is_sampled & mask)) {
+        // The first value since the sensor was reset is both the lowest and the highest
+        sensor->lowest_value  = value;
+        sensor->highest_value = value;
+        *is_sampled |= mask;
+    } else if (value < sensor->lowest_value) {
+        sensor->lowest_value = value;
+    } else if (value > sensor->highest_value) {
+        sensor->highest_value = value;
+    }
+    sensor->present_value = value;
+}
+
+static void rdm_sensors_reset(rdm_sensors_t *sensors, uint8_t sensor_num) {
+    rdm_sensor_value_t *const sensor = &sensors->sensor_value[sensor_num];
+    sensor->present_value            = 0;
+    sensor->lowest_value             = 0;
+    sensor->highest_value            = 0;
+    sensor->recorded_value           = 0;
+    sensors->is_sampled[sensor_num / 32] &= ~(1u << (sensor_num % 32));
+}
+
 static size_t rdm_rhd_get_set_sensor_value(dmx_port_t dmx_num, const rdm_parameter_definition_t *definition,
                                            const rdm_header_t *header) {
     // Get a pointer to the desired command
@@ -37,7 +93,7 @@ static size_t rdm_rhd_get_set_sensor_value(dmx_port_t dmx_num, const rdm_paramet
     }
 
     rdm_sensors_t *sensors = rdm_get_sensors(dmx_num, header->sub_device);
-    rdm_sensor_value_t *value;
+    rdm_sensor_value_t value;
     assert(sensors != NULL);
 
     if (header->cc == RDM_CC_GET_COMMAND) {
@@ -46,32 +102,27 @@ static size_t rdm_rhd_get_set_sensor_value(dmx_port_t dmx_num, const rdm_paramet
             return rdm_write_nack_reason(dmx_num, header, RDM_NR_UNSUPPORTED_COMMAND_CLASS);
         }
 
-        // Get the requested sensor value
-        value = &sensors->sensor_value[sensor_num];
-        assert(value != NULL);
+        // Get a snapshot of the requested sensor value
+        rdm_sensors_read(sensors, sensor_num, &value);
     } else {
+        taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+        rdm_sensors_write_begin(sensors);
         if (sensor_num == RDM_SENSOR_NUM_MAX) {
             // Reset all the sensors
             for (int i = 0; i < sensors->sensor_count; ++i) {
-                sensors->sensor_value[i].present_value  = 0;
-                sensors->sensor_value[i].lowest_value   = 0;
-                sensors->sensor_value[i].highest_value  = 0;
-                sensors->sensor_value[i].recorded_value = 0;
+                rdm_sensors_reset(sensors, i);
             }
-            value = &sensors->sensor_value[0];
-            assert(value != NULL);
+            sensor_num = 0;
         } else {
-            // Get the requested sensor value and reset it
-            value = &sensors->sensor_value[sensor_num];
-            assert(value != NULL);
-            value->present_value  = 0;
-            value->lowest_value   = 0;
-            value->highest_value  = 0;
-            value->recorded_value = 0;
+            // Reset the requested sensor value
+            rdm_sensors_reset(sensors, sensor_num);
         }
+        rdm_sensors_write_end(sensors);
+        value = sensors->sensor_value[sensor_num];
+        taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
     }
 
-    return rdm_write_ack(dmx_num, header, command->response.format, value, sizeof(*value));
+    return rdm_write_ack(dmx_num, header, command->response.format, &value, sizeof(value));
 }
 
 static size_t rdm_rhd_set_record_sensors(dmx_port_t dmx_num, const rdm_parameter_definition_t *definition,
@@ -171,6 +222,8 @@ bool rdm_register_sensor_value(dmx_port_t dmx_num, uint8_t sensor_count, rdm_cal
     rdm_sensors_t *sensors = rdm_get_sensors(dmx_num, RDM_SUB_DEVICE_ROOT);
     assert(sensors != NULL);
     sensors->sensor_count = sensor_count;
+    sensors->sequence     = 0;
+    memset(sensors->is_sampled, 0, sizeof(sensors->is_sampled));
     for (int i = 0; i < sensor_count; ++i) {
         sensors->sensor_value[i].sensor_num = i;
     }
@@ -246,9 +299,7 @@ size_t rdm_sensor_get(dmx_port_t dmx_num, rdm_sub_device_t sub_device, uint8_t s
         return 0;
     }
 
-    taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
-    *sensor_value = sensors->sensor_value[sensor_num];
-    taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+    rdm_sensors_read(sensors, sensor_num, sensor_value);
 
     return sizeof(*sensor_value);
 }
@@ -265,17 +316,42 @@ bool rdm_sensor_set(dmx_port_t dmx_num, rdm_sub_device_t sub_device, uint8_t sen
     }
 
     // Set the sensor value
+    taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+    rdm_sensors_write_begin(sensors);
     if (sensor_num != RDM_SENSOR_NUM_MAX) {
-        taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
-        sensors->sensor_value[sensor_num].present_value = value;
-        taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+        rdm_sensors_update(sensors, sensor_num, value);
     } else {
         for (int i = 0; i < sensors->sensor_count; ++i) {
-            taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
-            sensors->sensor_value[i].present_value = value;
-            taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+            rdm_sensors_update(sensors, i, value);
         }
     }
+    rdm_sensors_write_end(sensors);
+    taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+
+    return true;
+}
+
+bool rdm_sensor_set_many(dmx_port_t dmx_num, rdm_sub_device_t sub_device, uint8_t first, const int16_t *values,
+                         size_t n) {
+    DMX_CHECK(dmx_num < DMX_NUM_MAX, false, "dmx_num error");
+    DMX_CHECK(sub_device < RDM_SUB_DEVICE_MAX, false, "sub_device error");
+    DMX_CHECK(values != NULL || n == 0, false, "values is null");
+    DMX_CHECK(dmx_driver_is_installed(dmx_num), false, "driver is not installed");
+
+    // Validate the range of sensors
+    rdm_sensors_t *sensors = rdm_get_sensors(dmx_num, sub_device);
+    if (sensors == NULL || first + n > sensors->sensor_count) {
+        return false;
+    }
+
+    // Set the sensor values
+    taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+    rdm_sensors_write_begin(sensors);
+    for (size_t i = 0; i < n; ++i) {
+        rdm_sensors_update(sensors, first + i, values[i]);
+    }
+    rdm_sensors_write_end(sensors);
+    taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
 
     return true;
 }
@@ -291,19 +367,19 @@ bool rdm_sensor_record(dmx_port_t dmx_num, rdm_sub_device_t sub_device, uint8_t
         return false;
     }
 
+    taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+    rdm_sensors_write_begin(sensors);
     if (sensor_num == 0xff) {
-        for (int i = sensors->sensor_count; i >= 0; --i) {
+        for (int i = 0; i < sensors->sensor_count; ++i) {
             rdm_sensor_value_t *sensor = &sensors->sensor_value[i];
-            taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
-            sensor->recorded_value = sensor->present_value;
-            taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+            sensor->recorded_value     = sensor->present_value;
         }
     } else {
         rdm_sensor_value_t *sensor = &sensors->sensor_value[sensor_num];
-        taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
-        sensor->recorded_value = sensor->present_value;
-        taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+        sensor->recorded_value     = sensor->present_value;
     }
+    rdm_sensors_write_end(sensors);
+    taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
 
     return true;
 }
@@ -319,25 +395,17 @@ bool rdm_sensor_reset(dmx_port_t dmx_num, rdm_sub_device_t sub_device, uint8_t s
         return false;
     }
 
+    taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+    rdm_sensors_write_begin(sensors);
     if (sensor_num == 0xff) {
-        for (int i = sensors->sensor_count; i >= 0; --i) {
-            rdm_sensor_value_t *sensor = &sensors->sensor_value[i];
-            taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
-            sensor->present_value  = 0;
-            sensor->lowest_value   = 0;
-            sensor->highest_value  = 0;
-            sensor->recorded_value = 0;
-            taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+        for (int i = 0; i < sensors->sensor_count; ++i) {
+            rdm_sensors_reset(sensors, i);
         }
     } else {
-        rdm_sensor_value_t *sensor = &sensors->sensor_value[sensor_num];
-        taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
-        sensor->present_value  = 0;
-        sensor->lowest_value   = 0;
-        sensor->highest_value  = 0;
-        sensor->recorded_value = 0;
-        taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+        rdm_sensors_reset(sensors, sensor_num);
     }
+    rdm_sensors_write_end(sensors);
+    taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
 
     return true;
 }
@@ -6,6 +6,9 @@
 #include "../../dmx/include/service.h"
 #include "../include/uid.h"
 
+// Pages are sized so that ACK_OVERFLOW responses never exceed 255 bytes
+#define RDM_OVERFLOW_PAGE_SIZE_MAX (229)
+
 size_t rdm_write_ack(dmx_port_t dmx_num, const rdm_header_t *header, const char *format, const void *pd, size_t pdl) {
     assert(dmx_num < DMX_NUM_MAX);
     assert(header != NULL);
@@ -56,12 +59,251 @@ size_t rdm_write_nack_reason(dmx_port_t dmx_num, const rdm_header_t *header, rdm
 }
 
 size_t rdm_write_ack_timer(dmx_port_t dmx_num, const rdm_header_t *header, TickType_t ready_ticks) {
-    return 0;  // TODO: implement write_ack_timer()
+    assert(dmx_num < DMX_NUM_MAX);
+    assert(header != NULL);
+    assert(rdm_cc_is_request(header->cc));
+    assert(dmx_driver_is_installed(dmx_num));
+
+    // Estimated response time is in units of 100 milliseconds and is not zero
+    const uint64_t ms                = (uint64_t)ready_ticks * portTICK_PERIOD_MS;
+    uint16_t estimated_response_time = ms >= UINT16_MAX * 100 ? UINT16_MAX : (ms + 99) / 100;
+    if (estimated_response_time == 0) {
+        estimated_response_time = 1;
+    }
+
+    // PDL is a single word
+    const size_t pdl = sizeof(uint16_t);
+
+    // Build the response header
+    rdm_header_t response_header = {.message_len   = 24 + pdl,
+                                    .dest_uid      = header->src_uid,
+                                    .src_uid       = *rdm_uid_get(dmx_num),
+                                    .tn            = header->tn,
+                                    .response_type = RDM_RESPONSE_TYPE_ACK_TIMER,
+                                    .message_count = rdm_queue_size(dmx_num),
+                                    .sub_device    = header->sub_device,
+                                    .cc            = (header->cc | 0x1),  // Set to RDM_CC_x_COMMAND_RESPONSE
+                                    .pid           = header->pid,
+                                    .pdl           = pdl};
+
+    return rdm_write(dmx_num, &response_header, "w", &estimated_response_time);
 }
 
 size_t rdm_write_ack_overflow(dmx_port_t dmx_num, const rdm_header_t *header, const char *format, const void *pd,
                               size_t pdl, int page) {
-    return 0;  // TODO: implement write_ack_overflow()
+    assert(dmx_num < DMX_NUM_MAX);
+    assert(header != NULL);
+    assert(rdm_cc_is_request(header->cc));
+    assert(format != NULL);
+    assert(pd != NULL || pdl == 0);
+    assert(dmx_driver_is_installed(dmx_num));
+
+    dmx_driver_t *const driver = dmx_driver[dmx_num];
+
+    const size_t page_size = rdm_format_get_size(format, RDM_OVERFLOW_PAGE_SIZE_MAX);
+    if (page_size == 0) {
+        return rdm_write_nack_reason(dmx_num, header, RDM_NR_HARDWARE_FAULT);
+    }
+
+    // Restart at the first page if the requested page is out of range
+    size_t offset = page * page_size;
+    if (page < 0 || (offset >= pdl && pdl > 0)) {
+        page                                 = 0;
+        offset                               = 0;
+        driver->dmx.last_request_pid_repeats = 0;
+    }
+
+    // Send the final page with RDM_RESPONSE_TYPE_ACK
+    const size_t remaining = pdl - offset;
+    rdm_response_type_t response_type;
+    size_t page_pdl;
+    if (remaining > page_size) {
+        response_type = RDM_RESPONSE_TYPE_ACK_OVERFLOW;
+        page_pdl      = page_size;
+    } else {
+        response_type = RDM_RESPONSE_TYPE_ACK;
+        page_pdl      = remaining;
+
+        // The next request for this PID starts again at the first page
+        driver->dmx.last_request_pid = 0;
+    }
+
+    // Build the response header
+    rdm_header_t response_header = {.message_len   = 24 + page_pdl,
+                                    .dest_uid      = header->src_uid,
+                                    .src_uid       = *rdm_uid_get(dmx_num),
+                                    .tn            = header->tn,
+                                    .response_type = response_type,
+                                    .message_count = rdm_queue_size(dmx_num),
+                                    .sub_device    = header->sub_device,
+                                    .cc            = (header->cc | 0x1),  // Set to RDM_CC_x_COMMAND_RESPONSE
+                                    .pid           = header->pid,
+                                    .pdl           = page_pdl};
+
+    return rdm_write(dmx_num, &response_header, format, page_pdl > 0 ? (const uint8_t *)pd + offset : NULL);
+}
+
+/** @brief The task notification bit which asks the deferred work task to stop.
+ * The lower bits are the deferred slots which are ready to be run.*/
+#define RDM_DEFERRED_STOP_BIT (1u << 31)
+
+static void rdm_deferred_run(dmx_port_t dmx_num, int slot) {
+    dmx_driver_t *const driver             = dmx_driver[dmx_num];
+    struct dmx_driver_deferred_t *deferred = &driver->rdm.deferred[slot];
+
+    // The slot cannot be reused until the response is collected
+    rdm_header_t header;
+    rdm_deferred_cb_t cb;
+    void *context;
+    taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+    header  = deferred->header;
+    cb      = deferred->cb;
+    context = deferred->context;
+    taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+    if (cb == NULL) {
+        return;
+    }
+
+    cb(dmx_num, &header, context);
+
+    taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+    deferred->is_done = true;
+    taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+
+    // Let the controller know the response is ready
+    if (!rdm_queue_push(dmx_num, header.pid)) {
+        DMX_WARN("PID 0x%04x could not be queued after deferral", header.pid);
+    }
+}
+
+static void rdm_deferred_task(void *arg) {
+    const dmx_port_t dmx_num   = (dmx_port_t)(uintptr_t)arg;
+    dmx_driver_t *const driver = dmx_driver[dmx_num];
+
+    // Run each deferred slot as it is notified until the task is asked to stop
+    uint32_t slots = 0;
+    while (!(slots & RDM_DEFERRED_STOP_BIT)) {
+        xTaskNotifyWait(0, ULONG_MAX, &slots, portMAX_DELAY);
+        for (int i = 0; i < RDM_DEFERRED_MAX && !(slots & RDM_DEFERRED_STOP_BIT); ++i) {
+            if (slots & (1u << i)) {
+                rdm_deferred_run(dmx_num, i);
+            }
+        }
+    }
+
+    taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+    driver->rdm.deferred_task = NULL;
+    taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+    vTaskDelete(NULL);
+}
+
+bool rdm_deferred_stop(dmx_port_t dmx_num) {
+    assert(dmx_num < DMX_NUM_MAX);
+    assert(dmx_driver_is_installed(dmx_num));
+
+    dmx_driver_t *const driver = dmx_driver[dmx_num];
+
+    TaskHandle_t task;
+    taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+    task = driver->rdm.deferred_task;
+    taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+    if (task == NULL) {
+        return true;
+    }
+    DMX_CHECK(xTaskGetCurrentTaskHandle() != task, false, "cannot stop the deferred work task from its own task");
+
+    // Ask the task to stop and wait for the deferred work which is running to finish
+    xTaskNotify(task, RDM_DEFERRED_STOP_BIT, eSetBits);
+    do {
+        vTaskDelay(1);
+        taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+        task = driver->rdm.deferred_task;
+        taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+    } while (task != NULL);
+
+    return true;
+}
+
+size_t rdm_write_deferred(dmx_port_t dmx_num, const rdm_header_t *header, rdm_deferred_cb_t cb, void *context,
+                          TickType_t ready_ticks) {
+    assert(dmx_num < DMX_NUM_MAX);
+    assert(header != NULL);
+    assert(rdm_cc_is_request(header->cc));
+    assert(cb != NULL);
+    assert(dmx_driver_is_installed(dmx_num));
+
+    dmx_driver_t *const driver = dmx_driver[dmx_num];
+
+    // Deferred responses are collected using RDM_PID_QUEUED_MESSAGE
+    if (!dmx_parameter_exists(dmx_num, RDM_SUB_DEVICE_ROOT, RDM_PID_QUEUED_MESSAGE)) {
+        return rdm_write_nack_reason(dmx_num, header, RDM_NR_HARDWARE_FAULT);
+    }
+
+    // Claim an unused slot, or reuse the slot if this PID is already deferred
+    int slot = -1;
+    taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+    for (int i = 0; i < RDM_DEFERRED_MAX; ++i) {
+        if (driver->rdm.deferred[i].cb == NULL ||
+            (driver->rdm.deferred[i].header.pid == header->pid && driver->rdm.deferred[i].is_done)) {
+            slot = i;
+            break;
+        }
+    }
+    if (slot >= 0) {
+        driver->rdm.deferred[slot].header  = *header;
+        driver->rdm.deferred[slot].cb      = cb;
+        driver->rdm.deferred[slot].context = context;
+        driver->rdm.deferred[slot].is_done = false;
+    }
+    taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+    if (slot < 0) {
+        return rdm_write_nack_reason(dmx_num, header, RDM_NR_PROXY_BUFFER_FULL);
+    }
+
+    // Perform the deferred work in the deferred work task of the port, which is started on the first deferral
+    TaskHandle_t task;
+    taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+    task = driver->rdm.deferred_task;
+    taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+    if (task == NULL) {
+        if (xTaskCreate(rdm_deferred_task, "rdm_deferred", RDM_DEFERRED_TASK_STACK_SIZE, (void *)(uintptr_t)dmx_num,
+                        RDM_DEFERRED_TASK_PRIORITY, &task) != pdPASS) {
+            taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+            driver->rdm.deferred[slot].cb = NULL;
+            taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+            DMX_ERR("deferred work task create error");
+            return rdm_write_nack_reason(dmx_num, header, RDM_NR_HARDWARE_FAULT);
+        }
+        taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+        driver->rdm.deferred_task = task;
+        taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+    }
+    xTaskNotify(task, 1u << slot, eSetBits);
+
+    return rdm_write_ack_timer(dmx_num, header, ready_ticks);
+}
+
+bool rdm_deferred_take(dmx_port_t dmx_num, rdm_pid_t pid, rdm_header_t *header) {
+    assert(dmx_num < DMX_NUM_MAX);
+    assert(header != NULL);
+    assert(dmx_driver_is_installed(dmx_num));
+
+    dmx_driver_t *const driver = dmx_driver[dmx_num];
+
+    bool taken = false;
+    taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+    for (int i = 0; i < RDM_DEFERRED_MAX; ++i) {
+        struct dmx_driver_deferred_t *deferred = &driver->rdm.deferred[i];
+        if (deferred->cb != NULL && deferred->is_done && deferred->header.pid == pid) {
+            *header      = deferred->header;
+            deferred->cb = NULL;
+            taken        = true;
+            break;
+        }
+    }
+    taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+
+    return taken;
 }
 
 bool rdm_get_boot_loader(dmx_port_t dmx_num) {
@@ -105,6 +347,11 @@ size_t rdm_simple_response_handler(dmx_port_t dmx_num, const rdm_parameter_defin
             size_t pdl     = dmx_parameter_size(dmx_num, header->sub_device, header->pid);
             const void *pd = dmx_parameter_get_data(dmx_num, header->sub_device, header->pid);
             format         = definition->get.response.format;
+            if (pdl > RDM_OVERFLOW_PAGE_SIZE_MAX) {
+                // Page parameter data which is too large for a single response
+                const int page = dmx_driver[dmx_num]->dmx.last_request_pid_repeats;
+                return rdm_write_ack_overflow(dmx_num, header, format, pd, pdl, page);
+            }
             return rdm_write_ack(dmx_num, header, format, pd, pdl);
         } else {
             // Get the parameter from the request and write it to the RDM driver
@@ -122,13 +369,11 @@ size_t rdm_simple_response_handler(dmx_port_t dmx_num, const rdm_parameter_defin
             return rdm_write_nack_reason(dmx_num, header, RDM_NR_SUB_DEVICE_OUT_OF_RANGE);
         }
 
-        // Iterate through all sub-devices and update the parameter
+        // Update the parameter on the root device and every sub-device which exists
         uint8_t pd[231];
         format      = definition->set.request.format;
         size_t size = rdm_read_pd(dmx_num, format, pd, header->pdl);
-        for (int i = RDM_SUB_DEVICE_ROOT; i < RDM_SUB_DEVICE_MAX; ++i) {
-            dmx_parameter_set(dmx_num, i, header->pid, pd, size);
-        }
+        dmx_parameter_set_all(dmx_num, header->pid, pd, size);
         return rdm_write_ack(dmx_num, header, NULL, NULL, 0);
     }
 }
@@ -155,7 +400,19 @@ bool rdm_definition_set(dmx_port_t dmx_num, rdm_sub_device_t sub_device, rdm_pid
         return false;
     }
 
+    taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
     entry->definition = definition;
+    ++dmx_driver[dmx_num]->device.generation;  // Invalidate cached RDM responses
+    taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+
+    // Compile the formats so they are not parsed on each request
+    const char *formats[] = {definition->get.request.format, definition->get.response.format,
+                             definition->set.request.format, definition->set.response.format};
+    for (int i = 0; i < sizeof(formats) / sizeof(formats[0]); ++i) {
+        if (formats[i] != NULL) {
+            rdm_format_compile(formats[i]);
+        }
+    }
 
     return true;
 }
@@ -0,0 +1,165 @@
+#include "./include/virtual.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "../../dmx/include/driver.h"
+#include "../../dmx/include/service.h"
+#include "../include/driver.h"
+#include "../include/uid.h"
+#include "./include/device_control.h"
+#include "./include/discovery.h"
+#include "./include/product_info.h"
+#include "./include/rdm_info.h"
+
+static void rdm_virtual_identify_cb(dmx_port_t dmx_num, rdm_header_t *request, rdm_header_t *response,
+                                    void *context) {
+    if (request->cc == RDM_CC_SET_COMMAND && request->sub_device == RDM_SUB_DEVICE_ROOT &&
+        response->response_type == RDM_RESPONSE_TYPE_ACK) {
+#ifdef ARDUINO
+        printf("RDM identify device of " UIDSTR " was set\n", UID2STR(response->src_uid));
+#else
+        ESP_LOGI(TAG, "RDM identify device of " UIDSTR " was set", UID2STR(response->src_uid));
+#endif
+    }
+}
+
+static bool rdm_virtual_register_defaults(dmx_port_t dmx_num, const rdm_device_info_t *device_info,
+                                          const char *software_version_label, char *manufacturer_label) {
+    // Register the parameters which are required by every RDM responder
+    return rdm_register_disc_unique_branch(dmx_num, NULL, NULL) && rdm_register_disc_mute(dmx_num, NULL, NULL) &&
+           rdm_register_disc_un_mute(dmx_num, NULL, NULL) &&
+           rdm_register_device_info(dmx_num, device_info->model_id, device_info->product_category,
+                                    device_info->software_version_id, NULL, NULL) &&
+           rdm_register_software_version_label(dmx_num, software_version_label, NULL, NULL) &&
+           rdm_register_identify_device(dmx_num, rdm_virtual_identify_cb, NULL) &&
+           rdm_register_manufacturer_label(dmx_num, manufacturer_label, NULL, NULL) &&
+           rdm_register_device_label(dmx_num, "", NULL, NULL) &&
+           rdm_register_supported_parameters(dmx_num, NULL, NULL) &&
+           rdm_register_parameter_description(dmx_num, NULL, NULL);
+}
+
+bool rdm_virtual_responder_add(dmx_port_t dmx_num, const rdm_uid_t *uid, rdm_virtual_cb_t setup, void *context) {
+    DMX_CHECK(dmx_num < DMX_NUM_MAX, false, "dmx_num error");
+    DMX_CHECK(uid != NULL, false, "uid is null");
+    DMX_CHECK(!rdm_uid_is_null(uid) && !rdm_uid_is_broadcast(uid), false, "uid error");
+    DMX_CHECK(dmx_driver_is_installed(dmx_num), false, "driver is not installed");
+    DMX_CHECK(dmx_driver[dmx_num]->device.parameter_count.root > 0, false, "driver is not an RDM responder");
+    DMX_CHECK(!rdm_uid_is_eq(uid, &dmx_driver[dmx_num]->uid), false, "uid is the UID of the DMX port");
+
+    dmx_driver_t *const driver = dmx_driver[dmx_num];
+
+    xSemaphoreTakeRecursive(driver->mux, portMAX_DELAY);
+
+    // Allocate the virtual responders the first time one is added
+    struct dmx_driver_virtual_t *virtuals = driver->rdm.virtuals;
+    if (virtuals == NULL) {
+        virtuals = malloc(sizeof(*virtuals));
+        if (virtuals == NULL) {
+            xSemaphoreGiveRecursive(driver->mux);
+            DMX_ERR("virtual responder malloc error");
+            return false;
+        }
+        virtuals->count  = 0;
+        virtuals->active = NULL;
+        virtuals->task   = NULL;
+        taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+        driver->rdm.virtuals = virtuals;
+        taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+    }
+    if (virtuals->count == RDM_VIRTUAL_RESPONDER_MAX || rdm_virtual_find(dmx_num, uid, 0) >= 0) {
+        xSemaphoreGiveRecursive(driver->mux);
+        DMX_ERR("virtual responder exists or too many virtual responders");
+        return false;
+    }
+
+    // Copy the product information of the DMX port's own responder
+    rdm_device_info_t device_info;
+    char software_version_label[RDM_ASCII_SIZE_MAX] = {0};
+    char manufacturer_label[RDM_ASCII_SIZE_MAX]     = {0};
+    rdm_get_device_info(dmx_num, &device_info);
+    rdm_get_software_version_label(dmx_num, software_version_label, RDM_ASCII_SIZE_MAX - 1);
+    rdm_get_manufacturer_label(dmx_num, manufacturer_label, RDM_ASCII_SIZE_MAX - 1);
+
+    // Allocate the root device parameters, which are unused until they are registered
+    const size_t parameter_count = driver->device.parameter_count.root;
+    struct dmx_driver_virtual_responder_t responder = {.uid = *uid};
+    responder.root = calloc(1, sizeof(dmx_device_t) + sizeof(dmx_parameter_t) * parameter_count);
+    if (responder.root == NULL) {
+        xSemaphoreGiveRecursive(driver->mux);
+        DMX_ERR("virtual responder malloc error");
+        return false;
+    }
+    responder.root->num = RDM_SUB_DEVICE_ROOT;
+
+    // Register the parameters while the virtual responder is not yet answering requests
+    rdm_virtual_set_active(dmx_num, &responder);
+    bool success = rdm_virtual_register_defaults(dmx_num, &device_info, software_version_label, manufacturer_label);
+    responder.is_muted = dmx_parameter_get_data(dmx_num, RDM_SUB_DEVICE_ROOT, RDM_PID_DISC_MUTE);
+    if (success && setup != NULL) {
+        success = setup(dmx_num, &responder.uid, context);
+    }
+    rdm_virtual_set_active(dmx_num, NULL);
+    if (!success || responder.is_muted == NULL) {
+        free(responder.root);  // Parameter data is freed with the parameter arena
+        xSemaphoreGiveRecursive(driver->mux);
+        DMX_ERR("virtual responder setup error");
+        return false;
+    }
+    rdm_encode_disc_response(responder.branch, &responder.uid);
+
+    // Insert the virtual responder so that the virtual responders remain sorted by UID
+    int i = 0;
+    while (i < virtuals->count && rdm_uid_is_lt(&virtuals->responders[i].uid, uid)) {
+        ++i;
+    }
+    taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+    memmove(&virtuals->responders[i + 1], &virtuals->responders[i],
+            (virtuals->count - i) * sizeof(virtuals->responders[0]));
+    virtuals->responders[i] = responder;
+    ++virtuals->count;
+    taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+
+    xSemaphoreGiveRecursive(driver->mux);
+
+    return true;
+}
+
+bool rdm_virtual_responder_call(dmx_port_t dmx_num, const rdm_uid_t *uid, rdm_virtual_cb_t func, void *context) {
+    DMX_CHECK(dmx_num < DMX_NUM_MAX, false, "dmx_num error");
+    DMX_CHECK(uid != NULL, false, "uid is null");
+    DMX_CHECK(!rdm_uid_is_broadcast(uid), false, "uid error");
+    DMX_CHECK(func != NULL, false, "func is null");
+    DMX_CHECK(dmx_driver_is_installed(dmx_num), false, "driver is not installed");
+
+    dmx_driver_t *const driver = dmx_driver[dmx_num];
+
+    xSemaphoreTakeRecursive(driver->mux, portMAX_DELAY);
+    const int index = rdm_virtual_find(dmx_num, uid, 0);
+    if (index < 0) {
+        xSemaphoreGiveRecursive(driver->mux);
+        return false;  // The virtual responder does not exist
+    }
+
+    struct dmx_driver_virtual_responder_t *const responder = &driver->rdm.virtuals->responders[index];
+    rdm_virtual_set_active(dmx_num, responder);
+    const bool ret = func(dmx_num, &responder->uid, context);
+    rdm_virtual_set_active(dmx_num, NULL);
+    xSemaphoreGiveRecursive(driver->mux);
+
+    return ret;
+}
+
+int rdm_virtual_responder_get_count(dmx_port_t dmx_num) {
+    DMX_CHECK(dmx_num < DMX_NUM_MAX, 0, "dmx_num error");
+    DMX_CHECK(dmx_driver_is_installed(dmx_num), 0, "driver is not installed");
+
+    dmx_driver_t *const driver = dmx_driver[dmx_num];
+
+    int count;
+    xSemaphoreTakeRecursive(driver->mux, portMAX_DELAY);
+    count = driver->rdm.virtuals != NULL ? driver->rdm.virtuals->count : 0;
+    xSemaphoreGiveRecursive(driver->mux);
+
+    return count;
+}